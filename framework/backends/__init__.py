@@ -122,6 +122,10 @@ def load(file_path):
     extension), and then pass the file path into the appropriate loader, and
     then return the TestrunResult instance.
 
+    An up to date results.index in a results directory is loaded instead of
+    the results it was written from, see framework.backends.indexed. A
+    results file is always loaded as given.
+
     """
     def get_extension(file_path):
         """Get the extension name to use when searching for a loader.
@@ -149,8 +153,20 @@ def load(file_path):
         if not os.path.isdir(file_path):
             return _extension(file_path)
         else:
-            for file_ in os.listdir(file_path):
-                if file_.startswith('result') and not file_.endswith('.old'):
+            # Prefer an index to the results it was converted from, unless
+            # they have been written again since
+            files = os.listdir(file_path)
+            if 'results.index' in files:
+                mtime = os.path.getmtime(os.path.join(file_path,
+                                                      'results.index'))
+                if all(os.path.getmtime(os.path.join(file_path, f)) <= mtime
+                       for f in files if f.startswith('results.json')):
+                    return _extension('results.index')
+
+            for file_ in files:
+                if (file_.startswith('result') and
+                        not file_.endswith(('.old', '.index', '.blobs',
+                                            '.tmp'))):
                     return _extension(file_)
 
         tests = os.path.join(file_path, 'tests')
@@ -0,0 +1,268 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Indexed results, which load the status of the tests without their output.
+
+Loading JSON results decodes the output, dmesg and command of every test,
+which is most of the file, even to compare the status of the tests. Indexed
+results split them in two files in the results directory:
+
+results.index holds the status table, uncompressed. Its first line is a
+magic string, the second the metadata of the run as a JSON object, and each
+following line a JSON array for a test: its name, the fields of the test
+result other than the ones in the blob file, and the offset and length of
+its blob.
+
+results.blobs holds, for each test, a zlib compressed JSON object of the
+fields in BLOB_FIELDS. Loading results gives TestResults that read their
+blob the first time one of those fields is used.
+
+The results are written with "piglit run -b indexed", or converted from
+other results with "piglit summary index".
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import collections
+import functools
+import os
+import threading
+import zlib
+
+try:
+    import simplejson as json
+except ImportError:
+    import json
+
+import six
+from six.moves import copyreg
+
+from framework import exceptions, results
+from .json import (JSONBackend, CURRENT_JSON_VERSION, piglit_encoder,
+                   _iter_final_tests)
+from .register import Registry
+
+__all__ = [
+    'REGISTRY',
+    'IndexedBackend',
+    'write_results',
+]
+
+INDEX = 'results.index'
+BLOBS = 'results.blobs'
+
+_MAGIC = 'PIGLIT-RESULTS-INDEX-1'
+
+# The fields of TestResult that are stored in the blob file
+BLOB_FIELDS = ['out', 'err', 'dmesg', 'command', 'environment', 'traceback',
+               'exception']
+
+
+def _dumps(obj):
+    return json.dumps(obj, default=piglit_encoder, separators=(',', ':'))
+
+
+def write_results(dest, metadata, tests):
+    """Write indexed results into the directory dest.
+
+    The files are written under temporary names and renamed when complete,
+    so a reader sees either the old files or the new ones.
+
+    Arguments:
+    dest     -- the results directory.
+    metadata -- a dict of the metadata of the run.
+    tests    -- an iterable of (name, result) pairs, where result is a
+                TestResult or its dict form.
+
+    """
+    index = os.path.join(dest, INDEX)
+    blobs = os.path.join(dest, BLOBS)
+
+    metadata = dict(metadata)
+    metadata.pop('tests', None)
+    metadata.pop('totals', None)
+    metadata['results_version'] = CURRENT_JSON_VERSION
+
+    with open(index + '.tmp', 'wb') as i, open(blobs + '.tmp', 'wb') as b:
+        i.write((_MAGIC + '\n').encode('utf-8'))
+        i.write((_dumps(metadata) + '\n').encode('utf-8'))
+
+        offset = 0
+        for name, result in tests:
+            if isinstance(result, results.TestResult):
+                result = result.to_json()
+            else:
+                result = dict(result)
+
+            blob = zlib.compress(_dumps(
+                {f: result.pop(f) for f in BLOB_FIELDS
+                 if f in result}).encode('utf-8'))
+            b.write(blob)
+
+            i.write((_dumps([name, result, offset, len(blob)]) +
+                     '\n').encode('utf-8'))
+            offset += len(blob)
+
+    os.rename(blobs + '.tmp', blobs)
+    os.rename(index + '.tmp', index)
+
+
+class _BlobFile(object):
+    """Reads the blobs of a blob file, opening it on first use."""
+
+    def __init__(self, filename):
+        self.__filename = filename
+        self.__file = None
+        self.__lock = threading.Lock()
+
+    def read(self, offset, length):
+        with self.__lock:
+            if self.__file is None:
+                self.__file = open(self.__filename, 'rb')
+            self.__file.seek(offset)
+            data = self.__file.read(length)
+        return json.loads(zlib.decompress(data).decode('utf-8'))
+
+
+class _BlobField(object):  # pylint: disable=too-few-public-methods
+    """A field of TestResult that is read from the blob file on first use.
+
+    Setting the field reads the blob as well, so that it doesn't overwrite
+    the new value later.
+
+    """
+    def __init__(self, name):
+        self.__field = results.TestResult.__dict__[name]
+
+    def __get__(self, instance, cls):
+        if instance is None:
+            return self
+        instance.load_blob()
+        return self.__field.__get__(instance, cls)
+
+    def __set__(self, instance, value):
+        instance.load_blob()
+        self.__field.__set__(instance, value)
+
+
+class LazyTestResult(results.TestResult):
+    """A TestResult whose BLOB_FIELDS are loaded when first used."""
+    __slots__ = ['_blob']
+
+    out = _BlobField('out')
+    err = _BlobField('err')
+    dmesg = _BlobField('dmesg')
+    command = _BlobField('command')
+    environment = _BlobField('environment')
+    traceback = _BlobField('traceback')
+    exception = _BlobField('exception')
+
+    def __init__(self, result=None):
+        self._blob = None
+        super(LazyTestResult, self).__init__(result)
+
+    def load_blob(self):
+        """Read the blob of the test, if it hasn't been read yet."""
+        if self._blob is None:
+            return
+        blob, self._blob = self._blob, None
+        for name, value in six.iteritems(blob()):
+            setattr(self, name, value)
+
+    def __getstate__(self):
+        # The blob file can't be pickled, so pickle the blob itself
+        self.load_blob()
+        return {n: getattr(self, n)
+                for n in copyreg._slotnames(type(self))  # pylint: disable=protected-access
+                if n != '_blob' and hasattr(self, n)}
+
+    def __setstate__(self, state):
+        self._blob = None
+        for name, value in six.iteritems(state):
+            setattr(self, name, value)
+
+
+def load_results(filename, compression_):  # pylint: disable=unused-argument
+    """Load indexed results, from a results directory or its index file.
+
+    The blobs of the tests are not read, see LazyTestResult.
+
+    """
+    if os.path.isdir(filename):
+        filename = os.path.join(filename, INDEX)
+    blobs = _BlobFile(os.path.join(os.path.dirname(filename), BLOBS))
+
+    with open(filename, 'rb') as f:
+        if f.readline().decode('utf-8').rstrip('\n') != _MAGIC:
+            raise exceptions.PiglitFatalError(
+                '"{}" is not a piglit results index.'.format(filename))
+
+        meta = json.loads(f.readline().decode('utf-8'))
+        if meta.get('results_version') != CURRENT_JSON_VERSION:
+            raise exceptions.PiglitFatalError(
+                'The results index "{}" is version {}, piglit reads version '
+                '{}. Convert the results again with "piglit summary '
+                'index".'.format(filename, meta.get('results_version'),
+                                 CURRENT_JSON_VERSION))
+
+        tests = collections.OrderedDict()
+        for line in f:
+            name, result, offset, length = json.loads(line.decode('utf-8'))
+            test = LazyTestResult.from_dict(result)
+            test._blob = functools.partial(blobs.read, offset, length)
+            tests[name] = test
+
+    meta['tests'] = {}
+    testrun = results.TestrunResult.from_dict(meta)
+    testrun.tests = tests
+    testrun.totals = collections.defaultdict(results.Totals)
+    testrun.calculate_group_totals()
+    return testrun
+
+
+class IndexedBackend(JSONBackend):
+    """Backend writing indexed results.
+
+    The tests are written to the journal as by the JSON backend, and
+    finalize composes them into results.index and results.blobs.
+
+    """
+    def _write_results(self, tests_dir, metadata=None):
+        with open(os.path.join(self._dest, 'metadata.json'), 'r') as f:
+            meta = json.load(f)
+        if metadata:
+            meta.update(metadata)
+
+        write_results(self._dest, meta, _iter_final_tests(tests_dir))
+
+
+def set_meta(results_):
+    """Set indexed results specific metadata on a TestrunResult."""
+    results_.results_version = CURRENT_JSON_VERSION
+
+
+REGISTRY = Registry(
+    extensions=['.index'],
+    backend=IndexedBackend,
+    load=load_results,
+    meta=set_meta,
+)
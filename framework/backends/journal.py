@@ -0,0 +1,191 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""An append-only journal of result records.
+
+The journal is a single file of records, each of which is a header of two
+big-endian 32-bit integers, the length of the payload and its CRC32, followed
+by the payload, a UTF-8 string. A record that was cut short by a crash or
+power loss fails the length or the checksum test, and it and everything after
+it are ignored by the reader and dropped when the journal is opened again for
+appending.
+
+Each record is written with a single write under a lock and flushed at once,
+so it is safe from the piglit process dying as soon as append() returns. When
+syncing is enabled the file is fsync'd by a separate thread, once per group of
+records or once the oldest record that has not been synced is old enough,
+rather than once per record.
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import atexit
+import os
+import struct
+import threading
+import time
+import zlib
+
+__all__ = [
+    'Journal',
+    'read_records',
+]
+
+_HEADER = struct.Struct('>II')
+
+# Sync after this many records...
+SYNC_RECORDS = 64
+
+# ...or when the oldest unsynced record is this many seconds old.
+SYNC_INTERVAL = 0.25
+
+
+def _scan(f):
+    """Yield (end offset, payload) for each complete record in a file."""
+    offset = 0
+    while True:
+        header = f.read(_HEADER.size)
+        if len(header) < _HEADER.size:
+            return
+        length, crc = _HEADER.unpack(header)
+        payload = f.read(length)
+        if len(payload) < length or zlib.crc32(payload) & 0xffffffff != crc:
+            return
+        offset += _HEADER.size + length
+        yield offset, payload.decode('utf-8')
+
+
+def read_records(filename):
+    """Yield the payload of every complete record in a journal, in order.
+
+    Reading stops at the first record that is incomplete or corrupt.
+    """
+    with open(filename, 'rb') as f:
+        for _, payload in _scan(f):
+            yield payload
+
+
+class Journal(object):
+    """Writer for a journal file.
+
+    Opening an existing journal drops any incomplete record at its end, so
+    that new records are appended after the last complete one.
+
+    Arguments:
+    filename -- the journal file, created if it doesn't exist.
+
+    Keyword Arguments:
+    sync          -- if True fsync the journal in groups of records.
+    sync_records  -- the number of records to write between syncs.
+    sync_interval -- the longest time in seconds that a record may stay
+                     unsynced.
+
+    """
+    def __init__(self, filename, sync=False, sync_records=SYNC_RECORDS,
+                 sync_interval=SYNC_INTERVAL):
+        self._sync_records = sync_records
+        self._sync_interval = sync_interval
+
+        valid = 0
+        if os.path.exists(filename):
+            with open(filename, 'rb') as f:
+                for valid, _ in _scan(f):
+                    pass
+        self._file = open(filename, 'ab')
+        self._file.truncate(valid)
+
+        self._cond = threading.Condition()
+        self._unsynced = 0
+        self._oldest = None
+        self._closed = False
+        self._error = None
+        self._thread = None
+
+        if sync:
+            self._thread = threading.Thread(target=self._syncer)
+            self._thread.daemon = True
+            self._thread.start()
+
+            # Sync what is left if the run is interrupted before the backend
+            # is finalized.
+            atexit.register(self.close)
+
+    def append(self, payload):
+        """Append a record holding the string payload."""
+        data = payload.encode('utf-8')
+        record = _HEADER.pack(len(data), zlib.crc32(data) & 0xffffffff) + data
+
+        with self._cond:
+            assert not self._closed, 'append() called on a closed journal'
+            self._file.write(record)
+            self._file.flush()
+
+            if self._thread is not None:
+                if self._unsynced == 0:
+                    self._oldest = time.time()
+                self._unsynced += 1
+                if self._unsynced >= self._sync_records:
+                    self._cond.notify()
+
+    def close(self):
+        """Sync any unsynced records, and close the file."""
+        with self._cond:
+            if self._closed:
+                return
+            self._closed = True
+            self._cond.notify()
+
+        if self._thread is not None:
+            self._thread.join()
+        self._file.close()
+
+        if self._error is not None:
+            raise self._error  # pylint: disable=raising-bad-type
+
+    def _syncer(self):
+        """Thread body: fsync the journal in groups of records."""
+        while True:
+            with self._cond:
+                while not self._closed and (
+                        self._unsynced < self._sync_records and
+                        (self._unsynced == 0 or time.time() - self._oldest <
+                         self._sync_interval)):
+                    if self._unsynced:
+                        self._cond.wait(max(0, self._oldest +
+                                            self._sync_interval - time.time()))
+                    else:
+                        self._cond.wait()
+
+                if self._closed and self._unsynced == 0:
+                    return
+                self._unsynced = 0
+                closed = self._closed
+
+            # Records appended while this runs are counted for the next sync
+            try:
+                os.fsync(self._file.fileno())
+            except OSError as e:
+                if self._error is None:
+                    self._error = e
+
+            if closed:
+                return
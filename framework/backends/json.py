@@ -24,11 +24,13 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import collections
+import contextlib
 import functools
 import os
 import posixpath
 import shutil
 import sys
+import threading
 
 try:
     import simplejson as json
@@ -42,8 +44,9 @@ try:
 except ImportError:
     _STREAMS = False
 
-from framework import status, results, exceptions, compat
+from framework import status, results, exceptions, compat, options
 from .abstract import FileBackend, write_compressed
+from .journal import Journal, read_records
 from .register import Registry
 from . import compression
 
@@ -61,6 +64,9 @@ MINIMUM_SUPPORTED_VERSION = 7
 # The level to indent a final file
 INDENT = 4
 
+# The name of the result journal in the tests directory
+JOURNAL = 'results.journal'
+
 
 def piglit_encoder(obj):
     """ Encoder for piglit that can transform additional classes into json
@@ -77,6 +83,52 @@ def piglit_encoder(obj):
     return obj
 
 
+def _iter_tests(tests_dir):
+    """Yield the {name: result} dicts written into a tests directory.
+
+    These are the per-test files written by older versions of piglit, which a
+    resumed run may still have, followed by the records of the journal. A test
+    can appear more than once, the last appearance is its final result.
+    """
+    file_list = sorted((p for p in os.listdir(tests_dir)
+                        if os.path.splitext(p)[1] == '.json'),
+                       key=lambda p: int(os.path.splitext(p)[0]))
+    for test in file_list:
+        # Try to open the json snippets. If we fail to open a test then throw
+        # the whole thing out. This gives us atomic writes, the writing worked
+        # and is valid or it didn't work.
+        try:
+            with open(os.path.join(tests_dir, test), 'r') as f:
+                yield json.load(f)
+        except ValueError:
+            pass
+
+    journal = os.path.join(tests_dir, JOURNAL)
+    if os.path.exists(journal):
+        for record in read_records(journal):
+            try:
+                yield json.loads(record)
+            except ValueError:
+                pass
+
+
+def _iter_final_tests(tests_dir):
+    """Yield each test of a tests directory once, with its final result.
+
+    This takes two passes over the records, so that only the records needed
+    for the last pass are held in memory at a time.
+    """
+    last = {}
+    for i, test in enumerate(_iter_tests(tests_dir)):
+        for name in test:
+            last[name] = i
+
+    for i, test in enumerate(_iter_tests(tests_dir)):
+        for name, value in six.iteritems(test):
+            if last[name] == i:
+                yield name, value
+
+
 class JSONBackend(FileBackend):
     """ Piglit's native JSON backend
 
@@ -84,14 +136,31 @@ class JSONBackend(FileBackend):
     json module or the simplejson.
 
     This class is atomic, writes either completely fail or completley succeed.
-    To achieve this it writes individual files for each test and for the
-    metadata, and composes them at the end into a single file and removes the
-    intermediate files. When it tries to compose these files if it cannot read
-    a file it just ignores it, making the result atomic.
+    To achieve this it appends a record for each test to a journal (see
+    framework.backends.journal), an incomplete one when the test starts and
+    the final one when it is done, and composes them at the end into a single
+    file. The journal ignores any record that was not completely written,
+    making the result atomic.
 
     """
     _file_extension = 'json'
 
+    __INCOMPLETE = results.TestResult(result=status.INCOMPLETE)
+
+    def __init__(self, dest, file_start_count=0, **kwargs):
+        super(JSONBackend, self).__init__(dest, file_start_count, **kwargs)
+        self.__journal = None
+        self.__journal_lock = threading.Lock()
+
+    def __get_journal(self):
+        """Open the journal on first use."""
+        with self.__journal_lock:
+            if self.__journal is None:
+                self.__journal = Journal(
+                    os.path.join(self._dest, 'tests', JOURNAL),
+                    sync=options.OPTIONS.sync)
+            return self.__journal
+
     def initialize(self, metadata):
         """ Write boilerplate json code
 
@@ -125,10 +194,22 @@ class JSONBackend(FileBackend):
         containers that are still open and closes the file
 
         """
-        tests_dir = os.path.join(self._dest, 'tests')
-        file_list = sorted(os.listdir(tests_dir),
-                           key=lambda p: int(os.path.splitext(p)[0]))
+        if self.__journal is not None:
+            self.__journal.close()
 
+        self._write_results(os.path.join(self._dest, 'tests'), metadata)
+
+        # Delete the temporary files
+        os.unlink(os.path.join(self._dest, 'metadata.json'))
+        shutil.rmtree(os.path.join(self._dest, 'tests'))
+
+    def _write_results(self, tests_dir, metadata=None):
+        """Write the final results from the journal in tests_dir.
+
+        This writes results.json, composed of metadata.json, the metadata
+        passed to finalize, and the final result of each test.
+
+        """
         # If jsonstreams is not present then build a complete tree of all of
         # the data and write it with json.dump
         if not _STREAMS:
@@ -145,20 +226,8 @@ class JSONBackend(FileBackend):
                 data.update(metadata)
 
             # Add the tests to the dictionary
-            data['tests'] = collections.OrderedDict()
-
-            for test in file_list:
-                test = os.path.join(tests_dir, test)
-                if os.path.isfile(test):
-                    # Try to open the json snippets. If we fail to open a test
-                    # then throw the whole thing out. This gives us atomic
-                    # writes, the writing worked and is valid or it didn't
-                    # work.
-                    try:
-                        with open(test, 'r') as f:
-                            data['tests'].update(json.load(f))
-                    except ValueError:
-                        pass
+            data['tests'] = collections.OrderedDict(
+                _iter_final_tests(tests_dir))
             assert data['tests']
 
             data = results.TestrunResult.from_dict(data)
@@ -186,21 +255,24 @@ class JSONBackend(FileBackend):
                         s.iterwrite(six.iteritems(metadata))
 
                     with s.subobject('tests') as t:
-                        for test in file_list:
-                            test = os.path.join(tests_dir, test)
-                            if os.path.isfile(test):
-                                try:
-                                    with open(test, 'r') as f:
-                                        a = json.load(f)
-                                except ValueError:
-                                    continue
+                        t.iterwrite(_iter_final_tests(tests_dir))
 
-                                t.iterwrite(six.iteritems(a))
+    @contextlib.contextmanager
+    def write_test(self, name):
+        """Write a test.
 
+        When this context manager is opened it appends a record with the
+        status incomplete to the journal, and calling the object it yields
+        appends a record with the final result, which replaces the first one.
 
-        # Delete the temporary files
-        os.unlink(os.path.join(self._dest, 'metadata.json'))
-        shutil.rmtree(os.path.join(self._dest, 'tests'))
+        """
+        journal = self.__get_journal()
+
+        def finish(val):
+            journal.append(json.dumps({name: val}, default=piglit_encoder))
+
+        finish(self.__INCOMPLETE)
+        yield finish
 
     @staticmethod
     def _write(f, name, data):
@@ -288,16 +360,8 @@ def _resume(results_dir):
     meta['tests'] = collections.OrderedDict()
 
     # Load all of the test names and added them to the test list
-    tests_dir = os.path.join(results_dir, 'tests')
-    file_list = sorted(os.listdir(tests_dir),
-                       key=lambda p: int(os.path.splitext(p)[0]))
-
-    for file_ in file_list:
-        with open(os.path.join(tests_dir, file_), 'r') as f:
-            try:
-                meta['tests'].update(json.load(f))
-            except ValueError:
-                continue
+    for test in _iter_tests(os.path.join(results_dir, 'tests')):
+        meta['tests'].update(test)
 
     return results.TestrunResult.from_dict(meta)
 
@@ -401,7 +465,7 @@ def _update_eight_to_nine(result):
 
 
 REGISTRY = Registry(
-    extensions=['.json'],
+    extensions=['.json', '.journal'],
     backend=JSONBackend,
     load=load_results,
     meta=set_meta,
@@ -91,6 +91,9 @@ class JUnitWriter(object):
         err.text = data.err
         err.text += '\n\npid: {}\nstart time: {}\nend time: {}\n'.format(
             data.pid, data.time.start, data.time.end)
+        if data.rusage is not None:
+            err.text += 'rusage: {}\n'.format(
+                json.dumps(data.rusage.to_json(), sort_keys=True))
 
         if data.result in ['fail', 'dmesg-warn', 'dmesg-fail']:
             if expected_result == "failure":
@@ -416,6 +419,10 @@ def _load(results_file):
             elif line.startswith('pid:'):
                 result.pid = json.loads(line[len('pid: '):])
                 continue
+            elif line.startswith('rusage:'):
+                result.rusage = results.RusageAttribute.from_dict(
+                    json.loads(line[len('rusage: '):]))
+                continue
 
 
         run_result.tests[name] = result
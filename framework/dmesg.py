@@ -21,8 +21,10 @@
 
 """ Module implementing classes for reading posix dmesg
 
-Currently this module only has the default DummyDmesg, and a LinuxDmesg.
-The method used on Linux requires that timetamps are enabled, and no other
+Currently this module only has the default DummyDmesg, a KmsgDmesg, and a
+LinuxDmesg. KmsgDmesg reads /dev/kmsg directly and works with concurrent
+test runs; LinuxDmesg is the fallback for when /dev/kmsg can't be read. The
+method used by LinuxDmesg requires that timetamps are enabled, and no other
 posix system has timestamps.
 
 On OSX and *BSD one would likely want to implement a system that reads the
@@ -39,10 +41,14 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import abc
+import collections
+import errno
 import gzip
+import os
 import re
 import subprocess
 import sys
+import threading
 import warnings
 
 import six
@@ -52,6 +58,7 @@ from framework import exceptions
 __all__ = [
     'BaseDmesg',
     'DummyDmesg',
+    'KmsgDmesg',
     'LinuxDmesg',
     'get_dmesg',
 ]
@@ -72,9 +79,12 @@ class BaseDmesg(object):
     This class is not thread safe, because it does not black between the start
     of the test and the reading of dmesg, which means that if two tests run at
     the same time, and test A creates an entri in dmesg, but test B finishes
-    first, test B will be marked as having the dmesg error.
+    first, test B will be marked as having the dmesg error. Subclasses that
+    can attribute messages to concurrent tests set concurrent to True.
 
     """
+    concurrent = False
+
     @abc.abstractmethod
     def __init__(self):
         # A list containing all messages since the last time dmesg was read.
@@ -112,6 +122,19 @@ class BaseDmesg(object):
         Arguments:
         result -- A TestResult instance
 
+        """
+        # Get a new snapshot of dmesg
+        self.update_dmesg()
+
+        return self._mark_result(result, self._new_messages)
+
+    def _mark_result(self, result, messages):
+        """ Update a TestResult with a list of new dmesg messages
+
+        If there are messages (that match regex, if it is set) replace the
+        results of the test and subtests, and store the messages in the
+        result.
+
         """
         def replace(res):
             """ helper to replace statuses with the new dmesg status
@@ -126,15 +149,12 @@ class BaseDmesg(object):
                 "fail": "dmesg-fail"
             }.get(res, res)
 
-        # Get a new snapshot of dmesg
-        self.update_dmesg()
-
         # if update_dmesg() found new entries replace the results of the test
         # and subtests
-        if self._new_messages:
+        if messages:
 
             if self.regex:
-                for line in self._new_messages:
+                for line in messages:
                     if self.regex.search(line):
                         break
                 else:
@@ -147,7 +167,7 @@ class BaseDmesg(object):
                 result.subtests[key] = replace(value)
 
             # Add the dmesg values to the result
-            result.dmesg = "\n".join(self._new_messages)
+            result.dmesg = "\n".join(messages)
 
         return result
 
@@ -227,6 +247,152 @@ class LinuxDmesg(BaseDmesg):
         return 'LinuxDmesg()'
 
 
+class KmsgDmesg(BaseDmesg):
+    """ Read dmesg from /dev/kmsg
+
+    This keeps /dev/kmsg open in non-blocking mode, and each update reads
+    only the records that were added since the last one, rather than running
+    dmesg and searching all of its output.
+
+    Every record has a sequence number, which the kernel assigns in the order
+    the messages are logged. update_dmesg(), called when a test starts,
+    remembers the sequence number of the last record for the calling thread,
+    and update_result(), called from the same thread when the test is done,
+    reports the records logged after it. This makes it work with concurrent
+    runs, with the caveat that a message logged while more than one test is
+    running is reported for all of them.
+
+    Anything that uses the /dev/kmsg record format can stand in for the
+    device, such as a FIFO or a plain file.
+
+    """
+    concurrent = True
+
+    DEVICE = '/dev/kmsg'
+
+    # The kernel returns one record per read, and fails the read with EINVAL
+    # if the buffer is too small for it.
+    _READ_SIZE = 8192
+
+    # Only report emerg, alert, crit, err, warn, and notice, like LinuxDmesg
+    _MAX_LEVEL = 5
+
+    def __init__(self, device=None):
+        """ Create a kmsg instance
+
+        Raises OSError if the device can't be opened.
+
+        Keyword Arguments:
+        device -- the file to read records from, DEVICE by default
+
+        """
+        self._fd = os.open(device or self.DEVICE, os.O_RDONLY | os.O_NONBLOCK)
+        self._lock = threading.Lock()
+        self._partial = b''
+        self._last_seq = -1
+
+        # (sequence number, message) for each record that may still be
+        # needed by a running test
+        self._records = collections.deque()
+
+        # The last sequence number seen when each running test started, by
+        # thread
+        self._starts = {}
+
+        super(KmsgDmesg, self).__init__()
+
+        # Messages from before the run are not interesting
+        self._starts.clear()
+        self._records.clear()
+
+    def _read(self):
+        """ Read all records that are available
+
+        The caller must hold _lock.
+
+        """
+        while True:
+            try:
+                data = os.read(self._fd, self._READ_SIZE)
+            except OSError as e:
+                if e.errno == errno.EAGAIN:
+                    break
+                elif e.errno == errno.EPIPE:
+                    # The ring buffer wrapped around, and records were lost
+                    # before we could read them. The next read returns the
+                    # oldest record that is left.
+                    continue
+                raise
+            if not data:
+                break
+
+            lines = (self._partial + data).split(b'\n')
+            self._partial = lines.pop()
+            for line in lines:
+                self._parse(line)
+
+    def _parse(self, line):
+        """ Parse a record, and store it if it is of interest
+
+        A record looks like "<prio>,<seq>,<usecs>,<flags>[,...];<message>",
+        and may be followed by continuation lines that start with a space.
+
+        """
+        if not line or line.startswith(b' '):
+            return
+        header, _, message = line.partition(b';')
+        try:
+            prio, seq, usecs = [int(f) for f in header.split(b',')[:3]]
+        except ValueError:
+            return
+
+        self._last_seq = seq
+        if prio & 7 > self._MAX_LEVEL:
+            return
+
+        # Use the same format as the dmesg command
+        self._records.append((seq, '[{:5d}.{:06d}] {}'.format(
+            usecs // 1000000, usecs % 1000000,
+            message.decode('utf-8', 'replace'))))
+
+    def update_dmesg(self):
+        """ Read new records, and start a window for the calling thread """
+        with self._lock:
+            self._read()
+            self._starts[threading.current_thread().ident] = self._last_seq
+
+    def update_result(self, result):
+        """ Takes a TestResult object and updates it with dmesg statuses
+
+        The messages are those logged since the calling thread last called
+        update_dmesg().
+
+        Arguments:
+        result -- A TestResult instance
+
+        """
+        with self._lock:
+            self._read()
+            start = self._starts.pop(threading.current_thread().ident,
+                                     self._last_seq)
+            messages = [m for seq, m in self._records if seq > start]
+
+            # Drop the records that no running test can need
+            oldest = min(six.itervalues(self._starts)) if self._starts \
+                else self._last_seq
+            while self._records and self._records[0][0] <= oldest:
+                self._records.popleft()
+
+        return self._mark_result(result, messages)
+
+    def __del__(self):
+        if getattr(self, '_fd', None) is not None:
+            os.close(self._fd)
+
+    def __repr__(self):
+        return 'KmsgDmesg()'
+
+
 class DummyDmesg(BaseDmesg):
     """ An dummy class for dmesg on non unix-like systems
 
@@ -257,9 +423,13 @@ def get_dmesg(not_dummy=True):
 
     Normally this does a system check, and returns the type that proper for
     your system. However, if Dummy is True then it will always return a
-    DummyDmesg instance.
+    DummyDmesg instance. On Linux KmsgDmesg is used if /dev/kmsg can be read,
+    otherwise LinuxDmesg.
 
     """
     if sys.platform.startswith('linux') and not_dummy:
-        return LinuxDmesg()
+        try:
+            return KmsgDmesg()
+        except OSError:
+            return LinuxDmesg()
     return DummyDmesg()
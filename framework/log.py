@@ -155,6 +155,9 @@ class QuietLog(BaseLog):
         with self._LOCK:
             self._print_summary()
             self._print('\n')
+            if self._state.get('efficiency') is not None:
+                sys.stdout.write('scheduling efficiency: {:.1%}\n'.format(
+                    self._state['efficiency']))
 
     def _print_summary(self):
         """ Print the summary result
@@ -360,6 +363,7 @@ class LogManager(object):
             'lastlength': 0,
             'complete': 0,
             'running': [],
+            'efficiency': None,
         }
         self._state_lock = threading.Lock()
 
@@ -371,3 +375,13 @@ class LogManager(object):
     def get(self):
         """ Return a new log instance """
         return self._log(self._state, self._state_lock)
+
+    def set_efficiency(self, efficiency):
+        """ Record how well the scheduler used the workers
+
+        This is the time spent running tests divided by the wall time times
+        the number of workers. It is printed with the final summary.
+
+        """
+        with self._state_lock:
+            self._state['efficiency'] = efficiency
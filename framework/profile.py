@@ -33,12 +33,15 @@ from __future__ import (
 import collections
 import contextlib
 import copy
+import hashlib
 import importlib
 import itertools
 import multiprocessing
-import multiprocessing.dummy
 import os
 import re
+import threading
+import time
+import zlib
 
 import six
 
@@ -50,10 +53,12 @@ from framework.test.base import Test
 
 __all__ = [
     'RegexFilter',
+    'Scheduler',
     'TestDict',
     'TestProfile',
     'load_test_profile',
     'run',
+    'shard',
 ]
 
 
@@ -361,26 +366,261 @@ def load_test_profile(filename):
             'Did you specify the right file?'.format(filename))
 
 
-def run(profiles, logger, backend, concurrency):
-    """Runs all tests using Thread pool.
+def shard(profiles, index, count, durations=None):
+    """Restrict a list of profiles to one shard of their tests.
+
+    The tests that pass the filters of the profiles are split into count
+    shards, and a filter is added to each profile that only lets the tests of
+    shard index (counting from 1) through. The split only depends on the
+    names of the tests (and on durations), so every machine that runs the
+    same profiles with the same options computes the same shards.
+
+    Without durations each test goes to the shard picked by a hash of its
+    name, which balances the number of tests in each shard, and keeps a test
+    in the same shard when others are added or removed. With durations from a
+    previous run the tests are dealt out longest first to the shard with the
+    least total duration so far, to balance the run time instead. Tests
+    without a duration are given the mean.
+
+    Returns a dict describing the shard, for the results metadata, which
+    allows the results of the shards to be checked when they are merged:
+    index and count, total (the number of tests in all shards), tests (the
+    number in this shard), and digest (a hash of the names of all tests).
+
+    Arguments:
+    profiles  -- a list of TestProfile instances.
+    index     -- the shard to run, from 1 to count.
+    count     -- the number of shards.
+    durations -- a dict mapping test names to their duration in seconds in a
+                 previous run, or None.
+    """
+    assert 1 <= index <= count, 'shard index out of range'
+
+    names = sorted(set(itertools.chain.from_iterable(
+        (n for n, _ in p.itertests()) for p in profiles)))
+
+    if durations:
+        default = sum(six.itervalues(durations)) / len(durations)
+        load = [0.0] * count
+        owner = {}
+        # Sorting by name as well makes ties deterministic
+        for name in sorted(names,
+                           key=lambda n: (-durations.get(n, default), n)):
+            i = min(range(count), key=lambda i: load[i])
+            owner[name] = i
+            load[i] += durations.get(name, default)
+        selected = frozenset(n for n in names if owner[n] == index - 1)
+    else:
+        # crc32 is stable between runs and python versions, unlike hash()
+        def bucket(name):
+            return (zlib.crc32(name.encode('utf-8')) & 0xffffffff) % count
+
+        selected = frozenset(n for n in names if bucket(n) == index - 1)
+
+    for p in profiles:
+        p.filters.append(lambda n, _: n in selected)
+
+    digest = hashlib.sha1()
+    for name in names:
+        digest.update(name.encode('utf-8') + b'\n')
+
+    return {
+        'index': index,
+        'count': count,
+        'total': len(names),
+        'tests': len(selected),
+        'digest': digest.hexdigest(),
+    }
+
+
+class Scheduler(object):
+    """Cost-aware work-stealing scheduler for running tests on threads.
+
+    Jobs are sorted by their expected duration, taken from a previous run when
+    one is available, and dealt out longest first to one queue per worker,
+    always to the queue with the least work so far. Each worker runs the jobs
+    of its own queue in order, and once that is empty it steals the cheapest
+    job from the queue with the most work left. Without any durations all of
+    the jobs cost the same and are dealt to a single queue, which the workers
+    share in profile order.
+
+    Tests that cannot run concurrently share a single serial slot: only one of
+    them runs at a time, but they run alongside the concurrent tests instead
+    of in a phase of their own after them. A worker whose next job needs the
+    slot while it is taken runs its next concurrent job instead.
+
+    The scheduler keeps track of the time spent in tests (busy) and of the
+    time the run took (wall), which give the share of the workers' time that
+    was used.
+
+    Arguments:
+    workers   -- the number of worker threads.
+    durations -- a dict mapping test names to their duration in seconds in a
+                 previous run. Tests without a duration are given the mean,
+                 if there are no durations at all tests start in profile
+                 order.
+    """
+    _Job = collections.namedtuple('_Job', ['cost', 'name', 'test', 'serial'])
+
+    def __init__(self, workers, durations=None):
+        self.workers = workers
+        self.durations = durations or {}
+        self.busy = 0.0
+        self.wall = 0.0
+
+        if self.durations:
+            self._default_cost = (sum(six.itervalues(self.durations)) /
+                                  len(self.durations))
+        else:
+            self._default_cost = 0.0
+
+        self._queues = [collections.deque() for _ in range(workers)]
+        self._load = [0.0] * workers
+        self._cond = threading.Condition()
+        self._serial_running = False
+        self._stopped = False
+        self._error = None
+
+    @property
+    def efficiency(self):
+        """The busy time divided by the time all of the workers had."""
+        if not self.wall:
+            return None
+        return self.busy / (self.wall * self.workers)
+
+    def cost(self, name):
+        """Return the expected duration of a test."""
+        return self.durations.get(name, self._default_cost)
+
+    def stop(self):
+        """Don't start any more jobs, running ones are allowed to finish."""
+        with self._cond:
+            self._stopped = True
+            self._cond.notify_all()
+
+    def _deal(self, jobs):
+        """Sort the jobs longest first and deal them out to the queues."""
+        # sorted() is stable, so equal costs keep profile order
+        for job in sorted(jobs, key=lambda j: j.cost, reverse=True):
+            index = min(range(self.workers), key=lambda i: self._load[i])
+            self._queues[index].append(job)
+            self._load[index] += job.cost
+
+    def _pop(self, index, reverse=False):
+        """Remove and return the first job of a queue that can run now."""
+        queue = self._queues[index]
+        order = range(len(queue) - 1, -1, -1) if reverse else range(len(queue))
+        for i in order:
+            job = queue[i]
+            if job.serial and self._serial_running:
+                continue
+            del queue[i]
+            self._load[index] -= job.cost
+            return job
+        return None
+
+    def _take(self, index):
+        """Pick the next job for a worker.
+
+        Must be called with the lock held. Returns a job, None if there is
+        nothing this worker can run right now, or False if there is no work
+        left at all.
+        """
+        job = self._pop(index)
+        if job is None:
+            victims = sorted(range(self.workers), key=lambda i: self._load[i],
+                             reverse=True)
+            # Without durations every job went to one queue, taking from
+            # its tail would run most of the profile backwards.
+            for victim in victims:
+                job = self._pop(victim, reverse=bool(self.durations))
+                if job is not None:
+                    break
+        if job is None and not any(self._queues):
+            return False
+        return job
+
+    def _worker(self, index, function):
+        """Thread body: run jobs until there are none left."""
+        while True:
+            with self._cond:
+                while True:
+                    if self._stopped:
+                        return
+                    job = self._take(index)
+                    if job is False:
+                        return
+                    if job is not None:
+                        break
+                    self._cond.wait()
+                if job.serial:
+                    self._serial_running = True
+
+            start = time.time()
+            try:
+                function(job.name, job.test)
+            except Exception as e:  # pylint: disable=broad-except
+                with self._cond:
+                    if self._error is None:
+                        self._error = e
+                    self._stopped = True
+            finally:
+                with self._cond:
+                    self.busy += time.time() - start
+                    if job.serial:
+                        self._serial_running = False
+                    self._cond.notify_all()
+
+    def run(self, tests, function, serial=lambda test: False):
+        """Run function(name, test) for each (name, test) pair in tests.
+
+        This blocks until all of the tests have run or stop() is called. If
+        function raises the run is stopped and the first exception is raised
+        again here.
+
+        Arguments:
+        tests    -- an iterable of (name, Test) pairs.
+        function -- the callable that runs a single test.
+        serial   -- a callable returning True for tests that must not run
+                    concurrently with each other.
+        """
+        self._deal(self._Job(self.cost(n), n, t, serial(t)) for n, t in tests)
+
+        threads = [threading.Thread(target=self._worker, args=(i, function))
+                   for i in range(self.workers)]
+        start = time.time()
+        for thread in threads:
+            thread.daemon = True
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.wall += time.time() - start
+
+        if self._error is not None:
+            raise self._error  # pylint: disable=raising-bad-type
+
+
+def run(profiles, logger, backend, concurrency, durations=None):
+    """Runs all tests using a Scheduler.
 
     When called this method will flatten out self.tests into self.test_list,
-    then will prepare a logger, and begin executing tests through it's Thread
-    pools.
+    then will prepare a logger, and begin executing tests through a Scheduler,
+    longest tests first when durations from a previous run are given.
 
     Based on the value of options.OPTIONS.concurrent it will either run all the
-    tests concurrently, all serially, or first the thread safe tests then the
-    serial tests.
+    tests concurrently, all serially, or the thread safe tests concurrently
+    with the serial tests one at a time alongside them.
 
-    Finally it will print a final summary of the tests.
+    Finally it will print a final summary of the tests, including how well the
+    workers were kept busy.
 
     Arguments:
-    profiles -- a list of Profile instances.
-    logger   -- a log.LogManager instance.
-    backend  -- a results.Backend derived instance.
+    profiles  -- a list of Profile instances.
+    logger    -- a log.LogManager instance.
+    backend   -- a results.Backend derived instance.
+    durations -- a dict mapping test names to their duration in seconds in a
+                 previous run, or None.
     """
-    chunksize = 1
-
     # The logger needs to know how many tests are running. Because of filters
     # there's no way to do that without making a concrete list out of the
     # filters profiles.
@@ -391,59 +631,47 @@ def run(profiles, logger, backend, concurrency):
     if not any(l for _, l in profiles):
         raise exceptions.PiglitUserError('no matching tests')
 
-    def test(name, test, profile, this_pool=None):
-        """Function to call test.execute from map"""
-        with backend.write_test(name) as w:
-            test.execute(name, log.get(), profile.options)
-            w(test.result)
-        if profile.options['monitor'].abort_needed:
-            this_pool.terminate()
-
-    def run_threads(pool, profile, test_list, filterby=None):
-        """ Open a pool, close it, and join it """
-        if filterby:
-            # Although filterby could be attached to TestProfile as a filter,
-            # it would have to be removed when run_threads exits, requiring
-            # more code, and adding side-effects
-            test_list = (x for x in test_list if filterby(x))
-
-        pool.imap(lambda pair: test(pair[0], pair[1], profile, pool),
-                  test_list, chunksize)
-
-    def run_profile(profile, test_list):
+    if concurrency == "none":
+        workers = 1
+    else:
+        workers = multiprocessing.cpu_count()
+
+    if concurrency == "some":
+        serial = lambda t: not t.run_concurrent
+    else:
+        assert concurrency in ["all", "none"]
+        serial = lambda t: False
+
+    def run_profile(profile, test_list, scheduler):
         """Run an individual profile."""
+        def test(name, test):
+            """Function to call test.execute from the scheduler"""
+            with backend.write_test(name) as w:
+                test.execute(name, log.get(), profile.options)
+                w(test.result)
+            if profile.options['monitor'].abort_needed:
+                scheduler.stop()
+
         profile.setup()
-        if concurrency == "all":
-            run_threads(multi, profile, test_list)
-        elif concurrency == "none":
-            run_threads(single, profile, test_list)
-        else:
-            assert concurrency == "some"
-            # Filter and return only thread safe tests to the threaded pool
-            run_threads(multi, profile, test_list,
-                        lambda x: x[1].run_concurrent)
-
-            # Filter and return the non thread safe tests to the single
-            # pool
-            run_threads(single, profile, test_list,
-                        lambda x: not x[1].run_concurrent)
-        profile.teardown()
-
-    # Multiprocessing.dummy is a wrapper around Threading that provides a
-    # multiprocessing compatible API
-    #
-    # The default value of pool is the number of virtual processor cores
-    single = multiprocessing.dummy.Pool(1)
-    multi = multiprocessing.dummy.Pool()
+        try:
+            scheduler.run(test_list, test, serial)
+        finally:
+            profile.teardown()
 
+    busy = wall = 0.0
     try:
-        for p in profiles:
-            run_profile(*p)
-
-        for pool in [single, multi]:
-            pool.close()
-            pool.join()
+        for p, test_list in profiles:
+            scheduler = Scheduler(workers, durations)
+            try:
+                run_profile(p, test_list, scheduler)
+            finally:
+                busy += scheduler.busy
+                wall += scheduler.wall
+            if p.options['monitor'].abort_needed:
+                break
     finally:
+        if wall:
+            log.set_efficiency(busy / (wall * workers))
         log.get().summary()
 
     for p, _ in profiles:
@@ -0,0 +1,196 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Merge the results of the shards of a run into a single results file.
+
+The shards are the results of "piglit run --shard K/N" for each K. Each of
+them records which shard it is and a digest of the names of the tests in all
+of the shards, which is used to check that they split the same list of tests,
+that each shard is present once, and that no test is missing or duplicated.
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import argparse
+import collections
+import copy
+import os
+import os.path as path
+
+import six
+
+from . import parsers
+from framework import backends, core, exceptions, results
+
+__all__ = [
+    'main',
+    'merge',
+]
+
+# The number of test names to list in errors about missing or duplicate tests
+_MAX_NAMES = 10
+
+
+def _format_names(names):
+    """Return a list of test names for an error message."""
+    names = sorted(names)
+    text = '\n'.join('    ' + n for n in names[:_MAX_NAMES])
+    if len(names) > _MAX_NAMES:
+        text += '\n    ... and {} more'.format(len(names) - _MAX_NAMES)
+    return text
+
+
+def merge(shards, allow_missing=False):
+    """Merge a list of TestrunResults of shards into one TestrunResult.
+
+    Raises PiglitFatalError if the results are not shards of the same run, or
+    if a shard or tests are missing (unless allow_missing is True), or if a
+    test is in more than one shard.
+
+    Arguments:
+    shards -- a list of TestrunResult instances, one per shard.
+
+    Keyword Arguments:
+    allow_missing -- if True merge shards even if some shards or tests are
+                     missing.
+    """
+    infos = []
+    for shard in shards:
+        info = shard.options.get('shard')
+        if not info:
+            raise exceptions.PiglitFatalError(
+                'Results "{}" are not from a sharded run.'.format(shard.name))
+        infos.append(info)
+
+    first = infos[0]
+    for shard, info in zip(shards, infos):
+        if (info['count'], info['digest']) != (first['count'],
+                                               first['digest']):
+            raise exceptions.PiglitFatalError(
+                'Results "{}" and "{}" are not shards of the same run: they '
+                'have a different number of shards or list of tests.'.format(
+                    shards[0].name, shard.name))
+
+    seen = collections.Counter(i['index'] for i in infos)
+    duplicates = sorted(i for i, c in six.iteritems(seen) if c > 1)
+    if duplicates:
+        raise exceptions.PiglitFatalError(
+            'Shard(s) {} given more than once.'.format(
+                ', '.join('{}/{}'.format(i, first['count'])
+                          for i in duplicates)))
+
+    problems = []
+    missing = [i for i in range(1, first['count'] + 1) if i not in seen]
+    if missing:
+        problems.append('Shard(s) {} missing.'.format(
+            ', '.join('{}/{}'.format(i, first['count']) for i in missing)))
+
+    merged = results.TestrunResult()
+    owner = {}
+    for shard, info in sorted(zip(shards, infos),
+                              key=lambda s: s[1]['index']):
+        duplicates = [n for n in shard.tests if n in owner]
+        if duplicates:
+            raise exceptions.PiglitFatalError(
+                'Tests in both shard {}/{} and shard {}/{}:\n{}'.format(
+                    owner[duplicates[0]], info['count'], info['index'],
+                    info['count'], _format_names(duplicates)))
+
+        if len(shard.tests) != info['tests']:
+            problems.append('Shard {}/{} has {} of its {} tests.'.format(
+                info['index'], info['count'], len(shard.tests),
+                info['tests']))
+
+        for name, test in six.iteritems(shard.tests):
+            owner[name] = info['index']
+            merged.tests[name] = test
+
+    if problems and not allow_missing:
+        raise exceptions.PiglitFatalError(
+            'The merged results would be incomplete, {} of {} tests are '
+            'missing:\n{}'.format(first['total'] - len(merged.tests),
+                                  first['total'], '\n'.join(problems)))
+
+    # Take the metadata from the first shard, they were run with the same
+    # options on identical machines.
+    base = shards[0]
+    for name in ['name', 'uname', 'glxinfo', 'wglinfo', 'clinfo', 'lspci']:
+        setattr(merged, name, getattr(base, name))
+    merged.options = copy.copy(base.options)
+    merged.options['shard'] = None
+    merged.time_elapsed = results.TimeAttribute(
+        start=min(s.time_elapsed.start for s in shards),
+        end=max(s.time_elapsed.end for s in shards))
+    backends.json.set_meta(merged)
+    merged.calculate_group_totals()
+
+    return merged
+
+
+@exceptions.handler
+def main(input_):
+    """Merge shard results into a single results directory."""
+    unparsed = parsers.parse_config(input_)[1]
+
+    # Adding the parent is necissary to get the help options
+    parser = argparse.ArgumentParser(parents=[parsers.CONFIG])
+    parser.add_argument('-n', '--name',
+                        metavar='<test name>',
+                        default=None,
+                        help='Name of the merged results, the name of the '
+                             'output directory by default')
+    parser.add_argument('-o', '--overwrite',
+                        action='store_true',
+                        help='If the output directory already exists, '
+                             'overwrite the results in it')
+    parser.add_argument('--allow-missing',
+                        action='store_true',
+                        help='Write the merged results even if shards or '
+                             'tests are missing')
+    parser.add_argument('output',
+                        type=path.realpath,
+                        metavar='<Output Path>',
+                        help='Directory to write the merged results to')
+    parser.add_argument('shards',
+                        metavar='<Shard Results Path(s)>',
+                        nargs='+',
+                        help='Space separated paths to the results of each '
+                             'shard')
+    args = parser.parse_args(unparsed)
+
+    merged = merge([backends.load(s) for s in args.shards],
+                   allow_missing=args.allow_missing)
+    merged.name = args.name or path.basename(args.output)
+
+    if (path.isdir(args.output) and os.listdir(args.output) and
+            not args.overwrite):
+        raise exceptions.PiglitFatalError(
+            'Cannot overwrite existing folder without the -o/--overwrite '
+            'option being set.')
+    core.check_dir(args.output)
+
+    outfile = os.path.join(args.output, 'results.json')
+    backends.json._write(merged, outfile)  # pylint: disable=protected-access
+
+    print('Merged {} tests from {} shards into: {}.{}'.format(
+        len(merged.tests), len(args.shards), outfile,
+        backends.compression.get_mode()))
@@ -54,6 +54,17 @@ def booltype(val):
         '"1" are accepted.')
 
 
+def shardtype(val):
+    """Parse a shard in the form K/N, and return (K, N)."""
+    match = re.match(r'^(\d+)/(\d+)$', val)
+    if match:
+        index, count = int(match.group(1)), int(match.group(2))
+        if 1 <= index <= count:
+            return (index, count)
+    raise argparse.ArgumentTypeError(
+        'A shard must be given as K/N, with 1 <= K <= N.')
+
+
 def _default_platform():
     """ Logic to determine the default platform to use
 
@@ -149,7 +160,8 @@ def _run_parser(input_):
     parser.add_argument("--dmesg",
                         action="store_true",
                         help="Capture a difference in dmesg before and "
-                             "after each test. Implies -1/--no-concurrency")
+                             "after each test. Implies -1/--no-concurrency "
+                             "unless /dev/kmsg can be read")
     parser.add_argument("--abort-on-monitored-error",
                         action="store_true",
                         dest="monitored",
@@ -207,6 +219,33 @@ def _run_parser(input_):
                              'isolation. This allows, but does not require, '
                              'tests to run multiple tests per process. '
                              'This value can also be set in piglit.conf.')
+    parser.add_argument('--shader-server',
+                        dest='shader_server',
+                        action='store',
+                        type=booltype,
+                        default=core.PIGLIT_CONFIG.safe_get(
+                            'core', 'shader server', 'false'),
+                        metavar='<bool>',
+                        help='Run shader_test files on one long lived '
+                             'shader_runner per thread, fed over a pipe, '
+                             'instead of starting a process per test. '
+                             'This value can also be set in piglit.conf.')
+    parser.add_argument('--durations-from',
+                        dest='durations_from',
+                        type=path.realpath,
+                        metavar='<Results Path>',
+                        help='Use the test durations of a previous run to '
+                             'start the longest tests first')
+    parser.add_argument('--shard',
+                        type=shardtype,
+                        metavar='<K/N>',
+                        help='Split the tests into N shards and run shard K '
+                             '(counting from 1). The split is by a hash of '
+                             'the test names, or by the test durations when '
+                             '--durations-from is given, so that the shards '
+                             'take the same time. Every shard must be run '
+                             'with the same profiles and options; combine '
+                             'their results with "piglit merge".')
     parser.add_argument("test_profile",
                         metavar="<Profile path(s)>",
                         nargs='+',
@@ -220,7 +259,7 @@ def _run_parser(input_):
     return parser.parse_args(unparsed)
 
 
-def _create_metadata(args, name, forced_test_list):
+def _create_metadata(args, name, forced_test_list, shard=None):
     """Create and return a metadata dict for Backend.initialize()."""
     opts = dict(options.OPTIONS)
     opts['profile'] = args.test_profile
@@ -230,9 +269,11 @@ def _create_metadata(args, name, forced_test_list):
     opts['exclude_filter'] = args.exclude_tests
     opts['dmesg'] = args.dmesg
     opts['monitoring'] = args.monitored
+    opts['durations_from'] = args.durations_from
     if args.platform:
         opts['platform'] = args.platform
     opts['forced_test_list'] = forced_test_list
+    opts['shard'] = shard
 
     metadata = {'options': opts}
     metadata['name'] = name
@@ -260,6 +301,20 @@ def _disable_windows_exception_messages():
         ctypes.windll.kernel32.SetErrorMode(uMode)
 
 
+def _load_durations(results_path):
+    """Return a dict of test names to durations from a previous run.
+
+    Returns None if results_path is None.
+    """
+    if results_path is None:
+        return None
+
+    results = backends.load(results_path)
+    return {name: result.time.total
+            for name, result in six.iteritems(results.tests)
+            if result.time.total > 0}
+
+
 def _results_handler(path):
     """Handler for core.check_dir."""
     if os.path.isdir(path):
@@ -279,9 +334,10 @@ def run(input_):
     args = _run_parser(input_)
     _disable_windows_exception_messages()
 
-    # If dmesg is requested we must have serial run, this is because dmesg
-    # isn't reliable with threaded run
-    if args.dmesg or args.monitored:
+    # If dmesg is requested we must have serial run, unless it can be read
+    # from /dev/kmsg, this is because dmesg isn't reliable with threaded run
+    dmesg_ = dmesg.get_dmesg(args.dmesg) if args.dmesg else None
+    if (dmesg_ and not dmesg_.concurrent) or args.monitored:
         args.concurrency = "none"
 
     # Pass arguments into Options
@@ -290,6 +346,7 @@ def run(input_):
     options.OPTIONS.sync = args.sync
     options.OPTIONS.deqp_mustpass = args.deqp_mustpass
     options.OPTIONS.process_isolation = args.process_isolation
+    options.OPTIONS.shader_server = args.shader_server
 
     # Set the platform to pass to waffle
     options.OPTIONS.env['PIGLIT_PLATFORM'] = args.platform
@@ -321,13 +378,6 @@ def run(input_):
             stripped = (t.split('#')[0].strip() for t in test_list)
             forced_test_list = [t for t in stripped if t]
 
-    backend = backends.get_backend(args.backend)(
-        args.results_path,
-        junit_suffix=args.junit_suffix,
-        junit_subtests=args.junit_subtests)
-    backend.initialize(_create_metadata(
-        args, args.name or path.basename(args.results_path), forced_test_list))
-
     profiles = [profile.load_test_profile(p) for p in args.test_profile]
     for p in profiles:
         p.results_dir = args.results_path
@@ -337,9 +387,9 @@ def run(input_):
         profiles[0].forced_test_list = forced_test_list
 
     # Set the dmesg type
-    if args.dmesg:
+    if dmesg_:
         for p in profiles:
-            p.options['dmesg'] = dmesg.get_dmesg(args.dmesg)
+            p.options['dmesg'] = dmesg_
 
     if args.monitored:
         for p in profiles:
@@ -352,9 +402,27 @@ def run(input_):
         if args.include_tests:
             p.filters.append(profile.RegexFilter(args.include_tests))
 
+    durations = _load_durations(args.durations_from)
+
+    # Sharding has to come after all of the other filters, since it splits
+    # the tests that they let through
+    shard = None
+    if args.shard:
+        shard = profile.shard(profiles, args.shard[0], args.shard[1],
+                              durations)
+
+    backend = backends.get_backend(args.backend)(
+        args.results_path,
+        junit_suffix=args.junit_suffix,
+        junit_subtests=args.junit_subtests)
+    backend.initialize(_create_metadata(
+        args, args.name or path.basename(args.results_path), forced_test_list,
+        shard))
+
     time_elapsed = TimeAttribute(start=time.time())
 
-    profile.run(profiles, args.log_level, backend, args.concurrency)
+    profile.run(profiles, args.log_level, backend, args.concurrency,
+                durations)
 
     time_elapsed.end = time.time()
     backend.finalize({'time_elapsed': time_elapsed.to_json()})
@@ -388,6 +456,7 @@ def resume(input_):
     options.OPTIONS.sync = results.options['sync']
     options.OPTIONS.deqp_mustpass = results.options['deqp_mustpass']
     options.OPTIONS.proces_isolation = results.options['process_isolation']
+    options.OPTIONS.shader_server = results.options.get('shader_server', False)
 
     core.get_config(args.config_file)
 
@@ -409,20 +478,26 @@ def resume(input_):
         if args.no_retry or result.result != 'incomplete':
             exclude_tests.add(name)
 
+    # The dmesg reader may not be the same one that the run started with
+    concurrency = results.options['concurrent']
+    dmesg_ = None
+    if results.options['dmesg']:
+        dmesg_ = dmesg.get_dmesg(results.options['dmesg'])
+        if not dmesg_.concurrent:
+            concurrency = 'none'
+
     profiles = [profile.load_test_profile(p)
                 for p in results.options['profile']]
     for p in profiles:
         p.results_dir = args.results_path
 
-        if results.options['dmesg']:
-            p.dmesg = dmesg.get_dmesg(results.options['dmesg'])
+        if dmesg_:
+            p.options['dmesg'] = dmesg_
 
         if results.options['monitoring']:
             p.options['monitor'] = monitoring.Monitoring(
                 results.options['monitoring'])
 
-        if exclude_tests:
-            p.filters.append(lambda n, _: n not in exclude_tests)
         if results.options['exclude_filter']:
             p.filters.append(
                 profile.RegexFilter(results.options['exclude_filter'],
@@ -434,12 +509,25 @@ def resume(input_):
         if results.options['forced_test_list']:
             p.forced_test_list = results.options['forced_test_list']
 
+    durations = _load_durations(results.options.get('durations_from'))
+
+    # The shard has to be computed from the same tests as in the original
+    # run, so before the completed tests are excluded
+    shard = results.options.get('shard')
+    if shard:
+        profile.shard(profiles, shard['index'], shard['count'], durations)
+
+    if exclude_tests:
+        for p in profiles:
+            p.filters.append(lambda n, _: n not in exclude_tests)
+
     # This is resumed, don't bother with time since it won't be accurate anyway
     profile.run(
         profiles,
         results.options['log_level'],
         backend,
-        results.options['concurrent'])
+        concurrency,
+        durations)
 
     backend.finalize()
 
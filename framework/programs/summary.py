@@ -23,6 +23,7 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import argparse
+import multiprocessing
 import shutil
 import os
 import os.path as path
@@ -39,6 +40,7 @@ __all__ = [
     'console',
     'csv',
     'html',
+    'index',
     'feature'
 ]
 
@@ -72,6 +74,26 @@ def html(input_):
                              "given as arguments. This speeds up HTML "
                              "generation, but reduces the info in the HTML "
                              "pages. May be used multiple times")
+    parser.add_argument("-j", "--jobs",
+                        type=int,
+                        default=multiprocessing.cpu_count(),
+                        metavar="<int>",
+                        help="The number of processes rendering the test "
+                             "pages (default: the number of CPUs)")
+    parser.add_argument("--incremental",
+                        action="store_true",
+                        help="Update an existing summary directory, only "
+                             "writing the test pages whose results changed "
+                             "since the last summary written there")
+    parser.add_argument("--group-pages",
+                        type=int,
+                        nargs="?",
+                        const=100,
+                        default=None,
+                        metavar="<tests per page>",
+                        help="Write one page per group of tests, split into "
+                             "pages of the given number of tests (default: "
+                             "100), rather than a page per test")
     parser.add_argument("summaryDir",
                         metavar="<Summary Directory>",
                         help="Directory to put HTML files in")
@@ -81,6 +103,11 @@ def html(input_):
                         help="Results files to include in HTML")
     args = parser.parse_args(unparsed)
 
+    if args.jobs < 1:
+        parser.error('-j/--jobs must be at least 1')
+    if args.group_pages is not None and args.group_pages < 1:
+        parser.error('--group-pages must be at least 1')
+
     # If args.list and args.resultsFiles are empty, then raise an error
     if not args.list and not args.resultsFiles:
         raise parser.error("Missing required option -l or <resultsFiles>")
@@ -102,19 +129,22 @@ def html(input_):
 
     # If the requested directory doesn't exist, create it or throw an error
     try:
-        core.check_dir(args.summaryDir, not args.overwrite)
+        core.check_dir(args.summaryDir,
+                       not (args.overwrite or args.incremental))
     except exceptions.PiglitException:
         raise exceptions.PiglitFatalError(
             '{} already exists.\n'
-            'use -o/--overwrite if you want to overwrite it.'.format(
-                args.summaryDir))
+            'use -o/--overwrite if you want to overwrite it, or '
+            '--incremental to update it.'.format(args.summaryDir))
 
     # Merge args.list and args.resultsFiles
     if args.list:
         args.resultsFiles.extend(core.parse_listfile(args.list))
 
     # Create the HTML output
-    summary.html(args.resultsFiles, args.summaryDir, args.exclude_details)
+    summary.html(args.resultsFiles, args.summaryDir, args.exclude_details,
+                 jobs=args.jobs, incremental=args.incremental,
+                 page_size=args.group_pages)
 
 
 @exceptions.handler
@@ -145,6 +175,36 @@ def console(input_):
                            const="incomplete",
                            dest='mode',
                            help="Only display tests that are incomplete.")
+    excGroup1.add_argument("-r", "--resources",
+                           action="store_const",
+                           const="resources",
+                           dest='mode',
+                           help="Display the tests that use the most CPU "
+                                "time, memory, page faults and context "
+                                "switches, and compare them between results "
+                                "files")
+    excGroup1.add_argument("-p", "--perf",
+                           action="store_const",
+                           const="perf",
+                           dest='mode',
+                           help="Display the perf medians of the tests, and "
+                                "compare them between the first and the last "
+                                "results files. Exits with status 1 if any "
+                                "regressed")
+    parser.add_argument("-t", "--top",
+                        action="store",
+                        type=int,
+                        default=10,
+                        metavar="<int>",
+                        help="The number of tests to display for each "
+                             "resource with -r/--resources (default: 10)")
+    parser.add_argument("--threshold",
+                        action="store",
+                        type=float,
+                        default=5.0,
+                        metavar="<percent>",
+                        help="The change of a median that is a regression or "
+                             "an improvement with -p/--perf (default: 5)")
     parser.add_argument("-l", "--list",
                         action="store",
                         help="Use test results from a list file")
@@ -166,7 +226,10 @@ def console(input_):
         args.results.extend(core.parse_listfile(args.list))
 
     # Generate the output
-    summary.console(args.results, args.mode or 'all')
+    regressions = summary.console(args.results, args.mode or 'all',
+                                  top=args.top, threshold=args.threshold)
+    if regressions:
+        sys.exit(1)
 
 
 @exceptions.handler
@@ -246,6 +309,41 @@ def aggregate(input_):
         outfile, backends.compression.get_mode()))
 
 
+@exceptions.handler
+def index(input_):
+    """Write indexed results from other results."""
+    unparsed = parsers.parse_config(input_)[1]
+
+    # Adding the parent is necissary to get the help options
+    parser = argparse.ArgumentParser(parents=[parsers.CONFIG])
+    parser.add_argument('results',
+                        metavar="<results path>",
+                        help="Path to a results directory or file")
+    parser.add_argument('-o', '--output',
+                        type=path.realpath,
+                        default=None,
+                        help="Directory to write results.index and "
+                             "results.blobs to. Default: the results "
+                             "directory, or the directory of the results "
+                             "file")
+    args = parser.parse_args(unparsed)
+
+    output = args.output
+    if output is None:
+        output = path.realpath(args.results)
+        if not path.isdir(output):
+            output = path.dirname(output)
+    core.check_dir(output)
+
+    testrun = backends.load(args.results)
+    metadata = testrun.to_json()
+    backends.indexed.write_results(output, metadata,
+                                   six.iteritems(testrun.tests))
+
+    print("Indexed results written to: {}".format(
+        path.join(output, backends.indexed.INDEX)))
+
+
 @exceptions.handler
 def feature(input_):
     parser = argparse.ArgumentParser()
@@ -27,6 +27,7 @@ from __future__ import (
 import collections
 import copy
 import datetime
+import sys
 
 import six
 
@@ -144,11 +145,67 @@ class TimeAttribute(object):
         return cls(**dict_)
 
 
+class RusageAttribute(object):
+    """Attribute of TestResult for resource usage.
+
+    This stores the resource usage of the test's processes as reported by
+    wait4(): user and system time in seconds, the maximum resident set size
+    in kilobytes, the major and minor page faults, and the voluntary and
+    involuntary context switches. A test that runs more than one process has
+    the sum of all of them, except for maxrss, which is the largest.
+
+    """
+    __slots__ = ['utime', 'stime', 'maxrss', 'minflt', 'majflt', 'nvcsw',
+                 'nivcsw']
+
+    def __init__(self, utime=0.0, stime=0.0, maxrss=0, minflt=0, majflt=0,
+                 nvcsw=0, nivcsw=0):
+        self.utime = utime
+        self.stime = stime
+        self.maxrss = maxrss
+        self.minflt = minflt
+        self.majflt = majflt
+        self.nvcsw = nvcsw
+        self.nivcsw = nivcsw
+
+    @classmethod
+    def from_rusage(cls, ru):
+        """Create an instance from a resource.struct_rusage."""
+        maxrss = ru.ru_maxrss
+        # OSX reports maxrss in bytes rather than kilobytes
+        if sys.platform == 'darwin':
+            maxrss //= 1024
+        return cls(utime=ru.ru_utime, stime=ru.ru_stime, maxrss=maxrss,
+                   minflt=ru.ru_minflt, majflt=ru.ru_majflt,
+                   nvcsw=ru.ru_nvcsw, nivcsw=ru.ru_nivcsw)
+
+    def add(self, other):
+        """Add the usage of another process to this one."""
+        for each in self.__slots__:
+            if each == 'maxrss':
+                self.maxrss = max(self.maxrss, other.maxrss)
+            else:
+                setattr(self, each, getattr(self, each) + getattr(other, each))
+
+    def to_json(self):
+        res = {k: getattr(self, k) for k in self.__slots__}
+        res['__type__'] = 'RusageAttribute'
+        return res
+
+    @classmethod
+    def from_dict(cls, dict_):
+        dict_ = copy.copy(dict_)
+
+        if '__type__' in dict_:
+            del dict_['__type__']
+        return cls(**dict_)
+
+
 class TestResult(object):
     """An object represting the result of a single test."""
     __slots__ = ['returncode', '_err', '_out', 'time', 'command', 'traceback',
                  'environment', 'subtests', 'dmesg', '__result', 'images',
-                 'exception', 'pid']
+                 'exception', 'pid', 'probes', 'perf', 'rusage']
     err = StringDescriptor('_err')
     out = StringDescriptor('_out')
 
@@ -159,10 +216,13 @@ class TestResult(object):
         self.environment = str()
         self.subtests = Subtests()
         self.dmesg = str()
-        self.images = None
+        self.images = []
         self.traceback = None
         self.exception = None
         self.pid = []
+        self.probes = []
+        self.perf = []
+        self.rusage = None
         if result:
             self.result = result
         else:
@@ -206,6 +266,11 @@ class TestResult(object):
             'traceback': self.traceback,
             'dmesg': self.dmesg,
             'pid': self.pid,
+            'probes': self.probes,
+            'perf': self.perf,
+            'images': self.images,
+            'rusage': (self.rusage.to_json() if self.rusage is not None
+                       else None),
         }
         return obj
 
@@ -225,7 +290,8 @@ class TestResult(object):
         inst = cls()
 
         for each in ['returncode', 'command', 'exception', 'environment',
-                     'traceback', 'dmesg', 'pid', 'result']:
+                     'traceback', 'dmesg', 'pid', 'probes', 'perf',
+                     'images', 'result']:
             if each in dict_:
                 setattr(inst, each, dict_[each])
 
@@ -234,6 +300,8 @@ class TestResult(object):
             inst.subtests = Subtests.from_dict(dict_['subtests'])
         if 'time' in dict_:
             inst.time = TimeAttribute.from_dict(dict_['time'])
+        if dict_.get('rusage'):
+            inst.rusage = RusageAttribute.from_dict(dict_['rusage'])
 
         # out and err must be set manually to avoid replacing the setter
         if 'out' in dict_:
@@ -248,13 +316,23 @@ class TestResult(object):
 
         Native piglit tests output their data as valid json, and piglit uses
         the json module to parse this data. This method consumes that raw
-        dictionary data and updates itself.
+        dictionary data and updates itself. Probe mismatch statistics
+        (PIGLIT_PROBE_STATS) are collected in the probes list, and timings
+        (cl-program-tester -profile and the tests in tests/perf) in the perf
+        list, and the frames that didn't match their golden image
+        (PIGLIT_GOLDEN_DIR) in the images list.
 
         """
         if 'result' in dict_:
             self.result = dict_['result']
         elif 'subtest' in dict_:
             self.subtests.update(dict_['subtest'])
+        elif 'probe' in dict_:
+            self.probes.append(dict_['probe'])
+        elif 'perf' in dict_:
+            self.perf.append(dict_['perf'])
+        elif 'image' in dict_:
+            self.images.append(dict_['image'])
 
 
 @compat.python_2_bool_compatible
@@ -25,6 +25,7 @@
 from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
+import collections
 import textwrap
 
 import six
@@ -89,6 +90,159 @@ def _print_summary(results):
             for x in results.results])))
 
 
+# The resource usage metrics, as (attribute, description, format) tuples.
+_RUSAGE_METRICS = [
+    ('utime', 'user time (s)', '{:.3f}'),
+    ('stime', 'system time (s)', '{:.3f}'),
+    ('maxrss', 'max RSS (kB)', '{:d}'),
+    ('majflt', 'major page faults', '{:d}'),
+    ('minflt', 'minor page faults', '{:d}'),
+    ('nvcsw', 'voluntary context switches', '{:d}'),
+    ('nivcsw', 'involuntary context switches', '{:d}'),
+]
+
+
+def _print_resources(results, top):
+    """Print the tests that use the most of each resource.
+
+    For each metric this prints the total of each run (the largest value for
+    maxrss), and the top tests by the largest value in any run, with the
+    value of each run. When there is more than one run, the change from the
+    first run to the last is printed as well.
+
+    """
+    def fmt(format_, value):
+        return '-' if value is None else format_.format(value)
+
+    def change(values):
+        if len(values) < 2 or values[0] is None or values[-1] is None:
+            return ''
+        if values[0] == 0:
+            return '' if values[-1] == 0 else ' (new)'
+        return ' ({:+.0%})'.format((values[-1] - values[0]) / values[0])
+
+    names = set()
+    for run in results.results:
+        names.update(n for n, r in six.iteritems(run.tests)
+                     if r.rusage is not None)
+
+    for attr, desc, format_ in _RUSAGE_METRICS:
+        values = {}
+        for name in names:
+            values[name] = []
+            for run in results.results:
+                test = run.tests.get(name)
+                values[name].append(
+                    getattr(test.rusage, attr)
+                    if test is not None and test.rusage is not None else None)
+
+        totals = []
+        for i in range(len(results.results)):
+            run_values = [v[i] for v in six.itervalues(values)
+                          if v[i] is not None]
+            if attr == 'maxrss':
+                totals.append(max(run_values) if run_values else None)
+            else:
+                totals.append(sum(run_values) if run_values else None)
+
+        print('{}:'.format(desc))
+        print('    total: {}{}'.format(
+            ' '.join(fmt(format_, t) for t in totals), change(totals)))
+
+        ranked = sorted(
+            names,
+            key=lambda n: (-max(v for v in values[n] if v is not None), n))
+        for name in ranked[:top]:
+            print('    {}: {}{}'.format(
+                grouptools.format(name),
+                ' '.join(fmt(format_, v) for v in values[name]),
+                change(values[name])))
+
+
+def _perf_key(record):
+    """Return the name of a perf record within its test."""
+    return ' '.join(six.text_type(record[k])
+                    for k in ['name', 'test', 'kernel_name', 'device']
+                    if k in record)
+
+
+def _perf_medians(record, prefix=''):
+    """Yield (path, median, ci95) for the medians in a perf record.
+
+    The medians are the "median" values of the record and of the objects
+    nested in it, for example "ns_per_iteration.median" or
+    "kernel.duration_ns.median". ci95 is the 95% confidence interval of the
+    median next to it, "median_ci95", or None. The "ci95" of the records is
+    the interval of the mean, which doesn't bound the median.
+
+    """
+    if 'median' in record:
+        yield (prefix + 'median', record['median'],
+               record.get('median_ci95'))
+    for key, value in six.iteritems(record):
+        if isinstance(value, dict):
+            for median in _perf_medians(value, prefix + key + '.'):
+                yield median
+
+
+def _print_perf(results, threshold):
+    """Print the perf medians of each test, and compare them between runs.
+
+    The medians are times, so a rise from the first run to the last of more
+    than threshold percent is a regression, and a drop of more than threshold
+    percent an improvement. When both runs have a 95% confidence interval
+    of a median, the change only counts if the intervals don't overlap.
+
+    Returns the number of regressions.
+
+    """
+    def fmt(value):
+        return '-' if value is None else '{:.3f}'.format(value)
+
+    names = set()
+    for run in results.results:
+        names.update(n for n, r in six.iteritems(run.tests) if r.perf)
+
+    regressions = 0
+    improvements = 0
+    for name in sorted(names):
+        metrics = collections.OrderedDict()
+        for i, run in enumerate(results.results):
+            test = run.tests.get(name)
+            for record in (test.perf if test is not None else []):
+                key = _perf_key(record)
+                for path, median, ci95 in _perf_medians(record):
+                    values = metrics.setdefault(
+                        (key, path), [(None, None)] * len(results.results))
+                    values[i] = (median, ci95)
+
+        print('{}:'.format(grouptools.format(name)))
+        for (key, path), values in six.iteritems(metrics):
+            (first, first_ci), (last, last_ci) = values[0], values[-1]
+            change = ''
+            if len(values) > 1 and first and last is not None:
+                ratio = (last - first) / first
+                change = ' ({:+.1%})'.format(ratio)
+                overlap = (first_ci is not None and last_ci is not None and
+                           first_ci[0] <= last_ci[1] and
+                           last_ci[0] <= first_ci[1])
+                if ratio * 100 > threshold and not overlap:
+                    change += ' regression'
+                    regressions += 1
+                elif ratio * 100 < -threshold and not overlap:
+                    change += ' improvement'
+                    improvements += 1
+
+            print('    {}{}{}: {}{}'.format(
+                key, ' ' if key else '', path,
+                ' '.join(fmt(v[0]) for v in values), change))
+
+    if len(results.results) > 1:
+        print('perf regressions: {}, improvements: {} (threshold '
+              '{:g}%)'.format(regressions, improvements, threshold))
+    return regressions
+
+
 def _print_result(results, list_):
     """Takes a list of test names to print and prints the name and result."""
     for test in sorted(list_):
@@ -97,9 +251,24 @@ def _print_result(results, list_):
             statuses=' '.join(str(r) for r in results.get_result(test))))
 
 
-def console(results, mode):
-    """ Write summary information to the console """
-    assert mode in ['summary', 'diff', 'incomplete', 'all'], mode
+def console(results, mode, top=10, threshold=5.0):
+    """ Write summary information to the console
+
+    Returns the number of perf regressions in 'perf' mode, else 0.
+
+    Arguments:
+    results -- a list of paths to results
+    mode    -- one of 'summary', 'diff', 'incomplete', 'resources', 'perf' or
+               'all'
+
+    Keyword Arguments:
+    top       -- the number of tests to list per metric in 'resources' mode
+    threshold -- the change in percent of a perf median that is a
+                 regression or an improvement in 'perf' mode
+
+    """
+    assert mode in ['summary', 'diff', 'incomplete', 'resources', 'perf',
+                    'all'], mode
     results = Results([backends.load(r) for r in results])
 
     # Print the name of the test and the status from each test run
@@ -113,3 +282,8 @@ def console(results, mode):
         _print_result(results, results.names.all_incomplete)
     elif mode == 'summary':
         _print_summary(results)
+    elif mode == 'resources':
+        _print_resources(results, top)
+    elif mode == 'perf':
+        return _print_perf(results, threshold)
+    return 0
@@ -25,20 +25,31 @@
 from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
+import collections
 import errno
 import getpass
+import hashlib
+import multiprocessing
 import os
+import posixpath
 import shutil
 import sys
 import tempfile
 
+try:
+    import simplejson as json
+except ImportError:
+    import json
+
 import mako
 from mako.lookup import TemplateLookup
 import six
 
 # a local variable status exists, prevent accidental overloading by renaming
 # the module
-from framework import backends, exceptions, core
+from framework import backends, exceptions, core, grouptools
+from framework.backends.json import piglit_encoder
+from framework.results import TestResult
 
 from .common import Results, escape_filename, escape_pathname
 from .feature import FeatResults
@@ -48,6 +59,14 @@ __all__ = [
     'feat'
 ]
 
+# The pages rendered by _render_page, and the templates they use. A change to
+# any of them changes the hash of every page.
+_PAGE_TEMPLATES = ['test_result.mako', 'test_group.mako', 'test_details.mako']
+
+# The file in the summary directory that records the hash of each page
+_MANIFEST = 'manifest.json'
+
+
 _TEMP_DIR = os.path.join(
     tempfile.gettempdir(),
     getpass.getuser(),
@@ -76,22 +95,176 @@ def _copy_static_files(destination):
                 os.path.join(destination, "result.css"))
 
 
-def _make_testrun_info(results, destination, exclude=None):
-    """Create the pages for each results file."""
+def _templates_hash():
+    """Return a hash of the templates of the test and group pages."""
+    digest = hashlib.sha1()
+    for name in _PAGE_TEMPLATES:
+        with open(os.path.join(_TEMPLATE_DIR, name), 'rb') as f:
+            digest.update(f.read())
+    return digest.hexdigest()
+
+
+def _render_page(task):
+    """Render a test or group page, unless it hasn't changed.
+
+    This is run in the processes of a multiprocessing pool, so it takes
+    everything it needs as arguments: a tuple of the summary directory, the
+    path of the page within it, the template, the hash of the templates, the
+    JSON data of the page, and the hash of the page when it was last written
+    or None.
+
+    Returns a (path, hash) tuple.
+
+    """
+    destination, page, template, templates_hash, data, old_hash = task
+
+    digest = hashlib.sha1()
+    digest.update(templates_hash.encode('utf-8'))
+    digest.update(template.encode('utf-8'))
+    digest.update(data.encode('utf-8'))
+    digest = digest.hexdigest()
+
+    path = os.path.join(destination, page)
+    if digest == old_hash and os.path.exists(path):
+        return page, digest
+
+    dirname = os.path.dirname(path)
+    core.check_dir(dirname)
+    data = json.loads(data)
+    if template == 'test_result.mako':
+        args = {
+            'testname': data['name'],
+            'value': TestResult.from_dict(data['value']),
+        }
+    else:
+        args = data
+        args['tests'] = [(n, a, TestResult.from_dict(v))
+                         for n, a, v in data['tests']]
+
+    with open(path, 'wb') as out:
+        out.write(_TEMPLATES.get_template(template).render(
+            css=os.path.relpath(os.path.join(destination, 'result.css'),
+                                dirname),
+            index=os.path.relpath(os.path.join(destination, 'index.html'),
+                                  dirname),
+            **args))
+
+    return page, digest
+
+
+def _group_pages(tests, exclude, page_size):
+    """Split the tests of a run into the pages of their groups.
+
+    Returns a list of (group, [names]) tuples, with the names of the tests
+    on each page, sorted, and pages of a group in order.
+
+    """
+    groups = collections.defaultdict(list)
+    for name, value in six.iteritems(tests):
+        if value.result not in exclude:
+            groups[grouptools.groupname(name)].append(name)
+
+    pages = []
+    for group in sorted(groups):
+        names = sorted(groups[group])
+        for i in range(0, len(names), page_size):
+            pages.append((group, names[i:i + page_size]))
+    return pages
+
+
+def _group_page_name(group, page):
+    """Return the file name of a page of a group."""
+    return '{}.{}.html'.format(escape_filename(group) or 'root', page)
+
+
+def _page_tasks(run, destination, exclude, page_size, old_pages,
+                templates_hash, hrefs):
+    """Yield the _render_page tasks of the test or group pages of a run.
+
+    This also fills hrefs with the link of each test of the run, relative
+    to the summary directory.
+
+    """
+    name = escape_pathname(run.name)
+
+    def task(page, template, data):
+        data = json.dumps(data, default=piglit_encoder, sort_keys=True)
+        return (destination, page, template, templates_hash, data,
+                old_pages.get(page))
+
+    if not page_size:
+        for key, value in six.iteritems(run.tests):
+            if value.result not in exclude:
+                page = os.path.join(name, escape_filename(key + ".html"))
+                hrefs[key] = posixpath.join(name,
+                                            escape_filename(key + ".html"))
+                yield task(page, 'test_result.mako',
+                           {'name': key, 'value': value.to_json()})
+        return
+
+    pages = _group_pages(run.tests, exclude, page_size)
+    counts = collections.Counter(g for g, _ in pages)
+    number = collections.Counter()
+    for group, names in pages:
+        number[group] += 1
+        current = number[group]
+        filename = _group_page_name(group, current)
+        for key in names:
+            hrefs[key] = '{}#{}'.format(posixpath.join(name, filename),
+                                        escape_filename(key))
+
+        yield task(os.path.join(name, filename), 'test_group.mako', {
+            'group': group or 'root',
+            'page': current,
+            'pages': counts[group],
+            'prev': (_group_page_name(group, current - 1)
+                     if current > 1 else None),
+            'next': (_group_page_name(group, current + 1)
+                     if current < counts[group] else None),
+            'tests': [(k, escape_filename(k), run.tests[k].to_json())
+                      for k in names],
+        })
+
+
+def _read_manifest(destination):
+    """Return the pages of the manifest of a summary directory."""
+    try:
+        with open(os.path.join(destination, _MANIFEST), 'r') as f:
+            return json.load(f)['pages']
+    except (IOError, OSError, ValueError, KeyError):
+        return {}
+
+
+def _make_testrun_info(results, destination, exclude=None, jobs=1,
+                       incremental=False, page_size=None):
+    """Create the pages for each results file.
+
+    The test pages, or the group pages when page_size is set, are rendered by
+    a pool of jobs processes. When incremental is True, pages whose hash is
+    the same as in the manifest of the last summary written to destination
+    are not written again, and pages of the last summary that are no longer
+    part of the summary are removed. The manifest is written in any case.
+
+    Returns a dict of the link of each test of each result, by result name.
+
+    """
     exclude = exclude or {}
-    result_css = os.path.join(destination, "result.css")
-    index = os.path.join(destination, "index.html")
+    old_pages = _read_manifest(destination) if incremental else {}
+    templates_hash = _templates_hash()
+    hrefs = {}
+    tasks = []
 
+    names = set()
     for each in results.results:
         name = escape_pathname(each.name)
-        try:
-            core.check_dir(os.path.join(destination, name), True)
-        except exceptions.PiglitException:
+        if name in names:
             raise exceptions.PiglitFatalError(
                 'Two or more of your results have the same "name" '
                 'attribute. Try changing one or more of the "name" '
                 'values in your json files.\n'
                 'Duplicate value: {}'.format(name))
+        names.add(name)
+        core.check_dir(os.path.join(destination, name))
 
         with open(os.path.join(destination, name, "index.html"), 'wb') as out:
             out.write(_TEMPLATES.get_template('testrun_info.mako').render(
@@ -104,26 +277,47 @@ def _make_testrun_info(results, destination, exclude=None):
                 clinfo=each.clinfo,
                 lspci=each.lspci))
 
-        # Then build the individual test results
-        for key, value in six.iteritems(each.tests):
-            html_path = os.path.join(destination, name,
-                                     escape_filename(key + ".html"))
-            temp_path = os.path.dirname(html_path)
+        # Then build the individual test or group pages
+        hrefs[each.name] = {}
+        tasks.append(_page_tasks(each, destination, exclude, page_size,
+                                 old_pages, templates_hash,
+                                 hrefs[each.name]))
+
+    tasks = (t for run in tasks for t in run)
+    if jobs > 1:
+        # Compile the templates once, rather than in each process
+        for template in _PAGE_TEMPLATES:
+            _TEMPLATES.get_template(template)
+        pool = multiprocessing.Pool(jobs)
+        try:
+            pages = dict(pool.imap_unordered(_render_page, tasks,
+                                             chunksize=16))
+        finally:
+            pool.terminate()
+            pool.join()
+    else:
+        pages = dict(_render_page(t) for t in tasks)
+
+    for page in six.iterkeys(old_pages):
+        if page not in pages:
+            try:
+                os.unlink(os.path.join(destination, page))
+            except OSError:
+                pass
 
-            if value.result not in exclude:
-                core.check_dir(temp_path)
+    with open(os.path.join(destination, _MANIFEST), 'w') as f:
+        json.dump({'pages': pages}, f)
 
-                with open(html_path, 'wb') as out:
-                    out.write(_TEMPLATES.get_template(
-                        'test_result.mako').render(
-                            testname=key,
-                            value=value,
-                            css=os.path.relpath(result_css, temp_path),
-                            index=os.path.relpath(index, temp_path)))
+    return hrefs
 
 
-def _make_comparison_pages(results, destination, exclude):
-    """Create the pages of comparisons."""
+def _make_comparison_pages(results, destination, exclude, hrefs):
+    """Create the pages of comparisons.
+
+    hrefs is the link of each test of each result, by result name, as
+    returned by _make_testrun_info.
+
+    """
     pages = frozenset(['changes', 'problems', 'skips', 'fixes',
                        'regressions', 'enabled', 'disabled'])
 
@@ -135,7 +329,8 @@ def _make_comparison_pages(results, destination, exclude):
             results=results,
             page='all',
             pages=pages,
-            exclude=exclude))
+            exclude=exclude,
+            hrefs=hrefs))
 
     # Generate the rest of the pages
     for page in pages:
@@ -146,7 +341,8 @@ def _make_comparison_pages(results, destination, exclude):
                     results=results,
                     pages=pages,
                     page=page,
-                    exclude=exclude))
+                    exclude=exclude,
+                    hrefs=hrefs))
             # otherwise provide an empty page
             else:
                 out.write(
@@ -162,7 +358,8 @@ def _make_feature_info(results, destination):
             results=results))
 
 
-def html(results, destination, exclude):
+def html(results, destination, exclude, jobs=1, incremental=False,
+         page_size=None):
     """
     Produce HTML summaries.
 
@@ -171,12 +368,15 @@ def html(results, destination, exclude):
     The beauty of this approach is that mako is leveraged to do the
     heavy lifting, this method just passes it a bunch of dicts and lists
     of dicts, which mako turns into pretty HTML.
+
+    See _make_testrun_info for jobs, incremental and page_size.
     """
     results = Results([backends.load(i) for i in results])
 
     _copy_static_files(destination)
-    _make_testrun_info(results, destination, exclude)
-    _make_comparison_pages(results, destination, exclude)
+    hrefs = _make_testrun_info(results, destination, exclude, jobs=jobs,
+                               incremental=incremental, page_size=page_size)
+    _make_comparison_pages(results, destination, exclude, hrefs)
 
 
 def feat(results, destination, feat_desc):
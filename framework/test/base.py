@@ -42,7 +42,7 @@ from six.moves import range
 from framework import exceptions
 from framework import status
 from framework.options import OPTIONS
-from framework.results import TestResult
+from framework.results import RusageAttribute, TestResult
 
 # We're doing some special crazy here to make timeouts work on python 2. pylint
 # is going to complain a lot
@@ -104,6 +104,33 @@ elif six.PY3:
 
 # pylint: enable=wrong-import-position,wrong-import-order
 
+if hasattr(os, 'wait4'):
+    class Popen(subprocess.Popen):  # pylint: disable=function-redefined
+        """Subclass of Popen that reaps the child with wait4().
+
+        This saves the resource usage of the child process in the rusage
+        attribute. It stays None if the child is reaped some other way, such
+        as by poll() after a timeout, or if the Popen implementation doesn't
+        reap through _try_wait() (python 2 without subprocess32).
+
+        """
+        rusage = None
+
+        def _try_wait(self, wait_flags):
+            try:
+                pid, sts, rusage = os.wait4(self.pid, wait_flags)
+            except OSError as e:
+                if e.errno != errno.ECHILD:
+                    raise
+                # The child was already reaped, or SIGCHLD is ignored; Popen
+                # handles this the same way
+                return (self.pid, 0)
+            if pid == self.pid:
+                self.rusage = rusage
+            return (pid, sts)
+
+    subprocess.Popen = Popen
+
 
 __all__ = [
     'Test',
@@ -363,17 +390,36 @@ class Test(object):
             # Since the process isn't running it's safe to get any remaining
             # stdout/stderr values out and store them.
             self.result.out, self.result.err = proc.communicate()
+            self._add_rusage(proc)
 
             raise TestRunError(
                 'Test run time exceeded timeout value ({} seconds)\n'.format(
                     self.timeout),
                 'timeout')
 
+        self._add_rusage(proc)
+
         # The setter handles the bytes/unicode conversion
         self.result.out = out
         self.result.err = err
         self.result.returncode = returncode
 
+    def _add_rusage(self, proc):
+        """Add the resource usage of a finished process to the result.
+
+        Tests that run more than one process, like the ReducedProcessMixin
+        and the WindowResizeMixin do, get the sum of all of them.
+
+        """
+        rusage = getattr(proc, 'rusage', None)
+        if rusage is None:
+            return
+        rusage = RusageAttribute.from_rusage(rusage)
+        if self.result.rusage is None:
+            self.result.rusage = rusage
+        else:
+            self.result.rusage.add(rusage)
+
     def __eq__(self, other):
         return self.command == other.command
 
@@ -30,14 +30,15 @@ import re
 import io
 import six
 
-from framework import exceptions
-from .base import TestIsSkip
-from .opengl import FastSkipMixin
+from framework import exceptions, status
+from .base import ReducedProcessMixin, TestIsSkip
+from .opengl import FastSkipMixin, FastSkip
 from .piglit_test import PiglitBaseTest, TEST_BIN_DIR
 
 __all__ = [
     'GLSLParserTest',
     'GLSLParserNoConfigError',
+    'MultiGLSLParserTest',
 ]
 
 # In different configurations piglit may have one or both of these.
@@ -89,7 +90,7 @@ class Parser(object):
     _CONFIG_KEYS = frozenset(['expect_result', 'glsl_version',
                               'require_extensions', 'check_link'])
 
-    def __init__(self, filepath):
+    def __init__(self, filepath, config=None):
         # a set that stores a list of keys that have been found already
         self.__found_keys = set()
         self.gl_required = set()
@@ -97,9 +98,13 @@ class Parser(object):
         self.glsl_version = None
 
         try:
-            with io.open(filepath, mode='r', encoding='utf-8') as testfile:
-                testfile = testfile.read()
-                self.config = self.parse(testfile, filepath)
+            # A config that was parsed earlier, for example by the test index,
+            # can be passed in to skip reading the file.
+            if config is None:
+                with io.open(filepath, mode='r', encoding='utf-8') as testfile:
+                    testfile = testfile.read()
+                    config = self.parse(testfile, filepath)
+            self.config = config
             self.command = self.get_command(filepath)
         except GLSLParserInternalError as e:
             raise exceptions.PiglitFatalError(
@@ -270,10 +275,14 @@ class GLSLParserTest(FastSkipMixin, PiglitBaseTest):
     Arguments:
     filepath -- the path to a glsl_parser_test which must end in .vert,
                 .tesc, .tese, .geom or .frag
+
+    Keyword Arguments:
+    config -- the config block of the test as returned by Parser.parse, if
+              it has already been parsed.
     """
 
-    def __init__(self, filepath):
-        parsed = Parser(filepath)
+    def __init__(self, filepath, config=None):
+        parsed = Parser(filepath, config)
         super(GLSLParserTest, self).__init__(
             parsed.command,
             run_concurrent=True,
@@ -287,3 +296,94 @@ class GLSLParserTest(FastSkipMixin, PiglitBaseTest):
                              'but only an OpenGL ES binary has been built')
 
         super(GLSLParserTest, self).is_skip()
+
+
+class MultiGLSLParserTest(ReducedProcessMixin, PiglitBaseTest):
+    """A GLSLParserTest class that can run more than one test at a time.
+
+    This runs glslparsertest with -report-subtests and the arguments of many
+    test files, each of which is reported as a subtest named after its file.
+    All of the files must use the same glslparsertest binary, see
+    Parser.pick_binary.
+
+    Arguments:
+    filenames -- a list of absolute paths to glslparser test files
+
+    Keyword Arguments:
+    configs -- a list of the config blocks of the files, as for
+               GLSLParserTest, None entries are parsed here.
+    """
+
+    def __init__(self, filenames, configs=None):
+        assert filenames
+        prog = None
+        args = []
+        offsets = []
+        subtests = []
+        skips = []
+
+        for each, config in zip(filenames, configs or [None] * len(filenames)):
+            parser = Parser(each, config)
+            subtest = os.path.basename(each)
+
+            if prog is None:
+                prog = parser.command[0]
+            elif parser.command[0] != prog:
+                raise exceptions.PiglitInternalError(
+                    'GLES and GL glslparser tests in the same command!\n'
+                    'Cannot pick a glslparsertest binary!')
+
+            try:
+                if prog == 'None':
+                    raise TestIsSkip('Test is for desktop OpenGL, but only '
+                                     'an OpenGL ES binary has been built')
+                FastSkip(gl_required=parser.gl_required,
+                         glsl_version=parser.glsl_version,
+                         glsl_es_version=parser.glsl_es_version).test()
+            except TestIsSkip:
+                skips.append(subtest)
+                continue
+
+            # The offset of the test's arguments in the command
+            offsets.append(len(args) + 1)
+            args.extend(parser.command[1:])
+            subtests.append(subtest)
+
+        super(MultiGLSLParserTest, self).__init__(
+            [prog] + args,
+            subtests=subtests,
+            run_concurrent=True)
+        self._offsets = offsets
+
+        for name in skips:
+            self.result.subtests[name] = status.SKIP
+
+    @PiglitBaseTest.command.getter  # pylint: disable=no-member
+    def command(self):
+        """Add -report-subtests to the test command."""
+        return self._command + ['-report-subtests']
+
+    def _is_subtest(self, line):
+        return line.startswith('PIGLIT TEST:')
+
+    def _resume(self, current):
+        command = [self.command[0]]
+        command.extend(self.command[self._offsets[current]:])
+        return command
+
+    def _stop_status(self):
+        # Requirements that glslparsertest checks once per process, rather
+        # than per test, skip the whole process. Mark the test it stopped at
+        # as skip, the rest will be tried when resuming.
+        if self.result.out.endswith('PIGLIT: {"result": "skip" }\n'):
+            return status.SKIP
+        if self.result.returncode > 0:
+            return status.FAIL
+        return status.CRASH
+
+    def _is_cherry(self):
+        # A skip for the whole process exits with status 0, but leaves the
+        # rest of the tests unrun.
+        return (
+            self.result.returncode == 0 and not
+            self.result.out.endswith('PIGLIT: {"result": "skip" }\n'))
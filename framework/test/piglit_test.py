@@ -27,17 +27,20 @@ from __future__ import (
 )
 import glob
 import os
+import re
 import sys
 try:
     import simplejson as json
 except ImportError:
     import json
 
-from framework import core, options
-from .base import Test, WindowResizeMixin, ValgrindMixin, TestIsSkip
+from framework import core, options, status
+from .base import (Test, WindowResizeMixin, ValgrindMixin, TestIsSkip,
+                   ReducedProcessMixin)
 
 
 __all__ = [
+    'MultiCLProgramTest',
     'PiglitCLTest',
     'PiglitGLTest',
     'PiglitBaseTest',
@@ -54,6 +57,9 @@ else:
 CL_CONCURRENT = (not sys.platform.startswith('linux') or
                  glob.glob('/dev/dri/render*'))
 
+# The result line printed when a test exits the process
+_RESULT = re.compile(r'PIGLIT: {"result": "(?P<result>[a-z]+)" }\n$')
+
 
 class PiglitBaseTest(ValgrindMixin, Test):
     """
@@ -79,6 +85,12 @@ class PiglitBaseTest(ValgrindMixin, Test):
 
         self.result.out = '\n'.join(out)
 
+        # A frame that doesn't match its golden image is a rendering change
+        # the test's own checks didn't catch.
+        if self.result.result == status.PASS and any(
+                i.get('status') == 'mismatch' for i in self.result.images):
+            self.result.result = status.WARN
+
         super(PiglitBaseTest, self).interpret_result()
 
 
@@ -167,3 +179,50 @@ class PiglitCLTest(PiglitBaseTest):  # pylint: disable=too-few-public-methods
     """
     def __init__(self, command, run_concurrent=CL_CONCURRENT, **kwargs):
         super(PiglitCLTest, self).__init__(command, run_concurrent, **kwargs)
+
+
+class MultiCLProgramTest(ReducedProcessMixin, PiglitCLTest):
+    """Run many OpenCL program tests in one cl-program-tester process.
+
+    cl-program-tester -report-subtests runs each file as a test, reusing the
+    OpenCL contexts and the programs built by the earlier tests, and reports
+    it as a subtest named after the file without its extension.
+
+    Arguments:
+    filenames -- a list of paths to .cl and .program_test files
+    """
+
+    def __init__(self, filenames):
+        assert filenames
+        self._files = list(filenames)
+        super(MultiCLProgramTest, self).__init__(
+            ['cl-program-tester'] + self._files,
+            subtests=[os.path.splitext(os.path.basename(f))[0]
+                      for f in self._files])
+
+    @PiglitBaseTest.command.getter  # pylint: disable=no-member
+    def command(self):
+        """Add -report-subtests to the test command."""
+        return self._command + ['-report-subtests']
+
+    def _is_subtest(self, line):
+        return line.startswith('PIGLIT TEST:')
+
+    def _resume(self, current):
+        return [self.command[0]] + self._files[current:] + \
+            ['-report-subtests']
+
+    def _stop_status(self):
+        # An invalid test configuration, or a requirement that isn't met,
+        # exits the process with a result. Use it for the test it stopped
+        # at, the rest are run when resuming.
+        match = _RESULT.search(self.result.out)
+        if match is not None and self.result.returncode >= 0:
+            return status.status_lookup(match.group('result'))
+        return status.CRASH
+
+    def _is_cherry(self):
+        # After the last test the process exits with status 0 without
+        # printing a result line of its own.
+        return (self.result.returncode == 0 and
+                _RESULT.search(self.result.out) is None)
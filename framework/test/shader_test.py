@@ -26,13 +26,25 @@
 from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
+import atexit
+import errno
 import io
+import itertools
 import os
 import re
+import select
+import sys
+import tempfile
+import threading
+import time
+
+import six
 
 from framework import exceptions
 from framework import status
-from .base import ReducedProcessMixin, TestIsSkip
+from framework.options import OPTIONS
+from .base import (ReducedProcessMixin, TestIsSkip, TestRunError, subprocess,
+                   _EXTRA_POPEN_ARGS, _SUPPRESS_TIMEOUT)
 from .opengl import FastSkipMixin, FastSkip
 from .piglit_test import PiglitBaseTest
 
@@ -40,6 +52,163 @@ __all__ = [
     'ShaderTest',
 ]
 
+_END_MARKER = b'PIGLIT TEST END:'
+_START_MARKER = b'PIGLIT TEST:'
+
+
+class ShaderRunnerServer(object):
+    """A long lived shader_runner process fed test files over stdin.
+
+    shader_runner started with -server runs the file on its command line, then
+    reads more paths from stdin, one per line. Each test's stdout ends with a
+    'PIGLIT TEST END:' line, and stderr goes to a temporary file which is read
+    back after each test. If the process exits before the end marker the
+    test being run is the one that took it down, its output and return code
+    are reported for that test alone, and the next test starts a fresh
+    process.
+    """
+
+    def __init__(self, prog, env):
+        self.prog = prog
+        self.env = env
+        self.pid = None
+        self.__proc = None
+        self.__err = None
+        self.__err_offset = 0
+        self.__buffer = b''
+
+    @property
+    def running(self):
+        return self.__proc is not None
+
+    def __start(self, filename):
+        self.__err = tempfile.TemporaryFile()
+        self.__err_offset = 0
+        self.__buffer = b''
+        self.__proc = subprocess.Popen(
+            [self.prog, filename, '-auto', '-fbo', '-server'],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=self.__err,
+            env=self.env,
+            **_EXTRA_POPEN_ARGS)
+        self.pid = self.__proc.pid
+
+    def __send(self, filename):
+        """Queue a file on a running server, return False if it has died."""
+        try:
+            self.__proc.stdin.write(filename.encode('utf-8') + b'\n')
+            self.__proc.stdin.flush()
+        except (IOError, OSError) as e:
+            if e.errno not in (errno.EPIPE, errno.EINVAL):
+                raise
+            return False
+        return True
+
+    def __readline(self, deadline, timeout):
+        """Read one line from stdout.
+
+        Returns None at end of file, raises subprocess.TimeoutExpired if the
+        deadline passes, after killing the server.
+        """
+        fd = self.__proc.stdout.fileno()
+        while b'\n' not in self.__buffer:
+            wait = None
+            if deadline is not None:
+                wait = deadline - time.time()
+                if wait <= 0:
+                    self.stop(kill=True)
+                    raise subprocess.TimeoutExpired(self.prog, timeout)
+            ready, _, _ = select.select([fd], [], [], wait)
+            if not ready:
+                continue
+            data = os.read(fd, 65536)
+            if not data:
+                return None
+            self.__buffer += data
+
+        line, self.__buffer = self.__buffer.split(b'\n', 1)
+        return line + b'\n'
+
+    def __read_err(self):
+        self.__err.seek(self.__err_offset)
+        err = self.__err.read()
+        self.__err_offset += len(err)
+        return err
+
+    def run(self, filename, timeout=None):
+        """Run one file, returns a tuple of (stdout, stderr, returncode).
+
+        The return code is 0 while the server survives the test, otherwise it
+        is the exit status of the process.
+        """
+        if self.__proc is None or not self.__send(filename):
+            self.stop()
+            self.__start(filename)
+
+        deadline = time.time() + timeout if timeout else None
+        out = []
+        while True:
+            line = self.__readline(deadline, timeout)
+            if line is None:
+                out.append(self.__buffer)
+                err = self.__read_err()
+                returncode = self.__proc.wait()
+                self.stop()
+                break
+            if line.startswith(_END_MARKER):
+                err = self.__read_err()
+                returncode = 0
+                break
+            if not line.startswith(_START_MARKER):
+                out.append(line)
+
+        return (b''.join(out).decode('utf-8', 'replace'),
+                err.decode('utf-8', 'replace'),
+                returncode)
+
+    def stop(self, kill=False):
+        """Stop the server, killing it if requested or if it hangs."""
+        proc, self.__proc = self.__proc, None
+        if proc is not None:
+            if kill:
+                proc.kill()
+            else:
+                try:
+                    proc.stdin.close()
+                except (IOError, OSError):
+                    pass
+            proc.wait()
+            proc.stdout.close()
+        if self.__err is not None:
+            self.__err.close()
+            self.__err = None
+
+
+_SERVERS = threading.local()
+_ALL_SERVERS = []
+_ALL_SERVERS_LOCK = threading.Lock()
+
+
+def _get_server(prog, env):
+    """Return this thread's server for prog, creating it if needed."""
+    servers = getattr(_SERVERS, 'servers', None)
+    if servers is None:
+        servers = _SERVERS.servers = {}
+    if prog not in servers:
+        servers[prog] = ShaderRunnerServer(prog, env)
+        with _ALL_SERVERS_LOCK:
+            _ALL_SERVERS.append(servers[prog])
+    return servers[prog]
+
+
+@atexit.register
+def _stop_servers():
+    with _ALL_SERVERS_LOCK:
+        for server in _ALL_SERVERS:
+            server.stop()
+        del _ALL_SERVERS[:]
+
 
 class Parser(object):
     """An object responsible for parsing a shader_test file."""
@@ -126,6 +295,25 @@ class Parser(object):
         else:
             self.prog = 'shader_runner'
 
+    def to_index(self):
+        """Return the parsed values as a tuple of plain python values.
+
+        This is what the test index stores, see from_index.
+        """
+        return (self.prog, sorted(self.gl_required), self._gl_version,
+                self._gles_version, self._glsl_version, self._glsl_es_version,
+                self.__op, self.__sl_op)
+
+    @classmethod
+    def from_index(cls, filename, values):
+        """Create a parser for filename from the values of to_index."""
+        parser = cls(filename)
+        (parser.prog, gl_required, parser._gl_version, parser._gles_version,
+         parser._glsl_version, parser._glsl_es_version, parser.__op,
+         parser.__sl_op) = values
+        parser.gl_required = set(gl_required)
+        return parser
+
     # FIXME: All of these properties are a work-around for the fact that the
     # FastSkipMixin assumes that operations are always > or >=
 
@@ -152,11 +340,18 @@ class ShaderTest(FastSkipMixin, PiglitBaseTest):
     This function parses a shader test to determine if it's a GL, GLES2 or
     GLES3 test, and then returns a PiglitTest setup properly.
 
+    Arguments:
+    filename -- the path to the shader_test file
+
+    Keyword Arguments:
+    parser -- a Parser for the file that has already been parsed.
+
     """
 
-    def __init__(self, filename):
-        parser = Parser(filename)
-        parser.parse()
+    def __init__(self, filename, parser=None):
+        if parser is None:
+            parser = Parser(filename)
+            parser.parse()
 
         super(ShaderTest, self).__init__(
             [parser.prog, parser.filename],
@@ -176,6 +371,42 @@ class ShaderTest(FastSkipMixin, PiglitBaseTest):
     def command(self, new):
         self._command = [n for n in new if n not in ['-auto', '-fbo']]
 
+    def _run_command(self, *args, **kwargs):
+        """Run the test on this thread's shader_runner server if enabled.
+
+        Tests with their own environment or running under valgrind still get a
+        process of their own, as does everything on windows, where select()
+        doesn't work on pipes.
+        """
+        if (not OPTIONS.shader_server or OPTIONS.valgrind or self.env or
+                sys.platform == 'win32' or kwargs):
+            super(ShaderTest, self)._run_command(*args, **kwargs)
+            return
+
+        env = {six.text_type(k): six.text_type(v) for k, v in
+               itertools.chain(six.iteritems(os.environ),
+                               six.iteritems(OPTIONS.env))}
+        server = _get_server(self._command[0], env)
+
+        try:
+            out, err, returncode = server.run(
+                self._command[1],
+                None if _SUPPRESS_TIMEOUT else self.timeout)
+        except OSError as e:
+            if e.errno == errno.ENOENT:
+                raise TestRunError("Test executable not found.\n", 'skip')
+            raise
+        except subprocess.TimeoutExpired:
+            raise TestRunError(
+                'Test run time exceeded timeout value ({} seconds)\n'.format(
+                    self.timeout),
+                'timeout')
+
+        self.result.pid.append(server.pid)
+        self.result.out = out
+        self.result.err = err
+        self.result.returncode = returncode
+
 
 class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
     """A Shader class that can run more than one test at a time.
@@ -186,9 +417,13 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
 
     Arguments:
     filenames -- a list of absolute paths to shader test files
+
+    Keyword Arguments:
+    parsers -- a list of Parsers for the files that have already been parsed,
+               None entries are parsed here.
     """
 
-    def __init__(self, filenames):
+    def __init__(self, filenames, parsers=None):
         assert filenames
         prog = None
         files = []
@@ -198,9 +433,10 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
         # Walk each subtest, and either add it to the list of tests to run, or
         # determine it is skip, and set the result of that test in the subtests
         # dictionary to skip without adding it ot the liest of tests to run
-        for each in filenames:
-            parser = Parser(each)
-            parser.parse()
+        for each, parser in zip(filenames, parsers or [None] * len(filenames)):
+            if parser is None:
+                parser = Parser(each)
+                parser.parse()
             subtest = os.path.basename(os.path.splitext(each)[0]).lower()
 
             if prog is not None:
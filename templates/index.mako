@@ -161,22 +161,21 @@
             raw = res.tests.get(test)
             if raw is not None:
               result = raw.result
-              href = normalize_href(posixpath.join(escape_pathname(res.name),
-                                                   escape_filename(test)))
+              href = hrefs[res.name].get(test)
             else:
               raw = res.tests.get(grouptools.groupname(test))
               name = grouptools.testname(test)
               if raw is not None and name in raw.subtests:
                 result = raw.subtests[name]
-                href = normalize_href(posixpath.join(escape_pathname(res.name),
-                                                     escape_filename(grouptools.groupname(test))))
+                href = hrefs[res.name].get(grouptools.groupname(test))
               else:
                 result = status.NOTRUN
+                href = None
             del raw  # we don't need this, so don't let it leak
           %>
           <td class="${str(result)}">
-          % if str(result) not in exclude and result is not status.NOTRUN:
-            <a href="${href}.html">
+          % if href and str(result) not in exclude and result is not status.NOTRUN:
+            <a href="${normalize_href(href)}">
               ${str(result)}
             </a>
           % else:
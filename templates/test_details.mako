@@ -0,0 +1,96 @@
+<%doc>
+  The table of the details of a test result, shared by the test and the
+  group pages.
+</%doc>
+<%def name="table(value)">\
+    <h2>Details</h2>
+    <table>
+      <tr>
+        <th>Detail</th>
+        <th>Value</th>
+      </tr>
+      <tr>
+        <td>Returncode</td>
+        <td>${value.returncode}</td>
+      </tr>
+      <tr>
+        <td>Time</td>
+        <td>${value.time.delta}</b>
+      </tr>
+    % if value.images:
+      <tr>
+        <td>Images</td>
+        <td>
+          <table>
+            <tr>
+              <td/>
+              <td>reference</td>
+              <td>rendered</td>
+              <td>difference</td>
+            </tr>
+          % for image in value.images:
+            <tr>
+              <td>${image['image_desc']}</td>
+            % for key in ['image_ref', 'image_render', 'image_diff']:
+              % if image.get(key):
+              <td><img src="file://${image[key]}" /></td>
+              % else:
+              <td/>
+              % endif
+            % endfor
+            </tr>
+          % endfor
+          </table>
+        </td>
+      </tr>
+    % endif
+      <tr>
+        <td>Stdout</td>
+        <td>
+          <pre>${value.out | h}</pre>
+        </td>
+      </tr>
+      <tr>
+        <td>Stderr</td>
+        <td>
+          <pre>${value.err | h}</pre>
+        </td>
+      </tr>
+    % if value.environment:
+      <tr>
+        <td>Environment</td>
+        <td>
+          <pre>${value.environment | h}</pre>
+        </td>
+      </tr>
+    % endif
+      <tr>
+        <td>Command</td>
+        <td>
+          </pre>${value.command}</pre>
+        </td>
+      </tr>
+    % if value.exception:
+      <tr>
+        <td>Exception</td>
+        <td>
+          <pre>${value.exception | h}</pre>
+        </td>
+      </tr>
+    % endif
+    % if value.traceback:
+      <tr>
+        <td>Traceback</td>
+        <td>
+          <pre>${value.traceback | h}</pre>
+        </td>
+      </tr>
+    % endif
+      <tr>
+        <td>dmesg</td>
+        <td>
+          <pre>${value.dmesg | h}</pre>
+        </td>
+      </tr>
+    </table>\
+</%def>
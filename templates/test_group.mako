@@ -0,0 +1,37 @@
+<%namespace name="details" file="test_details.mako"/>\
+<?xml version="1.0" encoding="UTF-8"?>
+<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Strict//END"
+ "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd">
+<html xmlns="http://www.w3.org/1999/xhtml">
+  <head>
+    <meta http-equiv="Content-Type" content="text/html; charset=UTF-8" />
+    <title>${group} - Details</title>
+    <link rel="stylesheet" href="${css}" type="text/css" />
+  </head>
+  <body>
+    <h1>Results for ${group}</h1>
+    <%def name="navigation()">
+    <p>
+    % if pages > 1:
+      % if prev:
+      <a href="${prev}">Previous</a> |
+      % endif
+      Page ${page} of ${pages} |
+      % if next:
+      <a href="${next}">Next</a> |
+      % endif
+    % endif
+      <a href="${index}">Back to summary</a>
+    </p>
+    </%def>
+    ${navigation()}
+    % for name, anchor, value in tests:
+    <h2 id="${anchor}">${name}</h2>
+    <div>
+      <p><b>Result:</b> ${value.result}</p>
+    </div>
+${details.table(value)}
+    % endfor
+    ${navigation()}
+  </body>
+</html>
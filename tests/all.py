@@ -19,7 +19,10 @@ from framework.driver_classifier import DriverClassifier
 from framework.test import (PiglitGLTest, GleanTest, PiglitBaseTest,
                             GLSLParserTest, GLSLParserNoConfigError)
 from framework.test.shader_test import ShaderTest, MultiShaderTest
+from framework.test.glsl_parser_test import Parser as GLSLParser
+from framework.test.glsl_parser_test import MultiGLSLParserTest
 from .py_modules.constants import TESTS_DIR, GENERATED_TESTS_DIR
+from .py_modules import index as test_index
 
 __all__ = ['profile']
 
@@ -209,37 +212,48 @@ def power_set(s):
 profile = TestProfile()  # pylint: disable=invalid-name
 
 shader_tests = collections.defaultdict(list)
+glsl_parser_tests = collections.defaultdict(list)
+shader_test_groups = set()
+
+# Find and add all shader tests. This uses the index written by the build
+# when it is up to date, which saves parsing every file.
+for basedir, dirpath, filename, parsed in test_index.iter_files(
+        [TESTS_DIR, GENERATED_TESTS_DIR]):
+    testname, ext = os.path.splitext(filename)
+    groupname = grouptools.from_path(os.path.relpath(dirpath, basedir))
+    if ext == '.shader_test':
+        shader_test_groups.add(groupname)
+        if PROCESS_ISOLATION or options.OPTIONS.shader_server:
+            test = ShaderTest(os.path.join(dirpath, filename), parsed)
+        else:
+            shader_tests[groupname].append(
+                (os.path.join(dirpath, filename), parsed))
+            continue
+    elif not PROCESS_ISOLATION:
+        try:
+            parser = GLSLParser(os.path.join(dirpath, filename), parsed)
+        except GLSLParserNoConfigError:
+            continue
+        glsl_parser_tests[groupname].append(
+            (os.path.join(dirpath, filename), parser.config,
+             parser.command[0]))
+        continue
+    else:
+        try:
+            test = GLSLParserTest(os.path.join(dirpath, filename), parsed)
+        except GLSLParserNoConfigError:
+            # In the event that there is no config assume that it is a
+            # legacy test, and continue
+            continue
 
-# Find and add all shader tests.
-for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
-    for dirpath, _, filenames in os.walk(basedir):
-        for filename in filenames:
-            testname, ext = os.path.splitext(filename)
-            groupname = grouptools.from_path(os.path.relpath(dirpath, basedir))
-            if ext == '.shader_test':
-                if PROCESS_ISOLATION:
-                    test = ShaderTest(os.path.join(dirpath, filename))
-                else:
-                    shader_tests[groupname].append(os.path.join(dirpath, filename))
-                    continue
-            elif ext in ['.vert', '.tesc', '.tese', '.geom', '.frag', '.comp']:
-                try:
-                    test = GLSLParserTest(os.path.join(dirpath, filename))
-                except GLSLParserNoConfigError:
-                    # In the event that there is no config assume that it is a
-                    # legacy test, and continue
-                    continue
-
-                # For glslparser tests you can have multiple tests with the
-                # same name, but a different stage, so keep the extension.
-                testname = filename
-            else:
-                continue
+        # For glslparser tests you can have multiple tests with the
+        # same name, but a different stage, so keep the extension.
+        testname = filename
 
-            group = grouptools.join(groupname, testname)
-            assert group not in profile.test_list, group
+    group = grouptools.join(groupname, testname)
+    assert group not in profile.test_list, group
 
-            profile.test_list[group] = test
+    profile.test_list[group] = test
 
 # Because we need to handle duplicate group names in TESTS and GENERATED_TESTS
 # this dictionary is constructed, then added to the actual test dictionary.
@@ -249,10 +263,25 @@ for group, files in six.iteritems(shader_tests):
     # Otherwise use a MultiShaderTest
     if len(files) == 1:
         group = grouptools.join(
-            group, os.path.basename(os.path.splitext(files[0])[0]))
-        profile.test_list[group] = ShaderTest(files[0])
+            group, os.path.basename(os.path.splitext(files[0][0])[0]))
+        profile.test_list[group] = ShaderTest(*files[0])
+    else:
+        profile.test_list[group] = MultiShaderTest(
+            [f for f, _ in files], [p for _, p in files])
+
+# Group the glslparser tests of each directory into a MultiGLSLParserTest. A
+# directory that also has shader tests, or that needs both the GL and GLES
+# binaries, keeps a test per file.
+for group, files in six.iteritems(glsl_parser_tests):
+    if (len(files) == 1 or group in shader_test_groups or
+            len(set(b for _, _, b in files)) != 1):
+        for f, config, _ in files:
+            name = grouptools.join(group, os.path.basename(f))
+            assert name not in profile.test_list, name
+            profile.test_list[name] = GLSLParserTest(f, config)
     else:
-        profile.test_list[group] = MultiShaderTest(files)
+        profile.test_list[group] = MultiGLSLParserTest(
+            [f for f, _, _ in files], [c for _, c, _ in files])
 
 # Collect and add all asmparsertests
 for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
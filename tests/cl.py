@@ -11,17 +11,22 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 
+import collections
 import os
 
+import six
+
 from framework.profile import TestProfile
-from framework.test import PiglitCLTest
-from framework import grouptools
+from framework.test import PiglitCLTest, MultiCLProgramTest
+from framework import grouptools, options
 from .py_modules.constants import TESTS_DIR, GENERATED_TESTS_DIR
 
 __all__ = ['profile']
 
 profile = TestProfile()
 
+program_tests = collections.defaultdict(list)
+
 # Custom
 with profile.test_list.group_manager(PiglitCLTest, 'custom') as g:
     g(['cl-custom-run-simple-kernel'], 'Run simple kernel')
@@ -110,6 +115,10 @@ def add_program_test_dir(group, dirpath):
         if ext not in ['.cl', '.program_test']:
             continue
 
+        if not options.OPTIONS.process_isolation:
+            program_tests[group].append(os.path.join(dirpath, filename))
+            continue
+
         profile.test_list[grouptools.join(group, testname)] = PiglitCLTest(
             ['cl-program-tester', os.path.join(dirpath, filename)])
 
@@ -143,3 +152,14 @@ add_program_test_dir(grouptools.join('program', 'execute', 'store'),
                      os.path.join(GENERATED_TESTS_DIR, 'cl', 'store'))
 add_program_test_dir(grouptools.join('program', 'execute', 'vstore'),
                      os.path.join(GENERATED_TESTS_DIR, 'cl', 'vstore'))
+
+# Without process isolation, run the program tests of each group in one
+# cl-program-tester process, which reuses the OpenCL contexts and programs
+# from one test to the next.
+for group, files in six.iteritems(program_tests):
+    if len(files) == 1:
+        testname = os.path.splitext(os.path.basename(files[0]))[0]
+        profile.test_list[grouptools.join(group, testname)] = PiglitCLTest(
+            ['cl-program-tester', files[0]])
+    else:
+        profile.test_list[group] = MultiCLProgramTest(sorted(files))
@@ -0,0 +1,103 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Time the configuration parser of cl-program-tester over a test corpus.
+
+Runs "cl-program-tester <file> -parse-benchmark <runs>" for every .cl and
+.program_test file in the given directories, which only parses the
+configuration and needs no OpenCL implementation, and prints the total parse
+time and the slowest files.
+
+Usage: parser-benchmark.py [-r RUNS] [-n TOP] <cl-program-tester> <dir>...
+
+For example, from the build directory:
+    parser-benchmark.py bin/cl-program-tester ../tests/cl generated_tests/cl
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+_TIMES = re.compile(r'^parse: first (?P<first>[0-9.]+) ms'
+                    r'(, min (?P<min>[0-9.]+) ms)?', re.MULTILINE)
+
+
+def find_tests(dirs):
+    """Yield the .cl and .program_test files under dirs."""
+    for dir_ in dirs:
+        for dirpath, _, filenames in os.walk(dir_):
+            for filename in sorted(filenames):
+                if filename.endswith(('.cl', '.program_test')):
+                    yield os.path.join(dirpath, filename)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-r', '--runs',
+                        type=int,
+                        default=5,
+                        help='Times to parse each file (default: 5)')
+    parser.add_argument('-n', '--top',
+                        type=int,
+                        default=10,
+                        help='Number of slowest files to list (default: 10)')
+    parser.add_argument('tester',
+                        help='Path to the cl-program-tester binary')
+    parser.add_argument('dirs',
+                        nargs='+',
+                        help='Directories of tests to parse')
+    args = parser.parse_args()
+
+    results = []
+    skipped = 0
+    for test in find_tests(args.dirs):
+        proc = subprocess.Popen(
+            [args.tester, test, '-parse-benchmark', str(args.runs)],
+            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out = proc.communicate()[0].decode('utf-8', 'replace')
+        match = _TIMES.search(out)
+        if match is None:
+            # No configuration, or one the tester rejected
+            skipped += 1
+            continue
+        first = float(match.group('first'))
+        results.append((test, first, float(match.group('min') or first)))
+
+    if not results:
+        print('No tests parsed.', file=sys.stderr)
+        sys.exit(1)
+
+    print('Parsed {} files ({} skipped), {} runs each'.format(
+        len(results), skipped, args.runs))
+    print('  total first run: {:10.3f} ms'.format(sum(r[1] for r in results)))
+    print('  total best run:  {:10.3f} ms'.format(sum(r[2] for r in results)))
+    print('Slowest files (first run):')
+    for test, first, best in sorted(results, key=lambda r: -r[1])[:args.top]:
+        print('  {:10.3f} ms {:10.3f} ms  {}'.format(first, best, test))
+
+
+if __name__ == '__main__':
+    main()
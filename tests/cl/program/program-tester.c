@@ -28,6 +28,7 @@
  */
 
 #include <stdio.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <math.h>
 #include <regex.h>
@@ -285,6 +286,27 @@ size_t   global_offset[3] = {0, 0, 0};
 bool     local_work_size_null = false;
 bool     global_offset_null = true;
 
+/* Set the additional options back to their defaults for the next test */
+void
+reset_options()
+{
+	unsigned i;
+
+	expect_test_fail = false;
+	work_dimensions = 1;
+	for(i = 0; i < 3; i++) {
+		global_work_size[i] = 1;
+		local_work_size[i] = 1;
+		global_offset[i] = 0;
+	}
+	local_work_size_null = false;
+	global_offset_null = true;
+}
+
+// Profiling options, see test_kernel()
+unsigned int profile_runs = 0;
+const char* profile_file = NULL;
+
 /* Helper functions */
 
 void
@@ -535,6 +557,9 @@ free_tests()
 		}
 		free(tests[i].args_out);
 	}
+	free(tests);
+	tests = NULL;
+	num_tests = 0;
 }
 
 /* Strings */
@@ -569,9 +594,75 @@ free_dynamic_strs()
 		}
 
 		free(dynamic_strs);
+		dynamic_strs = NULL;
+		num_dynamic_strs = 0;
 	}
 }
 
+/* Regex cache */
+
+/*
+ * Compiled regexes, so that each pattern is only compiled once.  Patterns
+ * are the REGEX_* string constants, so they are looked up by address before
+ * comparing the strings.
+ */
+struct regex_cache_entry {
+	const char* pattern;
+	int cflags;
+	regex_t regex;
+};
+
+unsigned int num_regexes = 0;
+struct regex_cache_entry** regexes = NULL;
+
+regex_t*
+get_regex(const char* pattern, int cflags)
+{
+	unsigned i;
+	struct regex_cache_entry* entry;
+
+	for(i = 0; i < num_regexes; i++) {
+		if(regexes[i]->pattern == pattern && regexes[i]->cflags == cflags) {
+			return &regexes[i]->regex;
+		}
+	}
+	for(i = 0; i < num_regexes; i++) {
+		if(   regexes[i]->cflags == cflags
+		   && !strcmp(regexes[i]->pattern, pattern)) {
+			return &regexes[i]->regex;
+		}
+	}
+
+	entry = malloc(sizeof(struct regex_cache_entry));
+	if(regcomp(&entry->regex, pattern, REG_EXTENDED | cflags)) {
+		fprintf(stderr, "Invalid regular expression: '%s'\n", pattern);
+		free(entry);
+		return NULL;
+	}
+	entry->pattern = pattern;
+	entry->cflags = cflags;
+	add_dynamic_array((void**)&regexes,
+	                  &num_regexes,
+	                  sizeof(struct regex_cache_entry*),
+	                  &entry);
+
+	return &entry->regex;
+}
+
+void
+free_regexes()
+{
+	unsigned i;
+
+	for(i = 0; i < num_regexes; i++) {
+		regfree(&regexes[i]->regex);
+		free(regexes[i]);
+	}
+	free(regexes);
+	regexes = NULL;
+	num_regexes = 0;
+}
+
 /* Clean */
 
 void
@@ -581,6 +672,12 @@ clean(const int argc,
 {
 	free_dynamic_strs();
 	free_tests();
+	reset_options();
+
+	/* Keep the compiled regexes for the next test of this process */
+	if(!config->_subtest) {
+		free_regexes();
+	}
 }
 
 NORETURN void
@@ -588,6 +685,7 @@ exit_report_result(enum piglit_result result)
 {
 	free_dynamic_strs();
 	free_tests();
+	free_regexes();
 	piglit_report_result(result);
 }
 
@@ -600,26 +698,18 @@ regex_get_matches(const char* src,
                   size_t size,
                   int cflags)
 {
-	int errcode;
-	regex_t r;
+	regex_t* r = get_regex(pattern, cflags);
 
-	/* Build regex */
-	errcode = regcomp(&r, pattern, REG_EXTENDED | cflags);
-	if(errcode) {
-		fprintf(stderr, "Invalid regular expression: '%s'\n", pattern);
+	if(r == NULL) {
 		return false;
 	}
 
 	/* Match regex and if pmatch != NULL && size > 0 return matched */
 	if(pmatch == NULL || size == 0) {
-		errcode = regexec(&r, src, 0, NULL, 0);
+		return regexec(r, src, 0, NULL, 0) == 0;
 	} else {
-		errcode = regexec(&r, src, size, pmatch, 0);
+		return regexec(r, src, size, pmatch, 0) == 0;
 	}
-
-	regfree(&r);
-
-	return errcode == 0;
 }
 
 bool
@@ -697,96 +787,250 @@ regex_key_value(const char* src, char** key, char** value)
 	return false;
 }
 
+/*
+ * Value tokens
+ *
+ * Arrays can have thousands of elements, so their values are parsed by hand
+ * rather than with a regex per element.  The token functions accept exactly
+ * the values REGEX_BOOL, REGEX_INT, REGEX_UINT and REGEX_FLOAT match, given
+ * as the first len characters of src.
+ */
+
 bool
-get_bool(const char* src)
+token_is(const char* src, size_t len, const char* str)
+{
+	return strlen(str) == len && !strncmp(src, str, len);
+}
+
+bool
+token_is_one_of(const char* src, size_t len, const char* const* strs)
+{
+	for(; *strs != NULL; strs++) {
+		if(token_is(src, len, *strs)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+token_is_bool(const char* src, size_t len, bool* value)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_BOOL_TRUE))) {
+	if(token_is(src, len, "1") || token_is(src, len, "true")) {
+		*value = true;
+		return true;
+	} else if(token_is(src, len, "0") || token_is(src, len, "false")) {
+		*value = false;
 		return true;
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_BOOL_FALSE))) {
+	}
+	return false;
+}
+
+bool
+token_is_integer(const char* src, size_t len, bool is_signed)
+{
+	size_t i = 0;
+	bool hex = false;
+
+	if(i < len && (src[i] == '+' || (is_signed && src[i] == '-'))) {
+		i++;
+	}
+	if(len - i > 2 && src[i] == '0' && (src[i+1] == 'x' || src[i+1] == 'X')) {
+		hex = true;
+		i += 2;
+	}
+	if(i == len) {
+		return false;
+	}
+	for(; i < len; i++) {
+		if(hex ? !isxdigit((unsigned char)src[i])
+		       : !isdigit((unsigned char)src[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+token_is_int(const char* src, size_t len, int64_t* value)
+{
+	if(!token_is_integer(src, len, true)) {
 		return false;
+	}
+	/* Like REGEX_UINT before REGEX_INT, so that large hex values work */
+	if(src[0] == '-') {
+		*value = strtoll(src, NULL, 0);
 	} else {
+		*value = strtoull(src, NULL, 0);
+	}
+	return true;
+}
+
+bool
+token_is_uint(const char* src, size_t len, uint64_t* value)
+{
+	if(!token_is_integer(src, len, false)) {
+		return false;
+	}
+	*value = strtoull(src, NULL, 0);
+	return true;
+}
+
+bool
+token_is_float(const char* src, size_t len, double* value)
+{
+	static const char* const nans[] = { "nan", "NAN", "NaN", NULL };
+	static const char* const infs[] = { "infinity", "INFINITY", "Infinity",
+	                                    "inf", "INF", "Inf", NULL };
+	const char* num = src;
+	size_t i = 0;
+	size_t n;
+
+	if(len > 0 && (src[0] == '+' || src[0] == '-')) {
+		num++;
+		len--;
+	}
+
+	if(token_is_one_of(num, len, nans)) {
+		*value = src[0] == '-' ? -NAN : NAN;
+		return true;
+	} else if(token_is_one_of(num, len, infs)) {
+		*value = src[0] == '-' ? -INFINITY : INFINITY;
+		return true;
+	}
+
+	if(len > 2 && num[0] == '0' && (num[1] == 'x' || num[1] == 'X')) {
+		/* REGEX_FLOAT_HEX */
+		for(i = 2; i < len && (   isxdigit((unsigned char)num[i])
+		                       || num[i] == '.'); i++);
+		if(i == 2) {
+			return false;
+		}
+		for(; i < len && (   isdigit((unsigned char)num[i])
+		                  || strchr("pP+-", num[i]) != NULL); i++);
+	} else {
+		/* digits, optional fraction, then e*[+-]*[[:digit:]]* */
+		for(n = i; i < len && isdigit((unsigned char)num[i]); i++);
+		if(i == n) {
+			return false;
+		}
+		if(i < len && num[i] == '.') {
+			for(n = ++i; i < len && isdigit((unsigned char)num[i]); i++);
+			if(i == n) {
+				return false;
+			}
+		}
+		for(; i < len && num[i] == 'e'; i++);
+		for(; i < len && (num[i] == '+' || num[i] == '-'); i++);
+		for(; i < len && isdigit((unsigned char)num[i]); i++);
+	}
+	if(i != len) {
+		return false;
+	}
+
+	*value = strtod(src, NULL);
+	return true;
+}
+
+bool
+get_bool(const char* src)
+{
+	bool value;
+
+	if(!token_is_bool(src, strlen(src), &value)) {
 		fprintf(stderr,
 		        "Invalid configuration, could not convert to bool: %s\n",
 		        src);
 		exit_report_result(PIGLIT_WARN);
-		return false;
 	}
+	return value;
 }
 
 int64_t
 get_int(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_UINT))) {
-		return strtoull(src, NULL, 0);
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_INT))) {
-		return strtoll(src, NULL, 0);
-	} else {
+	int64_t value;
+
+	if(!token_is_int(src, strlen(src), &value)) {
 		fprintf(stderr,
 		        "Invalid configuration, could not convert to long: %s\n",
 		        src);
 		exit_report_result(PIGLIT_WARN);
-		return -1;
 	}
+	return value;
 }
 
 uint64_t
 get_uint(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_UINT))) {
-		return strtoull(src, NULL, 0);
-	} else {
+	uint64_t value;
+
+	if(!token_is_uint(src, strlen(src), &value)) {
 		fprintf(stderr,
 		        "Invalid configuration, could not convert to ulong: %s\n",
 		        src);
 		exit_report_result(PIGLIT_WARN);
-		return 0;
 	}
+	return value;
 }
 
 double
 get_float(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_FLOAT))) {
-		if(regex_match(src, REGEX_FULL_MATCH(REGEX_PNAN))) {
-			return NAN;
-		} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_NNAN))) {
-			return -NAN;
-		} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_PINF))) {
-			return INFINITY;
-		} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_NINF))) {
-			return -INFINITY;
-		} else {
-			return strtod(src, NULL);
-		}
-	} else {
+	double value;
+
+	if(!token_is_float(src, strlen(src), &value)) {
 		fprintf(stderr,
 		        "Invalid configuration, could not convert to double: %s\n",
 		        src);
 		exit_report_result(PIGLIT_WARN);
-		return 0;
 	}
+	return value;
+}
+
+/*
+ * Return the next whitespace separated token of *src, and its length in
+ * *len, and advance *src past it.  Returns NULL at the end of the string.
+ */
+const char*
+next_token(const char** src, size_t* len)
+{
+	const char* token = *src;
+
+	while(isspace((unsigned char)*token)) {
+		token++;
+	}
+	if(*token == '\0') {
+		return NULL;
+	}
+
+	*src = token;
+	while(**src != '\0' && !isspace((unsigned char)**src)) {
+		(*src)++;
+	}
+	*len = *src - token;
+
+	return token;
 }
 
 size_t
 get_array_length(const char* src)
 {
+	const char* pos = src;
+	const char* token;
+	size_t len;
 	size_t size = 0;
+	bool b;
+	double f;
 
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_ARRAY))) {
-		regmatch_t pmatch[1];
-
-		while(regex_get_matches(src,
-		                        REGEX_ARRAY_VALUE REGEX_ARRAY_DELIMITER,
-		                        pmatch,
-		                        1,
-		                        REG_NEWLINE)) {
-			src += pmatch[0].rm_eo;
-			size++;
-		}
-		if(regex_match(src, REGEX_ARRAY_VALUE)) {
-			size++;
+	while((token = next_token(&pos, &len)) != NULL) {
+		if(!token_is_bool(token, len, &b) && !token_is_float(token, len, &f)) {
+			size = 0;
+			break;
 		}
-	} else {
+		size++;
+	}
+	if(size == 0) {
 		fprintf(stderr,
 		        "Invalid configuration, could not convert to an array: %s\n",
 		        src);
@@ -796,97 +1040,88 @@ get_array_length(const char* src)
 	return size;
 }
 
+enum array_type {
+	ARRAY_BOOL,
+	ARRAY_INT,
+	ARRAY_UINT,
+	ARRAY_FLOAT,
+};
+
 size_t
-get_array(const char* src, void** array, size_t size, char* array_pattern)
+get_array(const char* src, void** array, size_t size, enum array_type type)
 {
-	bool regex_matched;
-	size_t i = 0;
-	size_t actual_size;
-	char* type;
-	char* value;
-	char* value_pattern;
-	regmatch_t pmatch[2];
-
-	actual_size = get_array_length(src);
-
-	if(!strcmp(array_pattern, REGEX_BOOL_ARRAY)) {
-		type = "bool";
-		value_pattern = REGEX_BOOL REGEX_ARRAY_DELIMITER;
-		*(bool**)array = malloc(actual_size * sizeof(bool));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_BOOL_ARRAY));
-	} else if(!strcmp(array_pattern, REGEX_INT_ARRAY)) {
-		type = "long";
-		value_pattern = REGEX_INT REGEX_ARRAY_DELIMITER;
-		*(int64_t**)array = malloc(actual_size * sizeof(int64_t));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_INT_ARRAY));
-	} else if(!strcmp(array_pattern, REGEX_UINT_ARRAY)) {
-		type = "ulong";
-		value_pattern = REGEX_UINT REGEX_ARRAY_DELIMITER;
-		*(uint64_t**)array = malloc(actual_size * sizeof(uint64_t));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_UINT_ARRAY));
-	} else if(!strcmp(array_pattern, REGEX_FLOAT_ARRAY)) {
-		type = "double";
-		value_pattern = REGEX_FLOAT REGEX_ARRAY_DELIMITER;
-		*(double**)array = malloc(actual_size * sizeof(double));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_FLOAT_ARRAY));
+	static const char* const type_names[] = {
+		[ARRAY_BOOL] = "bool",
+		[ARRAY_INT] = "long",
+		[ARRAY_UINT] = "ulong",
+		[ARRAY_FLOAT] = "double",
+	};
+	static const size_t element_sizes[] = {
+		[ARRAY_BOOL] = sizeof(bool),
+		[ARRAY_INT] = sizeof(int64_t),
+		[ARRAY_UINT] = sizeof(uint64_t),
+		[ARRAY_FLOAT] = sizeof(double),
+	};
+	const char* type_name = type_names[type];
+	const char* pos = src;
+	const char* token;
+	size_t len;
+	size_t actual_size = 0;
+	size_t capacity = size > 0 ? size : 16;
+
+	if(token_is(src, strlen(src), "NULL") || token_is(src, strlen(src), "null")) {
+		*array = NULL;
 	} else {
-		fprintf(stderr,
-		        "Internal error, invalid array pattern: %s\n",
-		        array_pattern);
-		exit_report_result(PIGLIT_WARN);
-	}
-
-	if(size > 0 && actual_size != size) {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert %s[%zu] to %s[%zu]: %s\n",
-		        type, actual_size, type, size, src);
-		exit_report_result(PIGLIT_WARN);
-	}
+		*array = malloc(capacity * element_sizes[type]);
 
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_NULL))) {
-		free(*array);
-		*array = NULL;
-		return 0;
-	}
+		while((token = next_token(&pos, &len)) != NULL) {
+			bool ok = false;
 
-	if(!regex_matched) {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to %s array: %s\n",
-		        type, src);
-		exit_report_result(PIGLIT_WARN);
-	}
+			if(actual_size == capacity) {
+				capacity *= 2;
+				*array = realloc(*array, capacity * element_sizes[type]);
+			}
 
-	while(regex_get_matches(src, value_pattern, pmatch, 2, 0)) {
-		if(regex_get_match_str(&value, src, pmatch, 1)) {
-			if(!strcmp(array_pattern, REGEX_BOOL_ARRAY)) {
-				(*(bool**)array)[i] = get_bool(value);
-			} else if(!strcmp(array_pattern, REGEX_INT_ARRAY)) {
-				(*(int64_t**)array)[i] = get_int(value);
-			} else if(!strcmp(array_pattern, REGEX_UINT_ARRAY)) {
-				(*(uint64_t**)array)[i] = get_uint(value);
-			} else if(!strcmp(array_pattern, REGEX_FLOAT_ARRAY)) {
-				(*(double**)array)[i] = get_float(value);
+			switch(type) {
+			case ARRAY_BOOL:
+				ok = token_is_bool(token, len,
+				                   &(*(bool**)array)[actual_size]);
+				break;
+			case ARRAY_INT:
+				ok = token_is_int(token, len,
+				                  &(*(int64_t**)array)[actual_size]);
+				break;
+			case ARRAY_UINT:
+				ok = token_is_uint(token, len,
+				                   &(*(uint64_t**)array)[actual_size]);
+				break;
+			case ARRAY_FLOAT:
+				ok = token_is_float(token, len,
+				                    &(*(double**)array)[actual_size]);
+				break;
 			}
-			free(value);
-		} else {
+			if(!ok) {
+				fprintf(stderr,
+				        "Invalid configuration, could not convert to %s array: %s\n",
+				        type_name, src);
+				exit_report_result(PIGLIT_WARN);
+			}
+			actual_size++;
+		}
+
+		if(actual_size == 0) {
 			fprintf(stderr,
-			        "Invalid configuration, could not read %s on index %zu: %s\n",
-			        type, i, src);
+			        "Invalid configuration, could not convert to an array: %s\n",
+			        src);
 			exit_report_result(PIGLIT_WARN);
 		}
-
-		src += pmatch[0].rm_eo;
-		i++;
 	}
 
-	if(!strcmp(array_pattern, REGEX_BOOL_ARRAY)) {
-		(*(bool**)array)[i] = get_bool(src);
-	} else if(!strcmp(array_pattern, REGEX_INT_ARRAY)) {
-		(*(int64_t**)array)[i] = get_int(src);
-	} else if(!strcmp(array_pattern, REGEX_UINT_ARRAY)) {
-		(*(uint64_t**)array)[i] = get_uint(src);
-	} else if(!strcmp(array_pattern, REGEX_FLOAT_ARRAY)) {
-		(*(double**)array)[i] = get_float(src);
+	if(size > 0 && actual_size != size) {
+		fprintf(stderr,
+		        "Invalid configuration, could not convert %s[%zu] to %s[%zu]: %s\n",
+		        type_name, actual_size, type_name, size, src);
+		exit_report_result(PIGLIT_WARN);
 	}
 
 	return actual_size;
@@ -895,25 +1130,25 @@ get_array(const char* src, void** array, size_t size, char* array_pattern)
 size_t
 get_bool_array(const char* src, bool** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_BOOL_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_BOOL);
 }
 
 size_t
 get_int_array(const char* src, int64_t** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_INT_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_INT);
 }
 
 size_t
 get_uint_array(const char* src, uint64_t** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_UINT_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_UINT);
 }
 
 size_t
 get_float_array(const char* src, double** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_FLOAT_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_FLOAT);
 }
 
 /* Help */
@@ -924,13 +1159,24 @@ print_usage(const int argc, const char** argv)
 	printf("Usage:\n" \
 	       "  %s [options] CONFIG.program_test\n"
 	       "  %s [options] [-config CONFIG.program_test] PROGRAM.cl|PROGRAM.bin\n"
+	       "  %s [options] -report-subtests TEST...\n"
+	       "\n"
+	       "Options:\n"
+	       "  -report-subtests       Run each TEST, a .program_test or .cl file,\n"
+	       "                         and report it as a subtest. OpenCL contexts\n"
+	       "                         and programs are shared between the tests.\n"
+	       "  -parse-benchmark RUNS  Only parse the configuration RUNS times and\n"
+	       "                         print the parse times.\n"
+	       "  -profile RUNS          Run each kernel test RUNS times with profiling\n"
+	       "                         enabled, and report the min and median times\n"
+	       "                         of the buffer writes, kernel and buffer reads.\n"
 	       "\n"
 	       "Notes:\n"
 	       "  - If CONFIG is not specified and PROGRAM has a comment config then a\n"
 	       "    comment config is used.\n"
 	       "  - If there is no CONFIG or comment config, then the program is only\n"
 	       "    tested to build properly.\n",
-	       argv[0], argv[0]);
+	       argv[0], argv[0], argv[0]);
 }
 
 void
@@ -1522,26 +1768,15 @@ static char*
 parse_name(const char *input)
 {
 	char *name = add_dynamic_str_copy(input);
-	int error;
-	regex_t regex;
 	regmatch_t pmatch[1];
 
-
-	if ((error = regcomp(&regex, "\\([/%]\\)",0))) {
-		char errbuf[100];
-		regerror(error, &regex, errbuf, 100);
-		fprintf(stderr, "Failed to compile regex for parse_name():%s\n", errbuf);
-		return NULL;
-	}
-
-	if (!regexec(&regex, input, 1, pmatch, 0)) {
+	if (regex_get_matches(input, "[/%]", pmatch, 1, 0)) {
 		char bad_char = *(input + pmatch[0].rm_so);
 		fprintf(stderr,	"Illegal character in test name '%s': %c\n",
 							input, bad_char);
 		return NULL;
 	}
 
-	regfree(&regex);
 	return name;
 }
 
@@ -1852,6 +2087,51 @@ parse_config(const char* config_str,
 	}
 }
 
+/* Parser benchmark */
+
+int
+compare_times(const void* a, const void* b)
+{
+	int64_t ta = *(const int64_t*)a;
+	int64_t tb = *(const int64_t*)b;
+
+	return (ta > tb) - (ta < tb);
+}
+
+/*
+ * Parse config_str runs times, and print the time of the first run, which
+ * includes compiling the regexes, and the minimum and median of the others.
+ */
+void
+benchmark_parser(const char* config_str,
+                 const struct piglit_cl_program_test_config* config,
+                 int runs)
+{
+	int64_t* times = malloc(runs * sizeof(int64_t));
+	int i;
+
+	for(i = 0; i < runs; i++) {
+		struct piglit_cl_program_test_config run_config = *config;
+		int64_t start = piglit_time_get_nano();
+
+		parse_config(config_str, &run_config);
+		times[i] = piglit_time_get_nano() - start;
+
+		free_tests();
+	}
+
+	printf("parse: first %.3f ms", times[0] / 1000000.0);
+	if(runs > 1) {
+		qsort(times + 1, runs - 1, sizeof(int64_t), compare_times);
+		printf(", min %.3f ms, median %.3f ms over %d runs",
+		       times[1] / 1000000.0, times[1 + (runs - 1) / 2] / 1000000.0,
+		       runs - 1);
+	}
+	printf("\n");
+
+	free(times);
+}
+
 /* Get configuration from comment */
 
 char*
@@ -1962,6 +2242,29 @@ init(const int argc,
 	}
 
 	/* Parse test configuration */
+	if(piglit_cl_is_arg_defined(argc, argv, "parse-benchmark")) {
+		const char* runs_str =
+			piglit_cl_get_arg_value(argc, argv, "parse-benchmark");
+		int runs = runs_str != NULL ? atoi(runs_str) : 0;
+
+		if(config_str == NULL || runs < 1) {
+			print_usage_and_warn(argc, argv, "Nothing to benchmark.");
+		}
+		benchmark_parser(config_str, config, runs);
+		free(config_str);
+		exit_report_result(PIGLIT_PASS);
+	}
+	if(piglit_cl_is_arg_defined(argc, argv, "profile")) {
+		const char* runs_str = piglit_cl_get_arg_value(argc, argv, "profile");
+		int runs = runs_str != NULL ? atoi(runs_str) : 0;
+
+		if(runs < 1) {
+			print_usage_and_warn(argc, argv, "Invalid number of profile runs.");
+		}
+		profile_runs = runs;
+		profile_file = add_dynamic_str_copy(main_argument);
+		config->queue_properties |= CL_QUEUE_PROFILING_ENABLE;
+	}
 	if(config_str != NULL) {
 		parse_config(config_str, config);
 		free(config_str);
@@ -2152,6 +2455,249 @@ check_test_arg_value(struct test_arg test_arg,
 	return true;
 }
 
+/* Kernel profiling */
+
+/*
+ * With "-profile RUNS" the command queues are created with profiling enabled,
+ * and every kernel test is run RUNS times: the first run is the one that is
+ * validated, the others only write the input buffers, run the kernel and
+ * read the output buffers again. For each type of command, the times that
+ * commands of a run spent queued (queued to submit), submitted (submit to
+ * start) and executing (start to end) are summed, and the min and median
+ * over the runs are printed in a PIGLIT: {"perf": {...}} record.
+ */
+
+enum profile_command {
+	PROFILE_WRITE,
+	PROFILE_KERNEL,
+	PROFILE_READ,
+	NUM_PROFILE_COMMANDS
+};
+
+static const char* const profile_command_names[NUM_PROFILE_COMMANDS] = {
+	"write", "kernel", "read"
+};
+
+enum profile_interval {
+	PROFILE_QUEUE_DELAY,
+	PROFILE_SUBMIT_DELAY,
+	PROFILE_DURATION,
+	NUM_PROFILE_INTERVALS
+};
+
+static const char* const profile_interval_names[NUM_PROFILE_INTERVALS] = {
+	"queue_delay_ns", "submit_delay_ns", "duration_ns"
+};
+
+/* Times of the commands of one run, in nanoseconds, summed per command type */
+struct profile_run {
+	unsigned int count[NUM_PROFILE_COMMANDS];
+	cl_ulong time[NUM_PROFILE_COMMANDS][NUM_PROFILE_INTERVALS];
+};
+
+/* Add the times of the command of event to run, and release event */
+void
+profile_add_event(struct profile_run* run,
+                  enum profile_command command,
+                  cl_event event)
+{
+	static const cl_profiling_info params[NUM_PROFILE_INTERVALS + 1] = {
+		CL_PROFILING_COMMAND_QUEUED,
+		CL_PROFILING_COMMAND_SUBMIT,
+		CL_PROFILING_COMMAND_START,
+		CL_PROFILING_COMMAND_END,
+	};
+	cl_ulong timestamps[NUM_PROFILE_INTERVALS + 1];
+	unsigned i;
+
+	if(run == NULL) {
+		return;
+	}
+
+	for(i = 0; i < NUM_PROFILE_INTERVALS + 1; i++) {
+		cl_ulong* timestamp =
+			piglit_cl_get_event_profiling_info(event, params[i]);
+
+		if(timestamp == NULL) {
+			clReleaseEvent(event);
+			return;
+		}
+		timestamps[i] = *timestamp;
+		free(timestamp);
+	}
+	clReleaseEvent(event);
+
+	run->count[command]++;
+	for(i = 0; i < NUM_PROFILE_INTERVALS; i++) {
+		run->time[command][i] += timestamps[i + 1] - timestamps[i];
+	}
+}
+
+bool
+profile_write_buffer(const struct piglit_cl_program_test_env* env,
+                     cl_mem buffer, size_t size, const void* value,
+                     struct profile_run* run)
+{
+	cl_event event;
+
+	if(!piglit_cl_write_buffer_with_event(env->context->command_queues[0],
+	                                      buffer, 0, size, value,
+	                                      run != NULL ? &event : NULL)) {
+		return false;
+	}
+	profile_add_event(run, PROFILE_WRITE, event);
+	return true;
+}
+
+bool
+profile_read_buffer(const struct piglit_cl_program_test_env* env,
+                    cl_mem buffer, size_t size, void* value,
+                    struct profile_run* run)
+{
+	cl_event event;
+
+	if(!piglit_cl_read_buffer_with_event(env->context->command_queues[0],
+	                                     buffer, 0, size, value,
+	                                     run != NULL ? &event : NULL)) {
+		return false;
+	}
+	profile_add_event(run, PROFILE_READ, event);
+	return true;
+}
+
+bool
+profile_execute_kernel(const struct piglit_cl_program_test_env* env,
+                       cl_kernel kernel, const struct test* test,
+                       struct profile_run* run)
+{
+	cl_event event;
+
+	if(!piglit_cl_execute_ND_range_kernel_with_event(
+	          env->context->command_queues[0],
+	          kernel,
+	          test->work_dimensions,
+	          test->global_offset_null ? NULL : test->global_offset,
+	          test->global_work_size,
+	          test->local_work_size_null ? NULL : test->local_work_size,
+	          run != NULL ? &event : NULL)) {
+		return false;
+	}
+	profile_add_event(run, PROFILE_KERNEL, event);
+	return true;
+}
+
+int
+compare_cl_ulongs(const void* a, const void* b)
+{
+	cl_ulong ta = *(const cl_ulong*)a;
+	cl_ulong tb = *(const cl_ulong*)b;
+
+	return (ta > tb) - (ta < tb);
+}
+
+/* Print the min and median times of the runs */
+void
+report_profile(const struct piglit_cl_program_test_env* env,
+               const char* test_name,
+               const char* kernel_name,
+               const struct profile_run* runs,
+               unsigned int num_runs)
+{
+	cl_ulong* times = malloc(num_runs * sizeof(cl_ulong));
+	char* device_name = piglit_cl_get_device_info(env->device_id,
+	                                              CL_DEVICE_NAME);
+	unsigned c, i, r;
+
+	printf("PIGLIT: {\"perf\": {\"file\": ");
+	piglit_print_json_string(profile_file);
+	printf(", \"test\": ");
+	piglit_print_json_string(test_name);
+	printf(", \"kernel_name\": ");
+	piglit_print_json_string(kernel_name);
+	printf(", \"device\": ");
+	piglit_print_json_string(device_name);
+	printf(", \"runs\": %u", num_runs);
+
+	for(c = 0; c < NUM_PROFILE_COMMANDS; c++) {
+		if(runs[0].count[c] == 0) {
+			continue;
+		}
+
+		printf(", \"%s\": {", profile_command_names[c]);
+		for(i = 0; i < NUM_PROFILE_INTERVALS; i++) {
+			for(r = 0; r < num_runs; r++) {
+				times[r] = runs[r].time[c][i];
+			}
+			qsort(times, num_runs, sizeof(cl_ulong), compare_cl_ulongs);
+			printf("%s\"%s\": {\"min\": %" PRIu64 ", \"median\": %" PRIu64 "}",
+			       i > 0 ? ", " : "", profile_interval_names[i],
+			       (uint64_t)times[0], (uint64_t)times[(num_runs - 1) / 2]);
+		}
+		printf("}");
+	}
+	printf("}}\n");
+	fflush(stdout);
+
+	free(device_name);
+	free(times);
+}
+
+/* Run the kernel of an already validated test again */
+bool
+profile_test(const struct piglit_cl_program_test_env* env,
+             cl_kernel kernel,
+             const struct test* test,
+             const struct mem_arg* mem_args,
+             unsigned int num_mem_args,
+             struct profile_run* run)
+{
+	unsigned j, k;
+
+	for(j = 0; j < test->num_args_in; j++) {
+		const struct test_arg* test_arg = &test->args_in[j];
+
+		if(test_arg->type != TEST_ARG_BUFFER || test_arg->value == NULL) {
+			continue;
+		}
+		for(k = 0; k < num_mem_args; k++) {
+			if(   mem_args[k].index == test_arg->index
+			   && !profile_write_buffer(env, mem_args[k].mem,
+			                            test_arg->size, test_arg->value,
+			                            run)) {
+				return false;
+			}
+		}
+	}
+
+	if(!profile_execute_kernel(env, kernel, test, run)) {
+		return false;
+	}
+
+	for(j = 0; j < test->num_args_out; j++) {
+		const struct test_arg* test_arg = &test->args_out[j];
+		void* read_value;
+		bool read = true;
+
+		if(test_arg->type != TEST_ARG_BUFFER || test_arg->value == NULL) {
+			continue;
+		}
+		read_value = malloc(test_arg->size);
+		for(k = 0; k < num_mem_args; k++) {
+			if(mem_args[k].index == test_arg->index) {
+				read = profile_read_buffer(env, mem_args[k].mem,
+				                           test_arg->size, read_value,
+				                           run);
+			}
+		}
+		free(read_value);
+		if(!read) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /* Run the kernel test */
 enum piglit_result
 test_kernel(const struct piglit_cl_program_test_config* config,
@@ -2172,6 +2718,9 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 	cl_sampler *sampler_args = NULL;
 	unsigned int num_sampler_args = 0;
 
+	// profiling
+	struct profile_run* runs = NULL;
+
 	/* Check if this device supports the local work size. */
 	if (!piglit_cl_framework_check_local_work_size(env->device_id,
 						test.local_work_size)) {
@@ -2201,6 +2750,10 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 
 	printf("Using kernel %s\n", kernel_name);
 
+	if(profile_runs > 0) {
+		runs = calloc(profile_runs, sizeof(struct profile_run));
+	}
+
 	/* Set kernel args */
 	printf("Setting kernel arguments...\n");
 
@@ -2225,11 +2778,11 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 				                                            CL_MEM_READ_WRITE,
 				                                            test_arg.size);
 				if(   mem_arg.mem != NULL
-				   && piglit_cl_write_buffer(env->context->command_queues[0],
-				                             mem_arg.mem,
-				                             0,
-				                             test_arg.size,
-				                             test_arg.value)
+				   && profile_write_buffer(env,
+				                           mem_arg.mem,
+				                           test_arg.size,
+				                           test_arg.value,
+				                           runs)
 				   && piglit_cl_set_kernel_arg(kernel,
 				                               mem_arg.index,
 				                               sizeof(cl_mem),
@@ -2318,6 +2871,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			clReleaseKernel(kernel);
 			free_mem_args(&mem_args, &num_mem_args);
 			free_sampler_args(&sampler_args, &num_sampler_args);
+			free(runs);
 			return PIGLIT_FAIL;
 		}
 	}
@@ -2441,6 +2995,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			clReleaseKernel(kernel);
 			free_mem_args(&mem_args, &num_mem_args);
 			free_sampler_args(&sampler_args, &num_sampler_args);
+			free(runs);
 			return PIGLIT_FAIL;
 		}
 	}
@@ -2448,16 +3003,12 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 	/* Execute kernel */
 	printf("Running the kernel...\n");
 
-	if(!piglit_cl_execute_ND_range_kernel(env->context->command_queues[0],
-	                                      kernel,
-	                                      test.work_dimensions,
-	                                      test.global_offset_null ? NULL : test.global_offset,
-	                                      test.global_work_size,
-	                                      test.local_work_size_null ? NULL : test.local_work_size)) {
+	if(!profile_execute_kernel(env, kernel, &test, runs)) {
 		printf("Failed to enqueue the kernel\n");
 		clReleaseKernel(kernel);
 		free_mem_args(&mem_args, &num_mem_args);
 		free_sampler_args(&sampler_args, &num_sampler_args);
+		free(runs);
 		return PIGLIT_FAIL;
 	}
 
@@ -2486,11 +3037,11 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			if(test_arg.value != NULL) {
 				void* read_value = malloc(test_arg.size);
 
-				if(piglit_cl_read_buffer(env->context->command_queues[0],
-					                     mem_arg.mem,
-					                     0,
-					                     test_arg.size,
-					                     read_value)) {
+				if(profile_read_buffer(env,
+				                       mem_arg.mem,
+				                       test_arg.size,
+				                       read_value,
+				                       runs)) {
 					arg_valid = true;
 					if(check_test_arg_value(test_arg, read_value)) {
 						printf(" Argument %u: PASS%s\n",
@@ -2564,10 +3115,30 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			clReleaseKernel(kernel);
 			free_mem_args(&mem_args, &num_mem_args);
 			free_sampler_args(&sampler_args, &num_sampler_args);
+			free(runs);
 			return PIGLIT_FAIL;
 		}
 	}
 
+	/* Run the kernel again to time it */
+	if(runs != NULL) {
+		unsigned r;
+
+		for(r = 1; r < profile_runs; r++) {
+			if(!profile_test(env, kernel, &test, mem_args, num_mem_args,
+			                 &runs[r])) {
+				printf("Failed to run the kernel for profiling\n");
+				piglit_merge_result(&result, PIGLIT_FAIL);
+				break;
+			}
+		}
+		if(r == profile_runs) {
+			report_profile(env, test.name, kernel_name, runs,
+			               profile_runs);
+		}
+		free(runs);
+	}
+
 	/* Clean memory used by test */
 	clReleaseKernel(kernel);
 	free_mem_args(&mem_args, &num_mem_args);
@@ -2612,7 +3183,15 @@ piglit_cl_test(const int argc,
 		test_result = test_kernel(config, env, tests[i]);
 		piglit_merge_result(&result, test_result);
 
-		piglit_report_subtest_result(test_result, "%s", tests[i].name);
+		/* When this file is itself a subtest, only its merged
+		 * result is reported.
+		 */
+		if(!config->_subtest) {
+			piglit_report_subtest_result(test_result, "%s", tests[i].name);
+		} else {
+			printf("> Kernel test %s: %s\n", test_name,
+			       piglit_result_to_string(test_result));
+		}
 	}
 
 	/* Print result */
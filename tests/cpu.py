@@ -14,7 +14,7 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 from tests.quick import profile as _profile
-from framework.test import GLSLParserTest
+from framework.test import GLSLParserTest, MultiGLSLParserTest
 
 __all__ = ['profile']
 
@@ -23,7 +23,8 @@ profile = _profile.copy()  # pylint: disable=invalid-name
 
 def filter_gpu(name, test):
     """Remove all tests that are run on the GPU."""
-    if isinstance(test, GLSLParserTest) or name.startswith('asmparsertest'):
+    if (isinstance(test, (GLSLParserTest, MultiGLSLParserTest)) or
+            name.startswith('asmparsertest')):
         return True
     return False
 
@@ -29,55 +29,40 @@
  *
  * Tests that compiling (but not linking or drawing with) a given
  * shader either succeeds or fails as expected.
+ *
+ * With -report-subtests, any number of tests can be given, each as
+ * the usual <filename> <pass|fail> <version> {--check-link}
+ * {extensions...} arguments, and each is reported as a subtest named
+ * after its file.  A test starts at every argument with a shader file
+ * extension.  The GL context is reused for as long as it suits the
+ * versions of the tests.
  */
 
 #include <errno.h>
 
 #include "piglit-util-gl.h"
+#include "piglit-framework-gl/piglit_gl_framework.h"
 
 static unsigned parse_glsl_version_number(const char *str);
 static int process_options(int argc, char **argv);
+static void get_required_config(const char *version,
+				struct piglit_gl_test_config *config);
+
+static bool report_subtests = false;
+static struct piglit_gl_test_config current_config;
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
-	argc = process_options(argc, argv);
+	report_subtests = PIGLIT_STRIP_ARG("-report-subtests");
+
+	/* In batch mode --check-link belongs to the test it is given
+	 * with, so it is left for piglit_init() to find.
+	 */
+	if (!report_subtests)
+		argc = process_options(argc, argv);
+
 	if (argc > 3) {
-		const unsigned int int_version
-			= parse_glsl_version_number(argv[3]);
-		switch (int_version) {
-		/* This is a hack to support es
-		 *
-		 * This works because version 1.00, 3.00, 3.10, 3.20 (even
-		 * though 3.x should include "es") are unique to GLES, there is
-		 * no desktop OpenGL shader language 1.00, 3.00, 3.10, or 3.20
-		 */
-		case 100:
-			config.supports_gl_compat_version = 10;
-			config.supports_gl_es_version = 20;
-			break;
-		case 300:
-			config.supports_gl_compat_version = 10;
-			config.supports_gl_es_version = 30;
-			break;
-		case 310:
-			config.supports_gl_compat_version = 10;
-			config.supports_gl_es_version = 31;
-			break;
-		case 320:
-			config.supports_gl_compat_version = 10;
-			config.supports_gl_es_version = 32;
-			break;
-		default: {
-			const unsigned int gl_version
-				= required_gl_version_from_glsl_version(int_version);
-			config.supports_gl_compat_version = gl_version;
-			if (gl_version < 31)
-				config.supports_gl_core_version = 0;
-			else
-				config.supports_gl_core_version = gl_version;
-		}
-			break;
-		}
+		get_required_config(argv[3], &config);
 	} else {
 		config.supports_gl_compat_version = 10;
 		config.supports_gl_es_version = 20;
@@ -87,6 +72,8 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 	config.window_height = 100;
 	config.window_visual = PIGLIT_GL_VISUAL_DOUBLE | PIGLIT_GL_VISUAL_RGB;
 
+	current_config = config;
+
 PIGLIT_GL_TEST_CONFIG_END
 
 static char *filename;
@@ -95,6 +82,76 @@ static int gl_version_times_10 = 0;
 static int check_link = 0;
 static unsigned requested_version = 110;
 static bool test_requires_geometry_shader4 = false;
+static unsigned implementation_glsl_version = 0;
+static int test_num = 0;
+
+/**
+ * Set the GL or GL ES versions that a test of the given GLSL version
+ * requires in config.
+ */
+static void
+get_required_config(const char *version, struct piglit_gl_test_config *config)
+{
+	const unsigned int int_version = parse_glsl_version_number(version);
+
+	switch (int_version) {
+	/* This is a hack to support es
+	 *
+	 * This works because version 1.00, 3.00, 3.10, 3.20 (even
+	 * though 3.x should include "es") are unique to GLES, there is
+	 * no desktop OpenGL shader language 1.00, 3.00, 3.10, or 3.20
+	 */
+	case 100:
+		config->supports_gl_compat_version = 10;
+		config->supports_gl_es_version = 20;
+		break;
+	case 300:
+		config->supports_gl_compat_version = 10;
+		config->supports_gl_es_version = 30;
+		break;
+	case 310:
+		config->supports_gl_compat_version = 10;
+		config->supports_gl_es_version = 31;
+		break;
+	case 320:
+		config->supports_gl_compat_version = 10;
+		config->supports_gl_es_version = 32;
+		break;
+	default: {
+		const unsigned int gl_version
+			= required_gl_version_from_glsl_version(int_version);
+		config->supports_gl_compat_version = gl_version;
+		if (gl_version < 31)
+			config->supports_gl_core_version = 0;
+		else
+			config->supports_gl_core_version = gl_version;
+	}
+		break;
+	}
+}
+
+static GLenum
+get_shader_type(const char *name)
+{
+	const size_t len = strlen(name);
+
+	if (len < 5 || name[len - 5] != '.')
+		return GL_NONE;
+
+	if (strcmp(name + len - 4, "frag") == 0)
+		return GL_FRAGMENT_SHADER;
+	else if (strcmp(name + len - 4, "vert") == 0)
+		return GL_VERTEX_SHADER;
+	else if (strcmp(name + len - 4, "tesc") == 0)
+		return GL_TESS_CONTROL_SHADER;
+	else if (strcmp(name + len - 4, "tese") == 0)
+		return GL_TESS_EVALUATION_SHADER;
+	else if (strcmp(name + len - 4, "geom") == 0)
+		return GL_GEOMETRY_SHADER;
+	else if (strcmp(name + len - 4, "comp") == 0)
+		return GL_COMPUTE_SHADER;
+	return GL_NONE;
+}
 
 static GLint
 get_shader_compile_status(GLuint shader)
@@ -233,7 +290,7 @@ attach_complementary_shader(GLuint shader_prog, GLenum type)
 		attach_dummy_shader(shader_prog, GL_FRAGMENT_SHADER);
 }
 
-static void
+static enum piglit_result
 require_feature(int gl_ver, const char *gl_ext, int es_ver, const char *es_ext)
 {
 	const int required_ver = piglit_is_gles() ? es_ver : gl_ver;
@@ -243,11 +300,36 @@ require_feature(int gl_ver, const char *gl_ext, int es_ver, const char *es_ext)
 	    !piglit_is_extension_supported(required_ext)) {
 		printf("Test requires version %g or %s\n",
 		       required_ver / 10.0, required_ext);
-		piglit_report_result(PIGLIT_SKIP);
+		return PIGLIT_SKIP;
 	}
+	return PIGLIT_PASS;
 }
 
-static void
+/**
+ * Like piglit_require_extension(), but returns PIGLIT_SKIP rather than
+ * exiting, so that the other tests of a batch still run.
+ */
+static enum piglit_result
+require_extension(const char *name)
+{
+	if (!piglit_is_extension_supported(name)) {
+		printf("Test requires %s\n", name);
+		return PIGLIT_SKIP;
+	}
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
+require_not_extension(const char *name)
+{
+	if (piglit_is_extension_supported(name)) {
+		printf("Test requires the absence of %s\n", name);
+		return PIGLIT_SKIP;
+	}
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
 test(void)
 {
 	GLint prog;
@@ -259,43 +341,32 @@ test(void)
 	GLint size;
 	GLenum type;
 	char *failing_stage = NULL;
+	enum piglit_result result = PIGLIT_PASS;
 
-	if (strcmp(filename + strlen(filename) - 4, "frag") == 0)
-		type = GL_FRAGMENT_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "vert") == 0)
-		type = GL_VERTEX_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "tesc") == 0)
-		type = GL_TESS_CONTROL_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "tese") == 0)
-		type = GL_TESS_EVALUATION_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "geom") == 0)
-		type = GL_GEOMETRY_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "comp") == 0)
-		type = GL_COMPUTE_SHADER;
-	else {
-		type = GL_NONE;
+	type = get_shader_type(filename);
+	if (type == GL_NONE) {
 		fprintf(stderr, "Couldn't determine type of program %s\n",
 			filename);
-		piglit_report_result(PIGLIT_FAIL);
+		return PIGLIT_FAIL;
 	}
 
-	piglit_require_vertex_shader();
-	piglit_require_fragment_shader();
-
 	if (type == GL_TESS_CONTROL_SHADER || type == GL_TESS_EVALUATION_SHADER) {
-		require_feature(40, "GL_ARB_tessellation_shader",
-				32, "GL_OES_tessellation_shader");
+		result = require_feature(40, "GL_ARB_tessellation_shader",
+					 32, "GL_OES_tessellation_shader");
 	}
 
 	if (type == GL_COMPUTE_SHADER) {
-		require_feature(43, "GL_ARB_compute_shader", 31, NULL);
+		result = require_feature(43, "GL_ARB_compute_shader", 31, NULL);
 	}
 
+	if (result != PIGLIT_PASS)
+		return result;
+
 	prog_string = piglit_load_text_file(filename, NULL);
 	if (prog_string == NULL) {
 		fprintf(stderr, "Couldn't open program %s: %s\n",
 			filename, strerror(errno));
-		exit(1);
+		return PIGLIT_FAIL;
 	}
 
 	prog = glCreateShader(type);
@@ -383,13 +454,16 @@ test(void)
 		free(info);
 	free(prog_string);
 	glDeleteShader(prog);
-	piglit_report_result (pass ? PIGLIT_PASS : PIGLIT_FAIL);
+	return pass ? PIGLIT_PASS : PIGLIT_FAIL;
 }
 
 static void usage(char *name)
 {
 	printf("%s {options} <filename.frag|filename.vert> <pass|fail> "
 	       "{requested GLSL version} {list of required GL extensions}\n", name);
+	printf("%s -report-subtests {<filename> <pass|fail> "
+	       "<requested GLSL version> {--check-link} "
+	       "{list of required GL extensions}}...\n", name);
 	printf("\nSupported options:\n");
 	printf("  --check-link: also detect link failures\n");
 	exit(1);
@@ -461,23 +535,18 @@ parse_glsl_version_string(const char *str)
 }
 
 
-static void
+static enum piglit_result
 check_version(unsigned glsl_version)
 {
 	if (!piglit_is_gles()) {
-		if (requested_version == 100) {
-			piglit_require_extension("GL_ARB_ES2_compatibility");
-			return;
-		} else if (requested_version == 300) {
-			piglit_require_extension("GL_ARB_ES3_compatibility");
-			return;
-		} else if (requested_version == 310) {
-			piglit_require_extension("GL_ARB_ES3_1_compatibility");
-			return;
-		} else if (requested_version == 320) {
-			piglit_require_extension("GL_ARB_ES3_2_compatibility");
-			return;
-		}
+		if (requested_version == 100)
+			return require_extension("GL_ARB_ES2_compatibility");
+		else if (requested_version == 300)
+			return require_extension("GL_ARB_ES3_compatibility");
+		else if (requested_version == 310)
+			return require_extension("GL_ARB_ES3_1_compatibility");
+		else if (requested_version == 320)
+			return require_extension("GL_ARB_ES3_2_compatibility");
 	}
 
 	if (glsl_version < requested_version) {
@@ -485,34 +554,155 @@ check_version(unsigned glsl_version)
 			"GLSL version is %u.%u, but requested version %u.%u is required\n",
 			glsl_version / 100, glsl_version % 100,
 			requested_version / 100, requested_version % 100);
-		piglit_report_result(PIGLIT_SKIP);
+		return PIGLIT_SKIP;
 	}
+	return PIGLIT_PASS;
 }
 
 
-void
-piglit_init(int argc, char**argv)
+/**
+ * Set up the state for the test given by argv, which holds the
+ * filename, the expected result, the GLSL version, and then options and
+ * required extensions.  Returns PIGLIT_SKIP if the test can't run.
+ */
+static enum piglit_result
+setup_test(char *exec_arg, int argc, char **argv)
 {
-	const char *glsl_version_string;
-	unsigned glsl_version = 0;
+	enum piglit_result result;
 	int i;
 
-	if (argc < 3)
-		usage(argv[0]);
+	if (argc < 2 || strlen(argv[0]) < 5)
+		usage(exec_arg);
+	filename = argv[0];
 
-	if (strlen(argv[1]) < 5)
-		usage(argv[0]);
-	filename = argv[1];
-
-	if (strcmp(argv[2], "pass") == 0)
+	if (strcmp(argv[1], "pass") == 0)
 		expected_pass = 1;
-	else if (strcmp(argv[2], "fail") == 0)
+	else if (strcmp(argv[1], "fail") == 0)
 		expected_pass = 0;
 	else
-		usage(argv[0]);
+		usage(exec_arg);
 
-	if (argc > 3)
-		requested_version = parse_glsl_version_number(argv[3]);
+	requested_version = argc > 2 ? parse_glsl_version_number(argv[2]) : 110;
+	test_requires_geometry_shader4 = false;
+	if (report_subtests)
+		check_link = 0;
+
+	result = check_version(implementation_glsl_version);
+
+	for (i = 3; i < argc && result == PIGLIT_PASS; i++) {
+		if (strcmp(argv[i], "--check-link") == 0) {
+			check_link = 1;
+		} else if (argv[i][0] == '!') {
+			result = require_not_extension(argv[i] + 1);
+		} else {
+			result = require_extension(argv[i]);
+			if (strstr(argv[i], "geometry_shader4") != NULL)
+				test_requires_geometry_shader4 = true;
+		}
+	}
+	return result;
+}
+
+
+/**
+ * Whether the current context can run a test that requires config.
+ */
+static bool
+validate_current_gl_context(const struct piglit_gl_test_config *config)
+{
+	if (!current_config.supports_gl_compat_version !=
+	    !config->supports_gl_compat_version)
+		return false;
+
+	if (!current_config.supports_gl_core_version !=
+	    !config->supports_gl_core_version)
+		return false;
+
+	if (!current_config.supports_gl_es_version !=
+	    !config->supports_gl_es_version)
+		return false;
+
+	if (piglit_is_gles())
+		return piglit_get_gl_version() >= config->supports_gl_es_version;
+	else if (config->supports_gl_core_version)
+		return piglit_get_gl_version() >= config->supports_gl_core_version;
+	return piglit_get_gl_version() >= config->supports_gl_compat_version;
+}
+
+
+/**
+ * Restart with a new context for the tests left in argv.  This doesn't
+ * return.
+ */
+static void
+recreate_gl_context(char *exec_arg, int param_argc, char **param_argv)
+{
+	int argc = param_argc + 2;
+	char **argv = malloc(sizeof(char*) * argc);
+
+	if (!argv) {
+		fprintf(stderr, "%s: malloc failed.\n", __func__);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	argv[0] = exec_arg;
+	memcpy(&argv[1], param_argv, param_argc * sizeof(char*));
+	argv[argc-1] = "-report-subtests";
+
+	if (gl_fw->destroy)
+		gl_fw->destroy(gl_fw);
+	gl_fw = NULL;
+
+	exit(main(argc, argv));
+}
+
+
+/**
+ * Run the first test of argv, which has test_argc arguments, as a
+ * subtest.  The remaining tests are only passed for the case where the
+ * context has to be recreated.
+ */
+static void
+run_subtest(char *exec_arg, int argc, char **argv, int test_argc)
+{
+	struct piglit_gl_test_config config = { 0 };
+	enum piglit_result result;
+	const char *name;
+
+	if (test_argc < 3)
+		usage(exec_arg);
+
+	get_required_config(argv[2], &config);
+	if (!validate_current_gl_context(&config))
+		recreate_gl_context(exec_arg, argc, argv);
+
+	name = strrchr(argv[0], PIGLIT_PATH_SEP);
+	name = name ? name + 1 : argv[0];
+
+	/* Print the name before we start the test, that way if the test
+	 * crashes the framework knows where to resume.
+	 */
+	printf("PIGLIT TEST: %i - %s\n", test_num, name);
+	fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, name);
+	test_num++;
+
+	result = setup_test(exec_arg, test_argc, argv);
+	if (result == PIGLIT_PASS)
+		result = test();
+
+	piglit_report_subtest_result(result, "%s", name);
+}
+
+
+void
+piglit_init(int argc, char**argv)
+{
+	const char *glsl_version_string;
+	enum piglit_result result;
+	int i;
+
+	if (argc < 3)
+		usage(argv[0]);
 
 	gl_version_times_10 = piglit_get_gl_version();
 
@@ -526,21 +716,30 @@ piglit_init(int argc, char**argv)
 		glGetString(GL_SHADING_LANGUAGE_VERSION);
 
 	if (glsl_version_string != NULL)
-		glsl_version = parse_glsl_version_string(glsl_version_string);
+		implementation_glsl_version =
+			parse_glsl_version_string(glsl_version_string);
 
-	check_version(glsl_version);
+	piglit_require_vertex_shader();
+	piglit_require_fragment_shader();
 
-	for (i = 4; i < argc; i++) {
-		if (argv[i][0] == '!') {
-			piglit_require_not_extension(argv[i] + 1);
-		} else {
-			piglit_require_extension(argv[i]);
-			if (strstr(argv[i], "geometry_shader4") != NULL)
-				test_requires_geometry_shader4 = true;
+	if (report_subtests) {
+		/* Each test runs from its filename up to the next one. */
+		for (i = 1; i < argc; ) {
+			int n = 1;
+
+			while (i + n < argc &&
+			       get_shader_type(argv[i + n]) == GL_NONE)
+				n++;
+			run_subtest(argv[0], argc - i, argv + i, n);
+			i += n;
 		}
+		exit(0);
 	}
 
-	test();
+	result = setup_test(argv[0], argc - 1, argv + 1);
+	if (result == PIGLIT_PASS)
+		result = test();
+	piglit_report_result(result);
 }
 
 enum piglit_result
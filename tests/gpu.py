@@ -7,12 +7,13 @@ from __future__ import (
 )
 
 from tests.quick import profile as _profile
-from framework.test import GLSLParserTest
+from framework.test import GLSLParserTest, MultiGLSLParserTest
 
 __all__ = ['profile']
 
 profile = _profile.copy()  # pylint: disable=invalid-name
 
 # Remove all parser tests, as they are compiler test
-profile.filters.append(lambda p, t: not isinstance(t, GLSLParserTest))
+profile.filters.append(
+    lambda p, t: not isinstance(t, (GLSLParserTest, MultiGLSLParserTest)))
 profile.filters.append(lambda n, _: not n.startswith('asmparsertest'))
@@ -26,6 +26,19 @@
 #include "piglit-util-gl.h"
 #include "common.h"
 
+#include <errno.h>
+#include <limits.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+struct perf_options perf_options = {
+	.warmup = 1,
+	.repetitions = 5,
+	.min_time = 0.1,
+	.cpu = -1,
+};
+
 /** Return time in seconds */
 static double
 perf_get_time(void)
@@ -33,85 +46,238 @@ perf_get_time(void)
 	return piglit_time_get_nano() * 0.000000001;
 }
 
+static void
+perf_pin_to_cpu(int cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+
+	if (cpu >= CPU_SETSIZE) {
+		fprintf(stderr, "Invalid CPU: %d\n", cpu);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		fprintf(stderr, "Failed to pin to CPU %d: %s\n",
+			cpu, strerror(errno));
+		piglit_report_result(PIGLIT_FAIL);
+	}
+#else
+	fprintf(stderr, "-cpu is not supported on this platform, "
+		"not pinning to CPU %d\n", cpu);
+#endif
+}
+
 /**
- * Run function 'f' for enough iterations to reach a steady state.
- * Return the rate (iterations/second).
+ * Parse and remove the options of perf_measure() from the arguments:
+ *
+ *   -warmup N       repetitions to run before measuring (default 1)
+ *   -repetitions N  repetitions to measure (default 5)
+ *   -min-time S     minimum duration of a repetition, in seconds (default
+ *                   0.1), which sets the number of iterations per repetition
+ *   -cpu N          pin the process to CPU N
+ *
+ * Call it before the context is created (in the PIGLIT_GL_TEST_CONFIG
+ * block), so that the threads of the driver inherit the pinning.
  */
-double
-perf_measure_rate(perf_rate_func f)
+void
+perf_parse_args(int *argc, char **argv)
 {
-	const double minDuration = 0.5;
-	double rate = 0.0, prevRate = 0.0;
-	unsigned subiters;
-
-	/* Compute initial number of iterations to try.
-	 * If the test function is pretty slow this helps to avoid
-	 * extraordinarily long run times.
-	 */
-	subiters = 2;
-	{
-		const double t0 = perf_get_time();
-		double t1;
-		do {
-			f(subiters); /* call the rendering function */
-			glFinish();
-			t1 = perf_get_time();
-			subiters *= 2;
-		} while (t1 - t0 < 0.1 * minDuration);
+	int i, j = 1;
+
+	for (i = 1; i < *argc; i++) {
+		const char *value = i + 1 < *argc ? argv[i + 1] : "";
+		char *end = NULL;
+		bool valid;
+
+		if (!strcmp(argv[i], "-warmup")) {
+			perf_options.warmup = strtoul(value, &end, 0);
+			valid = true;
+		} else if (!strcmp(argv[i], "-repetitions")) {
+			perf_options.repetitions = strtoul(value, &end, 0);
+			valid = perf_options.repetitions > 0;
+		} else if (!strcmp(argv[i], "-min-time")) {
+			perf_options.min_time = strtod(value, &end);
+			valid = perf_options.min_time > 0;
+		} else if (!strcmp(argv[i], "-cpu")) {
+			perf_options.cpu = strtol(value, &end, 0);
+			valid = perf_options.cpu >= 0;
+		} else {
+			argv[j++] = argv[i];
+			continue;
+		}
+
+		if (!valid || end == value || *end != '\0') {
+			fprintf(stderr, "Invalid value for %s: \"%s\"\n",
+				argv[i], value);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+		i++;
 	}
-	/*perf_printf("initial subIters = %u\n", subiters);*/
-
-	while (1) {
-		const double t0 = perf_get_time();
-		unsigned iters = 0;
-		double t1;
-
-		do {
-			f(subiters); /* call the rendering function */
-			glFinish();
-			t1 = perf_get_time();
-			iters += subiters;
-		} while (t1 - t0 < minDuration);
-
-		rate = iters / (t1 - t0);
-
-		if (0)
-			printf("prevRate %f  rate  %f  ratio %f  iters %u\n",
-			       prevRate, rate, rate/prevRate, iters);
-
-		/* Try and speed the search up by skipping a few steps: */
-		if (rate > prevRate * 1.6)
-			subiters *= 8;
-		else if (rate > prevRate * 1.2)
-			subiters *= 4;
-		else if (rate > prevRate * 1.05)
-			subiters *= 2;
-		else
+	argv[j] = NULL;
+	*argc = j;
+
+	if (perf_options.cpu >= 0)
+		perf_pin_to_cpu(perf_options.cpu);
+}
+
+/** Run f(iterations) and return how long it took, in seconds. */
+static double
+perf_time(perf_rate_func f, unsigned iterations)
+{
+	const double t0 = perf_get_time();
+
+	f(iterations); /* call the rendering function */
+	glFinish();
+	return perf_get_time() - t0;
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+ * Two-sided 95% quantile of Student's t distribution, for the given degrees
+ * of freedom.
+ */
+static double
+perf_t_95(unsigned df)
+{
+	static const double t[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+		2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+		2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+		2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+	};
+
+	return df <= ARRAY_SIZE(t) ? t[df - 1] : 1.960;
+}
+
+/**
+ * The largest k such that [x(k), x(n - 1 - k)] of n sorted samples is a
+ * 95% confidence interval of the median: it misses the median with the
+ * probability 2 P(B <= k), B ~ Binomial(n, 1/2).  0 when no interval is.
+ */
+static unsigned
+perf_median_ci_index(unsigned n)
+{
+	double tail = 0.0;
+	unsigned k;
+
+	for (k = 0; 2 * k + 1 < n; k++) {
+		tail += exp(lgamma(n + 1.0) - lgamma(k + 1.0) -
+			    lgamma(n - k + 1.0) - n * log(2.0));
+		if (2 * tail > 0.05)
 			break;
+	}
+
+	return k > 0 ? k - 1 : 0;
+}
+
+/**
+ * Measure the time per iteration of function 'f'.
+ *
+ * The number of iterations per repetition is doubled until a repetition
+ * takes perf_options.min_time. Then perf_options.warmup repetitions are run
+ * and thrown away, and the time of perf_options.repetitions repetitions is
+ * measured.
+ */
+void
+perf_measure(perf_rate_func f, struct perf_stats *stats)
+{
+	const unsigned n = perf_options.repetitions;
+	double *samples = malloc(n * sizeof(double));
+	double sum = 0.0, var = 0.0, ci;
+	unsigned iterations, i, k;
+
+	for (iterations = 1;
+	     perf_time(f, iterations) < perf_options.min_time &&
+	     iterations < UINT_MAX / 2;
+	     iterations *= 2)
+		;
+
+	for (i = 0; i < perf_options.warmup; i++)
+		perf_time(f, iterations);
 
-		prevRate = rate;
+	for (i = 0; i < n; i++) {
+		samples[i] = perf_time(f, iterations) * 1000000000.0 /
+			     iterations;
+		sum += samples[i];
 	}
 
-	if (0)
-		printf("%s returning iters %u  rate %f\n", __FUNCTION__, subiters, rate);
-	return rate;
+	stats->repetitions = n;
+	stats->iterations = iterations;
+	stats->mean = sum / n;
+	for (i = 0; i < n; i++)
+		var += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+	stats->stddev = n > 1 ? sqrt(var / (n - 1)) : 0.0;
+
+	qsort(samples, n, sizeof(double), compare_doubles);
+	stats->min = samples[0];
+	stats->max = samples[n - 1];
+	stats->median = n % 2 ? samples[n / 2] :
+		(samples[n / 2 - 1] + samples[n / 2]) / 2;
+	k = perf_median_ci_index(n);
+	stats->median_ci_low = samples[k];
+	stats->median_ci_high = samples[n - 1 - k];
+
+	ci = n > 1 ? perf_t_95(n - 1) * stats->stddev / sqrt(n) : 0.0;
+	stats->ci_low = stats->mean - ci;
+	stats->ci_high = stats->mean + ci;
+
+	free(samples);
 }
 
-/* Note static buffer, can only use once per printf.
+/**
+ * Print the statistics of a measurement as a PIGLIT: {"perf": {...}}
+ * record, which piglit stores in the perf list of the test result.
  */
-const char *
-perf_human_float( double d )
+void
+perf_report(const char *name, const struct perf_stats *stats)
+{
+	printf("PIGLIT: {\"perf\": {\"name\": ");
+	piglit_print_json_string(name);
+	printf(", \"repetitions\": %u, \"iterations\": %u, "
+	       "\"ns_per_iteration\": {\"median\": %.3f, \"min\": %.3f, "
+	       "\"max\": %.3f, \"mean\": %.3f, \"stddev\": %.3f, "
+	       "\"ci95\": [%.3f, %.3f], \"median_ci95\": [%.3f, %.3f]}}}\n",
+	       stats->repetitions, stats->iterations,
+	       stats->median, stats->min, stats->max, stats->mean,
+	       stats->stddev, stats->ci_low, stats->ci_high,
+	       stats->median_ci_low, stats->median_ci_high);
+	fflush(stdout);
+}
+
+/**
+ * Measure function 'f' with perf_measure().
+ * Return the median rate (iterations/second).
+ */
+double
+perf_measure_rate(perf_rate_func f)
 {
-	static char buf[80];
+	struct perf_stats stats;
 
+	perf_measure(f, &stats);
+	return 1000000000.0 / stats.median;
+}
+
+const char *
+perf_human_float(double d, char *buf, size_t size)
+{
 	if (d > 1000000000.0)
-		snprintf(buf, sizeof(buf), "%.2f billion", d / 1000000000.0);
+		snprintf(buf, size, "%.2f billion", d / 1000000000.0);
 	else if (d > 1000000.0)
-		snprintf(buf, sizeof(buf), "%.2f million", d / 1000000.0);
+		snprintf(buf, size, "%.2f million", d / 1000000.0);
 	else if (d > 1000.0)
-		snprintf(buf, sizeof(buf), "%.2f thousand", d / 1000.0);
+		snprintf(buf, size, "%.2f thousand", d / 1000.0);
 	else
-		snprintf(buf, sizeof(buf), "%.2f", d);
+		snprintf(buf, size, "%.2f", d);
 
 	return buf;
 }
@@ -22,13 +22,58 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 typedef void (*perf_rate_func)(unsigned count);
 
+/** How perf_measure() runs a function, see perf_parse_args(). */
+struct perf_options {
+	unsigned warmup;	/**< repetitions run before measuring */
+	unsigned repetitions;	/**< repetitions measured */
+	double min_time;	/**< minimum duration of a repetition, in s */
+	int cpu;		/**< CPU to pin the process to, or -1 */
+};
+
+/**
+ * Statistics of the time per iteration over the repetitions of
+ * perf_measure(), in nanoseconds.
+ */
+struct perf_stats {
+	unsigned repetitions;
+	unsigned iterations;	/**< iterations per repetition */
+	double median;
+	double min;
+	double max;
+	double mean;
+	double stddev;
+	double ci_low;		/**< 95% confidence interval of the mean */
+	double ci_high;
+	/**
+	 * 95% confidence interval of the median, from the order statistics
+	 * of the samples; the range of the samples with fewer than 6
+	 * repetitions, which can't give one.
+	 */
+	double median_ci_low;
+	double median_ci_high;
+};
+
+extern struct perf_options perf_options;
+
+void
+perf_parse_args(int *argc, char **argv);
+
+void
+perf_measure(perf_rate_func f, struct perf_stats *stats);
+
+void
+perf_report(const char *name, const struct perf_stats *stats);
+
 double
 perf_measure_rate(perf_rate_func f);
 
 const char *
-perf_human_float( double d );
+perf_human_float(double d, char *buf, size_t size);
 
 #endif /* COMMON_H */
 
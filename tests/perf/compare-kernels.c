@@ -0,0 +1,184 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Microbenchmark for the pixel comparison kernels in piglit-compare.c.
+ *
+ * Runs each kernel set this CPU supports over a fully matching image, so
+ * every pixel is visited, and prints the throughput relative to the scalar
+ * kernels.  It then plants a mismatch in the last row and exits with 1
+ * if any kernel set scans past it.
+ *
+ * Usage: compare-kernels [width height]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "piglit-util.h"
+#include "piglit-compare.h"
+
+#define MIN_DURATION 0.25
+
+static int width = 1024, height = 1024;
+static float *image_f, *other_f;
+static unsigned char *image_b;
+
+static const float expected_f[4] = { 0.25, 0.5, 0.75, 1.0 };
+static const unsigned char expected_b[4] = { 64, 128, 191, 255 };
+static const float tolerance_f[4] = { 0.01, 0.01, 0.01, 0.01 };
+static const unsigned char tolerance_b[4] = { 3, 3, 3, 3 };
+
+enum bench {
+	BENCH_RGBA_FLOAT,
+	BENCH_RGB_FLOAT,
+	BENCH_RGBA_UBYTE,
+	BENCH_IMAGES_FLOAT,
+};
+
+static const char *bench_names[] = {
+	"rgba float",
+	"rgb float",
+	"rgba ubyte",
+	"images float",
+};
+
+static int
+run_kernel(const struct piglit_compare_kernels *k, enum bench bench,
+	   const float *observed)
+{
+	int n = width * height;
+
+	switch (bench) {
+	case BENCH_RGBA_FLOAT:
+		return k->rgba_float(observed, n, expected_f, tolerance_f, 4);
+	case BENCH_RGB_FLOAT:
+		return k->rgba_float(observed, n, expected_f, tolerance_f, 3);
+	case BENCH_RGBA_UBYTE:
+		return k->rgba_ubyte(image_b, n, expected_b, tolerance_b, 4);
+	case BENCH_IMAGES_FLOAT:
+		return k->images_float(observed, other_f, n, tolerance_f, 4);
+	}
+	return 0;
+}
+
+/** Return the throughput in megapixels per second. */
+static double
+measure(const struct piglit_compare_kernels *k, enum bench bench)
+{
+	int64_t start = piglit_time_get_nano(), now;
+	unsigned iters = 0;
+	volatile int sink = 0;
+
+	do {
+		sink += run_kernel(k, bench, image_f);
+		iters++;
+		now = piglit_time_get_nano();
+	} while ((now - start) * 0.000000001 < MIN_DURATION);
+
+	(void) sink;
+	return (double) iters * width * height /
+	       ((now - start) * 0.000000001) / 1000000.0;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const enum piglit_simd_level levels[] = {
+		PIGLIT_SIMD_SCALAR,
+		PIGLIT_SIMD_SSE2,
+		PIGLIT_SIMD_AVX2,
+		PIGLIT_SIMD_NEON,
+	};
+	const struct piglit_compare_kernels *scalar =
+		piglit_get_compare_kernels_for(PIGLIT_SIMD_SCALAR);
+	double scalar_rate[4];
+	bool pass = true;
+	int i, b, l, n, mismatch;
+
+	if (argc == 3) {
+		width = atoi(argv[1]);
+		height = atoi(argv[2]);
+	}
+	if (width <= 0 || height <= 0) {
+		fprintf(stderr, "usage: %s [width height]\n", argv[0]);
+		return 1;
+	}
+
+	n = width * height;
+	image_f = malloc(n * 4 * sizeof(float));
+	other_f = malloc(n * 4 * sizeof(float));
+	image_b = malloc(n * 4);
+	for (i = 0; i < n * 4; i++) {
+		image_f[i] = other_f[i] = expected_f[i % 4];
+		image_b[i] = expected_b[i % 4];
+	}
+
+	printf("%dx%d pixels, best kernels: %s\n", width, height,
+	       piglit_get_compare_kernels()->name);
+
+	for (l = 0; l < ARRAY_SIZE(levels); l++) {
+		const struct piglit_compare_kernels *k =
+			piglit_get_compare_kernels_for(levels[l]);
+
+		if (k == NULL)
+			continue;
+
+		for (b = 0; b < ARRAY_SIZE(bench_names); b++) {
+			double rate = measure(k, b);
+
+			if (k == scalar)
+				scalar_rate[b] = rate;
+			printf("   %-7s %-13s %10.1f Mpix/s  %5.2fx\n",
+			       k->name, bench_names[b], rate,
+			       rate / scalar_rate[b]);
+		}
+	}
+
+	/* Put a mismatch in the last row; every kernel must stop at or
+	 * before it.
+	 */
+	mismatch = n - width / 2 - 1;
+	image_f[mismatch * 4 + 1] += 0.5;
+	image_b[mismatch * 4 + 1] += 10;
+	for (l = 0; l < ARRAY_SIZE(levels); l++) {
+		const struct piglit_compare_kernels *k =
+			piglit_get_compare_kernels_for(levels[l]);
+
+		if (k == NULL)
+			continue;
+
+		for (b = 0; b < ARRAY_SIZE(bench_names); b++) {
+			if (run_kernel(k, b, image_f) > mismatch) {
+				printf("%s %s missed the mismatch at pixel %d\n",
+				       k->name, bench_names[b], mismatch);
+				pass = false;
+			}
+		}
+	}
+
+	free(image_f);
+	free(other_f);
+	free(image_b);
+	return pass ? 0 : 1;
+}
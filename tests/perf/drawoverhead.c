@@ -29,6 +29,7 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 
 	config.supports_gl_compat_version = 0;
 	config.supports_gl_core_version = 32;
+	perf_parse_args(&argc, argv);
 	for (int i = 1; i < argc; i++) {
 		if (!strcmp(argv[i], "-compat")) {
 			config.supports_gl_compat_version = 10;
@@ -385,18 +386,30 @@ perf_run(const char *call, unsigned num_vbos, unsigned num_ubos,
 	 unsigned num_textures, const char *change, perf_rate_func f,
 	 double base_rate)
 {
-	double rate = perf_measure_rate(f);
-	double ratio = base_rate ? rate / base_rate : 1;
+	struct perf_stats stats;
+	char name[128], rate_text[32];
+	double rate, ratio;
+
+	perf_measure(f, &stats);
+	rate = 1000000000.0 / stats.median;
+	ratio = base_rate ? rate / base_rate : 1;
+
+	snprintf(name, sizeof(name), "%s (%u VBOs, %u UBOs, %u Tex) w/ %s change",
+		 call, num_vbos, num_ubos, num_textures, change);
+	perf_report(name, &stats);
 
 	printf("   %s (%2u VBOs, %u UBOs, %2u Tex) w/ %s change:%*s"
-	       COLOR_CYAN "%s" COLOR_RESET " %s(%.1f%%)" COLOR_RESET "\n",
+	       COLOR_CYAN "%s" COLOR_RESET " %s(%.1f%%)" COLOR_RESET
+	       " +/- %.1f%%\n",
 	       call, num_vbos, num_ubos, num_textures, change,
 	       MAX2(18 - (int)strlen(change), 0), "",
-	       perf_human_float(rate),
+	       perf_human_float(rate, rate_text, sizeof(rate_text)),
 	       base_rate == 0 ? COLOR_RESET :
 				ratio > 0.7 ? COLOR_GREEN :
 				ratio > 0.4 ? COLOR_YELLOW : COLOR_RED,
-	       100 * ratio);
+	       100 * ratio,
+	       100 * MAX2(stats.median - stats.median_ci_low,
+			  stats.median_ci_high - stats.median) / stats.median);
 	return rate;
 }
 
@@ -490,6 +503,6 @@ piglit_display(void)
 	perf_draw_variant("DrawElements", true);
 	perf_draw_variant("DrawArrays", false);
 
-	exit(0);
-	return PIGLIT_SKIP;
+	piglit_report_result(PIGLIT_PASS);
+	return PIGLIT_PASS;
 }
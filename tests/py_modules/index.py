@@ -0,0 +1,277 @@
+# encoding=utf-8
+# Copyright © 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""An index of the shader_test and glslparser test files.
+
+Loading all.py used to walk the test directories and parse every
+.shader_test and glslparser test file, which takes seconds. The build writes
+an index of the walk and of the parsed values of each file (see the
+gen-test-index target), and iter_files() loads it instead.
+
+The index records the mtime of every directory and file it covers. If a
+directory changed, files may have been added or removed, and unless its test
+files and subdirectories are still the same the index is not used at all. If
+only a file changed, that file is parsed again. __pycache__ and CMakeFiles
+directories are not covered, since loading all.py and building write to them.
+
+The directories are stored relative to the tests directory, so that an index
+written when installing piglit still applies after the tree is packaged and
+moved.
+
+The index is stored with marshal, and memory-mapped when loaded. marshal's
+format depends on the python version, so the version is stored as well.
+
+Usage: python -m tests.py_modules.index <index> <tests dir> <generated dir>
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import marshal
+import mmap
+import os
+import sys
+
+import six
+
+from framework import exceptions
+from framework.test import glsl_parser_test, shader_test
+from .constants import GENERATED_TESTS_DIR
+
+__all__ = [
+    'INDEX_FILE',
+    'build',
+    'iter_files',
+]
+
+INDEX_FILE = os.path.join(GENERATED_TESTS_DIR, 'all.index')
+
+_MAGIC = b'PIGLIT-TEST-INDEX-2\n'
+
+_GLSL_EXTENSIONS = frozenset(['.vert', '.tesc', '.tese', '.geom', '.frag',
+                              '.comp'])
+
+# Directories that never hold tests, but are written to by python and cmake
+_PRUNE = frozenset(['__pycache__', 'CMakeFiles'])
+
+
+def _filter(dirnames, filenames):
+    """Return the subdirectories and test files of a directory listing."""
+    return ([d for d in dirnames if d not in _PRUNE],
+            [f for f in filenames
+             if os.path.splitext(f)[1] == '.shader_test' or
+             os.path.splitext(f)[1] in _GLSL_EXTENSIONS])
+
+
+def _walk(basedirs):
+    """Yield (base, dirpath, dirnames, filenames) for the test files of
+    basedirs.
+
+    base is the index of the directory in basedirs, dirnames the
+    subdirectories that are walked and filenames only contains .shader_test
+    and glslparser test files, in os.walk order.
+    """
+    for base, basedir in enumerate(basedirs):
+        for dirpath, dirnames, filenames in os.walk(basedir):
+            dirnames[:], filenames = _filter(dirnames, filenames)
+            yield base, dirpath, dirnames, filenames
+
+
+def _changed(path, mtime, dirnames, filenames):
+    """Whether the directory path differs from when it was indexed.
+
+    A directory whose mtime changed is listed again, as creating a
+    __pycache__ directory changes the mtime of its parent.
+    """
+    if os.stat(path).st_mtime == mtime:
+        return False
+
+    listed = {'d': [], 'f': []}
+    for entry in os.listdir(path):
+        isdir = os.path.isdir(os.path.join(path, entry))
+        listed['d' if isdir else 'f'].append(entry)
+    subdirs, files = _filter(listed['d'], listed['f'])
+    return (sorted(subdirs) != sorted(dirnames) or
+            sorted(files) != sorted(filenames))
+
+
+def _parse(path):
+    """Parse a test file, and return the values that the index stores.
+
+    Returns None for glslparser tests without a config block, and raises
+    PiglitFatalError for files that fail to parse.
+    """
+    if path.endswith('.shader_test'):
+        parser = shader_test.Parser(path)
+        parser.parse()
+        return parser.to_index()
+
+    try:
+        return dict(glsl_parser_test.Parser(path).config)
+    except glsl_parser_test.GLSLParserNoConfigError:
+        return None
+
+
+def _relative(basedirs):
+    """Return basedirs relative to the first of them, the tests directory."""
+    try:
+        return [os.path.relpath(b, basedirs[0]) for b in basedirs]
+    except ValueError:
+        # On windows there is no relative path between two drives
+        return [os.path.abspath(b) for b in basedirs]
+
+
+def _load(filename, basedirs):
+    """Load an index, returning None if it is missing or doesn't apply."""
+    try:
+        with open(filename, 'rb') as f:
+            mapped = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    except (IOError, OSError, ValueError):
+        return None
+
+    try:
+        if mapped[:len(_MAGIC)] != _MAGIC:
+            return None
+        if six.PY2:
+            index = marshal.loads(mapped[len(_MAGIC):])
+        else:
+            with memoryview(mapped) as view:
+                index = marshal.loads(view[len(_MAGIC):])
+    except (EOFError, ValueError, TypeError):
+        return None
+    finally:
+        mapped.close()
+
+    if (tuple(index['python']) != tuple(sys.version_info[:2]) or
+            index['basedirs'] != _relative(basedirs)):
+        return None
+    return index
+
+
+def build(filename, basedirs):
+    """Write the index of basedirs to filename.
+
+    Files that haven't changed since a previous index at filename are taken
+    from it rather than parsed again.
+    """
+    old = _load(filename, basedirs)
+    old_files = old['files'] if old else {}
+
+    # The index usually lives in one of the directories it covers. Create it
+    # before taking the mtimes and overwrite it in place afterwards, so that
+    # writing it doesn't change the mtime of its directory.
+    if not os.path.exists(filename):
+        open(filename, 'wb').close()
+
+    dirs = []
+    files = {}
+    for base, dirpath, dirnames, filenames in _walk(basedirs):
+        rel = os.path.relpath(dirpath, basedirs[base])
+        dirs.append((base, rel, os.stat(dirpath).st_mtime, dirnames,
+                     filenames))
+
+        for f in filenames:
+            path = os.path.join(dirpath, f)
+            key = '{}:{}'.format(base, os.path.join(rel, f))
+            mtime = os.stat(path).st_mtime
+            if key in old_files and old_files[key][0] == mtime:
+                files[key] = old_files[key]
+                continue
+            try:
+                files[key] = (mtime, _parse(path))
+            except exceptions.PiglitFatalError:
+                # Leave it to loading all.py to report the error
+                pass
+
+    index = {
+        'python': list(sys.version_info[:2]),
+        'basedirs': _relative(basedirs),
+        'dirs': dirs,
+        'files': files,
+    }
+
+    # A reader that sees a partly written index fails to unmarshal it, and
+    # walks the directories instead.
+    with open(filename, 'wb') as f:
+        f.write(_MAGIC)
+        marshal.dump(index, f)
+
+
+def iter_files(basedirs, filename=INDEX_FILE):
+    """Yield the .shader_test and glslparser test files of basedirs.
+
+    Yields (basedir, dirpath, filename, parsed) tuples in os.walk order.
+    parsed is a shader_test.Parser for shader_test files and the config dict
+    for glslparser tests, or None when the file has to be parsed by the
+    caller. glslparser tests without a config block are left out when they
+    come from the index.
+
+    The index is used when it exists and no directory has changed since it
+    was built, otherwise the directories are walked.
+    """
+    index = _load(filename, basedirs)
+    if index is not None:
+        try:
+            stale = any(
+                _changed(os.path.join(basedirs[base], rel), mtime, dirnames,
+                         filenames)
+                for base, rel, mtime, dirnames, filenames in index['dirs'])
+        except OSError:
+            stale = True
+        if stale:
+            index = None
+
+    if index is None:
+        for base, dirpath, _, filenames in _walk(basedirs):
+            for f in filenames:
+                yield basedirs[base], dirpath, f, None
+        return
+
+    files = index['files']
+    for base, rel, _, _, filenames in index['dirs']:
+        dirpath = os.path.normpath(os.path.join(basedirs[base], rel))
+        for f in filenames:
+            path = os.path.join(dirpath, f)
+            entry = files.get('{}:{}'.format(base, os.path.join(rel, f)))
+
+            parsed = None
+            if entry is not None and os.stat(path).st_mtime == entry[0]:
+                if entry[1] is None:
+                    continue
+                if f.endswith('.shader_test'):
+                    parsed = shader_test.Parser.from_index(path, entry[1])
+                else:
+                    parsed = entry[1]
+
+            yield basedirs[base], dirpath, f, parsed
+
+
+def main():
+    if len(sys.argv) != 4:
+        print('usage: {} <index> <tests dir> <generated tests dir>'.format(
+            sys.argv[0]), file=sys.stderr)
+        sys.exit(1)
+    build(sys.argv[1], sys.argv[2:])
+
+
+if __name__ == '__main__':
+    main()
@@ -24,9 +24,12 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <inttypes.h>
+#include <limits.h>
 
 #include "piglit-util.h"
 #include "piglit-util-gl.h"
+#include "piglit-golden.h"
 #include "piglit-vbo.h"
 #include "piglit-framework-gl/piglit_gl_framework.h"
 
@@ -146,6 +149,7 @@ static GLint render_width, render_height;
 static GLint read_width, read_height;
 
 static bool report_subtests = false;
+static bool server_mode = false;
 
 static struct texture_binding {
 	GLuint obj;
@@ -236,6 +240,7 @@ get_resident_handle(unsigned idx)
 
 enum states {
 	none = 0,
+	parameters,
 	requirements,
 	vertex_shader,
 	vertex_shader_passthrough,
@@ -423,77 +428,18 @@ target_to_short_name(GLenum target)
 }
 
 
+/**
+ * Compile a shader from the given strings and add it to the list of
+ * shaders to be linked for its stage.
+ */
 static enum piglit_result
-compile_glsl(GLenum target)
+compile_shader_strings(GLenum target, GLsizei count,
+		       const GLchar **strings, const GLint *lengths)
 {
 	GLuint shader = glCreateShader(target);
 	GLint ok;
 
-	switch (target) {
-	case GL_VERTEX_SHADER:
-		if (piglit_get_gl_version() < 20 &&
-		    !(piglit_is_extension_supported("GL_ARB_shader_objects") &&
-		      piglit_is_extension_supported("GL_ARB_vertex_shader")))
-			return PIGLIT_SKIP;
-		break;
-	case GL_FRAGMENT_SHADER:
-		if (piglit_get_gl_version() < 20 &&
-		    !(piglit_is_extension_supported("GL_ARB_shader_objects") &&
-		      piglit_is_extension_supported("GL_ARB_fragment_shader")))
-			return PIGLIT_SKIP;
-		break;
-	case GL_TESS_CONTROL_SHADER:
-	case GL_TESS_EVALUATION_SHADER:
-		if (gl_version.num < (gl_version.es ? 32 : 40))
-			if (!piglit_is_extension_supported(gl_version.es ?
-							   "GL_OES_tessellation_shader" :
-							   "GL_ARB_tessellation_shader"))
-				return PIGLIT_SKIP;
-		break;
-	case GL_GEOMETRY_SHADER:
-		if (gl_version.num < 32)
-			if (!piglit_is_extension_supported(gl_version.es ?
-							   "GL_OES_geometry_shader" :
-							   "GL_ARB_geometry_shader4"))
-				return PIGLIT_SKIP;
-		break;
-	case GL_COMPUTE_SHADER:
-		if (gl_version.num < (gl_version.es ? 31 : 43))
-			if (!piglit_is_extension_supported("GL_ARB_compute_shader"))
-				return PIGLIT_SKIP;
-		break;
-	}
-
-	if (!glsl_req_version.num) {
-		printf("GLSL version requirement missing\n");
-		return PIGLIT_FAIL;
-	}
-
-	if (!strstr(shader_string, "#version ")) {
-		char *shader_strings[2];
-		char version_string[100];
-		GLint shader_string_sizes[2];
-
-		/* Add a #version directive based on the GLSL requirement. */
-		sprintf(version_string, "#version %d", glsl_req_version.num);
-		if (glsl_req_version.es && glsl_req_version.num != 100) {
-			strcat(version_string, " es");
-		}
-		strcat(version_string, "\n");
-		shader_strings[0] = version_string;
-		shader_string_sizes[0] = strlen(version_string);
-		shader_strings[1] = shader_string;
-		shader_string_sizes[1] = shader_string_size;
-
-		glShaderSource(shader, 2,
-				    (const GLchar **) shader_strings,
-				    shader_string_sizes);
-
-	} else {
-		glShaderSource(shader, 1,
-				    (const GLchar **) &shader_string,
-				    &shader_string_size);
-	}
+	glShaderSource(shader, count, strings, lengths);
 
 	glCompileShader(shader);
 
@@ -545,200 +491,671 @@ compile_glsl(GLenum target)
 	return PIGLIT_PASS;
 }
 
-static enum piglit_result
-compile_and_bind_program(GLenum target, const char *start, int len)
-{
-	GLuint prog;
+/**
+ * \name Program binary cache
+ *
+ * When PIGLIT_SHADER_CACHE_DIR is set, linked programs are stored there
+ * through glGetProgramBinary() and restored with glProgramBinary() on
+ * later runs, skipping compilation and linking entirely.  Entries are
+ * keyed on a hash of every shader source, the [require] section and the
+ * GL_RENDERER/GL_VERSION strings, so a driver update invalidates them.
+ *
+ * While the cache is active for a test, shader sources are only recorded
+ * by compile_glsl() and compiled at link time on a cache miss.  Tests
+ * that expect a link error, use separate shader objects or run on a
+ * context without program binary support always bypass the cache.
+ *
+ * While the rows of a [parameters] table run, the binaries are also kept
+ * in memory, so that rows which expand to the same shaders only compile
+ * them once, with or without PIGLIT_SHADER_CACHE_DIR.
+ */
+/*@{*/
+static const char *program_cache_dir = NULL;
+static bool program_cache_active = false;
+static bool program_cache_in_memory = false;
+static uint64_t program_cache_key;
+static unsigned program_cache_hits = 0;
+static unsigned program_cache_misses = 0;
+static unsigned program_cache_bypassed = 0;
+
+static struct deferred_shader {
+	GLenum target;
 	char *source;
+} deferred_shaders[256];
+static unsigned num_deferred_shaders = 0;
 
-	switch (target) {
-	case GL_VERTEX_PROGRAM_ARB:
-		if (!piglit_is_extension_supported("GL_ARB_vertex_program"))
-			return PIGLIT_SKIP;
-		break;
-	case GL_FRAGMENT_PROGRAM_ARB:
-		if (!piglit_is_extension_supported("GL_ARB_fragment_program"))
-			return PIGLIT_SKIP;
-		break;
-	}
-
-	source = malloc(len + 1);
-	memcpy(source, start, len);
-	source[len] = 0;
-	prog = piglit_compile_program(target, source);
+static struct cached_binary {
+	uint64_t key;
+	GLenum format;
+	GLint size;
+	void *binary;
+} *cached_binaries;
+static unsigned num_cached_binaries = 0;
 
-	glEnable(target);
-	glBindProgramARB(target, prog);
-	link_ok = true;
-	prog_in_use = true;
+static void
+free_cached_binaries(void)
+{
+	unsigned i;
 
-	return PIGLIT_PASS;
+	for (i = 0; i < num_cached_binaries; i++)
+		free(cached_binaries[i].binary);
+	free(cached_binaries);
+	cached_binaries = NULL;
+	num_cached_binaries = 0;
 }
 
-static enum piglit_result
-link_sso(GLenum target)
+static void
+free_deferred_shaders(void)
 {
-	GLint ok;
+	unsigned i;
 
-	glLinkProgram(prog);
+	for (i = 0; i < num_deferred_shaders; i++)
+		free(deferred_shaders[i].source);
+	num_deferred_shaders = 0;
+}
 
-	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
-	if (ok) {
-		link_ok = true;
-	} else {
-		GLint size;
+/** 64-bit FNV-1a */
+static uint64_t
+program_cache_hash(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	size_t i;
 
-		glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &size);
-		prog_err_info = malloc(size);
+	for (i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
 
-		glGetProgramInfoLog(prog, size, NULL, prog_err_info);
+	return hash;
+}
 
-		fprintf(stderr, "SSO glLinkProgram(%s) failed: %s\n",
-			target_to_short_name(target),
-			prog_err_info);
+static uint64_t
+program_cache_hash_str(uint64_t hash, const char *str)
+{
+	/* Include the terminator so that adjacent strings can't alias. */
+	return program_cache_hash(hash, str, strlen(str) + 1);
+}
 
-		free(prog_err_info);
-		return PIGLIT_FAIL;
-	}
+static bool
+program_cache_supported(void)
+{
+	GLint num_formats = 0;
 
-	switch (target) {
-	case GL_VERTEX_SHADER:
-		sso_vertex_prog = prog;
-		glUseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, prog);
-		break;
-	case GL_TESS_CONTROL_SHADER:
-		sso_tess_control_prog = prog;
-		glUseProgramStages(pipeline, GL_TESS_CONTROL_SHADER_BIT, prog);
-		break;
-	case GL_TESS_EVALUATION_SHADER:
-		sso_tess_eval_prog = prog;
-		glUseProgramStages(pipeline, GL_TESS_EVALUATION_SHADER_BIT, prog);
-		break;
-	case GL_GEOMETRY_SHADER:
-		sso_geometry_prog = prog;
-		glUseProgramStages(pipeline, GL_GEOMETRY_SHADER_BIT, prog);
-		break;
-	case GL_FRAGMENT_SHADER:
-		sso_fragment_prog = prog;
-		glUseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, prog);
-		break;
-	case GL_COMPUTE_SHADER:
-		sso_compute_prog = prog;
-		glUseProgramStages(pipeline, GL_COMPUTE_SHADER_BIT, prog);
-		break;
+	/* GL_OES_get_program_binary alone doesn't provide
+	 * glProgramParameteri for GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+	 */
+	if (gl_version.es) {
+		if (gl_version.num < 30)
+			return false;
+	} else {
+		if (gl_version.num < 41 &&
+		    !piglit_is_extension_supported("GL_ARB_get_program_binary"))
+			return false;
 	}
-	return PIGLIT_PASS;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	return num_formats > 0;
 }
 
 /**
- * Compare two values given a specified comparison operator
+ * Decide whether the program of the test script \p text may be cached,
+ * and start a new cache key for it.
  */
-static bool
-compare(float ref, float value, enum comparison cmp)
+static void
+program_cache_begin(const char *text)
 {
-	switch (cmp) {
-	case equal:         return value == ref;
-	case not_equal:     return value != ref;
-	case less:          return value <  ref;
-	case greater_equal: return value >= ref;
-	case greater:       return value >  ref;
-	case less_equal:    return value <= ref;
+	const char *test_section;
+
+	program_cache_active = false;
+	free_deferred_shaders();
+
+	if (program_cache_dir == NULL && !program_cache_in_memory)
+		return;
+
+	test_section = strstr(text, "\n[test]");
+	if ((test_section && strstr(test_section, "link error")) ||
+	    !program_cache_supported()) {
+		program_cache_bypassed++;
+		return;
 	}
 
-	assert(!"Should not get here.");
-	return false;
+	program_cache_key = UINT64_C(0xcbf29ce484222325);
+	program_cache_key = program_cache_hash_str(program_cache_key,
+		(const char *) glGetString(GL_RENDERER));
+	program_cache_key = program_cache_hash_str(program_cache_key,
+		(const char *) glGetString(GL_VERSION));
+	program_cache_active = true;
 }
 
-static bool
-compare_uint(GLuint ref, GLuint value, enum comparison cmp)
+/**
+ * Add a line of the [require] section to the cache key.
+ */
+static void
+program_cache_add_requirement(const char *line)
 {
-	switch (cmp) {
-	case equal:         return value == ref;
-	case not_equal:     return value != ref;
-	case less:          return value <  ref;
-	case greater_equal: return value >= ref;
-	case greater:       return value >  ref;
-	case less_equal:    return value <= ref;
-	}
-
-	assert(!"Should not get here.");
-	return false;
+	if (program_cache_active)
+		program_cache_key = program_cache_hash(program_cache_key, line,
+						       strchrnul(line, '\n') - line + 1);
 }
 
 /**
- * Get the string representation of a comparison operator
+ * Record a shader for compilation at link time, adding its source to the
+ * cache key.
  */
-static const char *
-comparison_string(enum comparison cmp)
+static enum piglit_result
+defer_shader(GLenum target, GLsizei count,
+	     const GLchar **strings, const GLint *lengths)
 {
-	switch (cmp) {
-	case equal:         return "==";
-	case not_equal:     return "!=";
-	case less:          return "<";
-	case greater_equal: return ">=";
-	case greater:       return ">";
-	case less_equal:    return "<=";
+	struct deferred_shader *shader;
+	size_t size = 0;
+	GLsizei i;
+
+	if (num_deferred_shaders >= ARRAY_SIZE(deferred_shaders)) {
+		fprintf(stderr, "Too many shaders in test script\n");
+		return PIGLIT_FAIL;
 	}
 
-	assert(!"Should not get here.");
-	return false;
+	for (i = 0; i < count; i++)
+		size += lengths[i];
+
+	shader = &deferred_shaders[num_deferred_shaders++];
+	shader->target = target;
+	shader->source = malloc(size + 1);
+	size = 0;
+	for (i = 0; i < count; i++) {
+		memcpy(shader->source + size, strings[i], lengths[i]);
+		size += lengths[i];
+	}
+	shader->source[size] = '\0';
+
+	program_cache_key = program_cache_hash(program_cache_key, &target,
+					       sizeof(target));
+	program_cache_key = program_cache_hash_str(program_cache_key,
+						   shader->source);
+
+	return PIGLIT_PASS;
 }
 
 /**
- * " ES" before the comparison operator indicates the version
- * pertains to GL ES.
+ * Compile all the shaders recorded by defer_shader().
  */
-static void
-parse_version_comparison(const char *line, enum comparison *cmp,
-			 struct component_version *v, enum version_tag tag)
+static enum piglit_result
+compile_deferred_shaders(void)
 {
-	unsigned major;
-	unsigned minor;
-	unsigned full_num;
-	const bool core = parse_str(line, "CORE", &line);
-	const bool es = parse_str(line, "ES", &line);
-
-	REQUIRE(parse_comparison_op(line, cmp, &line),
-		"Invalid comparison operation at: %s\n", line);
+	enum piglit_result result = PIGLIT_PASS;
+	unsigned i;
 
-	REQUIRE(parse_uint(line, &major, &line) &&
-		parse_str(line, ".", &line) &&
-		parse_uint(line, &minor, &line),
-		"Invalid version string: %s\n", line);
+	for (i = 0; i < num_deferred_shaders && result == PIGLIT_PASS; i++) {
+		const struct deferred_shader *shader = &deferred_shaders[i];
 
-	parse_whitespace(line, &line);
-	if (*line != '\n') {
-		printf("Unexpected characters following version comparison\n");
-		piglit_report_result(PIGLIT_FAIL);
+		result = compile_shader_strings(shader->target, 1,
+			(const GLchar **) &shader->source, NULL);
 	}
 
-	/* This hack is so that we can tell the difference between GL versions
-	 * and GLSL versions.  All GL versions look like 3.2, and we want the
-	 * integer to be 32.  All GLSL versions look like 1.40, and we want
-	 * the integer to be 140.
+	free_deferred_shaders();
+	return result;
+}
+
+static uint64_t
+program_cache_final_key(void)
+{
+	/* The geometry layout is applied at link time, so it is only
+	 * known to be final now.
 	 */
-	if (tag == VERSION_GLSL) {
-		full_num = (major * 100) + minor;
-	} else {
-		full_num = (major * 10) + minor;
-	}
+	uint64_t key = program_cache_key;
+	key = program_cache_hash(key, &geometry_layout_input_type,
+				 sizeof(geometry_layout_input_type));
+	key = program_cache_hash(key, &geometry_layout_output_type,
+				 sizeof(geometry_layout_output_type));
+	key = program_cache_hash(key, &geometry_layout_vertices_out,
+				 sizeof(geometry_layout_vertices_out));
+	return key;
+}
 
-	version_init(v, tag, core, es, full_num);
+static void
+program_cache_path(char *path, size_t size)
+{
+	snprintf(path, size, "%s%c%016" PRIx64 ".bin",
+		 program_cache_dir, PIGLIT_PATH_SEP, program_cache_final_key());
 }
 
 /**
- * Parse and check a line from the requirement section of the test
+ * Create the program from a binary.  On success the program is linked,
+ * and the deferred shaders are dropped.
  */
-static enum piglit_result
-process_requirement(const char *line)
+static bool
+program_from_binary(GLenum format, const void *binary, GLint size)
 {
-	char buffer[4096];
-	static const struct {
-		const char *name;
-		int *val;
-		const char *desc;
-	} getint_limits[] = {
-		{
+	GLint ok = GL_FALSE;
+
+	prog = glCreateProgram();
+	glProgramBinary(prog, format, binary, size);
+
+	/* The driver is free to reject binaries, for example after an
+	 * update that didn't change the version string.
+	 */
+	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	if (!piglit_check_gl_error(GL_NO_ERROR) || !ok) {
+		glDeleteProgram(prog);
+		prog = 0;
+		return false;
+	}
+
+	free_deferred_shaders();
+	return true;
+}
+
+/**
+ * Try to create the program from a cached binary, kept in memory or in
+ * the cache directory.  On success the program is linked, and the
+ * deferred shaders are dropped.
+ */
+static bool
+program_cache_load(void)
+{
+	char path[4096];
+	FILE *f;
+	long size;
+	GLenum format;
+	void *binary;
+	bool ok;
+	unsigned i;
+
+	if (program_cache_in_memory) {
+		uint64_t key = program_cache_final_key();
+
+		for (i = 0; i < num_cached_binaries; i++) {
+			if (cached_binaries[i].key == key)
+				return program_from_binary(
+					cached_binaries[i].format,
+					cached_binaries[i].binary,
+					cached_binaries[i].size);
+		}
+	}
+
+	if (program_cache_dir == NULL)
+		return false;
+
+	program_cache_path(path, sizeof(path));
+
+	f = fopen(path, "rb");
+	if (f == NULL)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	size = ftell(f) - (long) sizeof(format);
+	fseek(f, 0, SEEK_SET);
+
+	if (size <= 0 || fread(&format, sizeof(format), 1, f) != 1) {
+		fclose(f);
+		return false;
+	}
+
+	binary = malloc(size);
+	if (fread(binary, 1, size, f) != (size_t) size) {
+		free(binary);
+		fclose(f);
+		return false;
+	}
+	fclose(f);
+
+	ok = program_from_binary(format, binary, size);
+	free(binary);
+	return ok;
+}
+
+/**
+ * Store the binary of the just linked program in the cache.  Failures
+ * are not fatal, the test simply runs uncached next time.
+ */
+static void
+program_cache_store(void)
+{
+	char path[4096], tmp_path[4096 + 32];
+	GLint size = 0;
+	GLenum format;
+	void *binary;
+	FILE *f;
+	bool ok;
+
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+
+	binary = malloc(size);
+	glGetProgramBinary(prog, size, NULL, &format, binary);
+	if (!piglit_check_gl_error(GL_NO_ERROR)) {
+		free(binary);
+		return;
+	}
+
+	if (program_cache_in_memory) {
+		struct cached_binary *cached;
+
+		cached_binaries = realloc(cached_binaries,
+					  (num_cached_binaries + 1) *
+					  sizeof(*cached_binaries));
+		cached = &cached_binaries[num_cached_binaries++];
+		cached->key = program_cache_final_key();
+		cached->format = format;
+		cached->size = size;
+		cached->binary = malloc(size);
+		memcpy(cached->binary, binary, size);
+	}
+
+	if (program_cache_dir == NULL) {
+		free(binary);
+		return;
+	}
+
+	program_cache_path(path, sizeof(path));
+
+	/* Write to a private file first so that concurrent runs never see
+	 * a partially written entry.
+	 */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%" PRIx64 ".tmp", path,
+		 (uint64_t) piglit_time_get_nano());
+	f = fopen(tmp_path, "wb");
+	if (f == NULL) {
+		free(binary);
+		return;
+	}
+
+	ok = fwrite(&format, sizeof(format), 1, f) == 1 &&
+	     fwrite(binary, 1, size, f) == (size_t) size;
+	ok = fclose(f) == 0 && ok;
+	free(binary);
+
+	if (!ok || rename(tmp_path, path) != 0)
+		remove(tmp_path);
+}
+
+static void
+program_cache_report(void)
+{
+	if (program_cache_dir == NULL)
+		return;
+
+	fprintf(stderr,
+		"PIGLIT SHADER CACHE: %u hits, %u misses, %u bypassed\n",
+		program_cache_hits, program_cache_misses,
+		program_cache_bypassed);
+}
+/*@}*/
+
+static enum piglit_result
+compile_glsl(GLenum target)
+{
+	switch (target) {
+	case GL_VERTEX_SHADER:
+		if (piglit_get_gl_version() < 20 &&
+		    !(piglit_is_extension_supported("GL_ARB_shader_objects") &&
+		      piglit_is_extension_supported("GL_ARB_vertex_shader")))
+			return PIGLIT_SKIP;
+		break;
+	case GL_FRAGMENT_SHADER:
+		if (piglit_get_gl_version() < 20 &&
+		    !(piglit_is_extension_supported("GL_ARB_shader_objects") &&
+		      piglit_is_extension_supported("GL_ARB_fragment_shader")))
+			return PIGLIT_SKIP;
+		break;
+	case GL_TESS_CONTROL_SHADER:
+	case GL_TESS_EVALUATION_SHADER:
+		if (gl_version.num < (gl_version.es ? 32 : 40))
+			if (!piglit_is_extension_supported(gl_version.es ?
+							   "GL_OES_tessellation_shader" :
+							   "GL_ARB_tessellation_shader"))
+				return PIGLIT_SKIP;
+		break;
+	case GL_GEOMETRY_SHADER:
+		if (gl_version.num < 32)
+			if (!piglit_is_extension_supported(gl_version.es ?
+							   "GL_OES_geometry_shader" :
+							   "GL_ARB_geometry_shader4"))
+				return PIGLIT_SKIP;
+		break;
+	case GL_COMPUTE_SHADER:
+		if (gl_version.num < (gl_version.es ? 31 : 43))
+			if (!piglit_is_extension_supported("GL_ARB_compute_shader"))
+				return PIGLIT_SKIP;
+		break;
+	}
+
+	if (!glsl_req_version.num) {
+		printf("GLSL version requirement missing\n");
+		return PIGLIT_FAIL;
+	}
+
+	if (!strstr(shader_string, "#version ")) {
+		char *shader_strings[2];
+		char version_string[100];
+		GLint shader_string_sizes[2];
+
+		/* Add a #version directive based on the GLSL requirement. */
+		sprintf(version_string, "#version %d", glsl_req_version.num);
+		if (glsl_req_version.es && glsl_req_version.num != 100) {
+			strcat(version_string, " es");
+		}
+		strcat(version_string, "\n");
+		shader_strings[0] = version_string;
+		shader_string_sizes[0] = strlen(version_string);
+		shader_strings[1] = shader_string;
+		shader_string_sizes[1] = shader_string_size;
+
+		if (program_cache_active)
+			return defer_shader(target, 2,
+					    (const GLchar **) shader_strings,
+					    shader_string_sizes);
+
+		return compile_shader_strings(target, 2,
+					      (const GLchar **) shader_strings,
+					      shader_string_sizes);
+	} else {
+		if (program_cache_active)
+			return defer_shader(target, 1,
+					    (const GLchar **) &shader_string,
+					    &shader_string_size);
+
+		return compile_shader_strings(target, 1,
+					      (const GLchar **) &shader_string,
+					      &shader_string_size);
+	}
+}
+
+static enum piglit_result
+compile_and_bind_program(GLenum target, const char *start, int len)
+{
+	GLuint prog;
+	char *source;
+
+	switch (target) {
+	case GL_VERTEX_PROGRAM_ARB:
+		if (!piglit_is_extension_supported("GL_ARB_vertex_program"))
+			return PIGLIT_SKIP;
+		break;
+	case GL_FRAGMENT_PROGRAM_ARB:
+		if (!piglit_is_extension_supported("GL_ARB_fragment_program"))
+			return PIGLIT_SKIP;
+		break;
+	}
+
+	source = malloc(len + 1);
+	memcpy(source, start, len);
+	source[len] = 0;
+	prog = piglit_compile_program(target, source);
+
+	glEnable(target);
+	glBindProgramARB(target, prog);
+	link_ok = true;
+	prog_in_use = true;
+
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
+link_sso(GLenum target)
+{
+	GLint ok;
+
+	glLinkProgram(prog);
+
+	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	if (ok) {
+		link_ok = true;
+	} else {
+		GLint size;
+
+		glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &size);
+		prog_err_info = malloc(size);
+
+		glGetProgramInfoLog(prog, size, NULL, prog_err_info);
+
+		fprintf(stderr, "SSO glLinkProgram(%s) failed: %s\n",
+			target_to_short_name(target),
+			prog_err_info);
+
+		free(prog_err_info);
+		return PIGLIT_FAIL;
+	}
+
+	switch (target) {
+	case GL_VERTEX_SHADER:
+		sso_vertex_prog = prog;
+		glUseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, prog);
+		break;
+	case GL_TESS_CONTROL_SHADER:
+		sso_tess_control_prog = prog;
+		glUseProgramStages(pipeline, GL_TESS_CONTROL_SHADER_BIT, prog);
+		break;
+	case GL_TESS_EVALUATION_SHADER:
+		sso_tess_eval_prog = prog;
+		glUseProgramStages(pipeline, GL_TESS_EVALUATION_SHADER_BIT, prog);
+		break;
+	case GL_GEOMETRY_SHADER:
+		sso_geometry_prog = prog;
+		glUseProgramStages(pipeline, GL_GEOMETRY_SHADER_BIT, prog);
+		break;
+	case GL_FRAGMENT_SHADER:
+		sso_fragment_prog = prog;
+		glUseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, prog);
+		break;
+	case GL_COMPUTE_SHADER:
+		sso_compute_prog = prog;
+		glUseProgramStages(pipeline, GL_COMPUTE_SHADER_BIT, prog);
+		break;
+	}
+	return PIGLIT_PASS;
+}
+
+/**
+ * Compare two values given a specified comparison operator
+ */
+static bool
+compare(float ref, float value, enum comparison cmp)
+{
+	switch (cmp) {
+	case equal:         return value == ref;
+	case not_equal:     return value != ref;
+	case less:          return value <  ref;
+	case greater_equal: return value >= ref;
+	case greater:       return value >  ref;
+	case less_equal:    return value <= ref;
+	}
+
+	assert(!"Should not get here.");
+	return false;
+}
+
+static bool
+compare_uint(GLuint ref, GLuint value, enum comparison cmp)
+{
+	switch (cmp) {
+	case equal:         return value == ref;
+	case not_equal:     return value != ref;
+	case less:          return value <  ref;
+	case greater_equal: return value >= ref;
+	case greater:       return value >  ref;
+	case less_equal:    return value <= ref;
+	}
+
+	assert(!"Should not get here.");
+	return false;
+}
+
+/**
+ * Get the string representation of a comparison operator
+ */
+static const char *
+comparison_string(enum comparison cmp)
+{
+	switch (cmp) {
+	case equal:         return "==";
+	case not_equal:     return "!=";
+	case less:          return "<";
+	case greater_equal: return ">=";
+	case greater:       return ">";
+	case less_equal:    return "<=";
+	}
+
+	assert(!"Should not get here.");
+	return false;
+}
+
+/**
+ * " ES" before the comparison operator indicates the version
+ * pertains to GL ES.
+ */
+static void
+parse_version_comparison(const char *line, enum comparison *cmp,
+			 struct component_version *v, enum version_tag tag)
+{
+	unsigned major;
+	unsigned minor;
+	unsigned full_num;
+	const bool core = parse_str(line, "CORE", &line);
+	const bool es = parse_str(line, "ES", &line);
+
+	REQUIRE(parse_comparison_op(line, cmp, &line),
+		"Invalid comparison operation at: %s\n", line);
+
+	REQUIRE(parse_uint(line, &major, &line) &&
+		parse_str(line, ".", &line) &&
+		parse_uint(line, &minor, &line),
+		"Invalid version string: %s\n", line);
+
+	parse_whitespace(line, &line);
+	if (*line != '\n') {
+		printf("Unexpected characters following version comparison\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	/* This hack is so that we can tell the difference between GL versions
+	 * and GLSL versions.  All GL versions look like 3.2, and we want the
+	 * integer to be 32.  All GLSL versions look like 1.40, and we want
+	 * the integer to be 140.
+	 */
+	if (tag == VERSION_GLSL) {
+		full_num = (major * 100) + minor;
+	} else {
+		full_num = (major * 10) + minor;
+	}
+
+	version_init(v, tag, core, es, full_num);
+}
+
+/**
+ * Parse and check a line from the requirement section of the test
+ */
+static enum piglit_result
+process_requirement(const char *line)
+{
+	char buffer[4096];
+	static const struct {
+		const char *name;
+		int *val;
+		const char *desc;
+	} getint_limits[] = {
+		{
 			"GL_MAX_VERTEX_OUTPUT_COMPONENTS",
 			&gl_max_vertex_output_components,
 			"vertex output components",
@@ -766,6 +1183,8 @@ process_requirement(const char *line)
 	};
 	unsigned i;
 
+	program_cache_add_requirement(line);
+
 	/* The INT keyword in the requirements section causes
 	 * shader_runner to read the specified integer value and
 	 * processes the given requirement.
@@ -904,6 +1323,15 @@ process_requirement(const char *line)
 
 		sso_in_use = true;
 		glGenProgramPipelines(1, &pipeline);
+
+		/* Separable programs are linked per stage, which the
+		 * program cache doesn't handle.
+		 */
+		if (program_cache_active) {
+			program_cache_active = false;
+			program_cache_bypassed++;
+			free_deferred_shaders();
+		}
 	}
 	return PIGLIT_PASS;
 }
@@ -942,6 +1370,9 @@ leave_state(enum states state, const char *line)
 	case none:
 		break;
 
+	case parameters:
+		break;
+
 	case requirements:
 		break;
 
@@ -1052,6 +1483,22 @@ link_and_use_shaders(void)
 	GLenum err;
 	GLint ok;
 
+	if (program_cache_active && num_deferred_shaders) {
+		if (program_cache_load()) {
+			program_cache_hits++;
+			link_ok = true;
+			glUseProgram(prog);
+			if (!glGetError())
+				prog_in_use = true;
+			return PIGLIT_PASS;
+		}
+
+		program_cache_misses++;
+		result = compile_deferred_shaders();
+		if (result != PIGLIT_PASS)
+			return result;
+	}
+
 	if ((num_vertex_shaders == 0)
 	    && (num_fragment_shaders == 0)
 	    && (num_tess_ctrl_shaders == 0)
@@ -1082,13 +1529,20 @@ link_and_use_shaders(void)
 	if (result != PIGLIT_PASS)
 		goto cleanup;
 
-	if (!sso_in_use)
+	if (!sso_in_use) {
+		if (program_cache_active)
+			glProgramParameteri(prog,
+					    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+					    GL_TRUE);
 		glLinkProgram(prog);
+	}
 
 	if (!sso_in_use) {
 		glGetProgramiv(prog, GL_LINK_STATUS, &ok);
 		if (ok) {
 			link_ok = true;
+			if (program_cache_active)
+				program_cache_store();
 		} else {
 			GLint size;
 
@@ -1152,19 +1606,14 @@ cleanup:
 
 
 static enum piglit_result
-process_test_script(const char *script_name)
+process_test_script(const char *text)
 {
-	unsigned text_size;
 	unsigned line_num;
-	char *text = piglit_load_text_file(script_name, &text_size);
 	enum states state = none;
 	const char *line = text;
 	enum piglit_result result;
 
-	if (line == NULL) {
-		printf("could not read file \"%s\"\n", script_name);
-		return PIGLIT_FAIL;
-	}
+	program_cache_begin(text);
 
 	line_num = 1;
 
@@ -1176,6 +1625,9 @@ process_test_script(const char *script_name)
 
 			if (parse_str(line, "[require]", NULL)) {
 				state = requirements;
+			} else if (parse_str(line, "[parameters]", NULL)) {
+				/* Already expanded, see run_parameter_rows() */
+				state = parameters;
 			} else if (parse_str(line, "[vertex shader]", NULL)) {
 				state = vertex_shader;
 				shader_string = NULL;
@@ -1226,6 +1678,7 @@ process_test_script(const char *script_name)
 		} else {
 			switch (state) {
 			case none:
+			case parameters:
 			case vertex_shader_passthrough:
 				break;
 
@@ -2839,85 +3292,1409 @@ probe_atomic_counter(unsigned buffer_num, GLint counter_num, const char *op, uin
 	p = glMapNamedBufferRange(atomics_bos[buffer_num], counter_num * sizeof(uint32_t),
 			     sizeof(uint32_t), GL_MAP_READ_BIT);
 
-        if (!p) {
-                printf("Couldn't map atomic counter to verify expected value.\n");
-                return false;
-        }
+        if (!p) {
+                printf("Couldn't map atomic counter to verify expected value.\n");
+                return false;
+        }
+
+	observed = *p;
+	result = compare_uint(value, observed, cmp);
+
+	if (!result) {
+		printf("Atomic counter %d test failed: Reference %s Observed\n",
+		       counter_num, comparison_string(cmp));
+		printf("  Reference: %u\n", value);
+		printf("  Observed:  %u\n", observed);
+		glUnmapNamedBuffer(atomics_bos[buffer_num]);
+		return false;
+        }
+
+        glUnmapNamedBuffer(atomics_bos[buffer_num]);
+        return true;
+}
+
+static bool
+probe_ssbo_uint(GLint ssbo_index, GLint ssbo_offset, const char *op, uint32_t value)
+{
+	uint32_t *p;
+	uint32_t observed;
+	enum comparison cmp;
+	bool result;
+
+	REQUIRE(parse_comparison_op(op, &cmp, NULL),
+		"Invalid comparison operation at: %s\n", op);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
+	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
+			     sizeof(uint32_t), GL_MAP_READ_BIT);
+
+	if (!p) {
+		printf("Couldn't map ssbo to verify expected value.\n");
+		return false;
+	}
+
+	observed = *p;
+	result = compare_uint(value, observed, cmp);
+
+	if (!result) {
+		printf("SSBO %d test failed: Reference %s Observed\n",
+		       ssbo_offset, comparison_string(cmp));
+		printf("  Reference: %u\n", value);
+		printf("  Observed:  %u\n", observed);
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		return false;
+	}
+
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	return true;
+}
+
+struct test_run_state {
+	GLbitfield clear_bits;
+	bool link_error_expected;
+	int ubo_array_index;
+	/** Pixels read back for the current run of probes, if any. */
+	const struct piglit_probe_region *probe_region;
+};
+
+/**
+ * Execute one line of the [test] section through the textual command
+ * dispatch.  This is the slow path, used for commands that
+ * compile_test_section() doesn't know how to pre-decode.
+ */
+static enum piglit_result
+process_test_line(const char *line, struct test_run_state *state)
+{
+	float c[32];
+	double d[4];
+	int x, y, z, w, h, l, tex, level;
+	unsigned ux, uy;
+	char s[300]; // 300 for safety
+	const char *rest;
+	enum piglit_result result = PIGLIT_PASS;
+	if (line[0] == '\0') {
+	} else if (sscanf(line, "active shader program %s", s) == 1) {
+		switch (get_shader_from_string(s, &x)) {
+		case GL_VERTEX_SHADER:
+			glActiveShaderProgram(pipeline, sso_vertex_prog);
+		break;
+		case GL_TESS_CONTROL_SHADER:
+			glActiveShaderProgram(pipeline, sso_tess_control_prog);
+		break;
+		case GL_TESS_EVALUATION_SHADER:
+			glActiveShaderProgram(pipeline, sso_tess_eval_prog);
+		break;
+		case GL_GEOMETRY_SHADER:
+			glActiveShaderProgram(pipeline, sso_geometry_prog);
+		break;
+		case GL_FRAGMENT_SHADER:
+			glActiveShaderProgram(pipeline, sso_fragment_prog);
+		break;
+		case GL_COMPUTE_SHADER:
+			glActiveShaderProgram(pipeline, sso_compute_prog);
+		break;
+		}
+	} else if (sscanf(line, "atomic counter buffer %u %u", &x, &y) == 2) {
+		GLuint *atomics_buf = calloc(y, sizeof(GLuint));
+		glGenBuffers(1, &atomics_bos[x]);
+		glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, x, atomics_bos[x]);
+		glBufferData(GL_ATOMIC_COUNTER_BUFFER,
+			     sizeof(GLuint) * y, atomics_buf,
+			     GL_STATIC_DRAW);
+		free(atomics_buf);
+	} else if (sscanf(line, "atomic counters %d", &x) == 1) {
+		GLuint *atomics_buf = calloc(x, sizeof(GLuint));
+		glGenBuffers(1, &atomics_bos[0]);
+		glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, atomics_bos[0]);
+		glBufferData(GL_ATOMIC_COUNTER_BUFFER,
+			     sizeof(GLuint) * x,
+			     atomics_buf, GL_STATIC_DRAW);
+		free(atomics_buf);
+	} else if (sscanf(line, "atomic counter %u %u %u", &x, &y, &z) == 3) {
+		glNamedBufferSubData(atomics_bos[x],
+				     sizeof(GLuint) * y, sizeof(GLuint),
+				     &z);
+	} else if (parse_str(line, "clear color ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		glClearColor(c[0], c[1], c[2], c[3]);
+		state->clear_bits |= GL_COLOR_BUFFER_BIT;
+	} else if (parse_str(line, "clear depth ", &rest)) {
+		parse_floats(rest, c, 1, NULL);
+		glClearDepth(c[0]);
+		state->clear_bits |= GL_DEPTH_BUFFER_BIT;
+	} else if (parse_str(line, "clear", NULL)) {
+		glClear(state->clear_bits);
+	} else if (sscanf(line,
+			  "clip plane %d %lf %lf %lf %lf",
+			  &x, &d[0], &d[1], &d[2], &d[3]) == 5) {
+		if (x < 0 || x >= gl_max_clip_planes) {
+			printf("clip plane id %d out of range\n", x);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+		glClipPlane(GL_CLIP_PLANE0 + x, d);
+	} else if (sscanf(line,
+			  "compute %d %d %d",
+			  &x, &y, &z) == 3) {
+		result = program_must_be_in_use();
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		glDispatchCompute(x, y, z);
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+	} else if (sscanf(line,
+			  "compute group size %d %d %d %d %d %d",
+			  &x, &y, &z, &w, &h, &l) == 6) {
+		result = program_must_be_in_use();
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		glDispatchComputeGroupSizeARB(x, y, z, w, h, l);
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+	} else if (parse_str(line, "draw rect tex ", &rest)) {
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		parse_floats(rest, c, 8, NULL);
+		piglit_draw_rect_tex(c[0], c[1], c[2], c[3],
+				     c[4], c[5], c[6], c[7]);
+	} else if (parse_str(line, "draw rect ortho patch ", &rest)) {
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		parse_floats(rest, c, 4, NULL);
+
+		piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
+					-1.0 + 2.0 * (c[1] / piglit_height),
+					2.0 * (c[2] / piglit_width),
+					2.0 * (c[3] / piglit_height), true, 1);
+	} else if (parse_str(line, "draw rect ortho ", &rest)) {
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		parse_floats(rest, c, 4, NULL);
+
+		piglit_draw_rect(-1.0 + 2.0 * (c[0] / piglit_width),
+				 -1.0 + 2.0 * (c[1] / piglit_height),
+				 2.0 * (c[2] / piglit_width),
+				 2.0 * (c[3] / piglit_height));
+	} else if (parse_str(line, "draw rect patch ", &rest)) {
+		result = program_must_be_in_use();
+		parse_floats(rest, c, 4, NULL);
+		piglit_draw_rect_custom(c[0], c[1], c[2], c[3], true, 1);
+	} else if (parse_str(line, "draw rect ", &rest)) {
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		parse_floats(rest, c, 4, NULL);
+		piglit_draw_rect(c[0], c[1], c[2], c[3]);
+	} else if (parse_str(line, "draw instanced rect ortho patch ", &rest)) {
+		int instance_count;
+
+		result = program_must_be_in_use();
+		sscanf(rest, "%d %f %f %f %f",
+		       &instance_count,
+		       c + 0, c + 1, c + 2, c + 3);
+		piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
+					-1.0 + 2.0 * (c[1] / piglit_height),
+					2.0 * (c[2] / piglit_width),
+					2.0 * (c[3] / piglit_height), true,
+					instance_count);
+	} else if (parse_str(line, "draw instanced rect ortho ", &rest)) {
+		int instance_count;
+
+		result = program_must_be_in_use();
+		sscanf(rest, "%d %f %f %f %f",
+		       &instance_count,
+		       c + 0, c + 1, c + 2, c + 3);
+		piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
+					-1.0 + 2.0 * (c[1] / piglit_height),
+					2.0 * (c[2] / piglit_width),
+					2.0 * (c[3] / piglit_height), false,
+					instance_count);
+	} else if (parse_str(line, "draw instanced rect ", &rest)) {
+		int primcount;
+
+		result = program_must_be_in_use();
+		sscanf(rest, "%d %f %f %f %f",
+		       &primcount,
+		       c + 0, c + 1, c + 2, c + 3);
+		draw_instanced_rect(primcount, c[0], c[1], c[2], c[3]);
+	} else if (sscanf(line, "draw arrays instanced %31s %d %d %d", s, &x, &y, &z) == 4) {
+		GLenum mode = decode_drawing_mode(s);
+		int first = x;
+		size_t count = (size_t) y;
+		size_t primcount = (size_t) z;
+		draw_arrays_common(first, count);
+		glDrawArraysInstanced(mode, first, count, primcount);
+	} else if (sscanf(line, "draw arrays %31s %d %d", s, &x, &y) == 3) {
+		GLenum mode = decode_drawing_mode(s);
+		int first = x;
+		size_t count = (size_t) y;
+		result = draw_arrays_common(first, count);
+		glDrawArrays(mode, first, count);
+	} else if (parse_str(line, "disable ", &rest)) {
+		do_enable_disable(rest, false);
+	} else if (parse_str(line, "enable ", &rest)) {
+		do_enable_disable(rest, true);
+	} else if (sscanf(line, "depthfunc %31s", s) == 1) {
+		glDepthFunc(piglit_get_gl_enum_from_name(s));
+	} else if (parse_str(line, "fb ", &rest)) {
+		const GLenum target =
+			parse_str(rest, "draw ", &rest) ? GL_DRAW_FRAMEBUFFER :
+			parse_str(rest, "read ", &rest) ? GL_READ_FRAMEBUFFER :
+			GL_FRAMEBUFFER;
+		GLuint fbo = 0;
+
+		if (parse_str(rest, "tex 2d ", &rest)) {
+			GLenum attachments[32];
+			unsigned num_attachments = 0;
+
+			glGenFramebuffers(1, &fbo);
+			glBindFramebuffer(target, fbo);
+
+			while (parse_int(rest, &tex, &rest)) {
+				attachments[num_attachments] =
+					GL_COLOR_ATTACHMENT0 + num_attachments;
+				glFramebufferTexture2D(
+					target, attachments[num_attachments],
+					GL_TEXTURE_2D,
+					get_texture_binding(tex)->obj, 0);
+
+				if (!piglit_check_gl_error(GL_NO_ERROR)) {
+					fprintf(stderr,
+						"glFramebufferTexture2D error\n");
+					piglit_report_result(PIGLIT_FAIL);
+				}
+
+				num_attachments++;
+			}
+
+			if (target != GL_READ_FRAMEBUFFER)
+				glDrawBuffers(num_attachments, attachments);
+
+			w = get_texture_binding(tex)->width;
+			h = get_texture_binding(tex)->height;
+
+		} else if (parse_str(rest, "tex slice ", &rest)) {
+			GLenum tex_target;
+
+			REQUIRE(parse_tex_target(rest, &tex_target, &rest) &&
+				parse_int(rest, &tex, &rest) &&
+				parse_int(rest, &l, &rest) &&
+				parse_int(rest, &z, &rest),
+				"Framebuffer binding command not "
+				"understood at: %s\n", rest);
+
+			const GLuint tex_obj = get_texture_binding(tex)->obj;
+
+			glGenFramebuffers(1, &fbo);
+			glBindFramebuffer(target, fbo);
+
+			if (tex_target == GL_TEXTURE_1D) {
+				REQUIRE(z == 0,
+					"Invalid layer index provided "
+					"in command: %s\n", line);
+				glFramebufferTexture1D(
+					target, GL_COLOR_ATTACHMENT0,
+					tex_target, tex_obj, l);
+
+			} else if (tex_target == GL_TEXTURE_2D ||
+				   tex_target == GL_TEXTURE_RECTANGLE ||
+				   tex_target == GL_TEXTURE_2D_MULTISAMPLE) {
+				REQUIRE(z == 0,
+					"Invalid layer index provided "
+					"in command: %s\n", line);
+				glFramebufferTexture2D(
+					target, GL_COLOR_ATTACHMENT0,
+					tex_target, tex_obj, l);
+
+			} else if (tex_target == GL_TEXTURE_CUBE_MAP) {
+				static const GLenum cubemap_targets[] = {
+					GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+					GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+					GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
+					GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+					GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
+					GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
+				};
+				REQUIRE(z < ARRAY_SIZE(cubemap_targets),
+					"Invalid layer index provided "
+					"in command: %s\n", line);
+				tex_target = cubemap_targets[z];
+
+				glFramebufferTexture2D(
+					target, GL_COLOR_ATTACHMENT0,
+					tex_target, tex_obj, l);
+
+			} else {
+				glFramebufferTextureLayer(
+					target, GL_COLOR_ATTACHMENT0,
+					tex_obj, l, z);
+			}
+
+			if (!piglit_check_gl_error(GL_NO_ERROR)) {
+				fprintf(stderr, "Error binding texture "
+					"attachment for command: %s\n",
+					line);
+				piglit_report_result(PIGLIT_FAIL);
+			}
+
+			w = MAX2(1, get_texture_binding(tex)->width >> l);
+			h = MAX2(1, get_texture_binding(tex)->height >> l);
+
+		} else if (sscanf(rest, "tex layered %d", &tex) == 1) {
+			glGenFramebuffers(1, &fbo);
+			glBindFramebuffer(target, fbo);
+
+			glFramebufferTexture(
+				target, GL_COLOR_ATTACHMENT0,
+				get_texture_binding(tex)->obj, 0);
+			if (!piglit_check_gl_error(GL_NO_ERROR)) {
+				fprintf(stderr,
+					"glFramebufferTexture error\n");
+				piglit_report_result(PIGLIT_FAIL);
+			}
+
+			w = get_texture_binding(tex)->width;
+			h = get_texture_binding(tex)->height;
+
+		} else if (parse_str(rest, "ms ", &rest)) {
+			GLuint rb;
+			GLenum format;
+			int samples;
+
+			REQUIRE(parse_enum_gl(rest, &format, &rest) &&
+				parse_int(rest, &w, &rest) &&
+				parse_int(rest, &h, &rest) &&
+				parse_int(rest, &samples, &rest),
+				"Framebuffer binding command not "
+				"understood at: %s\n", rest);
+
+			glGenFramebuffers(1, &fbo);
+			glBindFramebuffer(target, fbo);
+
+			glGenRenderbuffers(1, &rb);
+			glBindRenderbuffer(GL_RENDERBUFFER, rb);
+
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+							 format, w, h);
+
+			glFramebufferRenderbuffer(target,
+						  GL_COLOR_ATTACHMENT0,
+						  GL_RENDERBUFFER, rb);
+
+			if (!piglit_check_gl_error(GL_NO_ERROR)) {
+				fprintf(stderr, "glFramebufferRenderbuffer error\n");
+				piglit_report_result(PIGLIT_FAIL);
+			}
+
+		} else if (parse_str(rest, "winsys", &rest)) {
+			fbo = piglit_winsys_fbo;
+			glBindFramebuffer(target, fbo);
+			if (!piglit_check_gl_error(GL_NO_ERROR)) {
+				fprintf(stderr, "glBindFramebuffer error\n");
+				piglit_report_result(PIGLIT_FAIL);
+			}
+
+			w = piglit_width;
+			h = piglit_height;
+
+		} else {
+			fprintf(stderr, "Unknown fb bind subcommand "
+				"\"%s\"\n", rest);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		const GLenum status = glCheckFramebufferStatus(target);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			fprintf(stderr, "incomplete fbo (status 0x%x)\n",
+				status);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		if (target != GL_READ_FRAMEBUFFER) {
+			render_width = w;
+			render_height = h;
+
+			/* Delete the previous draw FB in case
+			 * it's no longer reachable.
+			 */
+			if (draw_fbo != 0 &&
+			    draw_fbo != piglit_winsys_fbo &&
+			    draw_fbo != (target == GL_DRAW_FRAMEBUFFER ?
+					 read_fbo : 0))
+				glDeleteFramebuffers(1, &draw_fbo);
+
+			draw_fbo = fbo;
+		}
+
+		if (target != GL_DRAW_FRAMEBUFFER) {
+			read_width = w;
+			read_height = h;
+
+			/* Delete the previous read FB in case
+			 * it's no longer reachable.
+			 */
+			if (read_fbo != 0 &&
+			    read_fbo != piglit_winsys_fbo &&
+			    read_fbo != (target == GL_READ_FRAMEBUFFER ?
+					 draw_fbo : 0))
+				glDeleteFramebuffers(1, &read_fbo);
+
+			read_fbo = fbo;
+		}
+
+	} else if (parse_str(line, "blit ", &rest)) {
+		static const struct string_to_enum buffers[] = {
+			{ "color", GL_COLOR_BUFFER_BIT },
+			{ "depth", GL_DEPTH_BUFFER_BIT },
+			{ "stencil", GL_STENCIL_BUFFER_BIT },
+			{ NULL }
+		};
+		static const struct string_to_enum filters[] = {
+			{ "linear", GL_LINEAR },
+			{ "nearest", GL_NEAREST },
+			{ NULL }
+		};
+		unsigned buffer, filter;
+
+		REQUIRE(parse_enum_tab(buffers, rest, &buffer, &rest) &&
+			parse_enum_tab(filters, rest, &filter, &rest),
+			"FB blit command not understood at: %s\n",
+			rest);
+
+		glBlitFramebuffer(0, 0, read_width, read_height,
+				  0, 0, render_width, render_height,
+				  buffer, filter);
+
+		if (!piglit_check_gl_error(GL_NO_ERROR)) {
+			fprintf(stderr, "glBlitFramebuffer error\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+	} else if (parse_str(line, "frustum", &rest)) {
+		parse_floats(rest, c, 6, NULL);
+		piglit_frustum_projection(false, c[0], c[1], c[2],
+					  c[3], c[4], c[5]);
+	} else if (parse_str(line, "hint", &rest)) {
+		do_hint(rest);
+	} else if (sscanf(line,
+			  "image texture %d %31s",
+			  &tex, s) == 2) {
+		const GLenum img_fmt = piglit_get_gl_enum_from_name(s);
+		glBindImageTexture(tex, get_texture_binding(tex)->obj, 0,
+				   GL_FALSE, 0, GL_READ_WRITE, img_fmt);
+	} else if (sscanf(line, "memory barrier %s", s) == 1) {
+		glMemoryBarrier(piglit_get_gl_memory_barrier_enum_from_name(s));
+	} else if (parse_str(line, "blend barrier", NULL)) {
+		glBlendBarrier();
+	} else if (sscanf(line, "ortho %f %f %f %f",
+			  c + 0, c + 1, c + 2, c + 3) == 4) {
+		piglit_gen_ortho_projection(c[0], c[1], c[2], c[3],
+					    -1, 1, GL_FALSE);
+	} else if (parse_str(line, "ortho", NULL)) {
+		piglit_ortho_projection(render_width, render_height,
+					GL_FALSE);
+	} else if (parse_str(line, "probe rgba ", &rest)) {
+		parse_floats(rest, c, 6, NULL);
+		if (!piglit_probe_pixel_rgba((int) c[0], (int) c[1],
+					    & c[2])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (parse_str(line, "probe depth ", &rest)) {
+		parse_floats(rest, c, 3, NULL);
+		if (!piglit_probe_pixel_depth((int) c[0], (int) c[1],
+					      c[2])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (sscanf(line,
+			  "probe atomic counter %u %s %u",
+			  &ux, s, &uy) == 3) {
+		if (!probe_atomic_counter(0, ux, s, uy)) {
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	} else if (sscanf(line, "probe ssbo uint %d %d %s 0x%x",
+			  &x, &y, s, &z) == 4) {
+		if (!probe_ssbo_uint(x, y, s, z))
+			result = PIGLIT_FAIL;
+	} else if (sscanf(line, "probe ssbo uint %d %d %s %d",
+			  &x, &y, s, &z) == 4) {
+		if (!probe_ssbo_uint(x, y, s, z))
+			result = PIGLIT_FAIL;
+	} else if (sscanf(line,
+			  "relative probe rgba ( %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  c + 0, c + 1,
+			  c + 2, c + 3, c + 4, c + 5) == 6) {
+		x = c[0] * read_width;
+		y = c[1] * read_height;
+		if (x >= read_width)
+			x = read_width - 1;
+		if (y >= read_height)
+			y = read_height - 1;
+
+		if (!piglit_probe_pixel_rgba(x, y, &c[2])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (parse_str(line, "probe rgb ", &rest)) {
+		parse_floats(rest, c, 5, NULL);
+		if (!piglit_probe_pixel_rgb((int) c[0], (int) c[1],
+					    & c[2])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (sscanf(line,
+			  "relative probe rgb ( %f , %f ) "
+			  "( %f , %f , %f )",
+			  c + 0, c + 1,
+			  c + 2, c + 3, c + 4) == 5) {
+		x = c[0] * read_width;
+		y = c[1] * read_height;
+		if (x >= read_width)
+			x = read_width - 1;
+		if (y >= read_height)
+			y = read_height - 1;
+
+		if (!piglit_probe_pixel_rgb(x, y, &c[2])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (sscanf(line, "probe rect rgba "
+			  "( %d , %d , %d , %d ) "
+			  "( %f , %f , %f , %f )",
+			  &x, &y, &w, &h,
+			  c + 0, c + 1, c + 2, c + 3) == 8) {
+		if (!piglit_probe_rect_rgba(x, y, w, h, c)) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (sscanf(line, "relative probe rect rgb "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6) == 7) {
+		x = c[0] * read_width;
+		y = c[1] * read_height;
+		w = c[2] * read_width;
+		h = c[3] * read_height;
+
+		if (!piglit_probe_rect_rgb(x, y, w, h, &c[4])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (sscanf(line, "relative probe rect rgba "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6, c + 7) == 8) {
+		x = c[0] * read_width;
+		y = c[1] * read_height;
+		w = c[2] * read_width;
+		h = c[3] * read_height;
+
+		if (!piglit_probe_rect_rgba(x, y, w, h, &c[4])) {
+			result = PIGLIT_FAIL;
+		}
+	} else if (sscanf(line, "relative probe rect rgba int "
+			  "( %f , %f , %f , %f ) "
+			  "( %d , %d , %d , %d )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  &x, &y, &z, &w) == 8) {
+		const int expected[] = { x, y, z, w };
+		if (!piglit_probe_rect_rgba_int(c[0] * read_width,
+						c[1] * read_height,
+						c[2] * read_width,
+						c[3] * read_height,
+						expected))
+			result = PIGLIT_FAIL;
+
+	} else if (parse_str(line, "polygon mode ", &rest)) {
+		GLenum face, mode;
+
+		REQUIRE(parse_enum_gl(rest, &face, &rest) &&
+			parse_enum_gl(rest, &mode, &rest),
+			"Polygon mode command not understood at %s\n",
+			rest);
+
+		glPolygonMode(face, mode);
+
+		if (!piglit_check_gl_error(GL_NO_ERROR)) {
+			fprintf(stderr, "glPolygonMode error\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	} else if (parse_str(line, "probe all rgba ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		if (result != PIGLIT_FAIL &&
+		    !piglit_probe_rect_rgba(0, 0, read_width,
+					    read_height, c))
+			result = PIGLIT_FAIL;
+	} else if (parse_str(line, "probe warn all rgba ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		if (result == PIGLIT_PASS &&
+		    !piglit_probe_rect_rgba(0, 0, read_width,
+					    read_height, c))
+			result = PIGLIT_WARN;
+	} else if (parse_str(line, "probe all rgb", &rest)) {
+		parse_floats(rest, c, 3, NULL);
+		if (result != PIGLIT_FAIL &&
+		    !piglit_probe_rect_rgb(0, 0, read_width,
+					   read_height, c))
+			result = PIGLIT_FAIL;
+	} else if (parse_str(line, "tolerance", &rest)) {
+		parse_floats(rest, piglit_tolerance, 4, NULL);
+	} else if (parse_str(line, "shade model smooth", NULL)) {
+		glShadeModel(GL_SMOOTH);
+	} else if (parse_str(line, "shade model flat", NULL)) {
+		glShadeModel(GL_FLAT);
+	} else if (sscanf(line, "ssbo %d %d", &x, &y) == 2) {
+		GLuint *ssbo_init = calloc(y, 1);
+		glGenBuffers(1, &ssbo[x]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, x, ssbo[x]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, y,
+			     ssbo_init, GL_DYNAMIC_DRAW);
+		free(ssbo_init);
+	} else if (sscanf(line, "ssbo %d subdata float %d %f", &x, &y, &c[0]) == 3) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo[x]);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, y, 4, &c[0]);
+	} else if (sscanf(line, "texture rgbw %d ( %d", &tex, &w) == 2) {
+		GLenum int_fmt = GL_RGBA;
+		int num_scanned =
+			sscanf(line,
+			       "texture rgbw %d ( %d , %d ) %31s",
+			       &tex, &w, &h, s);
+		if (num_scanned < 3) {
+			fprintf(stderr,
+				"invalid texture rgbw command!\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		if (num_scanned >= 4) {
+			int_fmt = piglit_get_gl_enum_from_name(s);
+		}
+
+		glActiveTexture(GL_TEXTURE0 + tex);
+		int handle = piglit_rgbw_texture(
+			int_fmt, w, h, GL_FALSE, GL_FALSE,
+			(piglit_is_gles() ? GL_UNSIGNED_BYTE :
+			 GL_UNSIGNED_NORMALIZED));
+		set_texture_binding(tex, handle, w, h, 1);
+
+		if (!piglit_is_core_profile &&
+		    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
+			glEnable(GL_TEXTURE_2D);
+
+	} else if (sscanf(line, "resident texture %d", &tex) == 1) {
+		GLuint64 handle;
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		handle = glGetTextureHandleARB(get_texture_binding(tex)->obj);
+		glMakeTextureHandleResidentARB(handle);
+
+		set_resident_handle(tex, handle, true);
+
+		if (!piglit_check_gl_error(GL_NO_ERROR)) {
+			fprintf(stderr,
+				"glMakeTextureHandleResidentARB error\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	} else if (sscanf(line, "resident image texture %d %31s",
+			  &tex, s) == 2) {
+		const GLenum img_fmt = piglit_get_gl_enum_from_name(s);
+		GLuint64 handle;
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		handle = glGetImageHandleARB(get_texture_binding(tex)->obj,
+					     0, GL_FALSE, 0, img_fmt);
+		glMakeImageHandleResidentARB(handle, GL_READ_WRITE);
+
+		set_resident_handle(tex, handle, false);
+
+		if (!piglit_check_gl_error(GL_NO_ERROR)) {
+			fprintf(stderr,
+				"glMakeImageHandleResidentARB error\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	} else if (parse_str(line, "texture integer ", &rest)) {
+		GLenum int_fmt;
+		int b, a;
+		int num_scanned =
+			sscanf(rest, "%d ( %d , %d ) ( %d, %d ) %31s",
+			       &tex, &w, &h, &b, &a, s);
+		if (num_scanned < 6) {
+			fprintf(stderr,
+				"invalid texture integer command!\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		int_fmt = piglit_get_gl_enum_from_name(s);
+
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle =
+			piglit_integer_texture(int_fmt, w, h, b, a);
+		set_texture_binding(tex, handle, w, h, 1);
+
+	} else if (sscanf(line, "texture miptree %d", &tex) == 1) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_miptree_texture();
+		set_texture_binding(tex, handle, 8, 8, 1);
+
+		if (!piglit_is_core_profile &&
+		    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
+			glEnable(GL_TEXTURE_2D);
+	} else if (sscanf(line,
+			  "texture checkerboard %d %d ( %d , %d ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  &tex, &level, &w, &h,
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6, c + 7) == 12) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_checkerboard_texture(
+			0, level, w, h, w / 2, h / 2, c + 0, c + 4);
+		set_texture_binding(tex, handle, w, h, 1);
+
+		if (!piglit_is_core_profile &&
+		    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
+			glEnable(GL_TEXTURE_2D);
+	} else if (sscanf(line,
+			  "texture quads %d %d ( %d , %d ) ( %d , %d ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  &tex, &level, &w, &h, &x, &y,
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6, c + 7,
+			  c + 8, c + 9, c + 10, c + 11,
+			  c + 12, c + 13, c + 14, c + 15) == 22) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_quads_texture(
+			0, level, w, h, x, y, c + 0, c + 4, c + 8, c + 12);
+		set_texture_binding(tex, handle, w, h, 1);
+
+		if (!piglit_is_core_profile &&
+		    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
+			glEnable(GL_TEXTURE_2D);
+	} else if (sscanf(line,
+			  "texture junk 2DArray %d ( %d , %d , %d )",
+			  &tex, &w, &h, &l) == 4) {
+		GLuint texobj;
+		glActiveTexture(GL_TEXTURE0 + tex);
+		glGenTextures(1, &texobj);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texobj);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA,
+			     w, h, l, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		set_texture_binding(tex, texobj, w, h, l);
+
+	} else if (parse_str(line, "texture storage ", &rest)) {
+		GLenum target, format;
+		GLuint tex_obj;
+		int d = h = w = 1;
+
+		REQUIRE(parse_int(rest, &tex, &rest) &&
+			parse_tex_target(rest, &target, &rest) &&
+			parse_enum_gl(rest, &format, &rest) &&
+			parse_str(rest, "(", &rest) &&
+			parse_int(rest, &l, &rest) &&
+			parse_int(rest, &w, &rest),
+			"Texture storage command not understood "
+			"at: %s\n", rest);
+
+		glActiveTexture(GL_TEXTURE0 + tex);
+		glGenTextures(1, &tex_obj);
+		glBindTexture(target, tex_obj);
+
+		if (!parse_int(rest, &h, &rest))
+			glTexStorage1D(target, l, format, w);
+		else if (!parse_int(rest, &d, &rest))
+			glTexStorage2D(target, l, format, w, h);
+		else
+			glTexStorage3D(target, l, format, w, h, d);
+
+		if (!piglit_check_gl_error(GL_NO_ERROR)) {
+			fprintf(stderr, "glTexStorage error\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		if (target == GL_TEXTURE_1D_ARRAY)
+			set_texture_binding(tex, tex_obj, w, 1, h);
+		else
+			set_texture_binding(tex, tex_obj, w, h, d);
+
+	} else if (sscanf(line,
+			  "texture rgbw 2DArray %d ( %d , %d , %d )",
+			  &tex, &w, &h, &l) == 4) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_array_texture(
+			GL_TEXTURE_2D_ARRAY, GL_RGBA, w, h, l, GL_FALSE);
+		set_texture_binding(tex, handle, w, h, l);
+
+	} else if (sscanf(line,
+			  "texture rgbw 1DArray %d ( %d , %d )",
+			  &tex, &w, &l) == 3) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+                        h = 1;
+		const GLuint handle = piglit_array_texture(
+			GL_TEXTURE_1D_ARRAY, GL_RGBA, w, h, l, GL_FALSE);
+		set_texture_binding(tex, handle, w, 1, l);
+
+	} else if (sscanf(line,
+			  "texture shadow2D %d ( %d , %d )",
+			  &tex, &w, &h) == 3) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_depth_texture(
+			GL_TEXTURE_2D, GL_DEPTH_COMPONENT,
+			w, h, 1, GL_FALSE);
+		glTexParameteri(GL_TEXTURE_2D,
+				GL_TEXTURE_COMPARE_MODE,
+				GL_COMPARE_R_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D,
+				GL_TEXTURE_COMPARE_FUNC,
+				GL_GREATER);
+		set_texture_binding(tex, handle, w, h, 1);
+
+		if (!piglit_is_core_profile &&
+		    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
+			glEnable(GL_TEXTURE_2D);
+	} else if (sscanf(line,
+			  "texture shadowRect %d ( %d , %d )",
+			  &tex, &w, &h) == 3) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_depth_texture(
+			GL_TEXTURE_RECTANGLE, GL_DEPTH_COMPONENT,
+			w, h, 1, GL_FALSE);
+		glTexParameteri(GL_TEXTURE_RECTANGLE,
+				GL_TEXTURE_COMPARE_MODE,
+				GL_COMPARE_R_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_RECTANGLE,
+				GL_TEXTURE_COMPARE_FUNC,
+				GL_GREATER);
+		set_texture_binding(tex, handle, w, h, 1);
+	} else if (sscanf(line,
+			  "texture shadow1D %d ( %d )",
+			  &tex, &w) == 2) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_depth_texture(
+			GL_TEXTURE_1D, GL_DEPTH_COMPONENT,
+			w, 1, 1, GL_FALSE);
+		glTexParameteri(GL_TEXTURE_1D,
+				GL_TEXTURE_COMPARE_MODE,
+				GL_COMPARE_R_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_1D,
+				GL_TEXTURE_COMPARE_FUNC,
+				GL_GREATER);
+		set_texture_binding(tex, handle, w, 1, 1);
+	} else if (sscanf(line,
+			  "texture shadow1DArray %d ( %d , %d )",
+			  &tex, &w, &l) == 3) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_depth_texture(
+			GL_TEXTURE_1D_ARRAY, GL_DEPTH_COMPONENT,
+			w, l, 1, GL_FALSE);
+		glTexParameteri(GL_TEXTURE_1D_ARRAY,
+				GL_TEXTURE_COMPARE_MODE,
+				GL_COMPARE_R_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_1D_ARRAY,
+				GL_TEXTURE_COMPARE_FUNC,
+				GL_GREATER);
+		set_texture_binding(tex, handle, w, 1, l);
+	} else if (sscanf(line,
+			  "texture shadow2DArray %d ( %d , %d , %d )",
+			  &tex, &w, &h, &l) == 4) {
+		glActiveTexture(GL_TEXTURE0 + tex);
+		const GLuint handle = piglit_depth_texture(
+			GL_TEXTURE_2D_ARRAY, GL_DEPTH_COMPONENT,
+			w, h, l, GL_FALSE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY,
+				GL_TEXTURE_COMPARE_MODE,
+				GL_COMPARE_R_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY,
+				GL_TEXTURE_COMPARE_FUNC,
+				GL_GREATER);
+		set_texture_binding(tex, handle, w, h, l);
+	} else if (sscanf(line, "texcoord %d ( %f , %f , %f , %f )",
+	                  &x, c + 0, c + 1, c + 2, c + 3) == 5) {
+		glMultiTexCoord4fv(GL_TEXTURE0 + x, c);
+	} else if (parse_str(line, "texparameter ", &rest)) {
+		handle_texparameter(rest);
+	} else if (parse_str(line, "uniform ", &rest)) {
+		result = program_must_be_in_use();
+		set_uniform(rest, state->ubo_array_index);
+	} else if (parse_str(line, "subuniform ", &rest)) {
+		result = program_must_be_in_use();
+		check_shader_subroutine_support();
+		set_subroutine_uniform(rest);
+	} else if (parse_str(line, "parameter ", &rest)) {
+		set_parameter(rest);
+	} else if (parse_str(line, "patch parameter ", &rest)) {
+		set_patch_parameter(rest);
+	} else if (parse_str(line, "provoking vertex ", &rest)) {
+		set_provoking_vertex(rest);
+	} else if (parse_str(line, "link error", &rest)) {
+		state->link_error_expected = true;
+		if (link_ok) {
+			printf("shader link error expected, but it was successful!\n");
+			piglit_report_result(PIGLIT_FAIL);
+		} else {
+			fprintf(stderr, "Failed to link:\n%s\n", prog_err_info);
+		}
+	} else if (parse_str(line, "link success", &rest)) {
+		result = program_must_be_in_use();
+	} else if (parse_str(line, "ubo array index ", &rest)) {
+		parse_ints(rest, &state->ubo_array_index, 1, NULL);
+	} else if (parse_str(line, "active uniform ", &rest)) {
+		active_uniform(rest);
+	} else if (parse_str(line, "verify program_interface_query ", &rest)) {
+		active_program_interface(rest);
+	} else if ((line[0] != '\n') && (line[0] != '\0')
+		   && (line[0] != '#')) {
+		printf("unknown command \"%s\"\n", line);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	return result;
+}
+
+/**
+ * Opcodes of pre-decoded [test] commands.  Anything not listed here is
+ * kept as text and executed by process_test_line().
+ */
+enum test_op {
+	OP_GENERIC,
+	OP_CLEAR_COLOR,
+	OP_CLEAR_DEPTH,
+	OP_CLEAR,
+	OP_COMPUTE,
+	OP_DRAW_RECT_TEX,
+	OP_DRAW_RECT_ORTHO_PATCH,
+	OP_DRAW_RECT_ORTHO,
+	OP_DRAW_RECT_PATCH,
+	OP_DRAW_RECT,
+	OP_DRAW_ARRAYS,
+	OP_ENABLE,
+	OP_DISABLE,
+	OP_PROBE_RGBA,
+	OP_PROBE_RGB,
+	OP_RELATIVE_PROBE_RGBA,
+	OP_RELATIVE_PROBE_RGB,
+	OP_PROBE_RECT_RGBA,
+	OP_RELATIVE_PROBE_RECT_RGB,
+	OP_RELATIVE_PROBE_RECT_RGBA,
+	OP_PROBE_ALL_RGBA,
+	OP_PROBE_WARN_ALL_RGBA,
+	OP_PROBE_ALL_RGB,
+	OP_TOLERANCE,
+	OP_UNIFORM,
+	OP_UBO_ARRAY_INDEX,
+};
+
+struct test_command {
+	enum test_op op;
+
+	/** Line number in the script, used for failure messages. */
+	unsigned line_num;
+
+	/** Original command text, only kept for OP_GENERIC. */
+	char *line;
+
+	/** Enable cap, primitive mode or uniform type. */
+	GLenum e;
+
+	/** Resolved uniform location. */
+	GLint loc;
+
+	/** Number of values parsed into \c v. */
+	unsigned n;
+
+	int i[4];
 
-	observed = *p;
-	result = compare_uint(value, observed, cmp);
+	union {
+		float f[16];
+		double d[16];
+		int i[16];
+		unsigned u[16];
+		int64_t i64[16];
+		uint64_t u64[16];
+	} v;
+};
 
-	if (!result) {
-		printf("Atomic counter %d test failed: Reference %s Observed\n",
-		       counter_num, comparison_string(cmp));
-		printf("  Reference: %u\n", value);
-		printf("  Observed:  %u\n", observed);
-		glUnmapNamedBuffer(atomics_bos[buffer_num]);
-		return false;
-        }
+static struct test_command *test_commands;
+static unsigned num_test_commands;
+static bool test_commands_compiled = false;
+
+enum uniform_base_type {
+	UNIFORM_BASE_FLOAT,
+	UNIFORM_BASE_DOUBLE,
+	UNIFORM_BASE_INT,
+	UNIFORM_BASE_UINT,
+	UNIFORM_BASE_INT64,
+	UNIFORM_BASE_UINT64,
+};
 
-        glUnmapNamedBuffer(atomics_bos[buffer_num]);
-        return true;
-}
+static const struct {
+	const char *name;
+	GLenum type;
+	enum uniform_base_type base;
+	unsigned count;
+} uniform_types[] = {
+	{ "float",    GL_FLOAT,                  UNIFORM_BASE_FLOAT,  1 },
+	{ "vec2",     GL_FLOAT_VEC2,             UNIFORM_BASE_FLOAT,  2 },
+	{ "vec3",     GL_FLOAT_VEC3,             UNIFORM_BASE_FLOAT,  3 },
+	{ "vec4",     GL_FLOAT_VEC4,             UNIFORM_BASE_FLOAT,  4 },
+	{ "int",      GL_INT,                    UNIFORM_BASE_INT,    1 },
+	{ "ivec2",    GL_INT_VEC2,               UNIFORM_BASE_INT,    2 },
+	{ "ivec3",    GL_INT_VEC3,               UNIFORM_BASE_INT,    3 },
+	{ "ivec4",    GL_INT_VEC4,               UNIFORM_BASE_INT,    4 },
+	{ "uint",     GL_UNSIGNED_INT,           UNIFORM_BASE_UINT,   1 },
+	{ "uvec2",    GL_UNSIGNED_INT_VEC2,      UNIFORM_BASE_UINT,   2 },
+	{ "uvec3",    GL_UNSIGNED_INT_VEC3,      UNIFORM_BASE_UINT,   3 },
+	{ "uvec4",    GL_UNSIGNED_INT_VEC4,      UNIFORM_BASE_UINT,   4 },
+	{ "double",   GL_DOUBLE,                 UNIFORM_BASE_DOUBLE, 1 },
+	{ "dvec2",    GL_DOUBLE_VEC2,            UNIFORM_BASE_DOUBLE, 2 },
+	{ "dvec3",    GL_DOUBLE_VEC3,            UNIFORM_BASE_DOUBLE, 3 },
+	{ "dvec4",    GL_DOUBLE_VEC4,            UNIFORM_BASE_DOUBLE, 4 },
+	{ "int64_t",  GL_INT64_ARB,              UNIFORM_BASE_INT64,  1 },
+	{ "i64vec2",  GL_INT64_VEC2_ARB,         UNIFORM_BASE_INT64,  2 },
+	{ "i64vec3",  GL_INT64_VEC3_ARB,         UNIFORM_BASE_INT64,  3 },
+	{ "i64vec4",  GL_INT64_VEC4_ARB,         UNIFORM_BASE_INT64,  4 },
+	{ "uint64_t", GL_UNSIGNED_INT64_ARB,     UNIFORM_BASE_UINT64, 1 },
+	{ "u64vec2",  GL_UNSIGNED_INT64_VEC2_ARB, UNIFORM_BASE_UINT64, 2 },
+	{ "u64vec3",  GL_UNSIGNED_INT64_VEC3_ARB, UNIFORM_BASE_UINT64, 3 },
+	{ "u64vec4",  GL_UNSIGNED_INT64_VEC4_ARB, UNIFORM_BASE_UINT64, 4 },
+	{ "mat2",     GL_FLOAT_MAT2,             UNIFORM_BASE_FLOAT,  4 },
+	{ "mat2x2",   GL_FLOAT_MAT2,             UNIFORM_BASE_FLOAT,  4 },
+	{ "mat2x3",   GL_FLOAT_MAT2x3,           UNIFORM_BASE_FLOAT,  6 },
+	{ "mat2x4",   GL_FLOAT_MAT2x4,           UNIFORM_BASE_FLOAT,  8 },
+	{ "mat3x2",   GL_FLOAT_MAT3x2,           UNIFORM_BASE_FLOAT,  6 },
+	{ "mat3",     GL_FLOAT_MAT3,             UNIFORM_BASE_FLOAT,  9 },
+	{ "mat3x3",   GL_FLOAT_MAT3,             UNIFORM_BASE_FLOAT,  9 },
+	{ "mat3x4",   GL_FLOAT_MAT3x4,           UNIFORM_BASE_FLOAT,  12 },
+	{ "mat4x2",   GL_FLOAT_MAT4x2,           UNIFORM_BASE_FLOAT,  8 },
+	{ "mat4x3",   GL_FLOAT_MAT4x3,           UNIFORM_BASE_FLOAT,  12 },
+	{ "mat4",     GL_FLOAT_MAT4,             UNIFORM_BASE_FLOAT,  16 },
+	{ "mat4x4",   GL_FLOAT_MAT4,             UNIFORM_BASE_FLOAT,  16 },
+	{ "dmat2",    GL_DOUBLE_MAT2,            UNIFORM_BASE_DOUBLE, 4 },
+	{ "dmat2x2",  GL_DOUBLE_MAT2,            UNIFORM_BASE_DOUBLE, 4 },
+	{ "dmat2x3",  GL_DOUBLE_MAT2x3,          UNIFORM_BASE_DOUBLE, 6 },
+	{ "dmat2x4",  GL_DOUBLE_MAT2x4,          UNIFORM_BASE_DOUBLE, 8 },
+	{ "dmat3x2",  GL_DOUBLE_MAT3x2,          UNIFORM_BASE_DOUBLE, 6 },
+	{ "dmat3",    GL_DOUBLE_MAT3,            UNIFORM_BASE_DOUBLE, 9 },
+	{ "dmat3x3",  GL_DOUBLE_MAT3,            UNIFORM_BASE_DOUBLE, 9 },
+	{ "dmat3x4",  GL_DOUBLE_MAT3x4,          UNIFORM_BASE_DOUBLE, 12 },
+	{ "dmat4x2",  GL_DOUBLE_MAT4x2,          UNIFORM_BASE_DOUBLE, 8 },
+	{ "dmat4x3",  GL_DOUBLE_MAT4x3,          UNIFORM_BASE_DOUBLE, 12 },
+	{ "dmat4",    GL_DOUBLE_MAT4,            UNIFORM_BASE_DOUBLE, 16 },
+	{ "dmat4x4",  GL_DOUBLE_MAT4,            UNIFORM_BASE_DOUBLE, 16 },
+};
 
+/**
+ * Pre-decode a "uniform" command, resolving the uniform location once.
+ *
+ * Returns false if the command has to go through set_uniform() instead,
+ * either because it may target a uniform block, refers to state that
+ * only exists at execution time (bindless handles), or is malformed (in
+ * which case set_uniform() produces the usual diagnostics).
+ */
 static bool
-probe_ssbo_uint(GLint ssbo_index, GLint ssbo_offset, const char *op, uint32_t value)
+decode_uniform(const char *line, struct test_command *cmd)
 {
-	uint32_t *p;
-	uint32_t observed;
-	enum comparison cmp;
-	bool result;
+	char name[512], type[512];
+	unsigned i;
 
-	REQUIRE(parse_comparison_op(op, &cmp, NULL),
-		"Invalid comparison operation at: %s\n", op);
+	if (!link_ok || !prog_in_use)
+		return false;
 
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(uint32_t), GL_MAP_READ_BIT);
+	if (!parse_word_copy(line, type, sizeof(type), &line) ||
+	    !parse_word_copy(line, name, sizeof(name), &line))
+		return false;
 
-	if (!p) {
-		printf("Couldn't map ssbo to verify expected value.\n");
+	for (i = 0; i < ARRAY_SIZE(uniform_types); i++) {
+		if (strcmp(type, uniform_types[i].name) == 0)
+			break;
+	}
+	if (i == ARRAY_SIZE(uniform_types))
 		return false;
+
+	if (isdigit(name[0])) {
+		cmd->loc = strtol(name, NULL, 0);
+	} else {
+		GLuint prog;
+
+		if (num_uniform_blocks)
+			return false;
+
+		glGetIntegerv(GL_CURRENT_PROGRAM, (GLint *) &prog);
+		cmd->loc = glGetUniformLocation(prog, name);
+		if (cmd->loc < 0)
+			return false;
 	}
 
-	observed = *p;
-	result = compare_uint(value, observed, cmp);
+	cmd->e = uniform_types[i].type;
+	cmd->n = uniform_types[i].count;
 
-	if (!result) {
-		printf("SSBO %d test failed: Reference %s Observed\n",
-		       ssbo_offset, comparison_string(cmp));
-		printf("  Reference: %u\n", value);
-		printf("  Observed:  %u\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	switch (uniform_types[i].base) {
+	case UNIFORM_BASE_FLOAT:
+		parse_floats(line, cmd->v.f, cmd->n, NULL);
+		break;
+	case UNIFORM_BASE_DOUBLE:
+		check_double_support();
+		parse_doubles(line, cmd->v.d, cmd->n, NULL);
+		break;
+	case UNIFORM_BASE_INT:
+		parse_ints(line, cmd->v.i, cmd->n, NULL);
+		break;
+	case UNIFORM_BASE_UINT:
+		check_unsigned_support();
+		parse_uints(line, cmd->v.u, cmd->n, NULL);
+		break;
+	case UNIFORM_BASE_INT64:
+		check_int64_support();
+		parse_int64s(line, cmd->v.i64, cmd->n, NULL);
+		break;
+	case UNIFORM_BASE_UINT64:
+		check_int64_support();
+		parse_uint64s(line, cmd->v.u64, cmd->n, NULL);
+		break;
+	}
+
+	return true;
+}
+
+static void
+apply_uniform(const struct test_command *cmd)
+{
+	const GLint loc = cmd->loc;
+
+	switch (cmd->e) {
+	case GL_FLOAT:        glUniform1fv(loc, 1, cmd->v.f); break;
+	case GL_FLOAT_VEC2:   glUniform2fv(loc, 1, cmd->v.f); break;
+	case GL_FLOAT_VEC3:   glUniform3fv(loc, 1, cmd->v.f); break;
+	case GL_FLOAT_VEC4:   glUniform4fv(loc, 1, cmd->v.f); break;
+	case GL_INT:          glUniform1iv(loc, 1, cmd->v.i); break;
+	case GL_INT_VEC2:     glUniform2iv(loc, 1, cmd->v.i); break;
+	case GL_INT_VEC3:     glUniform3iv(loc, 1, cmd->v.i); break;
+	case GL_INT_VEC4:     glUniform4iv(loc, 1, cmd->v.i); break;
+	case GL_UNSIGNED_INT:      glUniform1uiv(loc, 1, cmd->v.u); break;
+	case GL_UNSIGNED_INT_VEC2: glUniform2uiv(loc, 1, cmd->v.u); break;
+	case GL_UNSIGNED_INT_VEC3: glUniform3uiv(loc, 1, cmd->v.u); break;
+	case GL_UNSIGNED_INT_VEC4: glUniform4uiv(loc, 1, cmd->v.u); break;
+	case GL_DOUBLE:       glUniform1dv(loc, 1, cmd->v.d); break;
+	case GL_DOUBLE_VEC2:  glUniform2dv(loc, 1, cmd->v.d); break;
+	case GL_DOUBLE_VEC3:  glUniform3dv(loc, 1, cmd->v.d); break;
+	case GL_DOUBLE_VEC4:  glUniform4dv(loc, 1, cmd->v.d); break;
+	case GL_INT64_ARB:      glUniform1i64vARB(loc, 1, cmd->v.i64); break;
+	case GL_INT64_VEC2_ARB: glUniform2i64vARB(loc, 1, cmd->v.i64); break;
+	case GL_INT64_VEC3_ARB: glUniform3i64vARB(loc, 1, cmd->v.i64); break;
+	case GL_INT64_VEC4_ARB: glUniform4i64vARB(loc, 1, cmd->v.i64); break;
+	case GL_UNSIGNED_INT64_ARB:
+		glUniform1ui64vARB(loc, 1, cmd->v.u64);
+		break;
+	case GL_UNSIGNED_INT64_VEC2_ARB:
+		glUniform2ui64vARB(loc, 1, cmd->v.u64);
+		break;
+	case GL_UNSIGNED_INT64_VEC3_ARB:
+		glUniform3ui64vARB(loc, 1, cmd->v.u64);
+		break;
+	case GL_UNSIGNED_INT64_VEC4_ARB:
+		glUniform4ui64vARB(loc, 1, cmd->v.u64);
+		break;
+	case GL_FLOAT_MAT2:
+		glUniformMatrix2fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT2x3:
+		glUniformMatrix2x3fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT2x4:
+		glUniformMatrix2x4fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT3x2:
+		glUniformMatrix3x2fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT3:
+		glUniformMatrix3fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT3x4:
+		glUniformMatrix3x4fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT4x2:
+		glUniformMatrix4x2fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT4x3:
+		glUniformMatrix4x3fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_FLOAT_MAT4:
+		glUniformMatrix4fv(loc, 1, GL_FALSE, cmd->v.f);
+		break;
+	case GL_DOUBLE_MAT2:
+		glUniformMatrix2dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT2x3:
+		glUniformMatrix2x3dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT2x4:
+		glUniformMatrix2x4dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT3x2:
+		glUniformMatrix3x2dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT3:
+		glUniformMatrix3dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT3x4:
+		glUniformMatrix3x4dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT4x2:
+		glUniformMatrix4x2dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT4x3:
+		glUniformMatrix4x3dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	case GL_DOUBLE_MAT4:
+		glUniformMatrix4dv(loc, 1, GL_FALSE, cmd->v.d);
+		break;
+	default:
+		assert(!"Should not get here.");
+	}
+}
+
+/**
+ * Try to turn one line of the [test] section into a pre-decoded command.
+ *
+ * The patterns are tried in the same relative order as in
+ * process_test_line(), and only for commands that no earlier pattern of
+ * process_test_line() could claim, so that both paths always agree on
+ * what a line means.  Returns false if the line must stay textual.
+ */
+static bool
+decode_test_command(const char *line, struct test_command *cmd)
+{
+	const char *rest;
+	char s[32];
+	float *c = cmd->v.f;
+	int *i = cmd->i;
+
+	if (parse_str(line, "clear color ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_CLEAR_COLOR;
+	} else if (parse_str(line, "clear depth ", &rest)) {
+		parse_floats(rest, c, 1, NULL);
+		cmd->op = OP_CLEAR_DEPTH;
+	} else if (parse_str(line, "clear", NULL)) {
+		cmd->op = OP_CLEAR;
+	} else if (sscanf(line, "compute %d %d %d",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_COMPUTE;
+	} else if (parse_str(line, "draw rect tex ", &rest)) {
+		parse_floats(rest, c, 8, NULL);
+		cmd->op = OP_DRAW_RECT_TEX;
+	} else if (parse_str(line, "draw rect ortho patch ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT_ORTHO_PATCH;
+	} else if (parse_str(line, "draw rect ortho ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT_ORTHO;
+	} else if (parse_str(line, "draw rect patch ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT_PATCH;
+	} else if (parse_str(line, "draw rect ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT;
+	} else if (parse_str(line, "draw arrays instanced ", NULL)) {
+		return false;
+	} else if (sscanf(line, "draw arrays %31s %d %d",
+			  s, &i[0], &i[1]) == 3) {
+		cmd->e = decode_drawing_mode(s);
+		cmd->op = OP_DRAW_ARRAYS;
+	} else if (parse_str(line, "disable ", &rest)) {
+		REQUIRE(parse_enum_tab(enable_table, rest, &cmd->e, NULL),
+			"Bad enable/disable enum at: %s\n", rest);
+		cmd->op = OP_DISABLE;
+	} else if (parse_str(line, "enable ", &rest)) {
+		REQUIRE(parse_enum_tab(enable_table, rest, &cmd->e, NULL),
+			"Bad enable/disable enum at: %s\n", rest);
+		cmd->op = OP_ENABLE;
+	} else if (parse_str(line, "probe rgba ", &rest)) {
+		parse_floats(rest, c, 6, NULL);
+		cmd->op = OP_PROBE_RGBA;
+	} else if (sscanf(line,
+			  "relative probe rgba ( %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  c + 0, c + 1,
+			  c + 2, c + 3, c + 4, c + 5) == 6) {
+		cmd->op = OP_RELATIVE_PROBE_RGBA;
+	} else if (parse_str(line, "probe rgb ", &rest)) {
+		parse_floats(rest, c, 5, NULL);
+		cmd->op = OP_PROBE_RGB;
+	} else if (sscanf(line,
+			  "relative probe rgb ( %f , %f ) "
+			  "( %f , %f , %f )",
+			  c + 0, c + 1,
+			  c + 2, c + 3, c + 4) == 5) {
+		cmd->op = OP_RELATIVE_PROBE_RGB;
+	} else if (sscanf(line, "probe rect rgba "
+			  "( %d , %d , %d , %d ) "
+			  "( %f , %f , %f , %f )",
+			  &i[0], &i[1], &i[2], &i[3],
+			  c + 0, c + 1, c + 2, c + 3) == 8) {
+		cmd->op = OP_PROBE_RECT_RGBA;
+	} else if (sscanf(line, "relative probe rect rgb "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6) == 7) {
+		cmd->op = OP_RELATIVE_PROBE_RECT_RGB;
+	} else if (sscanf(line, "relative probe rect rgba "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6, c + 7) == 8) {
+		cmd->op = OP_RELATIVE_PROBE_RECT_RGBA;
+	} else if (parse_str(line, "probe all rgba ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_PROBE_ALL_RGBA;
+	} else if (parse_str(line, "probe warn all rgba ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_PROBE_WARN_ALL_RGBA;
+	} else if (parse_str(line, "probe all rgb", &rest)) {
+		parse_floats(rest, c, 3, NULL);
+		cmd->op = OP_PROBE_ALL_RGB;
+	} else if (parse_str(line, "tolerance", &rest)) {
+		cmd->n = parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_TOLERANCE;
+	} else if (parse_str(line, "uniform ", &rest)) {
+		if (!decode_uniform(rest, cmd))
+			return false;
+		cmd->op = OP_UNIFORM;
+	} else if (parse_str(line, "ubo array index ", &rest)) {
+		if (parse_ints(rest, &i[0], 1, NULL) != 1)
+			return false;
+		cmd->op = OP_UBO_ARRAY_INDEX;
+	} else {
 		return false;
 	}
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	return true;
 }
 
-enum piglit_result
-piglit_display(void)
+static void
+free_test_commands(void)
 {
-	const char *line, *next_line, *rest;
-	unsigned line_num;
-	enum piglit_result full_result = PIGLIT_PASS;
-	GLbitfield clear_bits = 0;
-	bool link_error_expected = false;
-	int ubo_array_index = 0;
+	unsigned i;
 
-	if (test_start == NULL)
-		return PIGLIT_PASS;
+	for (i = 0; i < num_test_commands; i++)
+		free(test_commands[i].line);
+
+	free(test_commands);
+	test_commands = NULL;
+	num_test_commands = 0;
+	test_commands_compiled = false;
+}
+
+/**
+ * Translate the [test] section into an array of commands once, so that
+ * redisplays don't have to go through the string matching again.
+ */
+static void
+compile_test_section(void)
+{
+	const char *line, *next_line = test_start;
+	unsigned line_num = test_start_line_num;
+	unsigned capacity = 0;
+
+	free_test_commands();
 
-	next_line = test_start;
-	line_num = test_start_line_num;
 	while (next_line[0] != '\0') {
-		float c[32];
-		double d[4];
-		int x, y, z, w, h, l, tex, level;
-		unsigned ux, uy;
-		char s[300]; // 300 for safety
-		enum piglit_result result = PIGLIT_PASS;
+		struct test_command *cmd;
 
 		parse_whitespace(next_line, &line);
 
@@ -2930,887 +4707,388 @@ piglit_display(void)
 		if (next_line[0] != '\0')
 			next_line++;
 
-		if (line[0] == '\0') {
-		} else if (sscanf(line, "active shader program %s", s) == 1) {
-			switch (get_shader_from_string(s, &x)) {
-			case GL_VERTEX_SHADER:
-				glActiveShaderProgram(pipeline, sso_vertex_prog);
-			break;
-			case GL_TESS_CONTROL_SHADER:
-				glActiveShaderProgram(pipeline, sso_tess_control_prog);
-			break;
-			case GL_TESS_EVALUATION_SHADER:
-				glActiveShaderProgram(pipeline, sso_tess_eval_prog);
-			break;
-			case GL_GEOMETRY_SHADER:
-				glActiveShaderProgram(pipeline, sso_geometry_prog);
-			break;
-			case GL_FRAGMENT_SHADER:
-				glActiveShaderProgram(pipeline, sso_fragment_prog);
-			break;
-			case GL_COMPUTE_SHADER:
-				glActiveShaderProgram(pipeline, sso_compute_prog);
-			break;
-			}
-		} else if (sscanf(line, "atomic counter buffer %u %u", &x, &y) == 2) {
-			GLuint *atomics_buf = calloc(y, sizeof(GLuint));
-			glGenBuffers(1, &atomics_bos[x]);
-			glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, x, atomics_bos[x]);
-			glBufferData(GL_ATOMIC_COUNTER_BUFFER,
-				     sizeof(GLuint) * y, atomics_buf,
-				     GL_STATIC_DRAW);
-			free(atomics_buf);
-		} else if (sscanf(line, "atomic counters %d", &x) == 1) {
-			GLuint *atomics_buf = calloc(x, sizeof(GLuint));
-			glGenBuffers(1, &atomics_bos[0]);
-			glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, atomics_bos[0]);
-			glBufferData(GL_ATOMIC_COUNTER_BUFFER,
-				     sizeof(GLuint) * x,
-				     atomics_buf, GL_STATIC_DRAW);
-			free(atomics_buf);
-		} else if (sscanf(line, "atomic counter %u %u %u", &x, &y, &z) == 3) {
-			glNamedBufferSubData(atomics_bos[x],
-					     sizeof(GLuint) * y, sizeof(GLuint),
-					     &z);
-		} else if (parse_str(line, "clear color ", &rest)) {
-			parse_floats(rest, c, 4, NULL);
-			glClearColor(c[0], c[1], c[2], c[3]);
-			clear_bits |= GL_COLOR_BUFFER_BIT;
-		} else if (parse_str(line, "clear depth ", &rest)) {
-			parse_floats(rest, c, 1, NULL);
-			glClearDepth(c[0]);
-			clear_bits |= GL_DEPTH_BUFFER_BIT;
-		} else if (parse_str(line, "clear", NULL)) {
-			glClear(clear_bits);
-		} else if (sscanf(line,
-				  "clip plane %d %lf %lf %lf %lf",
-				  &x, &d[0], &d[1], &d[2], &d[3]) == 5) {
-			if (x < 0 || x >= gl_max_clip_planes) {
-				printf("clip plane id %d out of range\n", x);
+		/* Blank lines and comments don't produce commands. */
+		if (line[0] == '\0' || line[0] == '#') {
+			free((void *) line);
+			line_num++;
+			continue;
+		}
+
+		if (num_test_commands == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			test_commands = realloc(test_commands,
+						capacity * sizeof(*test_commands));
+			if (test_commands == NULL) {
+				fprintf(stderr, "%s: realloc failed.\n",
+					__func__);
 				piglit_report_result(PIGLIT_FAIL);
 			}
-			glClipPlane(GL_CLIP_PLANE0 + x, d);
-		} else if (sscanf(line,
-				  "compute %d %d %d",
-				  &x, &y, &z) == 3) {
-			result = program_must_be_in_use();
-			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-			glDispatchCompute(x, y, z);
-			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-		} else if (sscanf(line,
-				  "compute group size %d %d %d %d %d %d",
-				  &x, &y, &z, &w, &h, &l) == 6) {
-			result = program_must_be_in_use();
-			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-			glDispatchComputeGroupSizeARB(x, y, z, w, h, l);
-			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-		} else if (parse_str(line, "draw rect tex ", &rest)) {
-			result = program_must_be_in_use();
-			program_subroutine_uniforms();
-			parse_floats(rest, c, 8, NULL);
-			piglit_draw_rect_tex(c[0], c[1], c[2], c[3],
-					     c[4], c[5], c[6], c[7]);
-		} else if (parse_str(line, "draw rect ortho patch ", &rest)) {
-			result = program_must_be_in_use();
-			program_subroutine_uniforms();
-			parse_floats(rest, c, 4, NULL);
-
-			piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
-						-1.0 + 2.0 * (c[1] / piglit_height),
-						2.0 * (c[2] / piglit_width),
-						2.0 * (c[3] / piglit_height), true, 1);
-		} else if (parse_str(line, "draw rect ortho ", &rest)) {
-			result = program_must_be_in_use();
-			program_subroutine_uniforms();
-			parse_floats(rest, c, 4, NULL);
-
-			piglit_draw_rect(-1.0 + 2.0 * (c[0] / piglit_width),
-					 -1.0 + 2.0 * (c[1] / piglit_height),
-					 2.0 * (c[2] / piglit_width),
-					 2.0 * (c[3] / piglit_height));
-		} else if (parse_str(line, "draw rect patch ", &rest)) {
-			result = program_must_be_in_use();
-			parse_floats(rest, c, 4, NULL);
-			piglit_draw_rect_custom(c[0], c[1], c[2], c[3], true, 1);
-		} else if (parse_str(line, "draw rect ", &rest)) {
-			result = program_must_be_in_use();
-			program_subroutine_uniforms();
-			parse_floats(rest, c, 4, NULL);
-			piglit_draw_rect(c[0], c[1], c[2], c[3]);
-		} else if (parse_str(line, "draw instanced rect ortho patch ", &rest)) {
-			int instance_count;
-
-			result = program_must_be_in_use();
-			sscanf(rest, "%d %f %f %f %f",
-			       &instance_count,
-			       c + 0, c + 1, c + 2, c + 3);
-			piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
-						-1.0 + 2.0 * (c[1] / piglit_height),
-						2.0 * (c[2] / piglit_width),
-						2.0 * (c[3] / piglit_height), true,
-						instance_count);
-		} else if (parse_str(line, "draw instanced rect ortho ", &rest)) {
-			int instance_count;
-
-			result = program_must_be_in_use();
-			sscanf(rest, "%d %f %f %f %f",
-			       &instance_count,
-			       c + 0, c + 1, c + 2, c + 3);
-			piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
-						-1.0 + 2.0 * (c[1] / piglit_height),
-						2.0 * (c[2] / piglit_width),
-						2.0 * (c[3] / piglit_height), false,
-						instance_count);
-		} else if (parse_str(line, "draw instanced rect ", &rest)) {
-			int primcount;
-
-			result = program_must_be_in_use();
-			sscanf(rest, "%d %f %f %f %f",
-			       &primcount,
-			       c + 0, c + 1, c + 2, c + 3);
-			draw_instanced_rect(primcount, c[0], c[1], c[2], c[3]);
-		} else if (sscanf(line, "draw arrays instanced %31s %d %d %d", s, &x, &y, &z) == 4) {
-			GLenum mode = decode_drawing_mode(s);
-			int first = x;
-			size_t count = (size_t) y;
-			size_t primcount = (size_t) z;
-			draw_arrays_common(first, count);
-			glDrawArraysInstanced(mode, first, count, primcount);
-		} else if (sscanf(line, "draw arrays %31s %d %d", s, &x, &y) == 3) {
-			GLenum mode = decode_drawing_mode(s);
-			int first = x;
-			size_t count = (size_t) y;
-			result = draw_arrays_common(first, count);
-			glDrawArrays(mode, first, count);
-		} else if (parse_str(line, "disable ", &rest)) {
-			do_enable_disable(rest, false);
-		} else if (parse_str(line, "enable ", &rest)) {
-			do_enable_disable(rest, true);
-		} else if (sscanf(line, "depthfunc %31s", s) == 1) {
-			glDepthFunc(piglit_get_gl_enum_from_name(s));
-		} else if (parse_str(line, "fb ", &rest)) {
-			const GLenum target =
-				parse_str(rest, "draw ", &rest) ? GL_DRAW_FRAMEBUFFER :
-				parse_str(rest, "read ", &rest) ? GL_READ_FRAMEBUFFER :
-				GL_FRAMEBUFFER;
-			GLuint fbo = 0;
-
-			if (parse_str(rest, "tex 2d ", &rest)) {
-				GLenum attachments[32];
-				unsigned num_attachments = 0;
-
-				glGenFramebuffers(1, &fbo);
-				glBindFramebuffer(target, fbo);
-
-				while (parse_int(rest, &tex, &rest)) {
-					attachments[num_attachments] =
-						GL_COLOR_ATTACHMENT0 + num_attachments;
-					glFramebufferTexture2D(
-						target, attachments[num_attachments],
-						GL_TEXTURE_2D,
-						get_texture_binding(tex)->obj, 0);
-
-					if (!piglit_check_gl_error(GL_NO_ERROR)) {
-						fprintf(stderr,
-							"glFramebufferTexture2D error\n");
-						piglit_report_result(PIGLIT_FAIL);
-					}
+		}
 
-					num_attachments++;
-				}
+		cmd = &test_commands[num_test_commands++];
+		memset(cmd, 0, sizeof(*cmd));
+		cmd->line_num = line_num;
 
-				if (target != GL_READ_FRAMEBUFFER)
-					glDrawBuffers(num_attachments, attachments);
-
-				w = get_texture_binding(tex)->width;
-				h = get_texture_binding(tex)->height;
-
-			} else if (parse_str(rest, "tex slice ", &rest)) {
-				GLenum tex_target;
-
-				REQUIRE(parse_tex_target(rest, &tex_target, &rest) &&
-					parse_int(rest, &tex, &rest) &&
-					parse_int(rest, &l, &rest) &&
-					parse_int(rest, &z, &rest),
-					"Framebuffer binding command not "
-					"understood at: %s\n", rest);
-
-				const GLuint tex_obj = get_texture_binding(tex)->obj;
-
-				glGenFramebuffers(1, &fbo);
-				glBindFramebuffer(target, fbo);
-
-				if (tex_target == GL_TEXTURE_1D) {
-					REQUIRE(z == 0,
-						"Invalid layer index provided "
-						"in command: %s\n", line);
-					glFramebufferTexture1D(
-						target, GL_COLOR_ATTACHMENT0,
-						tex_target, tex_obj, l);
-
-				} else if (tex_target == GL_TEXTURE_2D ||
-					   tex_target == GL_TEXTURE_RECTANGLE ||
-					   tex_target == GL_TEXTURE_2D_MULTISAMPLE) {
-					REQUIRE(z == 0,
-						"Invalid layer index provided "
-						"in command: %s\n", line);
-					glFramebufferTexture2D(
-						target, GL_COLOR_ATTACHMENT0,
-						tex_target, tex_obj, l);
-
-				} else if (tex_target == GL_TEXTURE_CUBE_MAP) {
-					static const GLenum cubemap_targets[] = {
-						GL_TEXTURE_CUBE_MAP_POSITIVE_X,
-						GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
-						GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
-						GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
-						GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
-						GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
-					};
-					REQUIRE(z < ARRAY_SIZE(cubemap_targets),
-						"Invalid layer index provided "
-						"in command: %s\n", line);
-					tex_target = cubemap_targets[z];
-
-					glFramebufferTexture2D(
-						target, GL_COLOR_ATTACHMENT0,
-						tex_target, tex_obj, l);
+		if (decode_test_command(line, cmd)) {
+			free((void *) line);
+		} else {
+			cmd->op = OP_GENERIC;
+			cmd->line = (char *) line;
+		}
 
-				} else {
-					glFramebufferTextureLayer(
-						target, GL_COLOR_ATTACHMENT0,
-						tex_obj, l, z);
-				}
+		line_num++;
+	}
 
-				if (!piglit_check_gl_error(GL_NO_ERROR)) {
-					fprintf(stderr, "Error binding texture "
-						"attachment for command: %s\n",
-						line);
-					piglit_report_result(PIGLIT_FAIL);
-				}
+	test_commands_compiled = true;
+}
 
-				w = MAX2(1, get_texture_binding(tex)->width >> l);
-				h = MAX2(1, get_texture_binding(tex)->height >> l);
+/**
+ * Compute the window area read by a probe command.  Returns false for
+ * commands that aren't probes.
+ */
+static bool
+get_probe_area(const struct test_command *cmd, int *x, int *y, int *w, int *h)
+{
+	const float *c = cmd->v.f;
+
+	switch (cmd->op) {
+	case OP_PROBE_RGBA:
+	case OP_PROBE_RGB:
+		*x = c[0];
+		*y = c[1];
+		*w = *h = 1;
+		return true;
+
+	case OP_RELATIVE_PROBE_RGBA:
+	case OP_RELATIVE_PROBE_RGB:
+		*x = c[0] * read_width;
+		*y = c[1] * read_height;
+		if (*x >= read_width)
+			*x = read_width - 1;
+		if (*y >= read_height)
+			*y = read_height - 1;
+		*w = *h = 1;
+		return true;
+
+	case OP_PROBE_RECT_RGBA:
+		*x = cmd->i[0];
+		*y = cmd->i[1];
+		*w = cmd->i[2];
+		*h = cmd->i[3];
+		return true;
+
+	case OP_RELATIVE_PROBE_RECT_RGB:
+	case OP_RELATIVE_PROBE_RECT_RGBA:
+		*x = c[0] * read_width;
+		*y = c[1] * read_height;
+		*w = c[2] * read_width;
+		*h = c[3] * read_height;
+		return true;
+
+	case OP_PROBE_ALL_RGBA:
+	case OP_PROBE_WARN_ALL_RGBA:
+	case OP_PROBE_ALL_RGB:
+		*x = 0;
+		*y = 0;
+		*w = read_width;
+		*h = read_height;
+		return true;
 
-			} else if (sscanf(rest, "tex layered %d", &tex) == 1) {
-				glGenFramebuffers(1, &fbo);
-				glBindFramebuffer(target, fbo);
+	default:
+		return false;
+	}
+}
 
-				glFramebufferTexture(
-					target, GL_COLOR_ATTACHMENT0,
-					get_texture_binding(tex)->obj, 0);
-				if (!piglit_check_gl_error(GL_NO_ERROR)) {
-					fprintf(stderr,
-						"glFramebufferTexture error\n");
-					piglit_report_result(PIGLIT_FAIL);
-				}
+static bool
+is_pixel_probe(enum test_op op)
+{
+	switch (op) {
+	case OP_PROBE_RGBA:
+	case OP_PROBE_RGB:
+	case OP_RELATIVE_PROBE_RGBA:
+	case OP_RELATIVE_PROBE_RGB:
+		return true;
+	default:
+		return false;
+	}
+}
 
-				w = get_texture_binding(tex)->width;
-				h = get_texture_binding(tex)->height;
+/**
+ * If the commands starting at \c first are a run of two or more probes of
+ * the same kind, pixel or rect, with nothing but tolerance changes between
+ * them, read their bounding area back into \c region with a single
+ * glReadPixels and return the index one past the run.  Otherwise return
+ * \c first.
+ *
+ * Pixel and rect probes don't share a batch, since they read the buffer in
+ * different forms, see piglit_probe_region_read().
+ */
+static unsigned
+read_probe_batch(unsigned first, struct piglit_probe_region *region)
+{
+	int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+	unsigned i, num_probes = 0;
+	bool pixel_probes = false;
 
-			} else if (parse_str(rest, "ms ", &rest)) {
-				GLuint rb;
-				GLenum format;
-				int samples;
+	for (i = first; i < num_test_commands; i++) {
+		int x, y, w, h;
 
-				REQUIRE(parse_enum_gl(rest, &format, &rest) &&
-					parse_int(rest, &w, &rest) &&
-					parse_int(rest, &h, &rest) &&
-					parse_int(rest, &samples, &rest),
-					"Framebuffer binding command not "
-					"understood at: %s\n", rest);
+		if (test_commands[i].op == OP_TOLERANCE)
+			continue;
+		if (!get_probe_area(&test_commands[i], &x, &y, &w, &h))
+			break;
 
-				glGenFramebuffers(1, &fbo);
-				glBindFramebuffer(target, fbo);
+		if (num_probes == 0)
+			pixel_probes = is_pixel_probe(test_commands[i].op);
+		else if (is_pixel_probe(test_commands[i].op) != pixel_probes)
+			break;
 
-				glGenRenderbuffers(1, &rb);
-				glBindRenderbuffer(GL_RENDERBUFFER, rb);
+		num_probes++;
+		if (w <= 0 || h <= 0)
+			continue;
 
-				glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
-								 format, w, h);
+		x0 = MIN2(x0, x);
+		y0 = MIN2(y0, y);
+		x1 = MAX2(x1, x + w);
+		y1 = MAX2(y1, y + h);
+	}
 
-				glFramebufferRenderbuffer(target,
-							  GL_COLOR_ATTACHMENT0,
-							  GL_RENDERBUFFER, rb);
+	if (num_probes < 2 || x0 >= x1 || y0 >= y1)
+		return first;
 
-				if (!piglit_check_gl_error(GL_NO_ERROR)) {
-					fprintf(stderr, "glFramebufferRenderbuffer error\n");
-					piglit_report_result(PIGLIT_FAIL);
-				}
+	piglit_probe_region_read(region, x0, y0, x1 - x0, y1 - y0,
+				 pixel_probes);
+	return i;
+}
 
-			} else if (parse_str(rest, "winsys", &rest)) {
-				fbo = piglit_winsys_fbo;
-				glBindFramebuffer(target, fbo);
-				if (!piglit_check_gl_error(GL_NO_ERROR)) {
-					fprintf(stderr, "glBindFramebuffer error\n");
-					piglit_report_result(PIGLIT_FAIL);
-				}
+static bool
+probe_pixel_rgb(const struct test_run_state *state, int x, int y,
+		const float *expected)
+{
+	if (state->probe_region)
+		return piglit_probe_region_pixel_rgb(state->probe_region,
+						     x, y, expected);
+	return piglit_probe_pixel_rgb(x, y, expected);
+}
 
-				w = piglit_width;
-				h = piglit_height;
+static bool
+probe_pixel_rgba(const struct test_run_state *state, int x, int y,
+		 const float *expected)
+{
+	if (state->probe_region)
+		return piglit_probe_region_pixel_rgba(state->probe_region,
+						      x, y, expected);
+	return piglit_probe_pixel_rgba(x, y, expected);
+}
 
-			} else {
-				fprintf(stderr, "Unknown fb bind subcommand "
-					"\"%s\"\n", rest);
-				piglit_report_result(PIGLIT_FAIL);
-			}
+static bool
+probe_rect_rgb(const struct test_run_state *state, int x, int y, int w, int h,
+	       const float *expected)
+{
+	if (state->probe_region)
+		return piglit_probe_region_rect_rgb(state->probe_region,
+						    x, y, w, h, expected);
+	return piglit_probe_rect_rgb(x, y, w, h, expected);
+}
 
-			const GLenum status = glCheckFramebufferStatus(target);
-			if (status != GL_FRAMEBUFFER_COMPLETE) {
-				fprintf(stderr, "incomplete fbo (status 0x%x)\n",
-					status);
-				piglit_report_result(PIGLIT_FAIL);
-			}
+static bool
+probe_rect_rgba(const struct test_run_state *state, int x, int y, int w, int h,
+		const float *expected)
+{
+	if (state->probe_region)
+		return piglit_probe_region_rect_rgba(state->probe_region,
+						     x, y, w, h, expected);
+	return piglit_probe_rect_rgba(x, y, w, h, expected);
+}
 
-			if (target != GL_READ_FRAMEBUFFER) {
-				render_width = w;
-				render_height = h;
+static enum piglit_result
+execute_test_command(const struct test_command *cmd,
+		     struct test_run_state *state)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	const float *c = cmd->v.f;
+	int x, y, w, h;
 
-				/* Delete the previous draw FB in case
-				 * it's no longer reachable.
-				 */
-				if (draw_fbo != 0 &&
-				    draw_fbo != piglit_winsys_fbo &&
-				    draw_fbo != (target == GL_DRAW_FRAMEBUFFER ?
-						 read_fbo : 0))
-					glDeleteFramebuffers(1, &draw_fbo);
+	switch (cmd->op) {
+	case OP_GENERIC:
+		return process_test_line(cmd->line, state);
 
-				draw_fbo = fbo;
-			}
+	case OP_CLEAR_COLOR:
+		glClearColor(c[0], c[1], c[2], c[3]);
+		state->clear_bits |= GL_COLOR_BUFFER_BIT;
+		break;
 
-			if (target != GL_DRAW_FRAMEBUFFER) {
-				read_width = w;
-				read_height = h;
+	case OP_CLEAR_DEPTH:
+		glClearDepth(c[0]);
+		state->clear_bits |= GL_DEPTH_BUFFER_BIT;
+		break;
 
-				/* Delete the previous read FB in case
-				 * it's no longer reachable.
-				 */
-				if (read_fbo != 0 &&
-				    read_fbo != piglit_winsys_fbo &&
-				    read_fbo != (target == GL_READ_FRAMEBUFFER ?
-						 draw_fbo : 0))
-					glDeleteFramebuffers(1, &read_fbo);
+	case OP_CLEAR:
+		glClear(state->clear_bits);
+		break;
 
-				read_fbo = fbo;
-			}
+	case OP_COMPUTE:
+		result = program_must_be_in_use();
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		glDispatchCompute(cmd->i[0], cmd->i[1], cmd->i[2]);
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		break;
 
-		} else if (parse_str(line, "blit ", &rest)) {
-			static const struct string_to_enum buffers[] = {
-				{ "color", GL_COLOR_BUFFER_BIT },
-				{ "depth", GL_DEPTH_BUFFER_BIT },
-				{ "stencil", GL_STENCIL_BUFFER_BIT },
-				{ NULL }
-			};
-			static const struct string_to_enum filters[] = {
-				{ "linear", GL_LINEAR },
-				{ "nearest", GL_NEAREST },
-				{ NULL }
-			};
-			unsigned buffer, filter;
-
-			REQUIRE(parse_enum_tab(buffers, rest, &buffer, &rest) &&
-				parse_enum_tab(filters, rest, &filter, &rest),
-				"FB blit command not understood at: %s\n",
-				rest);
-
-			glBlitFramebuffer(0, 0, read_width, read_height,
-					  0, 0, render_width, render_height,
-					  buffer, filter);
+	case OP_DRAW_RECT_TEX:
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		piglit_draw_rect_tex(c[0], c[1], c[2], c[3],
+				     c[4], c[5], c[6], c[7]);
+		break;
 
-			if (!piglit_check_gl_error(GL_NO_ERROR)) {
-				fprintf(stderr, "glBlitFramebuffer error\n");
-				piglit_report_result(PIGLIT_FAIL);
-			}
+	case OP_DRAW_RECT_ORTHO_PATCH:
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
+					-1.0 + 2.0 * (c[1] / piglit_height),
+					2.0 * (c[2] / piglit_width),
+					2.0 * (c[3] / piglit_height), true, 1);
+		break;
 
-		} else if (parse_str(line, "frustum", &rest)) {
-			parse_floats(rest, c, 6, NULL);
-			piglit_frustum_projection(false, c[0], c[1], c[2],
-						  c[3], c[4], c[5]);
-		} else if (parse_str(line, "hint", &rest)) {
-			do_hint(rest);
-		} else if (sscanf(line,
-				  "image texture %d %31s",
-				  &tex, s) == 2) {
-			const GLenum img_fmt = piglit_get_gl_enum_from_name(s);
-			glBindImageTexture(tex, get_texture_binding(tex)->obj, 0,
-					   GL_FALSE, 0, GL_READ_WRITE, img_fmt);
-		} else if (sscanf(line, "memory barrier %s", s) == 1) {
-			glMemoryBarrier(piglit_get_gl_memory_barrier_enum_from_name(s));
-		} else if (parse_str(line, "blend barrier", NULL)) {
-			glBlendBarrier();
-		} else if (sscanf(line, "ortho %f %f %f %f",
-				  c + 0, c + 1, c + 2, c + 3) == 4) {
-			piglit_gen_ortho_projection(c[0], c[1], c[2], c[3],
-						    -1, 1, GL_FALSE);
-		} else if (parse_str(line, "ortho", NULL)) {
-			piglit_ortho_projection(render_width, render_height,
-						GL_FALSE);
-		} else if (parse_str(line, "probe rgba ", &rest)) {
-			parse_floats(rest, c, 6, NULL);
-			if (!piglit_probe_pixel_rgba((int) c[0], (int) c[1],
-						    & c[2])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (parse_str(line, "probe depth ", &rest)) {
-			parse_floats(rest, c, 3, NULL);
-			if (!piglit_probe_pixel_depth((int) c[0], (int) c[1],
-						      c[2])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (sscanf(line,
-				  "probe atomic counter %u %s %u",
-				  &ux, s, &uy) == 3) {
-			if (!probe_atomic_counter(0, ux, s, uy)) {
-				piglit_report_result(PIGLIT_FAIL);
-			}
-		} else if (sscanf(line, "probe ssbo uint %d %d %s 0x%x",
-				  &x, &y, s, &z) == 4) {
-			if (!probe_ssbo_uint(x, y, s, z))
-				result = PIGLIT_FAIL;
-		} else if (sscanf(line, "probe ssbo uint %d %d %s %d",
-				  &x, &y, s, &z) == 4) {
-			if (!probe_ssbo_uint(x, y, s, z))
-				result = PIGLIT_FAIL;
-		} else if (sscanf(line,
-				  "relative probe rgba ( %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  c + 0, c + 1,
-				  c + 2, c + 3, c + 4, c + 5) == 6) {
-			x = c[0] * read_width;
-			y = c[1] * read_height;
-			if (x >= read_width)
-				x = read_width - 1;
-			if (y >= read_height)
-				y = read_height - 1;
-
-			if (!piglit_probe_pixel_rgba(x, y, &c[2])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (parse_str(line, "probe rgb ", &rest)) {
-			parse_floats(rest, c, 5, NULL);
-			if (!piglit_probe_pixel_rgb((int) c[0], (int) c[1],
-						    & c[2])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (sscanf(line,
-				  "relative probe rgb ( %f , %f ) "
-				  "( %f , %f , %f )",
-				  c + 0, c + 1,
-				  c + 2, c + 3, c + 4) == 5) {
-			x = c[0] * read_width;
-			y = c[1] * read_height;
-			if (x >= read_width)
-				x = read_width - 1;
-			if (y >= read_height)
-				y = read_height - 1;
-
-			if (!piglit_probe_pixel_rgb(x, y, &c[2])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (sscanf(line, "probe rect rgba "
-				  "( %d , %d , %d , %d ) "
-				  "( %f , %f , %f , %f )",
-				  &x, &y, &w, &h,
-				  c + 0, c + 1, c + 2, c + 3) == 8) {
-			if (!piglit_probe_rect_rgba(x, y, w, h, c)) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (sscanf(line, "relative probe rect rgb "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f )",
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6) == 7) {
-			x = c[0] * read_width;
-			y = c[1] * read_height;
-			w = c[2] * read_width;
-			h = c[3] * read_height;
-
-			if (!piglit_probe_rect_rgb(x, y, w, h, &c[4])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (sscanf(line, "relative probe rect rgba "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6, c + 7) == 8) {
-			x = c[0] * read_width;
-			y = c[1] * read_height;
-			w = c[2] * read_width;
-			h = c[3] * read_height;
-
-			if (!piglit_probe_rect_rgba(x, y, w, h, &c[4])) {
-				result = PIGLIT_FAIL;
-			}
-		} else if (sscanf(line, "relative probe rect rgba int "
-				  "( %f , %f , %f , %f ) "
-				  "( %d , %d , %d , %d )",
-				  c + 0, c + 1, c + 2, c + 3,
-				  &x, &y, &z, &w) == 8) {
-			const int expected[] = { x, y, z, w };
-			if (!piglit_probe_rect_rgba_int(c[0] * read_width,
-							c[1] * read_height,
-							c[2] * read_width,
-							c[3] * read_height,
-							expected))
-				result = PIGLIT_FAIL;
-
-		} else if (parse_str(line, "polygon mode ", &rest)) {
-			GLenum face, mode;
-
-			REQUIRE(parse_enum_gl(rest, &face, &rest) &&
-				parse_enum_gl(rest, &mode, &rest),
-				"Polygon mode command not understood at %s\n",
-				rest);
-
-			glPolygonMode(face, mode);
+	case OP_DRAW_RECT_ORTHO:
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		piglit_draw_rect(-1.0 + 2.0 * (c[0] / piglit_width),
+				 -1.0 + 2.0 * (c[1] / piglit_height),
+				 2.0 * (c[2] / piglit_width),
+				 2.0 * (c[3] / piglit_height));
+		break;
 
-			if (!piglit_check_gl_error(GL_NO_ERROR)) {
-				fprintf(stderr, "glPolygonMode error\n");
-				piglit_report_result(PIGLIT_FAIL);
-			}
-		} else if (parse_str(line, "probe all rgba ", &rest)) {
-			parse_floats(rest, c, 4, NULL);
-			if (result != PIGLIT_FAIL &&
-			    !piglit_probe_rect_rgba(0, 0, read_width,
-						    read_height, c))
-				result = PIGLIT_FAIL;
-		} else if (parse_str(line, "probe warn all rgba ", &rest)) {
-			parse_floats(rest, c, 4, NULL);
-			if (result == PIGLIT_PASS &&
-			    !piglit_probe_rect_rgba(0, 0, read_width,
-						    read_height, c))
-				result = PIGLIT_WARN;
-		} else if (parse_str(line, "probe all rgb", &rest)) {
-			parse_floats(rest, c, 3, NULL);
-			if (result != PIGLIT_FAIL &&
-			    !piglit_probe_rect_rgb(0, 0, read_width,
-						   read_height, c))
-				result = PIGLIT_FAIL;
-		} else if (parse_str(line, "tolerance", &rest)) {
-			parse_floats(rest, piglit_tolerance, 4, NULL);
-		} else if (parse_str(line, "shade model smooth", NULL)) {
-			glShadeModel(GL_SMOOTH);
-		} else if (parse_str(line, "shade model flat", NULL)) {
-			glShadeModel(GL_FLAT);
-		} else if (sscanf(line, "ssbo %d %d", &x, &y) == 2) {
-			GLuint *ssbo_init = calloc(y, 1);
-			glGenBuffers(1, &ssbo[x]);
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, x, ssbo[x]);
-			glBufferData(GL_SHADER_STORAGE_BUFFER, y,
-				     ssbo_init, GL_DYNAMIC_DRAW);
-			free(ssbo_init);
-		} else if (sscanf(line, "ssbo %d subdata float %d %f", &x, &y, &c[0]) == 3) {
-			glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo[x]);
-			glBufferSubData(GL_SHADER_STORAGE_BUFFER, y, 4, &c[0]);
-		} else if (sscanf(line, "texture rgbw %d ( %d", &tex, &w) == 2) {
-			GLenum int_fmt = GL_RGBA;
-			int num_scanned =
-				sscanf(line,
-				       "texture rgbw %d ( %d , %d ) %31s",
-				       &tex, &w, &h, s);
-			if (num_scanned < 3) {
-				fprintf(stderr,
-					"invalid texture rgbw command!\n");
-				piglit_report_result(PIGLIT_FAIL);
-			}
+	case OP_DRAW_RECT_PATCH:
+		result = program_must_be_in_use();
+		piglit_draw_rect_custom(c[0], c[1], c[2], c[3], true, 1);
+		break;
 
-			if (num_scanned >= 4) {
-				int_fmt = piglit_get_gl_enum_from_name(s);
-			}
+	case OP_DRAW_RECT:
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		piglit_draw_rect(c[0], c[1], c[2], c[3]);
+		break;
+
+	case OP_DRAW_ARRAYS:
+		result = draw_arrays_common(cmd->i[0], (size_t) cmd->i[1]);
+		glDrawArrays(cmd->e, cmd->i[0], (size_t) cmd->i[1]);
+		break;
+
+	case OP_ENABLE:
+		glEnable(cmd->e);
+		break;
+
+	case OP_DISABLE:
+		glDisable(cmd->e);
+		break;
+
+	case OP_PROBE_RGBA:
+	case OP_RELATIVE_PROBE_RGBA:
+		get_probe_area(cmd, &x, &y, &w, &h);
+		if (!probe_pixel_rgba(state, x, y, &c[2]))
+			result = PIGLIT_FAIL;
+		break;
+
+	case OP_PROBE_RGB:
+	case OP_RELATIVE_PROBE_RGB:
+		get_probe_area(cmd, &x, &y, &w, &h);
+		if (!probe_pixel_rgb(state, x, y, &c[2]))
+			result = PIGLIT_FAIL;
+		break;
+
+	case OP_PROBE_RECT_RGBA:
+		get_probe_area(cmd, &x, &y, &w, &h);
+		if (!probe_rect_rgba(state, x, y, w, h, c))
+			result = PIGLIT_FAIL;
+		break;
 
-			glActiveTexture(GL_TEXTURE0 + tex);
-			int handle = piglit_rgbw_texture(
-				int_fmt, w, h, GL_FALSE, GL_FALSE,
-				(piglit_is_gles() ? GL_UNSIGNED_BYTE :
-				 GL_UNSIGNED_NORMALIZED));
-			set_texture_binding(tex, handle, w, h, 1);
+	case OP_RELATIVE_PROBE_RECT_RGB:
+		get_probe_area(cmd, &x, &y, &w, &h);
+		if (!probe_rect_rgb(state, x, y, w, h, &c[4]))
+			result = PIGLIT_FAIL;
+		break;
 
-			if (!piglit_is_core_profile &&
-			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
-				glEnable(GL_TEXTURE_2D);
+	case OP_RELATIVE_PROBE_RECT_RGBA:
+		get_probe_area(cmd, &x, &y, &w, &h);
+		if (!probe_rect_rgba(state, x, y, w, h, &c[4]))
+			result = PIGLIT_FAIL;
+		break;
 
-		} else if (sscanf(line, "resident texture %d", &tex) == 1) {
-			GLuint64 handle;
+	case OP_PROBE_ALL_RGBA:
+		if (!probe_rect_rgba(state, 0, 0, read_width, read_height, c))
+			result = PIGLIT_FAIL;
+		break;
 
-			glBindTexture(GL_TEXTURE_2D, 0);
+	case OP_PROBE_WARN_ALL_RGBA:
+		if (!probe_rect_rgba(state, 0, 0, read_width, read_height, c))
+			result = PIGLIT_WARN;
+		break;
 
-			handle = glGetTextureHandleARB(get_texture_binding(tex)->obj);
-			glMakeTextureHandleResidentARB(handle);
+	case OP_PROBE_ALL_RGB:
+		if (!probe_rect_rgb(state, 0, 0, read_width, read_height, c))
+			result = PIGLIT_FAIL;
+		break;
 
-			set_resident_handle(tex, handle, true);
+	case OP_TOLERANCE:
+		memcpy(piglit_tolerance, c, cmd->n * sizeof(float));
+		break;
 
-			if (!piglit_check_gl_error(GL_NO_ERROR)) {
-				fprintf(stderr,
-					"glMakeTextureHandleResidentARB error\n");
-				piglit_report_result(PIGLIT_FAIL);
-			}
-		} else if (sscanf(line, "resident image texture %d %31s",
-				  &tex, s) == 2) {
-			const GLenum img_fmt = piglit_get_gl_enum_from_name(s);
-			GLuint64 handle;
+	case OP_UNIFORM:
+		apply_uniform(cmd);
+		break;
 
-			glBindTexture(GL_TEXTURE_2D, 0);
+	case OP_UBO_ARRAY_INDEX:
+		state->ubo_array_index = cmd->i[0];
+		break;
+	}
 
-			handle = glGetImageHandleARB(get_texture_binding(tex)->obj,
-						     0, GL_FALSE, 0, img_fmt);
-			glMakeImageHandleResidentARB(handle, GL_READ_WRITE);
+	return result;
+}
 
-			set_resident_handle(tex, handle, false);
+enum piglit_result
+piglit_display(void)
+{
+	enum piglit_result full_result = PIGLIT_PASS;
+	struct test_run_state state = { 0, false, 0, NULL };
+	struct piglit_probe_region region;
+	unsigned i, batch_end = 0;
 
-			if (!piglit_check_gl_error(GL_NO_ERROR)) {
-				fprintf(stderr,
-					"glMakeImageHandleResidentARB error\n");
-				piglit_report_result(PIGLIT_FAIL);
-			}
-		} else if (parse_str(line, "texture integer ", &rest)) {
-			GLenum int_fmt;
-			int b, a;
-			int num_scanned =
-				sscanf(rest, "%d ( %d , %d ) ( %d, %d ) %31s",
-				       &tex, &w, &h, &b, &a, s);
-			if (num_scanned < 6) {
-				fprintf(stderr,
-					"invalid texture integer command!\n");
-				piglit_report_result(PIGLIT_FAIL);
-			}
+	if (test_start == NULL)
+		return PIGLIT_PASS;
 
-			int_fmt = piglit_get_gl_enum_from_name(s);
+	if (!test_commands_compiled)
+		compile_test_section();
 
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle =
-				piglit_integer_texture(int_fmt, w, h, b, a);
-			set_texture_binding(tex, handle, w, h, 1);
-
-		} else if (sscanf(line, "texture miptree %d", &tex) == 1) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_miptree_texture();
-			set_texture_binding(tex, handle, 8, 8, 1);
-
-			if (!piglit_is_core_profile &&
-			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
-				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture checkerboard %d %d ( %d , %d ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  &tex, &level, &w, &h,
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6, c + 7) == 12) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_checkerboard_texture(
-				0, level, w, h, w / 2, h / 2, c + 0, c + 4);
-			set_texture_binding(tex, handle, w, h, 1);
-
-			if (!piglit_is_core_profile &&
-			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
-				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture quads %d %d ( %d , %d ) ( %d , %d ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  &tex, &level, &w, &h, &x, &y,
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6, c + 7,
-				  c + 8, c + 9, c + 10, c + 11,
-				  c + 12, c + 13, c + 14, c + 15) == 22) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_quads_texture(
-				0, level, w, h, x, y, c + 0, c + 4, c + 8, c + 12);
-			set_texture_binding(tex, handle, w, h, 1);
-
-			if (!piglit_is_core_profile &&
-			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
-				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture junk 2DArray %d ( %d , %d , %d )",
-				  &tex, &w, &h, &l) == 4) {
-			GLuint texobj;
-			glActiveTexture(GL_TEXTURE0 + tex);
-			glGenTextures(1, &texobj);
-			glBindTexture(GL_TEXTURE_2D_ARRAY, texobj);
-			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA,
-				     w, h, l, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-			set_texture_binding(tex, texobj, w, h, l);
-
-		} else if (parse_str(line, "texture storage ", &rest)) {
-			GLenum target, format;
-			GLuint tex_obj;
-			int d = h = w = 1;
-
-			REQUIRE(parse_int(rest, &tex, &rest) &&
-				parse_tex_target(rest, &target, &rest) &&
-				parse_enum_gl(rest, &format, &rest) &&
-				parse_str(rest, "(", &rest) &&
-				parse_int(rest, &l, &rest) &&
-				parse_int(rest, &w, &rest),
-				"Texture storage command not understood "
-				"at: %s\n", rest);
-
-			glActiveTexture(GL_TEXTURE0 + tex);
-			glGenTextures(1, &tex_obj);
-			glBindTexture(target, tex_obj);
-
-			if (!parse_int(rest, &h, &rest))
-				glTexStorage1D(target, l, format, w);
-			else if (!parse_int(rest, &d, &rest))
-				glTexStorage2D(target, l, format, w, h);
-			else
-				glTexStorage3D(target, l, format, w, h, d);
+	for (i = 0; i < num_test_commands; i++) {
+		const struct test_command *cmd = &test_commands[i];
+		enum piglit_result result;
 
-			if (!piglit_check_gl_error(GL_NO_ERROR)) {
-				fprintf(stderr, "glTexStorage error\n");
-				piglit_report_result(PIGLIT_FAIL);
+		/* Consecutive probes share one readback of their
+		 * bounding area.
+		 */
+		if (i >= batch_end) {
+			if (state.probe_region) {
+				piglit_probe_region_free(&region);
+				state.probe_region = NULL;
 			}
 
-			if (target == GL_TEXTURE_1D_ARRAY)
-				set_texture_binding(tex, tex_obj, w, 1, h);
-			else
-				set_texture_binding(tex, tex_obj, w, h, d);
-
-		} else if (sscanf(line,
-				  "texture rgbw 2DArray %d ( %d , %d , %d )",
-				  &tex, &w, &h, &l) == 4) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_array_texture(
-				GL_TEXTURE_2D_ARRAY, GL_RGBA, w, h, l, GL_FALSE);
-			set_texture_binding(tex, handle, w, h, l);
-
-		} else if (sscanf(line,
-				  "texture rgbw 1DArray %d ( %d , %d )",
-				  &tex, &w, &l) == 3) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-                        h = 1;
-			const GLuint handle = piglit_array_texture(
-				GL_TEXTURE_1D_ARRAY, GL_RGBA, w, h, l, GL_FALSE);
-			set_texture_binding(tex, handle, w, 1, l);
-
-		} else if (sscanf(line,
-				  "texture shadow2D %d ( %d , %d )",
-				  &tex, &w, &h) == 3) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_depth_texture(
-				GL_TEXTURE_2D, GL_DEPTH_COMPONENT,
-				w, h, 1, GL_FALSE);
-			glTexParameteri(GL_TEXTURE_2D,
-					GL_TEXTURE_COMPARE_MODE,
-					GL_COMPARE_R_TO_TEXTURE);
-			glTexParameteri(GL_TEXTURE_2D,
-					GL_TEXTURE_COMPARE_FUNC,
-					GL_GREATER);
-			set_texture_binding(tex, handle, w, h, 1);
-
-			if (!piglit_is_core_profile &&
-			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
-				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture shadowRect %d ( %d , %d )",
-				  &tex, &w, &h) == 3) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_depth_texture(
-				GL_TEXTURE_RECTANGLE, GL_DEPTH_COMPONENT,
-				w, h, 1, GL_FALSE);
-			glTexParameteri(GL_TEXTURE_RECTANGLE,
-					GL_TEXTURE_COMPARE_MODE,
-					GL_COMPARE_R_TO_TEXTURE);
-			glTexParameteri(GL_TEXTURE_RECTANGLE,
-					GL_TEXTURE_COMPARE_FUNC,
-					GL_GREATER);
-			set_texture_binding(tex, handle, w, h, 1);
-		} else if (sscanf(line,
-				  "texture shadow1D %d ( %d )",
-				  &tex, &w) == 2) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_depth_texture(
-				GL_TEXTURE_1D, GL_DEPTH_COMPONENT,
-				w, 1, 1, GL_FALSE);
-			glTexParameteri(GL_TEXTURE_1D,
-					GL_TEXTURE_COMPARE_MODE,
-					GL_COMPARE_R_TO_TEXTURE);
-			glTexParameteri(GL_TEXTURE_1D,
-					GL_TEXTURE_COMPARE_FUNC,
-					GL_GREATER);
-			set_texture_binding(tex, handle, w, 1, 1);
-		} else if (sscanf(line,
-				  "texture shadow1DArray %d ( %d , %d )",
-				  &tex, &w, &l) == 3) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_depth_texture(
-				GL_TEXTURE_1D_ARRAY, GL_DEPTH_COMPONENT,
-				w, l, 1, GL_FALSE);
-			glTexParameteri(GL_TEXTURE_1D_ARRAY,
-					GL_TEXTURE_COMPARE_MODE,
-					GL_COMPARE_R_TO_TEXTURE);
-			glTexParameteri(GL_TEXTURE_1D_ARRAY,
-					GL_TEXTURE_COMPARE_FUNC,
-					GL_GREATER);
-			set_texture_binding(tex, handle, w, 1, l);
-		} else if (sscanf(line,
-				  "texture shadow2DArray %d ( %d , %d , %d )",
-				  &tex, &w, &h, &l) == 4) {
-			glActiveTexture(GL_TEXTURE0 + tex);
-			const GLuint handle = piglit_depth_texture(
-				GL_TEXTURE_2D_ARRAY, GL_DEPTH_COMPONENT,
-				w, h, l, GL_FALSE);
-			glTexParameteri(GL_TEXTURE_2D_ARRAY,
-					GL_TEXTURE_COMPARE_MODE,
-					GL_COMPARE_R_TO_TEXTURE);
-			glTexParameteri(GL_TEXTURE_2D_ARRAY,
-					GL_TEXTURE_COMPARE_FUNC,
-					GL_GREATER);
-			set_texture_binding(tex, handle, w, h, l);
-		} else if (sscanf(line, "texcoord %d ( %f , %f , %f , %f )",
-		                  &x, c + 0, c + 1, c + 2, c + 3) == 5) {
-			glMultiTexCoord4fv(GL_TEXTURE0 + x, c);
-		} else if (parse_str(line, "texparameter ", &rest)) {
-			handle_texparameter(rest);
-		} else if (parse_str(line, "uniform ", &rest)) {
-			result = program_must_be_in_use();
-			set_uniform(rest, ubo_array_index);
-		} else if (parse_str(line, "subuniform ", &rest)) {
-			result = program_must_be_in_use();
-			check_shader_subroutine_support();
-			set_subroutine_uniform(rest);
-		} else if (parse_str(line, "parameter ", &rest)) {
-			set_parameter(rest);
-		} else if (parse_str(line, "patch parameter ", &rest)) {
-			set_patch_parameter(rest);
-		} else if (parse_str(line, "provoking vertex ", &rest)) {
-			set_provoking_vertex(rest);
-		} else if (parse_str(line, "link error", &rest)) {
-			link_error_expected = true;
-			if (link_ok) {
-				printf("shader link error expected, but it was successful!\n");
-				piglit_report_result(PIGLIT_FAIL);
-			} else {
-				fprintf(stderr, "Failed to link:\n%s\n", prog_err_info);
-			}
-		} else if (parse_str(line, "link success", &rest)) {
-			result = program_must_be_in_use();
-		} else if (parse_str(line, "ubo array index ", &rest)) {
-			parse_ints(rest, &ubo_array_index, 1, NULL);
-		} else if (parse_str(line, "active uniform ", &rest)) {
-			active_uniform(rest);
-		} else if (parse_str(line, "verify program_interface_query ", &rest)) {
-			active_program_interface(rest);
-		} else if ((line[0] != '\n') && (line[0] != '\0')
-			   && (line[0] != '#')) {
-			printf("unknown command \"%s\"\n", line);
-			piglit_report_result(PIGLIT_FAIL);
+			batch_end = read_probe_batch(i, &region);
+			if (batch_end > i)
+				state.probe_region = &region;
 		}
 
-		free((void*) line);
-
+		result = execute_test_command(cmd, &state);
 		if (result != PIGLIT_PASS) {
-			printf("Test failure on line %u\n", line_num);
+			printf("Test failure on line %u\n", cmd->line_num);
 			full_result = result;
 		}
-
-		line_num++;
 	}
 
-	if (!link_ok && !link_error_expected) {
+	if (state.probe_region)
+		piglit_probe_region_free(&region);
+
+	if (!link_ok && !state.link_error_expected) {
 		full_result = program_must_be_in_use();
 	}
 
@@ -3843,16 +5121,21 @@ piglit_display(void)
 	return full_result;
 }
 
+/**
+ * Set up the test script \p text, which must stay allocated until the test
+ * has run.
+ */
 static enum piglit_result
-init_test(const char *file)
+init_test(const char *text)
 {
 	enum piglit_result result;
 
-	result = process_test_script(file);
+	result = process_test_script(text);
 	if (result != PIGLIT_PASS)
 		return result;
 
 	result = link_and_use_shaders();
+	program_cache_report();
 	if (result != PIGLIT_PASS)
 		return result;
 
@@ -3889,7 +5172,11 @@ recreate_gl_context(char *exec_arg, int param_argc, char **param_argv)
 	memcpy(&argv[1], param_argv, param_argc * sizeof(char*));
 	argv[argc-3] = "-auto";
 	argv[argc-2] = "-fbo";
-	argv[argc-1] = "-report-subtests";
+	argv[argc-1] = server_mode ? "-server" : "-report-subtests";
+
+	/* The last frame may still be in the readback ring */
+	piglit_present_finish();
+	piglit_readback_release();
 
 	if (gl_fw->destroy)
 		gl_fw->destroy(gl_fw);
@@ -3931,6 +5218,561 @@ validate_current_gl_context(const char *filename)
 	return true;
 }
 
+/**
+ * Reset the global and GL state between test files run in one process.
+ */
+static void
+reset_test_state(bool es)
+{
+	unsigned i;
+
+	/* Clear global variables to defaults. */
+	test_start = NULL;
+	assert(num_vertex_shaders == 0);
+	assert(num_tess_ctrl_shaders == 0);
+	assert(num_tess_eval_shaders == 0);
+	assert(num_geometry_shaders == 0);
+	assert(num_fragment_shaders == 0);
+	assert(num_compute_shaders == 0);
+	assert(num_uniform_blocks == 0);
+	assert(uniform_block_bos == NULL);
+	geometry_layout_input_type = GL_TRIANGLES;
+	geometry_layout_output_type = GL_TRIANGLE_STRIP;
+	geometry_layout_vertices_out = 0;
+	memset(atomics_bos, 0, sizeof(atomics_bos));
+	memset(ssbo, 0, sizeof(ssbo));
+	for (i = 0; i < ARRAY_SIZE(subuniform_locations); i++)
+		assert(subuniform_locations[i] == NULL);
+	memset(num_subuniform_locations, 0, sizeof(num_subuniform_locations));
+	shader_string = NULL;
+	shader_string_size = 0;
+	vertex_data_start = NULL;
+	vertex_data_end = NULL;
+	prog = 0;
+	sso_vertex_prog = 0;
+	sso_tess_control_prog = 0;
+	sso_tess_eval_prog = 0;
+	sso_geometry_prog = 0;
+	sso_fragment_prog = 0;
+	sso_compute_prog = 0;
+	num_vbo_rows = 0;
+	vbo_present = false;
+	link_ok = false;
+	prog_in_use = false;
+	sso_in_use = false;
+	prog_err_info = NULL;
+	vao = 0;
+
+	/* Report the program cache use of each test on its own. */
+	program_cache_hits = 0;
+	program_cache_misses = 0;
+	program_cache_bypassed = 0;
+
+	/* Clear GL states to defaults. */
+	glClearColor(0, 0, 0, 0);
+# if PIGLIT_USE_OPENGL
+	glClearDepth(1);
+# else
+	glClearDepthf(1.0);
+# endif
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(0);
+	glDisable(GL_DEPTH_TEST);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	for (int k = 0; k < gl_max_clip_planes; k++) {
+		glDisable(GL_CLIP_PLANE0 + k);
+	}
+
+	if (!(es) && (gl_version.num >= 20 ||
+	     piglit_is_extension_supported("GL_ARB_vertex_program")))
+		glDisable(GL_PROGRAM_POINT_SIZE);
+
+	for (i = 0; i < 16; i++)
+		glDisableVertexAttribArray(i);
+
+	if (!piglit_is_core_profile && !es) {
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glShadeModel(GL_SMOOTH);
+		glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
+	}
+
+	if (piglit_is_extension_supported("GL_ARB_vertex_program")) {
+		glDisable(GL_VERTEX_PROGRAM_ARB);
+		glBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
+	}
+	if (piglit_is_extension_supported("GL_ARB_fragment_program")) {
+		glDisable(GL_FRAGMENT_PROGRAM_ARB);
+		glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, 0);
+	}
+	if (piglit_is_extension_supported("GL_ARB_separate_shader_objects")) {
+		if (!pipeline)
+			glGenProgramPipelines(1, &pipeline);
+		glBindProgramPipeline(0);
+	}
+
+	if (piglit_is_extension_supported("GL_EXT_provoking_vertex"))
+		glProvokingVertexEXT(GL_LAST_VERTEX_CONVENTION_EXT);
+
+# if PIGLIT_USE_OPENGL
+	if (gl_version.num >= 40 ||
+	    piglit_is_extension_supported("GL_ARB_tessellation_shader")) {
+		static float ones[] = {1, 1, 1, 1};
+		glPatchParameteri(GL_PATCH_VERTICES, 3);
+		glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, ones);
+		glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, ones);
+	}
+# else
+	/* Ideally one would use the following code:
+	 *
+	 * if (gl_version.num >= 32) {
+	 *         glPatchParameteri(GL_PATCH_VERTICES, 3);
+	 * }
+	 *
+	 * however, that doesn't work with mesa because those
+	 * symbols apparently need to be exported, but that
+	 * breaks non-gles builds.
+	 *
+	 * It seems rather unlikely that an implementation
+	 * would have GLES 3.2 support but not
+	 * OES_tessellation_shader.
+	 */
+	if (piglit_is_extension_supported("GL_OES_tessellation_shader")) {
+		glPatchParameteriOES(GL_PATCH_VERTICES_OES, 3);
+	}
+# endif
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/**
+ * \name Parameter tables
+ *
+ * A test script with a [parameters] section is a template.  The first line
+ * of the section names the parameters, and each following line holds the
+ * values of one row, with the columns separated by '|'.  Blank lines and
+ * lines starting with '#' are ignored.  Each ${name} outside of the
+ * [parameters] and [require] sections is replaced by the value of the
+ * parameter, and the script runs once per row, in the same context.  The
+ * "name" parameter, if there is one, names the rows in the results.
+ *
+ * The [require] section is not expanded, since the GL context is created
+ * from it before the rows are known.
+ */
+/*@{*/
+struct parameter_table {
+	unsigned num_columns;
+	unsigned num_rows;
+	/** The names of the columns, followed by the values of each row. */
+	char **cells;
+	int name_column;
+};
+
+static void
+free_parameter_table(struct parameter_table *table)
+{
+	unsigned i;
+
+	for (i = 0; i < (table->num_rows + 1) * table->num_columns; i++)
+		free(table->cells[i]);
+	free(table->cells);
+	table->cells = NULL;
+	table->num_columns = 0;
+	table->num_rows = 0;
+}
+
+/**
+ * Append the trimmed cells of a line of the table to \p table, returning
+ * how many there are.
+ */
+static unsigned
+parse_parameter_line(const char *line, struct parameter_table *table,
+		     unsigned num_cells)
+{
+	const char *end = strchrnul(line, '\n');
+	unsigned n = 0;
+
+	while (true) {
+		const char *sep = memchr(line, '|', end - line);
+		const char *cell_end = sep ? sep : end;
+
+		while (line < cell_end && isspace((unsigned char) *line))
+			line++;
+		while (cell_end > line && isspace((unsigned char) cell_end[-1]))
+			cell_end--;
+
+		table->cells = realloc(table->cells,
+				       (num_cells + n + 1) * sizeof(char *));
+		table->cells[num_cells + n++] = strndup(line, cell_end - line);
+
+		if (sep == NULL)
+			return n;
+		line = sep + 1;
+	}
+}
+
+static bool
+is_parameter_name(const char *name)
+{
+	if (!isalpha((unsigned char) name[0]) && name[0] != '_')
+		return false;
+
+	for (name++; name[0] != '\0'; name++) {
+		if (!isalnum((unsigned char) name[0]) && name[0] != '_')
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Parse the [parameters] section of the test script \p text, if it has
+ * one.  Without it \p table is left empty.
+ */
+static enum piglit_result
+parse_parameter_table(const char *text, struct parameter_table *table)
+{
+	const char *line = text;
+	unsigned line_num = 1;
+	bool in_section = false, found = false;
+
+	memset(table, 0, sizeof(*table));
+	table->name_column = -1;
+
+	while (line[0] != '\0') {
+		const char *rest;
+
+		if (line[0] == '[') {
+			if (in_section)
+				break;
+			in_section = parse_str(line, "[parameters]", NULL);
+			found = found || in_section;
+		} else if (in_section) {
+			unsigned num_cells = (table->num_rows + 1) *
+					     table->num_columns;
+			unsigned n, i;
+
+			parse_whitespace(line, &rest);
+			if (rest[0] != '\0' && rest[0] != '\n' &&
+			    rest[0] != '\r' && rest[0] != '#') {
+				n = parse_parameter_line(line, table,
+							 table->num_columns ?
+							 num_cells : 0);
+				if (table->num_columns == 0) {
+					table->num_columns = n;
+					for (i = 0; i < n; i++) {
+						if (!is_parameter_name(table->cells[i])) {
+							printf("Invalid parameter name "
+							       "\"%s\" on line %u\n",
+							       table->cells[i],
+							       line_num);
+							free_parameter_table(table);
+							return PIGLIT_FAIL;
+						}
+						if (strcmp(table->cells[i], "name") == 0)
+							table->name_column = i;
+					}
+				} else if (n != table->num_columns) {
+					printf("Expected %u parameter values on "
+					       "line %u, found %u\n",
+					       table->num_columns, line_num, n);
+					for (i = 0; i < n; i++)
+						free(table->cells[num_cells + i]);
+					free_parameter_table(table);
+					return PIGLIT_FAIL;
+				} else {
+					table->num_rows++;
+				}
+			}
+		}
+
+		line = strchrnul(line, '\n');
+		if (line[0] != '\0')
+			line++;
+		line_num++;
+	}
+
+	if (found && table->num_rows == 0) {
+		printf("[parameters] section without rows\n");
+		free_parameter_table(table);
+		return PIGLIT_FAIL;
+	}
+
+	return PIGLIT_PASS;
+}
+
+static void
+append_text(char **text, size_t *len, size_t *size, const char *s, size_t n)
+{
+	if (*len + n + 1 > *size) {
+		*size = MAX2(*size * 2, *len + n + 1);
+		*text = realloc(*text, *size);
+	}
+	memcpy(*text + *len, s, n);
+	*len += n;
+	(*text)[*len] = '\0';
+}
+
+/**
+ * Find the next "${" in [\p p, \p end), or return NULL.
+ */
+static const char *
+find_parameter(const char *p, const char *end)
+{
+	while (p < end && (p = memchr(p, '$', end - p)) != NULL) {
+		if (p + 1 < end && p[1] == '{')
+			return p;
+		p++;
+	}
+	return NULL;
+}
+
+/**
+ * Return a copy of the test script \p text with the parameters replaced by
+ * the values of \p row, or NULL if it uses an unknown parameter.  Values
+ * can't span lines, so the line numbers don't change.
+ */
+static char *
+expand_parameters(const char *text, const struct parameter_table *table,
+		  unsigned row)
+{
+	char *const *values = table->cells + (row + 1) * table->num_columns;
+	size_t len = 0, size = strlen(text) + 1;
+	char *expanded = malloc(size);
+	const char *p = text;
+	unsigned line_num = 1;
+	bool expand = true;
+
+	expanded[0] = '\0';
+
+	while (p[0] != '\0') {
+		const char *end = strchrnul(p, '\n');
+		const char *var;
+
+		if (p[0] == '[')
+			expand = !parse_str(p, "[parameters]", NULL) &&
+				 !parse_str(p, "[require]", NULL);
+
+		/* Only search the line, the rest of the text may be long */
+		while (expand && (var = find_parameter(p, end)) != NULL) {
+			const char *close = memchr(var, '}', end - var);
+			const char *value = NULL;
+			unsigned i;
+
+			for (i = 0; close != NULL && i < table->num_columns; i++) {
+				if (strlen(table->cells[i]) == close - var - 2 &&
+				    strncmp(table->cells[i], var + 2,
+					    close - var - 2) == 0)
+					value = values[i];
+			}
+
+			if (value == NULL) {
+				printf("Unknown parameter on line %u: %.*s\n",
+				       line_num, (int) (end - p), p);
+				free(expanded);
+				return NULL;
+			}
+
+			append_text(&expanded, &len, &size, p, var - p);
+			append_text(&expanded, &len, &size, value,
+				    strlen(value));
+			p = close + 1;
+		}
+
+		if (end[0] != '\0')
+			end++;
+		append_text(&expanded, &len, &size, p, end - p);
+		p = end;
+		line_num++;
+	}
+
+	return expanded;
+}
+
+/**
+ * Run the rows of a template one after the other.  They are reported as
+ * subtests if \p report_rows is set, otherwise only their merged result
+ * is returned.
+ */
+static enum piglit_result
+run_parameter_rows(const char *text, const struct parameter_table *table,
+		   bool es, const float *default_tolerance, bool report_rows)
+{
+	enum piglit_result full_result = PIGLIT_SKIP;
+	unsigned row;
+
+	program_cache_in_memory = true;
+
+	for (row = 0; row < table->num_rows; row++) {
+		char name[64];
+		const char *row_name = name;
+		enum piglit_result result;
+		char *row_text;
+
+		if (table->name_column >= 0)
+			row_name = table->cells[(row + 1) * table->num_columns +
+						table->name_column];
+		else
+			snprintf(name, sizeof(name), "row %u", row + 1);
+
+		if (row > 0)
+			reset_test_state(es);
+		memcpy(piglit_tolerance, default_tolerance,
+		       sizeof(piglit_tolerance));
+
+		row_text = expand_parameters(text, table, row);
+		if (row_text == NULL) {
+			result = PIGLIT_FAIL;
+		} else {
+			result = init_test(row_text);
+			if (result == PIGLIT_PASS)
+				result = piglit_display();
+		}
+		piglit_present_finish();
+
+		if (report_rows)
+			piglit_report_subtest_result(result, "%s", row_name);
+		else
+			printf("Row %s: %s\n", row_name,
+			       piglit_result_to_string(result));
+		piglit_merge_result(&full_result, result);
+
+		teardown_ubos();
+		teardown_atomics();
+		teardown_fbos();
+		free_test_commands();
+		free(row_text);
+	}
+
+	program_cache_in_memory = false;
+	free_cached_binaries();
+
+	return full_result;
+}
+/*@}*/
+
+/**
+ * Run a single test file in an already initialized process, recreating the
+ * GL context first if the file needs a different configuration.
+ *
+ * \c argv[0] is the file to run, the remaining arguments are only used to
+ * restart the process with the files left in the list.
+ */
+static void
+run_test_file(char *exec_arg, int argc, char **argv, bool es,
+	      const float *default_tolerance)
+{
+	const char *filename = argv[0];
+	char testname[4096], *ext;
+	const char *hit;
+	enum piglit_result result;
+	struct parameter_table table;
+	unsigned text_size;
+	char *text;
+	int num;
+
+	memcpy(piglit_tolerance, default_tolerance, sizeof(piglit_tolerance));
+
+	/* Re-initialize the GL context if a different GL config is required. */
+	if (!validate_current_gl_context(filename))
+		recreate_gl_context(exec_arg, argc, argv);
+
+	reset_test_state(es);
+	piglit_golden_begin_test(filename);
+
+	/* Strip the file path. */
+	hit = strrchr(filename, PIGLIT_PATH_SEP);
+	if (hit)
+		strcpy(testname, hit+1);
+	else
+		strcpy(testname, filename);
+
+	/* Strip the file extension. */
+	ext = strstr(testname, ".shader_test");
+	if (ext && !ext[12])
+		*ext = 0;
+
+	/* Print the name before we start the test, that way if
+	 * the test fails we can still resume and know which
+	 * test failed */
+	num = test_num++;
+	printf("PIGLIT TEST: %i - %s\n", num, testname);
+	fprintf(stderr, "PIGLIT TEST: %i - %s\n", num, testname);
+
+	/* Run the test. */
+	text = piglit_load_text_file(filename, &text_size);
+	if (text == NULL) {
+		printf("could not read file \"%s\"\n", filename);
+		result = PIGLIT_FAIL;
+	} else {
+		result = parse_parameter_table(text, &table);
+	}
+
+	if (result == PIGLIT_PASS && table.num_rows > 0) {
+		result = run_parameter_rows(text, &table, es,
+					    default_tolerance, false);
+		free_parameter_table(&table);
+	} else if (result == PIGLIT_PASS) {
+		result = init_test(text);
+		if (result == PIGLIT_PASS)
+			result = piglit_display();
+	}
+
+	/* The golden image records of the file's frames must come before
+	 * its result and end marker.
+	 */
+	piglit_present_finish();
+
+	/* In server mode each file is reported as a test of its own,
+	 * the framework splits the output at the end marker.
+	 */
+	if (server_mode) {
+		printf("PIGLIT: {\"result\": \"%s\" }\n",
+		       piglit_result_to_string(result));
+	} else {
+		piglit_report_subtest_result(result, "%s", testname);
+	}
+
+	/* destroy GL objects? */
+	teardown_ubos();
+	teardown_atomics();
+	teardown_fbos();
+	free_test_commands();
+
+	if (server_mode) {
+		printf("PIGLIT TEST END: %i\n", num);
+		fflush(stdout);
+		fflush(stderr);
+	}
+}
+
+/**
+ * Server mode: after the files given on the command line, read further
+ * test file paths from stdin, one per line, until end of file.
+ */
+static void
+serve_test_files(char *exec_arg, bool es, const float *default_tolerance)
+{
+	char line[4096];
+
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		char *filename = line;
+		size_t len = strlen(line);
+
+		while (len > 0 && (line[len - 1] == '\n' ||
+				   line[len - 1] == '\r'))
+			line[--len] = '\0';
+		if (len == 0)
+			continue;
+
+		run_test_file(exec_arg, 1, &filename, es, default_tolerance);
+	}
+}
+
 void
 piglit_init(int argc, char **argv)
 {
@@ -3940,10 +5782,19 @@ piglit_init(int argc, char **argv)
 	bool es;
 	enum piglit_result result;
 	float default_piglit_tolerance[4];
+	struct parameter_table table;
+	unsigned text_size;
+	char *text;
 
 	report_subtests = piglit_strip_arg(&argc, argv, "-report-subtests");
+	server_mode = piglit_strip_arg(&argc, argv, "-server");
+
+	program_cache_dir = getenv("PIGLIT_SHADER_CACHE_DIR");
+	if (program_cache_dir && !program_cache_dir[0])
+		program_cache_dir = NULL;
+
 	if (argc < 2) {
-		printf("usage: shader_runner <test.shader_test>\n");
+		printf("usage: shader_runner <test.shader_test> [-server]\n");
 		exit(1);
 	}
 
@@ -4002,183 +5853,39 @@ piglit_init(int argc, char **argv)
 	read_height = render_height = piglit_height;
 
 	/* Automatic mode can run multiple tests per session. */
-	if (report_subtests) {
-		char testname[4096], *ext;
-		int i, j;
-
-		for (i = 1; i < argc; i++) {
-			const char *hit, *filename = argv[i];
-
-			memcpy(piglit_tolerance, default_piglit_tolerance,
-			       sizeof(piglit_tolerance));
-
-			/* Re-initialize the GL context if a different GL config is required. */
-			if (!validate_current_gl_context(filename))
-				recreate_gl_context(argv[0], argc - i, argv + i);
-
-			/* Clear global variables to defaults. */
-			test_start = NULL;
-			assert(num_vertex_shaders == 0);
-			assert(num_tess_ctrl_shaders == 0);
-			assert(num_tess_eval_shaders == 0);
-			assert(num_geometry_shaders == 0);
-			assert(num_fragment_shaders == 0);
-			assert(num_compute_shaders == 0);
-			assert(num_uniform_blocks == 0);
-			assert(uniform_block_bos == NULL);
-			geometry_layout_input_type = GL_TRIANGLES;
-			geometry_layout_output_type = GL_TRIANGLE_STRIP;
-			geometry_layout_vertices_out = 0;
-			memset(atomics_bos, 0, sizeof(atomics_bos));
-			memset(ssbo, 0, sizeof(ssbo));
-			for (j = 0; j < ARRAY_SIZE(subuniform_locations); j++)
-				assert(subuniform_locations[j] == NULL);
-			memset(num_subuniform_locations, 0, sizeof(num_subuniform_locations));
-			shader_string = NULL;
-			shader_string_size = 0;
-			vertex_data_start = NULL;
-			vertex_data_end = NULL;
-			prog = 0;
-			sso_vertex_prog = 0;
-			sso_tess_control_prog = 0;
-			sso_tess_eval_prog = 0;
-			sso_geometry_prog = 0;
-			sso_fragment_prog = 0;
-			sso_compute_prog = 0;
-			num_vbo_rows = 0;
-			vbo_present = false;
-			link_ok = false;
-			prog_in_use = false;
-			sso_in_use = false;
-			prog_err_info = NULL;
-			vao = 0;
-
-			/* Clear GL states to defaults. */
-			glClearColor(0, 0, 0, 0);
-# if PIGLIT_USE_OPENGL
-			glClearDepth(1);
-# else
-			glClearDepthf(1.0);
-# endif
-			glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
-			glActiveTexture(GL_TEXTURE0);
-			glUseProgram(0);
-			glDisable(GL_DEPTH_TEST);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-			for (int k = 0; k < gl_max_clip_planes; k++) {
-				glDisable(GL_CLIP_PLANE0 + k);
-			}
-
-			if (!(es) && (gl_version.num >= 20 ||
-			     piglit_is_extension_supported("GL_ARB_vertex_program")))
-				glDisable(GL_PROGRAM_POINT_SIZE);
-
-			for (int i = 0; i < 16; i++)
-				glDisableVertexAttribArray(i);
-
-			if (!piglit_is_core_profile && !es) {
-				glMatrixMode(GL_PROJECTION);
-				glLoadIdentity();
-				glMatrixMode(GL_MODELVIEW);
-				glLoadIdentity();
-				glShadeModel(GL_SMOOTH);
-				glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
-			}
-
-			if (piglit_is_extension_supported("GL_ARB_vertex_program")) {
-				glDisable(GL_VERTEX_PROGRAM_ARB);
-				glBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
-			}
-			if (piglit_is_extension_supported("GL_ARB_fragment_program")) {
-				glDisable(GL_FRAGMENT_PROGRAM_ARB);
-				glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, 0);
-			}
-			if (piglit_is_extension_supported("GL_ARB_separate_shader_objects")) {
-				if (!pipeline)
-					glGenProgramPipelines(1, &pipeline);
-				glBindProgramPipeline(0);
-			}
-
-			if (piglit_is_extension_supported("GL_EXT_provoking_vertex"))
-				glProvokingVertexEXT(GL_LAST_VERTEX_CONVENTION_EXT);
-
-# if PIGLIT_USE_OPENGL
-			if (gl_version.num >= 40 ||
-			    piglit_is_extension_supported("GL_ARB_tessellation_shader")) {
-				static float ones[] = {1, 1, 1, 1};
-				glPatchParameteri(GL_PATCH_VERTICES, 3);
-				glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, ones);
-				glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, ones);
-			}
-# else
-			/* Ideally one would use the following code:
-			 *
-			 * if (gl_version.num >= 32) {
-			 *         glPatchParameteri(GL_PATCH_VERTICES, 3);
-			 * }
-			 *
-			 * however, that doesn't work with mesa because those
-			 * symbols apparently need to be exported, but that
-			 * breaks non-gles builds.
-			 *
-			 * It seems rather unlikely that an implementation
-			 * would have GLES 3.2 support but not
-			 * OES_tessellation_shader.
-			 */
-			if (piglit_is_extension_supported("GL_OES_tessellation_shader")) {
-				glPatchParameteriOES(GL_PATCH_VERTICES_OES, 3);
-			}
-# endif
-
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if (report_subtests || server_mode) {
+		int i;
 
-			/* Strip the file path. */
-			hit = strrchr(filename, PIGLIT_PATH_SEP);
-			if (hit)
-				strcpy(testname, hit+1);
-			else
-				strcpy(testname, filename);
+		for (i = 1; i < argc; i++)
+			run_test_file(argv[0], argc - i, argv + i, es,
+				      default_piglit_tolerance);
 
-			/* Strip the file extension. */
-			ext = strstr(testname, ".shader_test");
-			if (ext && !ext[12])
-				*ext = 0;
+		if (server_mode)
+			serve_test_files(argv[0], es, default_piglit_tolerance);
+		exit(0);
+	}
 
-			/* Print the name before we start the test, that way if
-			 * the test fails we can still resume and know which
-			 * test failed */
-			printf("PIGLIT TEST: %i - %s\n", test_num, testname);
-			fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, testname);
-			test_num++;
+	/* Key the golden entries on the file, as run_test_file() does, so
+	 * that they don't depend on the mode the file is run in.
+	 */
+	piglit_golden_begin_test(argv[1]);
 
-			/* Run the test. */
-			result = init_test(filename);
+	text = piglit_load_text_file(argv[1], &text_size);
+	if (text == NULL) {
+		printf("could not read file \"%s\"\n", argv[1]);
+		piglit_report_result(PIGLIT_FAIL);
+	}
 
-			if (result == PIGLIT_PASS) {
-				result = piglit_display();
-			}
-			/* Use subtest when running with more than one test,
-			 * but use regular test result when running with just
-			 * one.  This allows the standard process-at-a-time
-			 * mode to keep working.
-			 */
-			if (report_subtests) {
-				piglit_report_subtest_result(
-					result, "%s", testname);
-			} else {
-				piglit_report_result(result);
-			}
+	result = parse_parameter_table(text, &table);
+	if (result != PIGLIT_PASS)
+		piglit_report_result(result);
 
-			/* destroy GL objects? */
-			teardown_ubos();
-			teardown_atomics();
-			teardown_fbos();
-		}
-		exit(0);
-	}
+	/* The rows of a template are subtests of the test. */
+	if (table.num_rows > 0)
+		piglit_report_result(run_parameter_rows(
+			text, &table, es, default_piglit_tolerance, true));
 
-	result = init_test(argv[1]);
+	result = init_test(text);
 	if (result != PIGLIT_PASS)
 		piglit_report_result(result);
 }
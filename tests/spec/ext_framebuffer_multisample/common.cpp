@@ -109,6 +109,12 @@
  */
 
 #include "common.h"
+
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 using namespace piglit_util_fbo;
 using namespace piglit_util_test_pattern;
 
@@ -483,6 +489,164 @@ Test::draw_reference_image()
 	}
 }
 
+/**
+ * sRGB decode of the 256 values of an 8-bit sRGB channel, indexed by
+ * the 8-bit value.  Filled by measure_accuracy() before any thread
+ * reads it.
+ */
+static float srgb_decode_table[256];
+static bool srgb_decode_table_ready = false;
+
+static void
+init_srgb_decode_table()
+{
+	if (srgb_decode_table_ready)
+		return;
+	for (int i = 0; i < 256; ++i)
+		srgb_decode_table[i] = piglit_srgb_to_linear(i / 255.0f);
+	srgb_decode_table_ready = true;
+}
+
+/**
+ * Same as piglit_srgb_to_linear(x), but looks x up in
+ * srgb_decode_table when it is exactly one of the values an 8-bit
+ * channel reads back as, which is the case for sRGB framebuffers.
+ */
+static inline float
+srgb_decode(float x)
+{
+	if (x >= 0.0f && x <= 1.0f) {
+		int i = (int) (x * 255.0f + 0.5f);
+		if (x == i / 255.0f)
+			return srgb_decode_table[i];
+	}
+	return piglit_srgb_to_linear(x);
+}
+
+/**
+ * The components [begin, end) of the reference and test images, and
+ * the errors measured over them, indexed by accuracy_class().
+ */
+struct accuracy_range {
+	const float *reference_data;
+	const float *test_data;
+	int begin, end;
+	bool srgb;
+	Stats stats[3];
+};
+
+enum {
+	ACCURACY_UNLIT,
+	ACCURACY_PARTIALLY_LIT,
+	ACCURACY_TOTALLY_LIT,
+};
+
+static inline int
+accuracy_class(float ref)
+{
+	return ref <= 0.0 ? ACCURACY_UNLIT :
+		ref >= 1.0 ? ACCURACY_TOTALLY_LIT : ACCURACY_PARTIALLY_LIT;
+}
+
+static void *
+measure_accuracy_range(void *data)
+{
+	accuracy_range *range = (accuracy_range *) data;
+	const float *reference_data = range->reference_data;
+	const float *test_data = range->test_data;
+
+	if (!range->srgb) {
+		for (int i = range->begin; i < range->end; ++i) {
+			float ref = reference_data[i];
+			range->stats[accuracy_class(ref)]
+				.record(test_data[i] - ref);
+		}
+		return NULL;
+	}
+
+	/* When testing sRGB, compare pixels linearly so that the
+	 * measured error is comparable to the non-sRGB case.  Alpha
+	 * is linear already.
+	 */
+	for (int i = range->begin; i < range->end; ++i) {
+		float ref = reference_data[i];
+		float test = test_data[i];
+		if (i % 4 != 3) {
+			ref = srgb_decode(ref);
+			test = srgb_decode(test);
+		}
+		range->stats[accuracy_class(ref)].record(test - ref);
+	}
+	return NULL;
+}
+
+/**
+ * Minimum number of pixels measured per thread.  Below this, starting
+ * a thread costs more than it saves.
+ */
+#define ACCURACY_PIXELS_PER_THREAD (128 * 128)
+#define ACCURACY_MAX_THREADS 8
+
+/**
+ * Measure the errors of test_data against reference_data, both
+ * num_pixels RGBA pixels, into stats (indexed by accuracy_class()).
+ *
+ * Large images are split in runs of rows measured by separate
+ * threads.  The stats of the runs are added in image order, so only
+ * the rounding of the sums may differ from a single-threaded pass.
+ */
+static void
+measure_accuracy_pixels(const float *reference_data, const float *test_data,
+			int num_pixels, bool srgb, Stats stats[3])
+{
+	int num_threads = 1;
+#ifdef PIGLIT_HAS_PTHREADS
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	num_threads = MIN2(num_pixels / ACCURACY_PIXELS_PER_THREAD,
+			   MIN2(cpus, ACCURACY_MAX_THREADS));
+	if (num_threads < 1)
+		num_threads = 1;
+#endif
+
+	if (srgb)
+		init_srgb_decode_table();
+
+	accuracy_range ranges[ACCURACY_MAX_THREADS];
+	for (int t = 0; t < num_threads; ++t) {
+		ranges[t].reference_data = reference_data;
+		ranges[t].test_data = test_data;
+		ranges[t].begin = 4 * (int) ((long) num_pixels * t /
+					     num_threads);
+		ranges[t].end = 4 * (int) ((long) num_pixels * (t + 1) /
+					   num_threads);
+		ranges[t].srgb = srgb;
+	}
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_t threads[ACCURACY_MAX_THREADS];
+	bool started[ACCURACY_MAX_THREADS] = { false };
+	for (int t = 1; t < num_threads; ++t) {
+		started[t] = pthread_create(&threads[t], NULL,
+					    measure_accuracy_range,
+					    &ranges[t]) == 0;
+	}
+	measure_accuracy_range(&ranges[0]);
+	for (int t = 1; t < num_threads; ++t) {
+		if (started[t])
+			pthread_join(threads[t], NULL);
+		else
+			measure_accuracy_range(&ranges[t]);
+	}
+#else
+	measure_accuracy_range(&ranges[0]);
+#endif
+
+	for (int t = 0; t < num_threads; ++t) {
+		for (int i = 0; i < 3; ++i)
+			stats[i].add(ranges[t].stats[i]);
+	}
+}
+
 /**
  * Measure the accuracy of MSAA downsampling.  Pixels that are fully
  * on or off in the reference image are required to be fully on or off
@@ -507,32 +671,12 @@ Test::measure_accuracy()
 	glReadPixels(0, 0, pattern_width, pattern_height, GL_RGBA,
 		     GL_FLOAT, test_data);
 
-	Stats unlit_stats;
-	Stats partially_lit_stats;
-	Stats totally_lit_stats;
-	for (int y = 0; y < pattern_height; ++y) {
-		for (int x = 0; x < pattern_width; ++x) {
-			for (int c = 0; c < 4; ++c) {
-				int pixel_pos = 4*(y*pattern_width + x) + c;
-				float ref = reference_data[pixel_pos];
-				float test = test_data[pixel_pos];
-				/* When testing sRGB, compare pixels
-				 * linearly so that the measured error
-				 * is comparable to the non-sRGB case.
-				 */
-				if (srgb && c < 3) {
-					ref = piglit_srgb_to_linear(ref);
-					test = piglit_srgb_to_linear(test);
-				}
-				if (ref <= 0.0)
-					unlit_stats.record(test - ref);
-				else if (ref >= 1.0)
-					totally_lit_stats.record(test - ref);
-				else
-					partially_lit_stats.record(test - ref);
-			}
-		}
-	}
+	Stats stats[3];
+	measure_accuracy_pixels(reference_data, test_data,
+				pattern_width * pattern_height, srgb, stats);
+	Stats &unlit_stats = stats[ACCURACY_UNLIT];
+	Stats &partially_lit_stats = stats[ACCURACY_PARTIALLY_LIT];
+	Stats &totally_lit_stats = stats[ACCURACY_TOTALLY_LIT];
 
 	double error_threshold;
 	if (test_resolve) {
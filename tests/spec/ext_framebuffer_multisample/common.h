@@ -78,6 +78,16 @@ public:
 		sum_squared_error += error * error;
 	}
 
+	/**
+	 * Add the errors recorded in other, e.g. by another thread
+	 * measuring part of the same image.
+	 */
+	void add(const Stats &other)
+	{
+		count += other.count;
+		sum_squared_error += other.sum_squared_error;
+	}
+
 	void summarize();
 
 	bool is_perfect();
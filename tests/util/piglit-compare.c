@@ -0,0 +1,469 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-compare.c
+ *
+ * SSE2, AVX2 and NEON versions of the pixel comparison loops, picked at
+ * runtime.  The predicate is the same as the scalar code's, so a vector
+ * kernel never passes a pixel the scalar loop would fail.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piglit-compare.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    defined(__SSE2__)
+#define PIGLIT_COMPARE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define PIGLIT_COMPARE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Scalar kernels */
+
+static int
+rgba_float_scalar(const float *pixels, int n, const float *expected,
+		  const float *tolerance, int num_components)
+{
+	int i, p;
+
+	for (i = 0; i < n; i++)
+		for (p = 0; p < num_components; p++)
+			if (fabs(pixels[i * 4 + p] - expected[p]) >=
+			    tolerance[p])
+				return i;
+	return n;
+}
+
+static int
+rgba_ubyte_scalar(const unsigned char *pixels, int n,
+		  const unsigned char *expected,
+		  const unsigned char *tolerance, int num_components)
+{
+	int i, p;
+
+	for (i = 0; i < n; i++)
+		for (p = 0; p < num_components; p++)
+			if (abs((int) pixels[i * 4 + p] - (int) expected[p]) >=
+			    tolerance[p])
+				return i;
+	return n;
+}
+
+static int
+images_float_scalar(const float *observed, const float *expected, int n,
+		    const float *tolerance, int num_components)
+{
+	int i, p;
+
+	for (i = 0; i < n; i++)
+		for (p = 0; p < num_components; p++)
+			if (fabs(observed[i * num_components + p] -
+				 expected[i * num_components + p]) >=
+			    tolerance[p])
+				return i;
+	return n;
+}
+
+static const struct piglit_compare_kernels scalar_kernels = {
+	"scalar",
+	rgba_float_scalar,
+	rgba_ubyte_scalar,
+	images_float_scalar,
+};
+
+/**
+ * Expand a per-component tolerance to four float lanes.  Unused channels
+ * of an RGBA pixel get an infinite tolerance so they never fail; images
+ * with one or two channels repeat their pattern across the lanes.
+ * Returns false for layouts that don't fit in four lanes.
+ */
+static bool
+expand_tolerance(const float *tolerance, int num_components, bool rgba,
+		 float *lanes)
+{
+	int p;
+
+	if (!rgba && num_components == 3)
+		return false;
+
+	for (p = 0; p < 4; p++) {
+		if (rgba)
+			lanes[p] = p < num_components ? tolerance[p] : INFINITY;
+		else
+			lanes[p] = tolerance[p % num_components];
+	}
+	return true;
+}
+
+static void
+expand_ubyte(const unsigned char *expected, const unsigned char *tolerance,
+	     int num_components, unsigned char *e, unsigned char *t,
+	     unsigned char *mask)
+{
+	int i, p;
+
+	for (i = 0; i < 4; i++) {
+		for (p = 0; p < 4; p++) {
+			bool used = p < num_components;
+
+			e[i * 4 + p] = used ? expected[p] : 0;
+			t[i * 4 + p] = used ? tolerance[p] : 0;
+			mask[i * 4 + p] = used ? 0xff : 0;
+		}
+	}
+}
+
+#ifdef PIGLIT_COMPARE_X86
+
+static inline __m128
+abs_ps(__m128 v)
+{
+	return _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+}
+
+static int
+rgba_float_sse2(const float *pixels, int n, const float *expected,
+		const float *tolerance, int num_components)
+{
+	float exp4[4] = { 0, 0, 0, 0 }, tol4[4];
+	__m128 e, t;
+	int i;
+
+	memcpy(exp4, expected, num_components * sizeof(float));
+	expand_tolerance(tolerance, num_components, true, tol4);
+	e = _mm_loadu_ps(exp4);
+	t = _mm_loadu_ps(tol4);
+
+	for (i = 0; i < n; i++) {
+		__m128 d = abs_ps(_mm_sub_ps(_mm_loadu_ps(pixels + i * 4), e));
+
+		if (_mm_movemask_ps(_mm_cmpge_ps(d, t)))
+			return i;
+	}
+	return n;
+}
+
+/** Return a byte mask of the lanes where |a - b| >= t. */
+static inline __m128i
+ubyte_mismatch_sse2(__m128i a, __m128i b, __m128i t)
+{
+	__m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+
+	return _mm_cmpeq_epi8(_mm_max_epu8(d, t), d);
+}
+
+static int
+rgba_ubyte_sse2(const unsigned char *pixels, int n,
+		const unsigned char *expected,
+		const unsigned char *tolerance, int num_components)
+{
+	unsigned char e16[16], t16[16], m16[16];
+	__m128i e, t, m;
+	int i;
+
+	expand_ubyte(expected, tolerance, num_components, e16, t16, m16);
+	e = _mm_loadu_si128((const __m128i *) e16);
+	t = _mm_loadu_si128((const __m128i *) t16);
+	m = _mm_loadu_si128((const __m128i *) m16);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (pixels + i * 4));
+		int bits = _mm_movemask_epi8(
+			_mm_and_si128(ubyte_mismatch_sse2(v, e, t), m));
+
+		if (bits)
+			return i + __builtin_ctz(bits) / 4;
+	}
+
+	return i + rgba_ubyte_scalar(pixels + i * 4, n - i, expected,
+				     tolerance, num_components);
+}
+
+static int
+images_float_sse2(const float *observed, const float *expected, int n,
+		  const float *tolerance, int num_components)
+{
+	float tol4[4];
+	__m128 t;
+	int i, total = n * num_components;
+
+	if (!expand_tolerance(tolerance, num_components, false, tol4))
+		return 0;
+	t = _mm_loadu_ps(tol4);
+
+	for (i = 0; i + 4 <= total; i += 4) {
+		__m128 d = abs_ps(_mm_sub_ps(_mm_loadu_ps(observed + i),
+					     _mm_loadu_ps(expected + i)));
+
+		if (_mm_movemask_ps(_mm_cmpge_ps(d, t)))
+			return i / num_components;
+	}
+
+	return i / num_components;
+}
+
+static const struct piglit_compare_kernels sse2_kernels = {
+	"sse2",
+	rgba_float_sse2,
+	rgba_ubyte_sse2,
+	images_float_sse2,
+};
+
+#define AVX2 __attribute__((target("avx2")))
+
+static inline AVX2 __m256
+abs_ps_avx2(__m256 v)
+{
+	return _mm256_and_ps(v,
+		_mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+}
+
+static AVX2 int
+rgba_float_avx2(const float *pixels, int n, const float *expected,
+		const float *tolerance, int num_components)
+{
+	float exp8[8] = { 0 }, tol8[8];
+	__m256 e, t;
+	int i;
+
+	memcpy(exp8, expected, num_components * sizeof(float));
+	memcpy(exp8 + 4, exp8, 4 * sizeof(float));
+	expand_tolerance(tolerance, num_components, true, tol8);
+	memcpy(tol8 + 4, tol8, 4 * sizeof(float));
+	e = _mm256_loadu_ps(exp8);
+	t = _mm256_loadu_ps(tol8);
+
+	for (i = 0; i + 2 <= n; i += 2) {
+		__m256 d = abs_ps_avx2(
+			_mm256_sub_ps(_mm256_loadu_ps(pixels + i * 4), e));
+		int bits = _mm256_movemask_ps(_mm256_cmp_ps(d, t, _CMP_GE_OQ));
+
+		if (bits)
+			return i + (bits & 0xf ? 0 : 1);
+	}
+
+	return i + rgba_float_scalar(pixels + i * 4, n - i, expected,
+				     tolerance, num_components);
+}
+
+static AVX2 int
+rgba_ubyte_avx2(const unsigned char *pixels, int n,
+		const unsigned char *expected,
+		const unsigned char *tolerance, int num_components)
+{
+	unsigned char e16[16], t16[16], m16[16];
+	__m256i e, t, m;
+	int i;
+
+	expand_ubyte(expected, tolerance, num_components, e16, t16, m16);
+	e = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) e16));
+	t = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) t16));
+	m = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) m16));
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256(
+			(const __m256i *) (pixels + i * 4));
+		__m256i d = _mm256_or_si256(_mm256_subs_epu8(v, e),
+					    _mm256_subs_epu8(e, v));
+		__m256i bad = _mm256_cmpeq_epi8(_mm256_max_epu8(d, t), d);
+		unsigned bits = _mm256_movemask_epi8(_mm256_and_si256(bad, m));
+
+		if (bits)
+			return i + __builtin_ctz(bits) / 4;
+	}
+
+	return i + rgba_ubyte_scalar(pixels + i * 4, n - i, expected,
+				     tolerance, num_components);
+}
+
+static AVX2 int
+images_float_avx2(const float *observed, const float *expected, int n,
+		  const float *tolerance, int num_components)
+{
+	float tol8[8];
+	__m256 t;
+	int i, total = n * num_components;
+
+	if (!expand_tolerance(tolerance, num_components, false, tol8))
+		return 0;
+	memcpy(tol8 + 4, tol8, 4 * sizeof(float));
+	t = _mm256_loadu_ps(tol8);
+
+	for (i = 0; i + 8 <= total; i += 8) {
+		__m256 d = abs_ps_avx2(
+			_mm256_sub_ps(_mm256_loadu_ps(observed + i),
+				      _mm256_loadu_ps(expected + i)));
+
+		if (_mm256_movemask_ps(_mm256_cmp_ps(d, t, _CMP_GE_OQ)))
+			return i / num_components;
+	}
+
+	return i / num_components;
+}
+
+static const struct piglit_compare_kernels avx2_kernels = {
+	"avx2",
+	rgba_float_avx2,
+	rgba_ubyte_avx2,
+	images_float_avx2,
+};
+
+#endif /* PIGLIT_COMPARE_X86 */
+
+#ifdef PIGLIT_COMPARE_NEON
+
+static int
+rgba_float_neon(const float *pixels, int n, const float *expected,
+		const float *tolerance, int num_components)
+{
+	float exp4[4] = { 0, 0, 0, 0 }, tol4[4];
+	float32x4_t e, t;
+	int i;
+
+	memcpy(exp4, expected, num_components * sizeof(float));
+	expand_tolerance(tolerance, num_components, true, tol4);
+	e = vld1q_f32(exp4);
+	t = vld1q_f32(tol4);
+
+	for (i = 0; i < n; i++) {
+		float32x4_t d = vabdq_f32(vld1q_f32(pixels + i * 4), e);
+
+		if (vmaxvq_u32(vcgeq_f32(d, t)))
+			return i;
+	}
+	return n;
+}
+
+static int
+rgba_ubyte_neon(const unsigned char *pixels, int n,
+		const unsigned char *expected,
+		const unsigned char *tolerance, int num_components)
+{
+	unsigned char e16[16], t16[16], m16[16];
+	uint8x16_t e, t, m;
+	int i;
+
+	expand_ubyte(expected, tolerance, num_components, e16, t16, m16);
+	e = vld1q_u8(e16);
+	t = vld1q_u8(t16);
+	m = vld1q_u8(m16);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		uint8x16_t d = vabdq_u8(vld1q_u8(pixels + i * 4), e);
+
+		if (vmaxvq_u8(vandq_u8(vcgeq_u8(d, t), m)))
+			return i;
+	}
+
+	return i + rgba_ubyte_scalar(pixels + i * 4, n - i, expected,
+				     tolerance, num_components);
+}
+
+static int
+images_float_neon(const float *observed, const float *expected, int n,
+		  const float *tolerance, int num_components)
+{
+	float tol4[4];
+	float32x4_t t;
+	int i, total = n * num_components;
+
+	if (!expand_tolerance(tolerance, num_components, false, tol4))
+		return 0;
+	t = vld1q_f32(tol4);
+
+	for (i = 0; i + 4 <= total; i += 4) {
+		float32x4_t d = vabdq_f32(vld1q_f32(observed + i),
+					  vld1q_f32(expected + i));
+
+		if (vmaxvq_u32(vcgeq_f32(d, t)))
+			return i / num_components;
+	}
+
+	return i / num_components;
+}
+
+static const struct piglit_compare_kernels neon_kernels = {
+	"neon",
+	rgba_float_neon,
+	rgba_ubyte_neon,
+	images_float_neon,
+};
+
+#endif /* PIGLIT_COMPARE_NEON */
+
+const struct piglit_compare_kernels *
+piglit_get_compare_kernels_for(enum piglit_simd_level level)
+{
+	switch (level) {
+	case PIGLIT_SIMD_SCALAR:
+		return &scalar_kernels;
+#ifdef PIGLIT_COMPARE_X86
+	case PIGLIT_SIMD_SSE2:
+		return &sse2_kernels;
+	case PIGLIT_SIMD_AVX2:
+		return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+#endif
+#ifdef PIGLIT_COMPARE_NEON
+	case PIGLIT_SIMD_NEON:
+		return &neon_kernels;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+const struct piglit_compare_kernels *
+piglit_get_compare_kernels(void)
+{
+	static const struct piglit_compare_kernels *kernels = NULL;
+	static const enum piglit_simd_level levels[] = {
+		PIGLIT_SIMD_AVX2,
+		PIGLIT_SIMD_SSE2,
+		PIGLIT_SIMD_NEON,
+	};
+	const char *env;
+	unsigned i;
+
+	if (kernels)
+		return kernels;
+
+	env = getenv("PIGLIT_NO_SIMD");
+	if (env == NULL || !env[0] || strcmp(env, "0") == 0) {
+		for (i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+			kernels = piglit_get_compare_kernels_for(levels[i]);
+			if (kernels)
+				return kernels;
+		}
+	}
+
+	kernels = &scalar_kernels;
+	return kernels;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-compare.h
+ *
+ * Vectorized pixel comparison kernels used by the probe and image compare
+ * functions.
+ *
+ * Each kernel scans a run of pixels and returns the index of the first
+ * pixel that may differ from the expected value by the tolerance or more,
+ * or \c n if none does.  Kernels may stop early, at a pixel that turns out
+ * to match; the callers finish the run with their scalar loop from the
+ * returned index, which decides the result and prints the diagnostics.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum piglit_simd_level {
+	PIGLIT_SIMD_SCALAR,
+	PIGLIT_SIMD_SSE2,
+	PIGLIT_SIMD_AVX2,
+	PIGLIT_SIMD_NEON,
+};
+
+struct piglit_compare_kernels {
+	const char *name;
+
+	/**
+	 * Compare \c n RGBA float pixels against one expected color, using
+	 * |observed - expected| >= tolerance on the first \c num_components
+	 * channels.
+	 */
+	int (*rgba_float)(const float *pixels, int n, const float *expected,
+			  const float *tolerance, int num_components);
+
+	/** As rgba_float, for RGBA unsigned byte pixels. */
+	int (*rgba_ubyte)(const unsigned char *pixels, int n,
+			  const unsigned char *expected,
+			  const unsigned char *tolerance, int num_components);
+
+	/**
+	 * Compare \c n pixels of two float images with \c num_components
+	 * channels each, using |observed - expected| >= tolerance.
+	 */
+	int (*images_float)(const float *observed, const float *expected,
+			    int n, const float *tolerance, int num_components);
+};
+
+/**
+ * Return the fastest kernels this CPU supports.  Setting
+ * PIGLIT_NO_SIMD in the environment forces the scalar ones.
+ */
+const struct piglit_compare_kernels *
+piglit_get_compare_kernels(void);
+
+/**
+ * Return the kernels for a given instruction set, or NULL if the build or
+ * the CPU doesn't support it.
+ */
+const struct piglit_compare_kernels *
+piglit_get_compare_kernels_for(enum piglit_simd_level level);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
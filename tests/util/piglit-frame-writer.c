@@ -0,0 +1,238 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-frame-writer.c
+ *
+ * Background writer for captured frames, see piglit-frame-writer.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "piglit-frame-writer.h"
+#include "piglit-golden.h"
+
+struct frame {
+	GLubyte *pixels;
+	int width, height;
+	enum piglit_frame_format format;
+	char *filename;
+	char *renderer;
+};
+
+static int png_level = -1;
+
+void
+piglit_frame_writer_set_png_level(int level)
+{
+	png_level = level;
+}
+
+/**
+ * Write the rows of a frame top row first, converted by \p pack, which
+ * packs one row of RGBA pixels into \p row and returns its size.
+ */
+static bool
+write_rows(FILE *f, const struct frame *frame,
+	   size_t (*pack)(GLubyte *row, const GLubyte *pixels, int width))
+{
+	GLubyte *row = malloc(4 * frame->width);
+	bool ok = true;
+	int y;
+
+	for (y = frame->height - 1; y >= 0 && ok; y--) {
+		size_t size = pack(row,
+				   frame->pixels + 4 * (size_t) frame->width * y,
+				   frame->width);
+		ok = fwrite(row, 1, size, f) == size;
+	}
+
+	free(row);
+	return ok;
+}
+
+static size_t
+pack_rgb(GLubyte *row, const GLubyte *pixels, int width)
+{
+	int x;
+
+	for (x = 0; x < width; x++) {
+		row[3 * x + 0] = pixels[4 * x + 0];
+		row[3 * x + 1] = pixels[4 * x + 1];
+		row[3 * x + 2] = pixels[4 * x + 2];
+	}
+	return 3 * width;
+}
+
+static size_t
+pack_rgba(GLubyte *row, const GLubyte *pixels, int width)
+{
+	memcpy(row, pixels, 4 * width);
+	return 4 * width;
+}
+
+static void
+write_frame(const struct frame *frame)
+{
+	FILE *f;
+	bool ok;
+
+	if (frame->format == PIGLIT_FRAME_PNG) {
+		piglit_write_png_level(frame->filename, GL_RGBA, frame->width,
+				       frame->height, frame->pixels, true,
+				       png_level);
+		return;
+	}
+
+	f = fopen(frame->filename, "wb");
+	if (f == NULL) {
+		fprintf(stderr, "Failed to open %s\n", frame->filename);
+		return;
+	}
+
+	if (frame->format == PIGLIT_FRAME_PPM) {
+		ok = fprintf(f, "P6\n%d %d\n255\n", frame->width,
+			     frame->height) > 0 &&
+		     write_rows(f, frame, pack_rgb);
+	} else {
+		ok = write_rows(f, frame, pack_rgba);
+	}
+
+	if (fclose(f) != 0 || !ok)
+		fprintf(stderr, "Failed to write %s\n", frame->filename);
+}
+
+static void
+process_frame(struct frame *frame)
+{
+	if (frame->renderer) {
+		piglit_golden_check_frame(frame->renderer, frame->pixels,
+					  frame->width, frame->height);
+	}
+	if (frame->filename)
+		write_frame(frame);
+
+	free(frame->pixels);
+	free(frame->filename);
+	free(frame->renderer);
+}
+
+#ifdef PIGLIT_HAS_PTHREADS
+static struct frame queue[PIGLIT_FRAME_QUEUE_SIZE];
+static unsigned queue_head = 0;
+static unsigned queue_count = 0;
+/** Whether the writer is processing a frame it took off the queue. */
+static bool writer_busy = false;
+static bool writer_started = false;
+static bool writer_failed = false;
+static pthread_t writer;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Signaled when a frame is queued. */
+static pthread_cond_t queue_filled = PTHREAD_COND_INITIALIZER;
+/** Signaled when the writer takes a frame, or is done with one. */
+static pthread_cond_t queue_drained = PTHREAD_COND_INITIALIZER;
+
+static void *
+writer_main(void *data)
+{
+	struct frame frame;
+
+	pthread_mutex_lock(&queue_lock);
+	for (;;) {
+		while (queue_count == 0)
+			pthread_cond_wait(&queue_filled, &queue_lock);
+
+		frame = queue[queue_head];
+		queue_head = (queue_head + 1) % PIGLIT_FRAME_QUEUE_SIZE;
+		queue_count--;
+		writer_busy = true;
+		pthread_cond_broadcast(&queue_drained);
+		pthread_mutex_unlock(&queue_lock);
+
+		process_frame(&frame);
+
+		pthread_mutex_lock(&queue_lock);
+		writer_busy = false;
+		pthread_cond_broadcast(&queue_drained);
+	}
+
+	return NULL;
+}
+#endif
+
+void
+piglit_frame_writer_queue(GLubyte *pixels, int width, int height,
+			  enum piglit_frame_format format, char *filename,
+			  char *renderer)
+{
+	struct frame frame = {
+		pixels, width, height, format, filename, renderer
+	};
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&queue_lock);
+
+	if (!writer_started && !writer_failed) {
+		if (pthread_create(&writer, NULL, writer_main, NULL) == 0) {
+			pthread_detach(writer);
+			writer_started = true;
+		} else {
+			writer_failed = true;
+		}
+	}
+
+	if (writer_started) {
+		while (queue_count == PIGLIT_FRAME_QUEUE_SIZE)
+			pthread_cond_wait(&queue_drained, &queue_lock);
+
+		queue[(queue_head + queue_count) % PIGLIT_FRAME_QUEUE_SIZE] =
+			frame;
+		queue_count++;
+		pthread_cond_signal(&queue_filled);
+		pthread_mutex_unlock(&queue_lock);
+		return;
+	}
+
+	pthread_mutex_unlock(&queue_lock);
+#endif
+
+	process_frame(&frame);
+}
+
+void
+piglit_frame_writer_flush(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&queue_lock);
+	while (queue_count > 0 || writer_busy)
+		pthread_cond_wait(&queue_drained, &queue_lock);
+	pthread_mutex_unlock(&queue_lock);
+#endif
+	fflush(stdout);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-frame-writer.h
+ *
+ * Background writer for the frames captured by piglit_present_results().
+ *
+ * Frames are queued with their pixels and written by a thread, so that
+ * encoding them doesn't hold up rendering.  The queue holds
+ * PIGLIT_FRAME_QUEUE_SIZE frames; queueing another one waits for the
+ * writer.  Without pthreads, frames are written as they are queued.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "piglit-util-gl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIGLIT_FRAME_QUEUE_SIZE 4
+
+enum piglit_frame_format {
+	/** PNG, with the level set by piglit_frame_writer_set_png_level() */
+	PIGLIT_FRAME_PNG,
+	/** Binary PPM (P6), RGB without alpha, not compressed */
+	PIGLIT_FRAME_PPM,
+	/** RGBA bytes, top row first, without any header */
+	PIGLIT_FRAME_RAW,
+};
+
+/**
+ * Set the zlib compression level of the PNG frames, from 0 to 9, or -1
+ * for the libpng default.  Call before the first frame is queued.
+ */
+void
+piglit_frame_writer_set_png_level(int level);
+
+/**
+ * Queue a frame, taking ownership of the malloc'ed \p pixels, \p filename
+ * and \p renderer.
+ *
+ * \param pixels    RGBA unsigned byte pixels, bottom row first, as read
+ *                  by glReadPixels
+ * \param filename  file to write the frame to in \p format, or NULL
+ * \param renderer  GL_RENDERER of the frame, to check it against its
+ *                  golden image (see piglit-golden.h), or NULL
+ */
+void
+piglit_frame_writer_queue(GLubyte *pixels, int width, int height,
+			  enum piglit_frame_format format, char *filename,
+			  char *renderer);
+
+/** Wait until all the queued frames are written. */
+void
+piglit_frame_writer_flush(void);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
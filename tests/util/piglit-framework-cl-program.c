@@ -39,8 +39,139 @@ const struct piglit_cl_program_test_config
 	.expect_build_fail = false,
 
 	.kernel_name = NULL,
+
+	.queue_properties = 0,
+};
+
+/*
+ * Contexts and programs kept from one test to the next when a process runs
+ * many of them, see piglit_cl_framework_run(). Creating a context and
+ * building a program can take longer than running the test, and the tests
+ * of a directory often build the same program. They are released when the
+ * process exits.
+ */
+struct program_cache_entry {
+	piglit_cl_context context;
+	char* build_options;
+	bool expect_build_fail;
+	bool binary;
+	size_t length;
+	char* data; /* source or binary */
+	cl_program program;
+};
+
+struct context_cache_entry {
+	piglit_cl_context context;
+	cl_command_queue_properties queue_properties;
 };
 
+static unsigned int num_cached_contexts = 0;
+static struct context_cache_entry* cached_contexts = NULL;
+
+static unsigned int num_cached_programs = 0;
+static struct program_cache_entry* cached_programs = NULL;
+
+static piglit_cl_context
+get_context(cl_platform_id platform_id,
+            const cl_device_id device_ids[],
+            unsigned int num_devices,
+            cl_command_queue_properties queue_properties,
+            bool cache)
+{
+	unsigned int i;
+	piglit_cl_context context;
+
+	if(!cache) {
+		return piglit_cl_create_context_with_queue_properties(platform_id,
+		                                                      device_ids,
+		                                                      num_devices,
+		                                                      queue_properties);
+	}
+
+	for(i = 0; i < num_cached_contexts; i++) {
+		context = cached_contexts[i].context;
+		if(   cached_contexts[i].queue_properties == queue_properties
+		   && context->platform_id == platform_id
+		   && context->num_devices == num_devices
+		   && !memcmp(context->device_ids, device_ids,
+		              num_devices * sizeof(cl_device_id))) {
+			return context;
+		}
+	}
+
+	context = piglit_cl_create_context_with_queue_properties(platform_id,
+	                                                         device_ids,
+	                                                         num_devices,
+	                                                         queue_properties);
+	if(context != NULL) {
+		cached_contexts = realloc(cached_contexts,
+		                          (num_cached_contexts + 1) *
+		                          sizeof(struct context_cache_entry));
+		cached_contexts[num_cached_contexts].context = context;
+		cached_contexts[num_cached_contexts].queue_properties =
+			queue_properties;
+		num_cached_contexts++;
+	}
+
+	return context;
+}
+
+/* Return a new reference to a cached program, or NULL */
+static cl_program
+get_cached_program(piglit_cl_context context,
+                   const char* build_options,
+                   bool expect_build_fail,
+                   bool binary,
+                   const void* data,
+                   size_t length)
+{
+	unsigned int i;
+
+	for(i = 0; i < num_cached_programs; i++) {
+		struct program_cache_entry* entry = &cached_programs[i];
+
+		if(   entry->context == context
+		   && entry->expect_build_fail == expect_build_fail
+		   && entry->binary == binary
+		   && entry->length == length
+		   && !strcmp(entry->build_options, build_options)
+		   && !memcmp(entry->data, data, length)) {
+			printf("#   Using program built by an earlier test\n");
+			clRetainProgram(entry->program);
+			return entry->program;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+cache_program(piglit_cl_context context,
+              const char* build_options,
+              bool expect_build_fail,
+              bool binary,
+              const void* data,
+              size_t length,
+              cl_program program)
+{
+	struct program_cache_entry* entry;
+
+	cached_programs = realloc(cached_programs,
+	                          (num_cached_programs + 1) *
+	                          sizeof(struct program_cache_entry));
+	entry = &cached_programs[num_cached_programs++];
+
+	entry->context = context;
+	entry->build_options = strdup(build_options);
+	entry->expect_build_fail = expect_build_fail;
+	entry->binary = binary;
+	entry->length = length;
+	entry->data = malloc(length);
+	memcpy(entry->data, data, length);
+	entry->program = program;
+	clRetainProgram(program);
+}
+
 /* Return default values for test configuration */
 const void*
 piglit_cl_get_empty_program_test_config()
@@ -149,6 +280,10 @@ piglit_cl_program_test_run(const int argc,
 	char* build_options = malloc(1 * sizeof(char));
 	unsigned int num_devices;
 	cl_device_id* device_ids;
+	char* program_data = NULL;
+	size_t program_length = 0;
+	bool program_binary = false;
+	bool free_program_data = false;
 
 	build_options[0] = '\0';
 
@@ -198,12 +333,15 @@ piglit_cl_program_test_run(const int argc,
 	printf("#   OpenCL C version: %d.%d\n",
 	       env.clc_version/10, env.clc_version%10);
 
-	/* Create context */
+	/* Create context, or reuse one from an earlier test */
 	if(config->run_per_platform) {
-		env.context = piglit_cl_create_context(platform_id, device_ids,
-		                                       num_devices);
+		env.context = get_context(platform_id, device_ids, num_devices,
+		                          config->queue_properties,
+		                          config->_subtest);
 	} else { // config->run_per_device
-		env.context = piglit_cl_create_context(platform_id, &device_id, 1);
+		env.context = get_context(platform_id, &device_id, 1,
+		                          config->queue_properties,
+		                          config->_subtest);
 	}
 
 	if(env.context == NULL) {
@@ -234,70 +372,70 @@ piglit_cl_program_test_run(const int argc,
 
 	printf("#   Build options: %s\n", build_options);
 
-	/* Create and build program */
+	/* Get program source or binary */
 	if(config->program_source != NULL) {
-		if(!config->expect_build_fail) {
-			env.program = piglit_cl_build_program_with_source(env.context,
-			                                                  1,
-			                                                  &config->program_source,
-			                                                  build_options);
-		} else {
-			env.program = piglit_cl_fail_build_program_with_source(env.context,
-			                                                       1,
-			                                                       &config->program_source,
-			                                                       build_options);
-		}
+		program_data = config->program_source;
+		program_length = strlen(program_data);
 	} else if(config->program_source_file != NULL) {
 		unsigned int size;
-		char* program_source;
 
-		program_source = piglit_load_text_file(config->program_source_file, &size);
-		if(program_source != NULL && size > 0) {
+		program_data = piglit_load_text_file(config->program_source_file, &size);
+		if(program_data == NULL || size == 0) {
+			fprintf(stderr, "Program source file %s does not exists or is empty\n",
+			        config->program_source_file);
+			return PIGLIT_WARN;
+		}
+		program_length = size;
+		free_program_data = true;
+	} else if(config->program_binary != NULL) {
+		program_data = (char*)config->program_binary;
+		program_length = strlen(program_data);
+		program_binary = true;
+	} else if(config->program_binary_file != NULL) {
+		unsigned int size;
+
+		program_data = piglit_load_text_file(config->program_binary_file, &size);
+		if(program_data == NULL || size == 0) {
+			fprintf(stderr, "Program binary file %s does not exists or is empty\n",
+			        config->program_binary_file);
+			return PIGLIT_WARN;
+		}
+		program_length = size;
+		free_program_data = true;
+		program_binary = true;
+	}
+
+	/* Create and build program, or reuse one from an earlier test */
+	if(config->_subtest) {
+		env.program = get_cached_program(env.context,
+		                                 build_options,
+		                                 config->expect_build_fail,
+		                                 program_binary,
+		                                 program_data,
+		                                 program_length);
+	}
+	if(env.program == NULL) {
+		if(!program_binary) {
 			if(!config->expect_build_fail) {
 				env.program = piglit_cl_build_program_with_source(env.context,
 				                                                  1,
-				                                                  &program_source,
+				                                                  &program_data,
 				                                                  build_options);
 			} else {
 				env.program = piglit_cl_fail_build_program_with_source(env.context,
 				                                                       1,
-				                                                       &program_source,
+				                                                       &program_data,
 				                                                       build_options);
 			}
 		} else {
-			fprintf(stderr, "Program source file %s does not exists or is empty\n",
-			        config->program_source_file);
-			return PIGLIT_WARN;
-		}
-		free(program_source);
-	} else if(config->program_binary != NULL) {
-		size_t length = strlen((char*)config->program_binary);
+			size_t* lengths = malloc(sizeof(size_t) * env.context->num_devices);
+			unsigned char** program_binaries = malloc(sizeof(unsigned char*) * env.context->num_devices);
 
-		if(!config->expect_build_fail) {
-			env.program = piglit_cl_build_program_with_binary(env.context,
-			                                                  &length,
-			                                                  &config->program_binary,
-			                                                  build_options);
-		} else {
-			env.program = piglit_cl_fail_build_program_with_binary(env.context,
-			                                                       &length,
-			                                                       &config->program_binary,
-			                                                       build_options);
-		}
-	} else if(config->program_binary_file != NULL) {
-		unsigned int length;
-		size_t* lengths = malloc(sizeof(size_t) * env.context->num_devices);
-		unsigned char** program_binaries = malloc(sizeof(unsigned char*) * env.context->num_devices);
-
-		((char**)program_binaries)[0] =
-			piglit_load_text_file(config->program_binary_file, &length);
-		lengths[0] = length;
-		for(i = 1; i < env.context->num_devices; i++) {
-			lengths[i] = lengths[0];
-			program_binaries[i] = program_binaries[0];
-		}
+			for(i = 0; i < env.context->num_devices; i++) {
+				lengths[i] = program_length;
+				program_binaries[i] = (unsigned char*)program_data;
+			}
 
-		if(((char**)program_binaries)[0] != NULL && length > 0) {
 			if(!config->expect_build_fail) {
 				env.program = piglit_cl_build_program_with_binary(env.context,
 				                                                  lengths,
@@ -309,17 +447,25 @@ piglit_cl_program_test_run(const int argc,
 				                                                       program_binaries,
 				                                                       build_options);
 			}
-		} else {
-			fprintf(stderr, "Program binary file %s does not exists or is empty\n",
-			        config->program_source_file);
-			return PIGLIT_WARN;
+
+			free(program_binaries);
+			free(lengths);
 		}
 
-		free(program_binaries[0]);
-		free(program_binaries);
-		free(lengths);
+		if(config->_subtest && env.program != NULL) {
+			cache_program(env.context,
+			              build_options,
+			              config->expect_build_fail,
+			              program_binary,
+			              program_data,
+			              program_length,
+			              env.program);
+		}
 	}
 
+	if(free_program_data) {
+		free(program_data);
+	}
 	free(build_options);
 
 	if(env.program == NULL) {
@@ -353,8 +499,10 @@ piglit_cl_program_test_run(const int argc,
 	/* Release program */
 	clReleaseProgram(env.program);
 
-	/* Release context */
-	piglit_cl_release_context(env.context);
+	/* Release context, unless it is kept for the next test */
+	if(!config->_subtest) {
+		piglit_cl_release_context(env.context);
+	}
 
 	return result;
 }
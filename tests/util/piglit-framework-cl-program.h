@@ -88,6 +88,10 @@ PIGLIT_CL_DEFINE_TEST_CONFIG_BEGIN(struct piglit_cl_program_test_config)
 	                        Conflicts with both \c expect_build_fail==TRUE and
 	                        \c build_only==TRUE. (optional) */
 
+	cl_command_queue_properties queue_properties; /**< Properties of the
+	                                                   command queues of the
+	                                                   context. (optional) */
+
 PIGLIT_CL_DEFINE_TEST_CONFIG_END
 
 piglit_cl_get_empty_test_config_t piglit_cl_get_empty_program_test_config;
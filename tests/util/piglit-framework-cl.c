@@ -31,6 +31,7 @@
 const struct piglit_cl_test_config_header
              PIGLIT_CL_DEFAULT_TEST_CONFIG_HEADER = {
 	._filename = "",
+	._subtest = false,
 	.name = NULL,
 
 	.run_per_platform = false,
@@ -132,8 +133,9 @@ bool check_device_extensions(cl_device_id device_id, char* extensions)
 	return true;
 }
 
-/* Run the test(s) */
-int piglit_cl_framework_run(int argc, char** argv)
+/* Run the test(s) of one test configuration */
+static enum piglit_result
+run_test(int argc, char** argv, bool subtest)
 {
 	enum piglit_result result = PIGLIT_SKIP;
 
@@ -146,6 +148,7 @@ int piglit_cl_framework_run(int argc, char** argv)
 		piglit_cl_get_test_config(argc,
 		                          (const char**)argv,
 		                          &PIGLIT_CL_DEFAULT_TEST_CONFIG_HEADER);
+	config->_subtest = subtest;
 
 	/* Check that config is valid */
 	// run_per_platform, run_per_device
@@ -369,6 +372,82 @@ int piglit_cl_framework_run(int argc, char** argv)
 		config->clean_func(argc, (const char**)argv, config);
 	}
 
+	return result;
+}
+
+/*
+ * Run each unnamed argument as a test of its own, with all of the named
+ * arguments, and report it as a subtest named after its file.
+ */
+static NORETURN void
+run_subtests(int argc, char** argv)
+{
+	int i;
+	int num = 0;
+	int test_argc = 1;
+	char** test_argv = malloc((argc + 2) * sizeof(char*));
+
+	/* Named arguments, the test's file is added after them */
+	test_argv[0] = argv[0];
+	for(i = 1; i < argc; i++) {
+		if(!strncmp(argv[i], "-", 1)) {
+			test_argv[test_argc++] = argv[i];
+			if(i + 1 < argc) {
+				test_argv[test_argc++] = argv[++i];
+			}
+		}
+	}
+	test_argv[test_argc + 1] = NULL;
+
+	for(i = 1; i < argc; i++) {
+		enum piglit_result result;
+		char* name;
+		char* ext;
+
+		if(!strncmp(argv[i], "-", 1)) {
+			i++;
+			continue;
+		}
+
+		/* Strip the path and the extension of the file */
+		name = strrchr(argv[i], PIGLIT_PATH_SEP);
+		name = strdup(name != NULL ? name + 1 : argv[i]);
+		ext = strrchr(name, '.');
+		if(ext != NULL && ext != name) {
+			*ext = '\0';
+		}
+
+		/* Print the name before running the test, so that the run can
+		 * be resumed after the test if it crashes.
+		 */
+		printf("PIGLIT TEST: %i - %s\n", num, name);
+		fprintf(stderr, "PIGLIT TEST: %i - %s\n", num, name);
+		num++;
+
+		test_argv[test_argc] = argv[i];
+		result = run_test(test_argc + 1, test_argv, true);
+
+		printf("# Result:\n");
+		piglit_report_subtest_result(result, "%s", name);
+
+		free(name);
+	}
+
+	free(test_argv);
+	exit(0);
+}
+
+/* Run the test(s) */
+int piglit_cl_framework_run(int argc, char** argv)
+{
+	enum piglit_result result;
+
+	if(piglit_strip_arg(&argc, argv, "-report-subtests")) {
+		run_subtests(argc, argv);
+	}
+
+	result = run_test(argc, argv, false);
+
 	/* Report merged result */
 	printf("# Result:\n");
 	piglit_report_result(result);
@@ -97,6 +97,10 @@ typedef void piglit_cl_test_clean_t(const int argc,
         char* _filename; /**< Read-only test filename. (internal) */         \
         piglit_cl_test_run_t* _test_run;                                     \
           /**< Function pointer to run the test. (internal) */               \
+        bool _subtest;                                                       \
+          /**< Test is one of many run by this process and is reported
+               as a subtest, see \c piglit_cl_framework_run().
+               (internal) */                                                 \
                                                                              \
         char* name; /**< Name of test. (optional) */                         \
                                                                              \
@@ -253,6 +257,12 @@ piglit_cl_get_test_config(const int argc,
  * in its configuration. The only thing that \c main does
  * is to call this function.
  *
+ * With the \c -report-subtests argument each unnamed argument is run as a
+ * test of its own, with the named arguments, and reported as a subtest named
+ * after its file. The process exits with status 0 after the last one. Tests
+ * can keep state, like OpenCL contexts, from one of these to the next when
+ * \c config->_subtest is \c true.
+ *
  * @param argc  Argument count passed to \c main().
  * @param argv  Argument vector passed to \c main().
  */
@@ -28,7 +28,13 @@
 #include <stdlib.h>
 #include <math.h>
 
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "piglit-util-gl.h"
+#include "piglit-frame-writer.h"
+#include "piglit-golden.h"
 #include "piglit-framework-gl/piglit_gl_framework.h"
 
 struct piglit_gl_framework *gl_fw;
@@ -43,6 +49,8 @@ unsigned piglit_winsys_fbo = 0;
 int piglit_width;
 int piglit_height;
 
+static enum piglit_frame_format frame_format = PIGLIT_FRAME_PNG;
+
 static void
 process_args(int *argc, char *argv[], unsigned *force_samples,
 	     struct piglit_gl_test_config *config);
@@ -108,6 +116,8 @@ process_args(int *argc, char *argv[], unsigned *force_samples,
 
 	piglit_binary_name = argv[0];
 
+	piglit_golden_init(*argc, argv);
+
 	piglit_parse_subtest_args(argc, argv, config->subtests,
 				  &config->selected_subtests,
 				  &config->num_selected_subtests);
@@ -127,6 +137,33 @@ process_args(int *argc, char *argv[], unsigned *force_samples,
 			piglit_dump_png = true;
 			delete_arg(argv, *argc, j--);
 			*argc -= 1;
+		} else if (!strncmp(argv[j], "-png-level=", 11)) {
+			char *end;
+			long level = strtol(argv[j] + 11, &end, 10);
+
+			if (end == argv[j] + 11 || *end || level < 0 ||
+			    level > 9) {
+				fprintf(stderr,
+					"-png-level requires a value from "
+					"0 to 9\n");
+				piglit_report_result(PIGLIT_FAIL);
+			}
+
+			piglit_dump_png = true;
+			frame_format = PIGLIT_FRAME_PNG;
+			piglit_frame_writer_set_png_level(level);
+			delete_arg(argv, *argc, j--);
+			*argc -= 1;
+		} else if (!strcmp(argv[j], "-ppm")) {
+			piglit_dump_png = true;
+			frame_format = PIGLIT_FRAME_PPM;
+			delete_arg(argv, *argc, j--);
+			*argc -= 1;
+		} else if (!strcmp(argv[j], "-raw")) {
+			piglit_dump_png = true;
+			frame_format = PIGLIT_FRAME_RAW;
+			delete_arg(argv, *argc, j--);
+			*argc -= 1;
 		} else if (!strcmp(argv[j], "-rlimit")) {
 			char *ptr;
 			unsigned long lim;
@@ -245,37 +282,136 @@ piglit_swap_buffers(void)
 		gl_fw->swap_buffers(gl_fw);
 }
 
+/**
+ * The frame captured by the last piglit_present_results(), whose readback
+ * may still be in flight.  It is handed to the frame writer by the next
+ * piglit_present_results() or by piglit_present_finish(), so that the
+ * readback overlaps the rendering of the next frame.
+ */
+static struct {
+	struct piglit_readback *readback;
+	int width, height;
+	size_t stride;
+	char *filename;
+	char *renderer;
+#ifdef PIGLIT_HAS_PTHREADS
+	/** The thread with the context that read the frame */
+	pthread_t thread;
+#endif
+} pending_frame;
+
+static void
+queue_pending_frame(void)
+{
+	struct piglit_readback *readback = pending_frame.readback;
+	const GLubyte *src;
+	GLubyte *pixels;
+	int y;
+
+	if (readback == NULL)
+		return;
+#ifdef PIGLIT_HAS_PTHREADS
+	/* E.g. a timeout reporting the result */
+	if (!pthread_equal(pending_frame.thread, pthread_self()))
+		return;
+#endif
+	pending_frame.readback = NULL;
+
+	src = piglit_readback_map(readback);
+	pixels = malloc(4 * pending_frame.width * pending_frame.height);
+	for (y = 0; y < pending_frame.height; y++) {
+		memcpy(pixels + 4 * pending_frame.width * y,
+		       src + pending_frame.stride * y,
+		       4 * pending_frame.width);
+	}
+	piglit_readback_end(readback);
+
+	piglit_frame_writer_queue(pixels, pending_frame.width,
+				  pending_frame.height, frame_format,
+				  pending_frame.filename,
+				  pending_frame.renderer);
+}
+
 void
-piglit_present_results(void)
+piglit_present_finish(void)
 {
-	if (piglit_dump_png) {
-		static char *fileprefix = NULL;
-		static int frame = 0;
-		char *filename;
-		GLenum base_format = GL_RGBA;
-		GLubyte *image;
-		if (fileprefix == NULL) {
-			int i;
-			fileprefix = strdup(piglit_binary_name);
-			fileprefix = basename(fileprefix);
-			/* Strip potentially bad characters */
-			for (i = 0; fileprefix[i]; i++) {
-				if (!isalnum(fileprefix[i]) && fileprefix[i] != '-')
-					fileprefix[i] = '_';
-			}
+	queue_pending_frame();
+	piglit_frame_writer_flush();
+}
+
+static void
+capture_frame(void)
+{
+	static char *fileprefix = NULL;
+	static int frame = 0;
+	GLint alignment = 4;
+
+	if (fileprefix == NULL) {
+		int i;
+		fileprefix = strdup(piglit_binary_name);
+		fileprefix = basename(fileprefix);
+		/* Strip potentially bad characters */
+		for (i = 0; fileprefix[i]; i++) {
+			if (!isalnum(fileprefix[i]) && fileprefix[i] != '-')
+				fileprefix[i] = '_';
 		}
-		image = malloc(4 * piglit_width * piglit_height);
-		glReadPixels(0, 0, piglit_width, piglit_height,
-			     base_format, GL_UNSIGNED_BYTE, image);
-		assert(glGetError() == GL_NO_ERROR);
-
-		(void)!asprintf(&filename, "%s%03d.png", fileprefix, frame++);
-
-		printf("Writing %s...\n", filename);
-		piglit_write_png(filename, base_format, piglit_width,
-				 piglit_height, image, true);
-		free(filename);
-		free(image);
+
+		/* The pending readback needs the GL context, which may be
+		 * gone by the time atexit handlers run, so only the report
+		 * hook hands it over.  At exit, only write out what is queued.
+		 */
+		piglit_set_report_result_hook(piglit_present_finish);
+		atexit(piglit_frame_writer_flush);
+	}
+
+	pending_frame.filename = NULL;
+	if (!piglit_dump_png) {
+		/* Golden image check only */
+	} else if (frame_format == PIGLIT_FRAME_PNG) {
+		(void)!asprintf(&pending_frame.filename, "%s%03d.png",
+				fileprefix, frame++);
+	} else if (frame_format == PIGLIT_FRAME_PPM) {
+		(void)!asprintf(&pending_frame.filename, "%s%03d.ppm",
+				fileprefix, frame++);
+	} else {
+		(void)!asprintf(&pending_frame.filename, "%s%03d-%dx%d.rgba",
+				fileprefix, frame++, piglit_width,
+				piglit_height);
+	}
+	if (pending_frame.filename)
+		printf("Writing %s...\n", pending_frame.filename);
+
+	pending_frame.renderer = NULL;
+	if (piglit_golden_enabled()) {
+		const GLubyte *renderer = glGetString(GL_RENDERER);
+
+		pending_frame.renderer =
+			strdup(renderer ? (const char *) renderer : "");
+	}
+
+	glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+	pending_frame.width = piglit_width;
+	pending_frame.height = piglit_height;
+	pending_frame.stride = ALIGN(4 * piglit_width, alignment);
+#ifdef PIGLIT_HAS_PTHREADS
+	pending_frame.thread = pthread_self();
+#endif
+	pending_frame.readback =
+		piglit_readback_begin_async(0, 0, piglit_width, piglit_height,
+					    GL_RGBA, GL_UNSIGNED_BYTE);
+	assert(glGetError() == GL_NO_ERROR);
+
+	/* The pixels are there already */
+	if (!piglit_readback_can_async())
+		queue_pending_frame();
+}
+
+void
+piglit_present_results(void)
+{
+	if (piglit_dump_png || piglit_golden_enabled()) {
+		queue_pending_frame();
+		capture_frame();
 	}
 
 	if (!piglit_automatic)
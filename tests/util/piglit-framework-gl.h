@@ -304,6 +304,14 @@ extern struct piglit_gl_framework *gl_fw;
 
 void piglit_swap_buffers(void);
 void piglit_present_results();
+
+/**
+ * Write out the frames captured by piglit_present_results() that are still
+ * in flight.  piglit_report_result() calls it.  Tests that report several
+ * results from one process call it before each, and before
+ * piglit_readback_release() frees the buffers of the readbacks.
+ */
+void piglit_present_finish(void);
 void piglit_post_redisplay(void);
 void piglit_set_keyboard_func(void (*func)(unsigned char key, int x, int y));
 void piglit_set_reshape_func(void (*func)(int w, int h));
@@ -0,0 +1,526 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-golden.c
+ *
+ * Golden image checks, see piglit-golden.h.
+ *
+ * Each frame has one entry in PIGLIT_GOLDEN_DIR, named
+ * <test>-<key>-<frame>, where <test> is the name of the test binary and
+ * <key> a hash of the command line, or of the name given to
+ * piglit_golden_begin_test(), and GL_RENDERER:
+ *
+ * - <entry>.golden holds the hash and size of the frame, then the key in
+ *   clear for whoever reads the directory.
+ * - <entry>.png is the reference image, recorded with the hash when
+ *   piglit is built with libpng.
+ * - <entry>.actual.png and <entry>.diff.png are the last frame that
+ *   didn't match and its difference to the reference image.
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piglit-golden.h"
+
+/**
+ * The CIE76 color difference above which a change is considered
+ * perceptible.
+ */
+#define GOLDEN_JND 2.3
+
+static bool golden_initialized = false;
+static char *golden_dir = NULL;
+static bool golden_update = false;
+static char *golden_test = NULL;
+static char *golden_args = NULL;
+static int golden_frame = 0;
+
+/**
+ * 64-bit hash of \p size bytes, 8 at a time (MurmurHash64A).
+ */
+static uint64_t
+golden_hash(const void *data, size_t size, uint64_t seed)
+{
+	const uint64_t m = UINT64_C(0xc6a4a7935bd1e995);
+	const unsigned char *p = data;
+	uint64_t h = seed ^ (size * m);
+	size_t i, tail;
+
+	for (i = 0; i + 8 <= size; i += 8) {
+		uint64_t k;
+
+		memcpy(&k, p + i, sizeof(k));
+		k *= m;
+		k ^= k >> 47;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	tail = size - i;
+	if (tail) {
+		while (tail--)
+			h ^= (uint64_t) p[i + tail] << (8 * tail);
+		h *= m;
+	}
+
+	h ^= h >> 47;
+	h *= m;
+	h ^= h >> 47;
+	return h;
+}
+
+void
+piglit_golden_init(int argc, char *argv[])
+{
+	const char *dir = getenv("PIGLIT_GOLDEN_DIR");
+	const char *update = getenv("PIGLIT_GOLDEN_UPDATE");
+	size_t size = 1;
+	char *name;
+	int i;
+
+	/* shader_runner runs main() again when it recreates its context,
+	 * the files it runs next call piglit_golden_begin_test().
+	 */
+	if (golden_initialized)
+		return;
+	golden_initialized = true;
+
+	if (dir == NULL || dir[0] == '\0')
+		return;
+
+#ifdef _WIN32
+	golden_dir = _fullpath(NULL, dir, 0);
+#else
+	golden_dir = realpath(dir, NULL);
+#endif
+	if (golden_dir == NULL) {
+		fprintf(stderr, "PIGLIT_GOLDEN_DIR %s doesn't exist, "
+			"golden images disabled\n", dir);
+		return;
+	}
+
+	golden_update = update != NULL && strcmp(update, "0") != 0;
+
+	/* Name the entries after the binary, as the -png dumps are */
+	name = strrchr(argv[0], PIGLIT_PATH_SEP);
+	golden_test = strdup(name ? name + 1 : argv[0]);
+	for (i = 0; golden_test[i]; i++) {
+		if (!isalnum((unsigned char) golden_test[i]) &&
+		    golden_test[i] != '-')
+			golden_test[i] = '_';
+	}
+
+	/* The options that don't change the rendering aren't part of the
+	 * key, so that the entries recorded by one mode match the others.
+	 */
+	for (i = 1; i < argc; i++)
+		size += strlen(argv[i]) + 1;
+	golden_args = calloc(size, 1);
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-auto") || !strcmp(argv[i], "-png") ||
+		    !strncmp(argv[i], "-png-level=", 11) ||
+		    !strcmp(argv[i], "-ppm") || !strcmp(argv[i], "-raw"))
+			continue;
+		if (golden_args[0])
+			strcat(golden_args, " ");
+		strcat(golden_args, argv[i]);
+	}
+}
+
+static bool
+is_path_sep(char c)
+{
+	return c == '/' || c == PIGLIT_PATH_SEP;
+}
+
+/**
+ * The part of \p path from its last tests or generated_tests directory on,
+ * so that the entries don't depend on where piglit is checked out or
+ * installed.  Other paths are returned unchanged.
+ */
+static const char *
+tests_relative_path(const char *path)
+{
+	static const char *const dirs[] = { "tests", "generated_tests" };
+	const char *rel = path;
+	const char *p;
+	unsigned i;
+
+	for (p = path; *p; p++) {
+		if (p != path && !is_path_sep(p[-1]))
+			continue;
+
+		for (i = 0; i < ARRAY_SIZE(dirs); i++) {
+			size_t len = strlen(dirs[i]);
+
+			if (!strncmp(p, dirs[i], len) && is_path_sep(p[len]))
+				rel = p;
+		}
+	}
+	return rel;
+}
+
+void
+piglit_golden_begin_test(const char *name)
+{
+	char *p;
+
+	if (golden_dir == NULL)
+		return;
+
+	free(golden_args);
+	golden_args = strdup(tests_relative_path(name));
+	for (p = golden_args; *p; p++) {
+		if (is_path_sep(*p))
+			*p = '/';
+	}
+	golden_frame = 0;
+}
+
+bool
+piglit_golden_enabled(void)
+{
+	return golden_dir != NULL;
+}
+
+static void
+lock_stdout(void)
+{
+#if defined(PIGLIT_HAS_PTHREADS) && !defined(_WIN32)
+	flockfile(stdout);
+#endif
+}
+
+static void
+unlock_stdout(void)
+{
+#if defined(PIGLIT_HAS_PTHREADS) && !defined(_WIN32)
+	funlockfile(stdout);
+#endif
+}
+
+static bool
+read_golden(const char *path, uint64_t *hash, int *width, int *height)
+{
+	FILE *f = fopen(path, "r");
+	bool ok;
+
+	if (f == NULL)
+		return false;
+	ok = fscanf(f, "%" SCNx64 " %dx%d", hash, width, height) == 3;
+	fclose(f);
+	return ok;
+}
+
+static bool
+write_golden(const char *path, uint64_t hash, int width, int height,
+	     const char *key)
+{
+	char *tmp_path;
+	FILE *f;
+	bool ok;
+
+	/* Write to a private file first so that concurrent runs never see
+	 * a partially written entry.
+	 */
+	(void)!asprintf(&tmp_path, "%s.%" PRIx64 ".tmp", path,
+			(uint64_t) piglit_time_get_nano());
+	f = fopen(tmp_path, "w");
+	if (f == NULL) {
+		free(tmp_path);
+		return false;
+	}
+
+	fprintf(f, "%016" PRIx64 " %dx%d\n%s\n", hash, width, height, key);
+	ok = fclose(f) == 0;
+	if (!ok || rename(tmp_path, path) != 0) {
+		remove(tmp_path);
+		ok = false;
+	}
+	free(tmp_path);
+	return ok;
+}
+
+/** CIE L*a*b* of an sRGB color, D65 white point. */
+static void
+srgb_to_lab(const GLubyte *rgb, double lab[3])
+{
+	static double linear[256];
+	static bool linear_ready = false;
+	double r, g, b, xyz[3];
+	int i;
+
+	if (!linear_ready) {
+		for (i = 0; i < 256; i++)
+			linear[i] = piglit_srgb_to_linear(i / 255.0);
+		linear_ready = true;
+	}
+
+	r = linear[rgb[0]];
+	g = linear[rgb[1]];
+	b = linear[rgb[2]];
+	xyz[0] = (0.4124 * r + 0.3576 * g + 0.1805 * b) / 0.95047;
+	xyz[1] = 0.2126 * r + 0.7152 * g + 0.0722 * b;
+	xyz[2] = (0.0193 * r + 0.1192 * g + 0.9505 * b) / 1.08883;
+
+	for (i = 0; i < 3; i++) {
+		if (xyz[i] > 216.0 / 24389.0)
+			xyz[i] = cbrt(xyz[i]);
+		else
+			xyz[i] = (24389.0 / 27.0 * xyz[i] + 16.0) / 116.0;
+	}
+
+	lab[0] = 116.0 * xyz[1] - 16.0;
+	lab[1] = 500.0 * (xyz[0] - xyz[1]);
+	lab[2] = 200.0 * (xyz[1] - xyz[2]);
+}
+
+struct golden_diff {
+	unsigned pixels;
+	unsigned perceptible;
+	int max_error;
+	double rms_error;
+	double delta_e_max;
+	double delta_e_mean;
+};
+
+/**
+ * Compare two RGBA images of \p n pixels, and fill \p diff_image with
+ * the reference image dimmed to gray and the differing pixels in red,
+ * brighter for larger color differences.
+ */
+static void
+diff_images(const GLubyte *image, const GLubyte *ref, int n,
+	    GLubyte *diff_image, struct golden_diff *diff)
+{
+	double sum_squared_error = 0.0, sum_delta_e = 0.0;
+	int i, c;
+
+	memset(diff, 0, sizeof(*diff));
+
+	for (i = 0; i < n; i++) {
+		const GLubyte *p = image + 4 * i, *q = ref + 4 * i;
+		GLubyte *d = diff_image + 4 * i;
+		double lab_p[3], lab_q[3], delta_e;
+		int max_error = 0;
+
+		for (c = 0; c < 4; c++) {
+			int error = abs(p[c] - q[c]);
+
+			max_error = MAX2(max_error, error);
+			sum_squared_error += error * error;
+		}
+
+		d[3] = 255;
+		if (max_error == 0) {
+			d[0] = d[1] = d[2] =
+				(q[0] * 77 + q[1] * 150 + q[2] * 29) >> 10;
+			continue;
+		}
+
+		srgb_to_lab(p, lab_p);
+		srgb_to_lab(q, lab_q);
+		delta_e = sqrt((lab_p[0] - lab_q[0]) * (lab_p[0] - lab_q[0]) +
+			       (lab_p[1] - lab_q[1]) * (lab_p[1] - lab_q[1]) +
+			       (lab_p[2] - lab_q[2]) * (lab_p[2] - lab_q[2]));
+
+		diff->pixels++;
+		if (delta_e > GOLDEN_JND)
+			diff->perceptible++;
+		diff->max_error = MAX2(diff->max_error, max_error);
+		diff->delta_e_max = MAX2(diff->delta_e_max, delta_e);
+		sum_delta_e += delta_e;
+
+		d[0] = MIN2(255, 128 + (int) (8.0 * delta_e));
+		d[1] = d[2] = 0;
+	}
+
+	diff->rms_error = sqrt(sum_squared_error / (4.0 * n));
+	diff->delta_e_mean = sum_delta_e / n;
+}
+
+static void
+report_mismatch(const char *status, uint64_t expected, uint64_t actual,
+		const char *ref_path, const char *render_path,
+		const char *diff_path, const struct golden_diff *diff)
+{
+	/* The frame writer thread prints this while the test runs */
+	lock_stdout();
+	printf("PIGLIT: {\"image\": {\"image_desc\": \"frame %d\", "
+	       "\"status\": \"%s\", \"frame\": %d",
+	       golden_frame, status, golden_frame);
+	if (strcmp(status, "missing") != 0)
+		printf(", \"expected\": \"%016" PRIx64 "\"", expected);
+	printf(", \"actual\": \"%016" PRIx64 "\"", actual);
+
+	if (ref_path) {
+		printf(", \"image_ref\": ");
+		piglit_print_json_string(ref_path);
+	}
+	if (render_path) {
+		printf(", \"image_render\": ");
+		piglit_print_json_string(render_path);
+	}
+	if (diff_path) {
+		printf(", \"image_diff\": ");
+		piglit_print_json_string(diff_path);
+	}
+
+	if (diff) {
+		printf(", \"pixels\": %u, \"perceptible\": %u, "
+		       "\"max_error\": %d, \"rms_error\": %f, "
+		       "\"delta_e_max\": %f, \"delta_e_mean\": %f",
+		       diff->pixels, diff->perceptible, diff->max_error,
+		       diff->rms_error, diff->delta_e_max, diff->delta_e_mean);
+	}
+
+	printf("}}\n");
+	fflush(stdout);
+	unlock_stdout();
+}
+
+static void
+record_frame(const char *entry, const char *golden_path, const char *key,
+	     const GLubyte *image, int width, int height, uint64_t hash)
+{
+	char *path;
+
+	printf("Recording golden image %s\n", golden_path);
+	if (!write_golden(golden_path, hash, width, height, key)) {
+		fprintf(stderr, "Failed to write %s\n", golden_path);
+		return;
+	}
+
+#ifdef PIGLIT_HAS_PNG
+	(void)!asprintf(&path, "%s.png", entry);
+	piglit_write_png(path, GL_RGBA, width, height,
+			 (GLubyte *) image, true);
+	free(path);
+#endif
+
+	/* A stale mismatch would look like it is about this entry */
+	(void)!asprintf(&path, "%s.actual.png", entry);
+	remove(path);
+	free(path);
+	(void)!asprintf(&path, "%s.diff.png", entry);
+	remove(path);
+	free(path);
+}
+
+static void
+check_frame(const char *entry, const char *golden_path,
+	    const GLubyte *image, int width, int height, uint64_t hash)
+{
+	char *ref_path = NULL, *render_path = NULL, *diff_path = NULL;
+	struct golden_diff diff;
+	bool have_diff = false;
+	uint64_t expected;
+	int expected_width, expected_height;
+
+	if (!read_golden(golden_path, &expected, &expected_width,
+			 &expected_height)) {
+		report_mismatch("missing", 0, hash, NULL, NULL, NULL, NULL);
+		return;
+	}
+
+	if (expected == hash && expected_width == width &&
+	    expected_height == height)
+		return;
+
+	printf("Frame %d doesn't match golden image %s\n",
+	       golden_frame, golden_path);
+
+#ifdef PIGLIT_HAS_PNG
+	{
+		GLubyte *ref, *diff_image;
+		int ref_width, ref_height;
+
+		(void)!asprintf(&render_path, "%s.actual.png", entry);
+		piglit_write_png(render_path, GL_RGBA, width, height,
+				 (GLubyte *) image, true);
+
+		(void)!asprintf(&ref_path, "%s.png", entry);
+		ref = piglit_read_png(ref_path, &ref_width, &ref_height, true);
+		if (ref == NULL) {
+			free(ref_path);
+			ref_path = NULL;
+		} else if (ref_width == width && ref_height == height) {
+			diff_image = malloc(4 * width * height);
+			diff_images(image, ref, width * height, diff_image,
+				    &diff);
+			have_diff = true;
+
+			(void)!asprintf(&diff_path, "%s.diff.png", entry);
+			piglit_write_png(diff_path, GL_RGBA, width, height,
+					 diff_image, true);
+			free(diff_image);
+		}
+		free(ref);
+	}
+#endif
+
+	report_mismatch("mismatch", expected, hash, ref_path, render_path,
+			diff_path, have_diff ? &diff : NULL);
+	free(ref_path);
+	free(render_path);
+	free(diff_path);
+}
+
+void
+piglit_golden_check_frame(const char *renderer, const GLubyte *image,
+			  int width, int height)
+{
+	char *key, *entry, *golden_path;
+	uint64_t hash;
+
+	if (golden_dir == NULL)
+		return;
+
+	(void)!asprintf(&key, "%s %s\n%s", golden_test, golden_args,
+			renderer);
+	(void)!asprintf(&entry, "%s%c%s-%016" PRIx64 "-%03d", golden_dir,
+			PIGLIT_PATH_SEP, golden_test,
+			golden_hash(key, strlen(key), 0), golden_frame);
+	(void)!asprintf(&golden_path, "%s.golden", entry);
+
+	hash = golden_hash(image, 4 * (size_t) width * height,
+			   ((uint64_t) width << 32) | (uint32_t) height);
+
+	if (golden_update)
+		record_frame(entry, golden_path, key, image, width, height,
+			     hash);
+	else
+		check_frame(entry, golden_path, image, width, height, hash);
+
+	golden_frame++;
+	free(golden_path);
+	free(entry);
+	free(key);
+}
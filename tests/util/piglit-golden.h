@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-golden.h
+ *
+ * Golden image checks of the frames passed to piglit_present_results().
+ *
+ * When PIGLIT_GOLDEN_DIR names an existing directory, each presented frame
+ * is hashed and compared with the hash stored there for the same test
+ * command line, frame number and GL_RENDERER.  A match costs the readback
+ * and the hash, nothing is written.  A mismatch writes the rendered frame
+ * and, if a reference image was recorded, a diff image next to the golden
+ * entry, and prints a PIGLIT: {"image": {...}} record with the error
+ * metrics.  With PIGLIT_GOLDEN_UPDATE set, the frames are recorded as the
+ * new golden entries instead.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "piglit-util-gl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Read PIGLIT_GOLDEN_DIR and PIGLIT_GOLDEN_UPDATE, and key the golden
+ * entries of this process on the command line in \p argv.  Only the first
+ * call does anything.
+ */
+void
+piglit_golden_init(int argc, char *argv[]);
+
+/**
+ * Key the golden entries of the next frames on \p name instead of the
+ * command line, and number them from 0 again.  For processes that run
+ * several tests, so that the entries of a test don't depend on the others
+ * run with it.  A path in \p name is keyed from its tests or
+ * generated_tests directory on.  Call it while no frame is in flight, e.g.
+ * after piglit_present_finish().
+ */
+void
+piglit_golden_begin_test(const char *name);
+
+bool
+piglit_golden_enabled(void);
+
+/**
+ * Check the next frame against its golden entry, or record it.  Needs no
+ * GL context, the frame writer thread calls it.
+ *
+ * \param renderer  GL_RENDERER of the context that rendered the frame
+ * \param image     RGBA unsigned byte pixels, bottom row first, as read
+ *                  by glReadPixels
+ */
+void
+piglit_golden_check_frame(const char *renderer, const GLubyte *image,
+			  int width, int height);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
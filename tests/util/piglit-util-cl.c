@@ -533,17 +533,63 @@ piglit_cl_get_event_profiling_info(cl_event event, cl_profiling_info param) {
 	return piglit_cl_get_info(clGetEventProfilingInfo, &event, param);
 }
 
+/**
+ * Extension sets of the platforms and devices queried so far.  Platform and
+ * device extensions can't change, so each set is built once.
+ */
+struct cl_extension_cache_entry {
+	const void *id;
+	struct piglit_extension_set *set;
+};
+
+static struct cl_extension_cache_entry cl_extension_cache[16];
+static unsigned cl_extension_cache_next;
+
+static struct cl_extension_cache_entry *
+find_cl_extension_set(const void *id)
+{
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(cl_extension_cache); i++) {
+		if (cl_extension_cache[i].set != NULL &&
+		    cl_extension_cache[i].id == id)
+			return &cl_extension_cache[i];
+	}
+
+	return NULL;
+}
+
+static struct piglit_extension_set *
+add_cl_extension_set(const void *id, char *extensions)
+{
+	struct cl_extension_cache_entry *entry = &cl_extension_cache[
+		cl_extension_cache_next++ % ARRAY_SIZE(cl_extension_cache)];
+
+	piglit_extension_set_destroy(entry->set);
+	entry->id = id;
+	entry->set = piglit_extension_set_create_from_string(extensions);
+	free(extensions);
+
+	return entry->set;
+}
+
 bool
 piglit_cl_is_platform_extension_supported(cl_platform_id platform,
                                           const char *name)
 {
-	char* extensions = piglit_cl_get_platform_info(platform,
-	                                               CL_PLATFORM_EXTENSIONS);
-	bool supported = piglit_is_extension_in_string(extensions, name);
+	struct cl_extension_cache_entry *entry =
+		find_cl_extension_set(platform);
+	struct piglit_extension_set *set;
 
-	free(extensions);
+	if (entry != NULL) {
+		set = entry->set;
+	} else {
+		set = add_cl_extension_set(platform,
+			piglit_cl_get_platform_info(platform,
+			                            CL_PLATFORM_EXTENSIONS));
+	}
 
-	return supported;
+	return piglit_extension_set_contains(set, name);
 }
 
 void
@@ -568,12 +614,19 @@ piglit_cl_require_not_platform_extension(cl_platform_id platform,
 bool
 piglit_cl_is_device_extension_supported(cl_device_id device, const char *name)
 {
-	char* extensions = piglit_cl_get_device_info(device, CL_DEVICE_EXTENSIONS);
-	bool supported = piglit_is_extension_in_string(extensions, name);
+	struct cl_extension_cache_entry *entry =
+		find_cl_extension_set(device);
+	struct piglit_extension_set *set;
 
-	free(extensions);
+	if (entry != NULL) {
+		set = entry->set;
+	} else {
+		set = add_cl_extension_set(device,
+			piglit_cl_get_device_info(device,
+			                          CL_DEVICE_EXTENSIONS));
+	}
 
-	return supported;
+	return piglit_extension_set_contains(set, name);
 }
 
 void
@@ -699,6 +752,18 @@ piglit_cl_context
 piglit_cl_create_context(cl_platform_id platform_id,
                          const cl_device_id device_ids[],
                         unsigned int num_devices)
+{
+	return piglit_cl_create_context_with_queue_properties(platform_id,
+	                                                      device_ids,
+	                                                      num_devices,
+	                                                      0);
+}
+
+piglit_cl_context
+piglit_cl_create_context_with_queue_properties(cl_platform_id platform_id,
+                                               const cl_device_id device_ids[],
+                                               unsigned int num_devices,
+                                               cl_command_queue_properties queue_properties)
 {
 	piglit_cl_context context = malloc(sizeof(struct _piglit_cl_context));
 
@@ -738,7 +803,7 @@ piglit_cl_create_context(cl_platform_id platform_id,
 	for(i = 0; i < num_devices; i++) {
 		context->command_queues[i] = clCreateCommandQueue(context->cl_ctx,
 		                                                  context->device_ids[i],
-		                                                  0,
+		                                                  queue_properties,
 		                                                  &errNo);
 		if(errNo != CL_SUCCESS) {
 			clReleaseContext(context->cl_ctx);
@@ -981,11 +1046,20 @@ piglit_cl_create_buffer(piglit_cl_context context, cl_mem_flags flags,
 bool
 piglit_cl_write_buffer(cl_command_queue command_queue, cl_mem buffer,
                        size_t offset, size_t cb, const void *ptr)
+{
+	return piglit_cl_write_buffer_with_event(command_queue, buffer, offset,
+	                                         cb, ptr, NULL);
+}
+
+bool
+piglit_cl_write_buffer_with_event(cl_command_queue command_queue,
+                                  cl_mem buffer, size_t offset, size_t cb,
+                                  const void *ptr, cl_event *event)
 {
 	cl_int errNo;
 
 	errNo = clEnqueueWriteBuffer(command_queue, buffer, CL_TRUE, offset, cb,
-	                             ptr, 0, NULL, NULL);
+	                             ptr, 0, NULL, event);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
 		        "Could not enqueue buffer write: %s\n",
@@ -1014,11 +1088,20 @@ piglit_cl_write_whole_buffer(cl_command_queue command_queue, cl_mem buffer,
 bool
 piglit_cl_read_buffer(cl_command_queue command_queue, cl_mem buffer,
                       size_t offset, size_t cb, void *ptr)
+{
+	return piglit_cl_read_buffer_with_event(command_queue, buffer, offset,
+	                                        cb, ptr, NULL);
+}
+
+bool
+piglit_cl_read_buffer_with_event(cl_command_queue command_queue,
+                                 cl_mem buffer, size_t offset, size_t cb,
+                                 void *ptr, cl_event *event)
 {
 	cl_int errNo;
 
 	errNo = clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, offset, cb, ptr,
-	                            0, NULL, NULL);
+	                            0, NULL, event);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
 		        "Could not enqueue buffer read: %s\n",
@@ -1307,12 +1390,30 @@ piglit_cl_enqueue_ND_range_kernel(cl_command_queue command_queue,
                                   const size_t* global_offset,
                                   const size_t* global_work_size,
                                   const size_t* local_work_size)
+{
+	return piglit_cl_enqueue_ND_range_kernel_with_event(command_queue,
+	                                                    kernel,
+	                                                    work_dim,
+	                                                    global_offset,
+	                                                    global_work_size,
+	                                                    local_work_size,
+	                                                    NULL);
+}
+
+bool
+piglit_cl_enqueue_ND_range_kernel_with_event(cl_command_queue command_queue,
+                                             cl_kernel kernel,
+                                             cl_uint work_dim,
+                                             const size_t* global_offset,
+                                             const size_t* global_work_size,
+                                             const size_t* local_work_size,
+                                             cl_event* event)
 {
 	cl_int errNo;
 
 	errNo = clEnqueueNDRangeKernel(command_queue, kernel, work_dim,
 	                               global_offset, global_work_size,
-	                               local_work_size, 0, NULL, NULL);
+	                               local_work_size, 0, NULL, event);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
 		        "Could not enqueue ND range kernel: %s\n",
@@ -1329,15 +1430,34 @@ piglit_cl_execute_ND_range_kernel(cl_command_queue command_queue,
                                   const size_t* global_offset,
                                   const size_t* global_work_size,
                                   const size_t* local_work_size)
+{
+	return piglit_cl_execute_ND_range_kernel_with_event(command_queue,
+	                                                    kernel,
+	                                                    work_dim,
+	                                                    global_offset,
+	                                                    global_work_size,
+	                                                    local_work_size,
+	                                                    NULL);
+}
+
+bool
+piglit_cl_execute_ND_range_kernel_with_event(cl_command_queue command_queue,
+                                             cl_kernel kernel,
+                                             cl_uint work_dim,
+                                             const size_t* global_offset,
+                                             const size_t* global_work_size,
+                                             const size_t* local_work_size,
+                                             cl_event* event)
 {
 	int errNo;
 
-	if(!piglit_cl_enqueue_ND_range_kernel(command_queue,
-	                                     kernel,
-	                                     work_dim,
-	                                     global_offset,
-	                                     global_work_size,
-	                                     local_work_size)) {
+	if(!piglit_cl_enqueue_ND_range_kernel_with_event(command_queue,
+	                                                kernel,
+	                                                work_dim,
+	                                                global_offset,
+	                                                global_work_size,
+	                                                local_work_size,
+	                                                event)) {
 		return false;
 	}
 
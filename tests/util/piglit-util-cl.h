@@ -391,6 +391,24 @@ piglit_cl_create_context(cl_platform_id platform_id,
                          const cl_device_id device_ids[],
                          unsigned int num_devices);
 
+/**
+ * \brief Create \c piglit_cl_context with command queue properties
+ *
+ * Like \c piglit_cl_create_context, but the command queues are created
+ * with \c queue_properties, for example \c CL_QUEUE_PROFILING_ENABLE.
+ *
+ * @param platform_id       Platform from which to create context.
+ * @param device_ids        Device ids to add to context.
+ * @param num_devices       Number of members in \c device_ids.
+ * @param queue_properties  Properties of the command queues.
+ * @return                  Created context or NULL on fail.
+ */
+piglit_cl_context
+piglit_cl_create_context_with_queue_properties(cl_platform_id platform_id,
+                                               const cl_device_id device_ids[],
+                                               unsigned int num_devices,
+                                               cl_command_queue_properties queue_properties);
+
 /**
  * \brief Release \c piglit_cl_context
  *
@@ -504,6 +522,22 @@ piglit_cl_write_buffer(cl_command_queue command_queue,
                        size_t cb,
                        const void *ptr);
 
+/**
+ * \brief Blocking write to a buffer, returning an event for the command.
+ *
+ * Like \c piglit_cl_write_buffer. The event, which the caller must
+ * release, can be used to get the profiling information of the write.
+ *
+ * @param event          Returns the event of the write, may be NULL.
+ */
+bool
+piglit_cl_write_buffer_with_event(cl_command_queue command_queue,
+                                  cl_mem buffer,
+                                  size_t offset,
+                                  size_t cb,
+                                  const void *ptr,
+                                  cl_event *event);
+
 /**
  * \brief Blocking write to a whole buffer.
  *
@@ -537,6 +571,22 @@ piglit_cl_read_buffer(cl_command_queue command_queue,
                       size_t cb,
                       void *ptr);
 
+/**
+ * \brief Blocking read from a buffer, returning an event for the command.
+ *
+ * Like \c piglit_cl_read_buffer. The event, which the caller must
+ * release, can be used to get the profiling information of the read.
+ *
+ * @param event          Returns the event of the read, may be NULL.
+ */
+bool
+piglit_cl_read_buffer_with_event(cl_command_queue command_queue,
+                                 cl_mem buffer,
+                                 size_t offset,
+                                 size_t cb,
+                                 void *ptr,
+                                 cl_event *event);
+
 /**
  * \brief Blocking read from a whole buffer.
  *
@@ -742,6 +792,23 @@ piglit_cl_enqueue_ND_range_kernel(cl_command_queue command_queue,
                                   const size_t* global_work_size,
                                   const size_t* local_work_size);
 
+/**
+ * \brief Enqueue ND-range kernel, returning an event for the command.
+ *
+ * Like \c piglit_cl_enqueue_ND_range_kernel. The event must be released
+ * by the caller.
+ *
+ * @param event             Returns the event of the kernel, may be NULL.
+ */
+bool
+piglit_cl_enqueue_ND_range_kernel_with_event(cl_command_queue command_queue,
+                                             cl_kernel kernel,
+                                             cl_uint work_dim,
+                                             const size_t* global_offset,
+                                             const size_t* global_work_size,
+                                             const size_t* local_work_size,
+                                             cl_event* event);
+
 /**
  * \brief Enqueue ND-range kernel and wait it to complete.
  *
@@ -761,6 +828,24 @@ piglit_cl_execute_ND_range_kernel(cl_command_queue command_queue,
                                   const size_t* global_work_size,
                                   const size_t* local_work_size);
 
+/**
+ * \brief Enqueue ND-range kernel and wait it to complete, returning an event
+ * for the command.
+ *
+ * Like \c piglit_cl_execute_ND_range_kernel. The event, which the caller
+ * must release, can be used to get the profiling information of the kernel.
+ *
+ * @param event             Returns the event of the kernel, may be NULL.
+ */
+bool
+piglit_cl_execute_ND_range_kernel_with_event(cl_command_queue command_queue,
+                                             cl_kernel kernel,
+                                             cl_uint work_dim,
+                                             const size_t* global_offset,
+                                             const size_t* global_work_size,
+                                             const size_t* local_work_size,
+                                             cl_event* event);
+
 /**
  * \brief Enqueue kernel task.
  *
@@ -138,6 +138,44 @@ piglit_egl_get_default_display(EGLenum platform)
 	return peglGetPlatformDisplayEXT(platform, EGL_DEFAULT_DISPLAY, NULL);
 }
 
+/**
+ * Extension sets of the displays queried most recently.  eglQueryString
+ * returns the same string for a display until it is terminated or
+ * reinitialized, so a set is rebuilt whenever the string changes.
+ */
+static struct {
+	EGLDisplay dpy;
+	const char *string;
+	struct piglit_extension_set *set;
+} egl_extension_cache[4];
+static unsigned egl_extension_cache_next;
+
+static struct piglit_extension_set *
+get_egl_extension_set(EGLDisplay egl_dpy, const char *egl_extension_list)
+{
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(egl_extension_cache); i++) {
+		if (egl_extension_cache[i].set != NULL &&
+		    egl_extension_cache[i].dpy == egl_dpy)
+			break;
+	}
+
+	if (i == ARRAY_SIZE(egl_extension_cache)) {
+		i = egl_extension_cache_next++ % ARRAY_SIZE(egl_extension_cache);
+	} else if (egl_extension_cache[i].string == egl_extension_list) {
+		return egl_extension_cache[i].set;
+	}
+
+	piglit_extension_set_destroy(egl_extension_cache[i].set);
+	egl_extension_cache[i].dpy = egl_dpy;
+	egl_extension_cache[i].string = egl_extension_list;
+	egl_extension_cache[i].set =
+		piglit_extension_set_create_from_string(egl_extension_list);
+
+	return egl_extension_cache[i].set;
+}
+
 bool
 piglit_is_egl_extension_supported(EGLDisplay egl_dpy, const char *name)
 {
@@ -154,7 +192,11 @@ piglit_is_egl_extension_supported(EGLDisplay egl_dpy, const char *name)
 			piglit_check_egl_error(EGL_BAD_DISPLAY))
 		return false;
 
-	return piglit_is_extension_in_string(egl_extension_list, name);
+	if (!egl_extension_list)
+		return false;
+
+	return piglit_extension_set_contains(
+		get_egl_extension_set(egl_dpy, egl_extension_list), name);
 }
 
 void piglit_require_egl_extension(EGLDisplay dpy, const char *name)
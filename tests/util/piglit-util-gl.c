@@ -22,18 +22,24 @@
  */
 
 #include "piglit-util-gl.h"
+#include "piglit-compare.h"
 #include <ctype.h>
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 /**
- * An array of pointers to extension strings.
- *
- * Each extension is pointed to by a separate entry in the array.
- *
- * The end of the array is indicated by a NULL pointer.
+ * The extensions of the current context, built on first use and dropped by
+ * piglit_gl_invalidate_extensions().
  */
-static const char **gl_extensions = NULL;
+static struct piglit_extension_set *gl_extensions = NULL;
+
+/**
+ * The GL_VERSION string piglit_get_gl_version() last parsed, and the
+ * result.  The string is owned by the context, so a different pointer means
+ * a different context.
+ */
+static const char *gl_version_string = NULL;
+static int gl_version = 0;
 
 static const float color_wheel[4][4] = {
 	{1, 0, 0, 1}, /* red */
@@ -63,6 +69,10 @@ int piglit_get_gl_version(void)
 	int major;
 	int minor;
 
+	if (version_string == gl_version_string && gl_version != 0)
+		return gl_version;
+	gl_version_string = version_string;
+
 	/* skip to version number */
 	while (!isdigit(*version_string) && *version_string != '\0')
 		version_string++;
@@ -74,14 +84,8 @@ int piglit_get_gl_version(void)
 		       version_string);
 		piglit_report_result(PIGLIT_FAIL);
 	}
-	return 10*major+minor;
-}
-
-static const char** gl_extension_array_from_getstring()
-{
-	const char *gl_extensions_string;
-	gl_extensions_string = (const char *) glGetString(GL_EXTENSIONS);
-	return piglit_split_string_to_array(gl_extensions_string, " ");
+	gl_version = 10*major+minor;
+	return gl_version;
 }
 
 static const char** gl_extension_array_from_getstringi()
@@ -109,24 +113,28 @@ static void initialize_piglit_extension_support(void)
 	}
 
 	if (piglit_get_gl_version() < 30) {
-		gl_extensions = gl_extension_array_from_getstring();
+		gl_extensions = piglit_extension_set_create_from_string(
+			(const char *) glGetString(GL_EXTENSIONS));
 	} else {
-		gl_extensions = gl_extension_array_from_getstringi();
+		const char **strings = gl_extension_array_from_getstringi();
+
+		gl_extensions = piglit_extension_set_create(strings);
+		free(strings);
 	}
 }
 
 void piglit_gl_invalidate_extensions()
 {
-	if (gl_extensions != NULL) {
-		free(gl_extensions);
-		gl_extensions = NULL;
-	}
+	piglit_extension_set_destroy(gl_extensions);
+	gl_extensions = NULL;
+	gl_version_string = NULL;
+	gl_version = 0;
 }
 
 bool piglit_is_extension_supported(const char *name)
 {
 	initialize_piglit_extension_support();
-	return piglit_is_extension_in_array(gl_extensions, name);
+	return piglit_extension_set_contains(gl_extensions, name);
 }
 
 void piglit_require_gl_version(int required_version_times_10)
@@ -1048,6 +1056,305 @@ piglit_get_luminance_intensity_bits(GLenum internalformat, int *bits)
 	return false;
 }
 
+/**
+ * \name Asynchronous readback
+ *
+ * Readbacks go through a small ring of pixel pack buffers.  Each one is
+ * fenced when queued and only waited for and mapped when the pixels are
+ * needed.  Without PBOs, fences and glMapBufferRange, or unless
+ * PIGLIT_ASYNC_READBACK is set, a readback is a plain glReadPixels into
+ * memory owned by the ring slot.
+ * @{
+ */
+#define READBACK_RING_SIZE 8
+
+struct piglit_readback {
+	bool busy;
+	bool async;
+	GLuint pbo;
+	GLsizeiptr pbo_size;
+	GLsync fence;
+	void *map;
+	size_t size;
+	void *data;
+	size_t data_size;
+};
+
+static struct piglit_readback readback_ring[READBACK_RING_SIZE];
+static unsigned readback_next = 0;
+/** -1 until the first readback decides. */
+static int readback_supported = -1;
+static int readback_async = -1;
+
+/**
+ * Whether the context supports asynchronous readbacks, whether or not
+ * PIGLIT_ASYNC_READBACK asks for them.
+ */
+bool
+piglit_readback_can_async(void)
+{
+	if (readback_supported >= 0)
+		return readback_supported;
+
+	if (piglit_is_gles()) {
+		readback_supported = piglit_get_gl_version() >= 30;
+	} else {
+		int version = piglit_get_gl_version();
+
+		readback_supported =
+			(version >= 32 ||
+			 piglit_is_extension_supported("GL_ARB_sync")) &&
+			(version >= 30 ||
+			 piglit_is_extension_supported("GL_ARB_map_buffer_range")) &&
+			(version >= 21 ||
+			 piglit_is_extension_supported("GL_ARB_pixel_buffer_object"));
+	}
+
+	return readback_supported;
+}
+
+bool
+piglit_readback_is_async(void)
+{
+	const char *env;
+
+	if (readback_async >= 0)
+		return readback_async;
+
+	env = getenv("PIGLIT_ASYNC_READBACK");
+	readback_async = env != NULL && env[0] && strcmp(env, "0") != 0 &&
+			 piglit_readback_can_async();
+
+	return readback_async;
+}
+
+static size_t
+readback_size(int w, int h, GLenum format, GLenum type)
+{
+	GLint alignment = 4;
+	size_t row;
+
+	glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+
+	switch (type) {
+	case GL_FLOAT:
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+		row = w * piglit_num_components(format) * 4;
+		break;
+	default:
+		row = w * piglit_num_components(format);
+		break;
+	}
+
+	row = ALIGN(row, alignment);
+	return row * h;
+}
+
+/**
+ * glReadPixels with the pack state the ring's sizes assume.  readback_size()
+ * and the callers' row strides only account for GL_PACK_ALIGNMENT, so the
+ * test's GL_PACK_ROW_LENGTH, GL_PACK_SKIP_ROWS and GL_PACK_SKIP_PIXELS are
+ * reset around the read and restored afterwards.  OpenGL ES 2.0 has none of
+ * them.
+ */
+static void
+readback_read_pixels(int x, int y, int w, int h, GLenum format, GLenum type,
+		     void *pixels)
+{
+	static const GLenum pnames[] = {
+		GL_PACK_ROW_LENGTH,
+		GL_PACK_SKIP_ROWS,
+		GL_PACK_SKIP_PIXELS,
+	};
+	GLint saved[ARRAY_SIZE(pnames)];
+	bool has_pack_state = !piglit_is_gles() ||
+			      piglit_get_gl_version() >= 30;
+	unsigned i;
+
+	if (has_pack_state) {
+		for (i = 0; i < ARRAY_SIZE(pnames); i++) {
+			glGetIntegerv(pnames[i], &saved[i]);
+			glPixelStorei(pnames[i], 0);
+		}
+	}
+
+	glReadPixels(x, y, w, h, format, type, pixels);
+
+	if (has_pack_state) {
+		for (i = 0; i < ARRAY_SIZE(pnames); i++)
+			glPixelStorei(pnames[i], saved[i]);
+	}
+}
+
+static struct piglit_readback *
+readback_begin(int x, int y, int w, int h, GLenum format, GLenum type,
+	       bool async)
+{
+	struct piglit_readback *rb;
+	GLint bound = 0;
+	unsigned i;
+
+	/* A slot may stay busy while the ones after it are reused, e.g.
+	 * the frame captured by piglit_present_results().
+	 */
+	for (i = 0; i < READBACK_RING_SIZE; i++) {
+		rb = &readback_ring[readback_next];
+		readback_next = (readback_next + 1) % READBACK_RING_SIZE;
+		if (!rb->busy)
+			break;
+	}
+	if (rb->busy) {
+		fprintf(stderr, "%s: more than %d readbacks in flight\n",
+			__func__, READBACK_RING_SIZE);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	rb->busy = true;
+	rb->size = readback_size(w, h, format, type);
+
+	/* Don't steal a pack buffer the test has bound itself. */
+	if (async)
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &bound);
+	rb->async = async && bound == 0;
+
+	if (!rb->async) {
+		if (rb->data_size < rb->size) {
+			free(rb->data);
+			rb->data = malloc(rb->size);
+			rb->data_size = rb->size;
+		}
+		readback_read_pixels(x, y, w, h, format, type, rb->data);
+		return rb;
+	}
+
+	if (rb->pbo == 0)
+		glGenBuffers(1, &rb->pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+	if (rb->pbo_size < (GLsizeiptr) rb->size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, rb->size, NULL,
+			     GL_STREAM_READ);
+		rb->pbo_size = rb->size;
+	}
+	readback_read_pixels(x, y, w, h, format, type, NULL);
+	rb->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	return rb;
+}
+
+/**
+ * Queue a readback of the given area of the current read buffer.
+ *
+ * The pixels are packed with the current GL_PACK_ALIGNMENT only, the
+ * other pack parameters are ignored.  The returned handle stays valid
+ * until piglit_readback_end() and at most READBACK_RING_SIZE readbacks may
+ * be outstanding at a time.
+ */
+struct piglit_readback *
+piglit_readback_begin(int x, int y, int w, int h, GLenum format, GLenum type)
+{
+	return readback_begin(x, y, w, h, format, type,
+			      piglit_readback_is_async());
+}
+
+/**
+ * Like piglit_readback_begin(), but asynchronous whenever the context
+ * supports it, regardless of PIGLIT_ASYNC_READBACK.  For readbacks that
+ * don't feed a probe, such as the frames captured for -png.
+ */
+struct piglit_readback *
+piglit_readback_begin_async(int x, int y, int w, int h, GLenum format,
+			    GLenum type)
+{
+	return readback_begin(x, y, w, h, format, type,
+			      piglit_readback_can_async());
+}
+
+/**
+ * Wait for a queued readback and return its pixels, packed as
+ * glReadPixels would have written them to client memory.
+ */
+const void *
+piglit_readback_map(struct piglit_readback *rb)
+{
+	GLint bound;
+
+	if (!rb->async)
+		return rb->data;
+	if (rb->map)
+		return rb->map;
+
+	while (glClientWaitSync(rb->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+				1000000000) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync(rb->fence);
+	rb->fence = NULL;
+
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &bound);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+	rb->map = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rb->size,
+				   GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, bound);
+
+	if (rb->map == NULL) {
+		fprintf(stderr, "%s: failed to map the readback buffer\n",
+			__func__);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	return rb->map;
+}
+
+/** Unmap a readback and hand its slot back to the ring. */
+void
+piglit_readback_end(struct piglit_readback *rb)
+{
+	GLint bound;
+
+	if (rb->map) {
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &bound);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, bound);
+		rb->map = NULL;
+	}
+
+	if (rb->fence) {
+		glDeleteSync(rb->fence);
+		rb->fence = NULL;
+	}
+
+	rb->busy = false;
+}
+
+/**
+ * Free the ring's buffers.  Must be called with the context that did the
+ * readbacks still current, before it is destroyed.  Readbacks that weren't
+ * ended are dropped, so their callers must be done with them first.
+ */
+void
+piglit_readback_release(void)
+{
+	unsigned i;
+
+	for (i = 0; i < READBACK_RING_SIZE; i++) {
+		struct piglit_readback *rb = &readback_ring[i];
+
+		if (rb->busy)
+			piglit_readback_end(rb);
+		if (rb->pbo)
+			glDeleteBuffers(1, &rb->pbo);
+		free(rb->data);
+		memset(rb, 0, sizeof(*rb));
+	}
+
+	readback_next = 0;
+	readback_supported = -1;
+	readback_async = -1;
+}
+/** @} */
+
 /* Wrapper around glReadPixels that always returns floats; reads and converts
  * GL_UNSIGNED_BYTE on GLES.  If pixels == NULL, malloc a float array of the
  * appropriate size, otherwise use the one provided. */
@@ -1055,7 +1362,8 @@ static GLfloat *
 piglit_read_pixels_float(GLint x, GLint y, GLsizei width, GLsizei height,
                          GLenum format, GLfloat *pixels)
 {
-	GLubyte *pixels_b;
+	struct piglit_readback *rb;
+	const GLubyte *pixels_b;
 	unsigned i, ncomponents;
 
 	ncomponents = width * height * piglit_num_components(format);
@@ -1063,15 +1371,26 @@ piglit_read_pixels_float(GLint x, GLint y, GLsizei width, GLsizei height,
 		pixels = malloc(ncomponents * sizeof(GLfloat));
 
 	if (!piglit_is_gles()) {
-		glReadPixels(x, y, width, height, format, GL_FLOAT, pixels);
+		if (!piglit_readback_is_async()) {
+			glReadPixels(x, y, width, height, format, GL_FLOAT,
+				     pixels);
+			return pixels;
+		}
+
+		rb = piglit_readback_begin(x, y, width, height, format,
+					   GL_FLOAT);
+		memcpy(pixels, piglit_readback_map(rb),
+		       ncomponents * sizeof(GLfloat));
+		piglit_readback_end(rb);
 		return pixels;
 	}
 
-	pixels_b = malloc(ncomponents * sizeof(GLubyte));
-	glReadPixels(x, y, width, height, format, GL_UNSIGNED_BYTE, pixels_b);
+	rb = piglit_readback_begin(x, y, width, height, format,
+				   GL_UNSIGNED_BYTE);
+	pixels_b = piglit_readback_map(rb);
 	for (i = 0; i < ncomponents; i++)
 		pixels[i] = pixels_b[i] / 255.0;
-	free(pixels_b);
+	piglit_readback_end(rb);
 	return pixels;
 }
 
@@ -1143,6 +1462,40 @@ piglit_probe_pixel_rgba_silent(int x, int y, const float* expected, float *out_p
 	return pass;
 }
 
+/**
+ * Compare the first \c num_components channels of a pixel that was read
+ * back at (x, y) against \c expected, printing the usual probe message on
+ * mismatch.
+ */
+static bool
+compare_pixel_float(int x, int y, int num_components, const float *expected,
+		    const GLfloat *probe)
+{
+	int i;
+	bool pass = true;
+
+	for (i = 0; i < num_components; ++i)
+		if (fabs(probe[i] - expected[i]) > piglit_tolerance[i])
+			pass = false;
+
+	if (pass)
+		return true;
+
+	printf("Probe color at (%i,%i)\n", x, y);
+	if (num_components == 4) {
+		printf("  Expected: %f %f %f %f\n",
+		       expected[0], expected[1], expected[2], expected[3]);
+		printf("  Observed: %f %f %f %f\n",
+		       probe[0], probe[1], probe[2], probe[3]);
+	} else {
+		printf("  Expected: %f %f %f\n",
+		       expected[0], expected[1], expected[2]);
+		printf("  Observed: %f %f %f\n", probe[0], probe[1], probe[2]);
+	}
+
+	return false;
+}
+
 /**
  * Read a pixel from the given location and compare its RGB value to the
  * given expected values.
@@ -1154,23 +1507,10 @@ int
 piglit_probe_pixel_rgb(int x, int y, const float* expected)
 {
 	GLfloat probe[3];
-	int i;
-	GLboolean pass = GL_TRUE;
 
 	piglit_read_pixels_float(x, y, 1, 1, GL_RGB, probe);
 
-	for(i = 0; i < 3; ++i)
-		if (fabs(probe[i] - expected[i]) > piglit_tolerance[i])
-			pass = GL_FALSE;
-
-	if (pass)
-		return 1;
-
-	printf("Probe color at (%i,%i)\n", x, y);
-	printf("  Expected: %f %f %f\n", expected[0], expected[1], expected[2]);
-	printf("  Observed: %f %f %f\n", probe[0], probe[1], probe[2]);
-
-	return 0;
+	return compare_pixel_float(x, y, 3, expected, probe);
 }
 
 /**
@@ -1184,23 +1524,10 @@ int
 piglit_probe_pixel_rgba(int x, int y, const float* expected)
 {
 	GLfloat probe[4];
-	int i;
-	GLboolean pass = GL_TRUE;
 
 	piglit_read_pixels_float(x, y, 1, 1, GL_RGBA, probe);
 
-	for(i = 0; i < 4; ++i)
-		if (fabs(probe[i] - expected[i]) > piglit_tolerance[i])
-			pass = GL_FALSE;
-
-	if (pass)
-		return 1;
-
-	printf("Probe color at (%i,%i)\n", x, y);
-	printf("  Expected: %f %f %f %f\n", expected[0], expected[1], expected[2], expected[3]);
-	printf("  Observed: %f %f %f %f\n", probe[0], probe[1], probe[2], probe[3]);
-
-	return 0;
+	return compare_pixel_float(x, y, 4, expected, probe);
 }
 
 static void
@@ -1221,26 +1548,284 @@ piglit_array_float_to_ubyte_roundup(int n, const float *f, GLubyte *b)
 		b[i] = ceil(f[i] * 255);
 }
 
+/**
+ * \name Probe mismatch statistics
+ *
+ * Normally a failing rect or image probe stops at the first bad pixel.
+ * With PIGLIT_PROBE_STATS set it then scans the whole area once more and
+ * reports the number of failing pixels, their bounding box and the max
+ * and RMS error of each channel as a PIGLIT: {"probe": {...}} record.
+ * With PIGLIT_PROBE_STATS=mask the record also carries a hex bitmap of the
+ * failing pixels in the bounding box, one bit per pixel, rows from the
+ * bottom, as long as the box has no more than PROBE_STATS_MAX_MASK pixels.
+ * @{
+ */
+#define PROBE_STATS_MAX_MASK 16384
+
+enum probe_stats_mode {
+	PROBE_STATS_OFF,
+	PROBE_STATS_ON,
+	PROBE_STATS_MASK,
+};
+
+struct probe_stats {
+	int x, y, w, h;
+	int num_components;
+	unsigned failed;
+	/** Bounding box of the failures, x1 and y1 exclusive. */
+	int x0, y0, x1, y1;
+	double max_error[4];
+	double sum_sq[4];
+	/** One byte per probed pixel, only in PROBE_STATS_MASK mode. */
+	GLubyte *failures;
+};
+
+static enum probe_stats_mode
+get_probe_stats_mode(void)
+{
+	static int mode = -1;
+
+	if (mode < 0) {
+		const char *env = getenv("PIGLIT_PROBE_STATS");
+
+		if (env == NULL || !env[0] || strcmp(env, "0") == 0)
+			mode = PROBE_STATS_OFF;
+		else if (strcmp(env, "mask") == 0)
+			mode = PROBE_STATS_MASK;
+		else
+			mode = PROBE_STATS_ON;
+	}
+
+	return mode;
+}
+
+static void
+probe_stats_init(struct probe_stats *stats, int x, int y, int w, int h,
+		 int num_components)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->x = x;
+	stats->y = y;
+	stats->w = w;
+	stats->h = h;
+	stats->num_components = num_components;
+	stats->x0 = INT_MAX;
+	stats->y0 = INT_MAX;
+	stats->x1 = INT_MIN;
+	stats->y1 = INT_MIN;
+
+	if (get_probe_stats_mode() == PROBE_STATS_MASK)
+		stats->failures = calloc(w * h, 1);
+}
+
+/**
+ * Account for the pixel at offset (i, j) in the probed area.  \c error is
+ * the absolute error of each channel, in normalized units.
+ */
+static void
+probe_stats_add(struct probe_stats *stats, int i, int j,
+		const double *error, bool failed)
+{
+	int p;
+
+	for (p = 0; p < stats->num_components; p++) {
+		/* NaN and Inf would poison the sums and aren't JSON. */
+		if (!isfinite(error[p]))
+			continue;
+		stats->max_error[p] = MAX2(stats->max_error[p], error[p]);
+		stats->sum_sq[p] += error[p] * error[p];
+	}
+
+	if (!failed)
+		return;
+
+	stats->failed++;
+	stats->x0 = MIN2(stats->x0, i);
+	stats->y0 = MIN2(stats->y0, j);
+	stats->x1 = MAX2(stats->x1, i + 1);
+	stats->y1 = MAX2(stats->y1, j + 1);
+	if (stats->failures)
+		stats->failures[j * stats->w + i] = 1;
+}
+
+static void
+print_double_array(const char *name, const double *values, int count)
+{
+	int p;
+
+	printf(", \"%s\": [", name);
+	for (p = 0; p < count; p++)
+		printf("%s%g", p ? ", " : "", values[p]);
+	printf("]");
+}
+
+static void
+probe_stats_report(struct probe_stats *stats)
+{
+	unsigned pixels = stats->w * stats->h;
+	double rms[4];
+	int p;
+
+	for (p = 0; p < stats->num_components; p++)
+		rms[p] = pixels ? sqrt(stats->sum_sq[p] / pixels) : 0;
+
+	printf("PIGLIT: {\"probe\": {\"rect\": [%d, %d, %d, %d], "
+	       "\"pixels\": %u, \"failed\": %u",
+	       stats->x, stats->y, stats->w, stats->h, pixels, stats->failed);
+
+	if (stats->failed) {
+		printf(", \"bbox\": [%d, %d, %d, %d]",
+		       stats->x + stats->x0, stats->y + stats->y0,
+		       stats->x1 - stats->x0, stats->y1 - stats->y0);
+	}
+
+	print_double_array("max_error", stats->max_error,
+			   stats->num_components);
+	print_double_array("rms_error", rms, stats->num_components);
+
+	if (stats->failures && stats->failed &&
+	    (stats->x1 - stats->x0) * (stats->y1 - stats->y0) <=
+	    PROBE_STATS_MAX_MASK) {
+		unsigned bit = 0, byte = 0;
+		int i, j;
+
+		printf(", \"mask\": \"");
+		for (j = stats->y0; j < stats->y1; j++) {
+			for (i = stats->x0; i < stats->x1; i++) {
+				byte = (byte << 1) |
+				       stats->failures[j * stats->w + i];
+				if (++bit == 8) {
+					printf("%02x", byte);
+					bit = byte = 0;
+				}
+			}
+		}
+		if (bit)
+			printf("%02x", byte << (8 - bit));
+		printf("\"");
+	}
+
+	printf("}}\n");
+	fflush(stdout);
+
+	free(stats->failures);
+	stats->failures = NULL;
+}
+
+static void
+report_rect_stats_ubyte(int x, int y, int w, int h, int num_components,
+			const GLubyte *expected, const GLubyte *tolerance,
+			const GLubyte *pixels, int stride)
+{
+	struct probe_stats stats;
+	double error[4];
+	int i, j, p;
+
+	probe_stats_init(&stats, x, y, w, h, num_components);
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < w; i++) {
+			const GLubyte *probe = &pixels[(j*stride+i)*4];
+			bool failed = false;
+
+			for (p = 0; p < num_components; p++) {
+				int diff = abs((int)probe[p] - (int)expected[p]);
+
+				error[p] = diff / 255.0;
+				if (diff >= tolerance[p])
+					failed = true;
+			}
+			probe_stats_add(&stats, i, j, error, failed);
+		}
+	}
+	probe_stats_report(&stats);
+}
+
+static void
+report_rect_stats_float(int x, int y, int w, int h, int num_components,
+			const float *expected, const GLfloat *pixels,
+			int stride)
+{
+	struct probe_stats stats;
+	double error[4];
+	int i, j, p;
+
+	probe_stats_init(&stats, x, y, w, h, num_components);
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < w; i++) {
+			const GLfloat *probe = &pixels[(j*stride+i)*4];
+			bool failed = false;
+
+			for (p = 0; p < num_components; p++) {
+				error[p] = fabs(probe[p] - expected[p]);
+				if (error[p] >= piglit_tolerance[p])
+					failed = true;
+			}
+			probe_stats_add(&stats, i, j, error, failed);
+		}
+	}
+	probe_stats_report(&stats);
+}
+
+static void
+report_image_stats(int x, int y, int w, int h, int num_components,
+		   const float *tolerance, const float *expected_image,
+		   const float *observed_image)
+{
+	struct probe_stats stats;
+	double error[4];
+	int i, j, p;
+
+	/* Images with more channels than RGBA don't exist in piglit. */
+	assert(num_components <= 4);
+
+	probe_stats_init(&stats, x, y, w, h, num_components);
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < w; i++) {
+			const float *expected =
+				&expected_image[(j*w+i)*num_components];
+			const float *probe =
+				&observed_image[(j*w+i)*num_components];
+			bool failed = false;
+
+			for (p = 0; p < num_components; p++) {
+				error[p] = fabs(probe[p] - expected[p]);
+				if (error[p] >= tolerance[p])
+					failed = true;
+			}
+			probe_stats_add(&stats, i, j, error, failed);
+		}
+	}
+	probe_stats_report(&stats);
+}
+/** @} */
+
+/**
+ * Compare a w x h block of RGBA ubyte pixels whose rows are \c stride pixels
+ * apart.  x and y are only used for the message.
+ */
 static bool
-piglit_probe_rect_ubyte(int x, int y, int w, int h, int num_components,
-			const float *fexpected, bool silent)
+compare_rect_ubyte(int x, int y, int w, int h, int num_components,
+		   const float *fexpected, const GLubyte *pixels, int stride,
+		   bool silent)
 {
+	const struct piglit_compare_kernels *kernels =
+		piglit_get_compare_kernels();
 	int i, j, p;
-	GLubyte *probe;
-	GLubyte *pixels;
+	const GLubyte *probe;
 	GLubyte tolerance[4];
 	GLubyte expected[4];
 
 	piglit_array_float_to_ubyte_roundup(num_components, piglit_tolerance, tolerance);
 	piglit_array_float_to_ubyte(num_components, fexpected, expected);
 
-	/* RGBA readbacks are likely to be faster */
-	pixels = malloc(w*h*4);
-	glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-
 	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*4];
+		/* Skip the matching start of the row, the scalar loop
+		 * below has the final say and prints the diagnostics.
+		 */
+		i = kernels->rgba_ubyte(&pixels[j*stride*4], w, expected,
+					tolerance, num_components);
+		for (; i < w; i++) {
+			probe = &pixels[(j*stride+i)*4];
 
 			for (p = 0; p < num_components; ++p) {
 				if (abs((int)probe[p] - (int)expected[p]) >= tolerance[p]) {
@@ -1259,15 +1844,86 @@ piglit_probe_rect_ubyte(int x, int y, int w, int h, int num_components,
 							printf("  Observed: %u %u %u\n",
 							       probe[0], probe[1], probe[2]);
 						}
+						if (get_probe_stats_mode())
+							report_rect_stats_ubyte(
+								x, y, w, h,
+								num_components,
+								expected, tolerance,
+								pixels, stride);
 					}
-					free(pixels);
 					return false;
 				}
 			}
 		}
 	}
 
-	free(pixels);
+	return true;
+}
+
+static bool
+piglit_probe_rect_ubyte(int x, int y, int w, int h, int num_components,
+			const float *fexpected, bool silent)
+{
+	struct piglit_readback *rb;
+	bool pass;
+
+	/* RGBA readbacks are likely to be faster */
+	rb = piglit_readback_begin(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE);
+	pass = compare_rect_ubyte(x, y, w, h, num_components, fexpected,
+				  piglit_readback_map(rb), w, silent);
+	piglit_readback_end(rb);
+
+	return pass;
+}
+
+/**
+ * Compare a w x h block of RGBA float pixels whose rows are \c stride
+ * pixels apart.  x and y are only used for the message.
+ */
+static bool
+compare_rect_float(int x, int y, int w, int h, int num_components,
+		   const float *expected, const GLfloat *pixels, int stride)
+{
+	const struct piglit_compare_kernels *kernels =
+		piglit_get_compare_kernels();
+	int i, j, p;
+	const GLfloat *probe;
+
+	for (j = 0; j < h; j++) {
+		i = kernels->rgba_float(&pixels[j*stride*4], w, expected,
+					piglit_tolerance, num_components);
+		for (; i < w; i++) {
+			probe = &pixels[(j*stride+i)*4];
+
+			for (p = 0; p < num_components; ++p) {
+				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
+					printf("Probe color at (%i,%i)\n", x+i, y+j);
+					if (num_components == 4) {
+						printf("  Expected: %f %f %f %f\n",
+						       expected[0], expected[1],
+						       expected[2], expected[3]);
+						printf("  Observed: %f %f %f %f\n",
+						       probe[0], probe[1],
+						       probe[2], probe[3]);
+					} else {
+						printf("  Expected: %f %f %f\n",
+						       expected[0], expected[1],
+						       expected[2]);
+						printf("  Observed: %f %f %f\n",
+						       probe[0], probe[1], probe[2]);
+					}
+					if (get_probe_stats_mode())
+						report_rect_stats_float(
+							x, y, w, h,
+							num_components,
+							expected, pixels,
+							stride);
+					return false;
+				}
+			}
+		}
+	}
+
 	return true;
 }
 
@@ -1335,36 +1991,17 @@ piglit_probe_rect_r_ubyte(int x, int y, int w, int h, GLubyte expected)
 int
 piglit_probe_rect_rgb(int x, int y, int w, int h, const float *expected)
 {
-	int i, j, p;
-	GLfloat *probe;
 	GLfloat *pixels;
+	bool pass;
 
 	if (piglit_can_probe_ubyte())
 		return piglit_probe_rect_ubyte(x, y, w, h, 3, expected, false);
 
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
-
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*4];
-
-			for (p = 0; p < 3; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					printf("Probe color at (%i,%i)\n", x+i, y+j);
-					printf("  Expected: %f %f %f\n",
-					       expected[0], expected[1], expected[2]);
-					printf("  Observed: %f %f %f\n",
-					       probe[0], probe[1], probe[2]);
-
-					free(pixels);
-					return 0;
-				}
-			}
-		}
-	}
+	pass = compare_rect_float(x, y, w, h, 3, expected, pixels, w);
 
 	free(pixels);
-	return 1;
+	return pass;
 }
 
 int
@@ -1405,36 +2042,143 @@ piglit_probe_rects_equal(int x1, int y1, int x2, int y2,
 int
 piglit_probe_rect_rgba(int x, int y, int w, int h, const float *expected)
 {
-	int i, j, p;
-	GLfloat *probe;
 	GLfloat *pixels;
+	bool pass;
 
 	if (piglit_can_probe_ubyte())
 		return piglit_probe_rect_ubyte(x, y, w, h, 4, expected, false);
 
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
+	pass = compare_rect_float(x, y, w, h, 4, expected, pixels, w);
 
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*4];
+	free(pixels);
+	return pass;
+}
 
-			for (p = 0; p < 4; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					printf("Probe color at (%i,%i)\n", x+i, y+j);
-					printf("  Expected: %f %f %f %f\n",
-					       expected[0], expected[1], expected[2], expected[3]);
-					printf("  Observed: %f %f %f %f\n",
-					       probe[0], probe[1], probe[2], probe[3]);
+/**
+ * Read back a block of the current read buffer so that several probes can
+ * be checked against it with a single glReadPixels.
+ *
+ * The pixels are read in the same form the probes would use: RGBA float
+ * if \p pixel_probes is set, as piglit_probe_pixel_rgba() reads floats.
+ * Otherwise RGBA ubyte if the buffer has no more than 8 bits per channel,
+ * as the rect probes do, and RGBA float for deeper buffers.
+ */
+void
+piglit_probe_region_read(struct piglit_probe_region *region,
+			 int x, int y, int w, int h, bool pixel_probes)
+{
+	region->x = x;
+	region->y = y;
+	region->w = w;
+	region->h = h;
+	region->ubyte = !pixel_probes && piglit_can_probe_ubyte();
+
+	if (region->ubyte) {
+		region->readback = piglit_readback_begin(x, y, w, h, GL_RGBA,
+							 GL_UNSIGNED_BYTE);
+		region->pixels = piglit_readback_map(region->readback);
+	} else {
+		region->readback = NULL;
+		region->pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA,
+							  NULL);
+	}
+}
 
-					free(pixels);
-					return 0;
-				}
-			}
-		}
+void
+piglit_probe_region_free(struct piglit_probe_region *region)
+{
+	if (region->readback)
+		piglit_readback_end(region->readback);
+	else
+		free((void *) region->pixels);
+	region->readback = NULL;
+	region->pixels = NULL;
+}
+
+static bool
+region_contains(const struct piglit_probe_region *region,
+		int x, int y, int w, int h)
+{
+	return x >= region->x && y >= region->y &&
+	       x + w <= region->x + region->w &&
+	       y + h <= region->y + region->h;
+}
+
+static bool
+region_probe_pixel(const struct piglit_probe_region *region, int x, int y,
+		   int num_components, const float *expected)
+{
+	unsigned offset;
+	GLfloat probe[4];
+	int i;
+
+	assert(region_contains(region, x, y, 1, 1));
+
+	offset = ((y - region->y) * region->w + (x - region->x)) * 4;
+	if (region->ubyte) {
+		const GLubyte *pixel =
+			(const GLubyte *) region->pixels + offset;
+
+		for (i = 0; i < 4; i++)
+			probe[i] = pixel[i] / 255.0;
+	} else {
+		memcpy(probe, (const GLfloat *) region->pixels + offset,
+		       sizeof(probe));
 	}
 
-	free(pixels);
-	return 1;
+	return compare_pixel_float(x, y, num_components, expected, probe);
+}
+
+static bool
+region_probe_rect(const struct piglit_probe_region *region,
+		  int x, int y, int w, int h, int num_components,
+		  const float *expected)
+{
+	unsigned offset;
+
+	if (w <= 0 || h <= 0)
+		return true;
+
+	assert(region_contains(region, x, y, w, h));
+
+	offset = ((y - region->y) * region->w + (x - region->x)) * 4;
+	if (region->ubyte)
+		return compare_rect_ubyte(x, y, w, h, num_components, expected,
+					  (const GLubyte *) region->pixels +
+					  offset, region->w, false);
+	else
+		return compare_rect_float(x, y, w, h, num_components, expected,
+					  (const GLfloat *) region->pixels +
+					  offset, region->w);
+}
+
+int
+piglit_probe_region_pixel_rgb(const struct piglit_probe_region *region,
+			      int x, int y, const float *expected)
+{
+	return region_probe_pixel(region, x, y, 3, expected);
+}
+
+int
+piglit_probe_region_pixel_rgba(const struct piglit_probe_region *region,
+			       int x, int y, const float *expected)
+{
+	return region_probe_pixel(region, x, y, 4, expected);
+}
+
+int
+piglit_probe_region_rect_rgb(const struct piglit_probe_region *region,
+			     int x, int y, int w, int h, const float *expected)
+{
+	return region_probe_rect(region, x, y, w, h, 3, expected);
+}
+
+int
+piglit_probe_region_rect_rgba(const struct piglit_probe_region *region,
+			      int x, int y, int w, int h, const float *expected)
+{
+	return region_probe_rect(region, x, y, w, h, 4, expected);
 }
 
 int
@@ -1569,11 +2313,16 @@ piglit_compare_image_halves_color(int w, int h, int num_components,
 			    const float *tolerance,
 			    const float *image)
 {
+	const struct piglit_compare_kernels *kernels =
+		piglit_get_compare_kernels();
 	int i, j, half_width;
 
 	half_width = w/2;
 	for (j = 0; j < h; j++) {
-		for (i = 0; i < half_width; i++) {
+		i = kernels->images_float(&image[j*w*num_components],
+					  &image[(j*w+half_width)*num_components],
+					  half_width, tolerance, num_components);
+		for (; i < half_width; i++) {
 			const float *probe =
 				&image[(j*w+i)*num_components];
 			const float *expected =
@@ -1597,9 +2346,17 @@ piglit_compare_images_color(int x, int y, int w, int h, int num_components,
 			    const float *expected_image,
 			    const float *observed_image)
 {
-	int i, j, p;
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
+	const struct piglit_compare_kernels *kernels =
+		piglit_get_compare_kernels();
+	int i, j, p, first;
+
+	if (w <= 0 || h <= 0)
+		return 1;
+
+	first = kernels->images_float(observed_image, expected_image, w*h,
+				      tolerance, num_components);
+	for (j = first / w; j < h; j++) {
+		for (i = (j == first / w) ? first % w : 0; i < w; i++) {
 			const float *expected =
 				&expected_image[(j*w+i)*num_components];
 			const float *probe =
@@ -1615,6 +2372,13 @@ piglit_compare_images_color(int x, int y, int w, int h, int num_components,
 					print_pixel_float(probe, num_components);
 					printf("\n");
 
+					if (get_probe_stats_mode())
+						report_image_stats(
+							x, y, w, h,
+							num_components,
+							tolerance,
+							expected_image,
+							observed_image);
 					return 0;
 				}
 			}
@@ -154,6 +154,61 @@ int piglit_probe_rect_rgba_int(int x, int y, int w, int h, const int* expected);
 int piglit_probe_rect_rgba_uint(int x, int y, int w, int h, const unsigned int* expected);
 void piglit_compute_probe_tolerance(GLenum format, float *tolerance);
 
+/**
+ * Asynchronous readback through a ring of pixel pack buffers.
+ *
+ * piglit_readback_begin() queues a glReadPixels of the given area and
+ * returns at once, piglit_readback_map() waits for it and returns the
+ * pixels, piglit_readback_end() releases the slot.  This lets a test queue
+ * several readbacks and check them while the GPU keeps working.  The
+ * piglit_probe_* functions use the same path synchronously.  Readbacks
+ * are only asynchronous when PIGLIT_ASYNC_READBACK is set and the context
+ * supports PBOs, fences and glMapBufferRange; otherwise they are a plain
+ * glReadPixels.  piglit_readback_begin_async() doesn't depend on
+ * PIGLIT_ASYNC_READBACK.  The rows of the pixels are padded to
+ * GL_PACK_ALIGNMENT, the other pack parameters don't apply.
+ */
+struct piglit_readback;
+
+bool piglit_readback_can_async(void);
+bool piglit_readback_is_async(void);
+struct piglit_readback *piglit_readback_begin(int x, int y, int w, int h,
+					      GLenum format, GLenum type);
+struct piglit_readback *piglit_readback_begin_async(int x, int y, int w, int h,
+						    GLenum format,
+						    GLenum type);
+const void *piglit_readback_map(struct piglit_readback *readback);
+void piglit_readback_end(struct piglit_readback *readback);
+void piglit_readback_release(void);
+
+/**
+ * A block of the read buffer read back once, so that several probes can be
+ * checked against it on the CPU.  The piglit_probe_region_* functions
+ * behave and report like the corresponding piglit_probe_* functions, the
+ * probed area must lie inside the region.
+ */
+struct piglit_probe_region {
+	int x, y, w, h;
+	/** RGBA GL_UNSIGNED_BYTE pixels if true, RGBA GL_FLOAT otherwise. */
+	bool ubyte;
+	const void *pixels;
+	struct piglit_readback *readback;
+};
+
+void piglit_probe_region_read(struct piglit_probe_region *region,
+			      int x, int y, int w, int h, bool pixel_probes);
+void piglit_probe_region_free(struct piglit_probe_region *region);
+int piglit_probe_region_pixel_rgb(const struct piglit_probe_region *region,
+				  int x, int y, const float *expected);
+int piglit_probe_region_pixel_rgba(const struct piglit_probe_region *region,
+				   int x, int y, const float *expected);
+int piglit_probe_region_rect_rgb(const struct piglit_probe_region *region,
+				 int x, int y, int w, int h,
+				 const float *expected);
+int piglit_probe_region_rect_rgba(const struct piglit_probe_region *region,
+				  int x, int y, int w, int h,
+				  const float *expected);
+
 /**
  * Compare two pixels.
  * \param x the x coordinate of the pixel being probed
@@ -362,6 +417,14 @@ void
 piglit_write_png(const char *filename, GLenum base_format,
                  int width, int height, GLubyte *data, bool flip_y);
 
+void
+piglit_write_png_level(const char *filename, GLenum base_format,
+                       int width, int height, GLubyte *data, bool flip_y,
+                       int level);
+
+GLubyte *
+piglit_read_png(const char *filename, int *width, int *height, bool flip_y);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
@@ -53,14 +53,19 @@ _abortf(const char *s, ...)
  * \param height      The height of the image
  * \param data        The image data stored as unsigned bytes
  * \param flip_y      Whether to flip the image upside down (for FBO data)
+ * \param level       The zlib compression level, from 0 (none) to 9
+ *                    (best), or -1 for the libpng default.  Below level 3
+ *                    the rows aren't filtered either, which costs more
+ *                    time than it saves at those levels.
  */
 void
-piglit_write_png(const char *filename,
-		 GLenum base_format,
-		 int width,
-		 int height,
-		 GLubyte *data,
-		 bool flip_y)
+piglit_write_png_level(const char *filename,
+		       GLenum base_format,
+		       int width,
+		       int height,
+		       GLubyte *data,
+		       bool flip_y,
+		       int level)
 {
 #ifndef PIGLIT_HAS_PNG
 	aborts("Piglit not built with libpng support.");
@@ -112,6 +117,12 @@ piglit_write_png(const char *filename,
 		     8, color_type, PNG_INTERLACE_NONE,
 		     PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
+	if (level >= 0) {
+		png_set_compression_level(png, level);
+		if (level < 3)
+			png_set_filter(png, 0, PNG_FILTER_NONE);
+	}
+
 	png_write_info(png, info);
 
 	if (flip_y) {
@@ -129,7 +140,106 @@ piglit_write_png(const char *filename,
 	}
 
 	png_write_end(png, 0);
+	png_destroy_write_struct(&png, &info);
 
 	fclose(fp);
 #endif
 }
+
+/* Write a PNG file with the default compression level, see
+ * piglit_write_png_level().
+ */
+void
+piglit_write_png(const char *filename,
+		 GLenum base_format,
+		 int width,
+		 int height,
+		 GLubyte *data,
+		 bool flip_y)
+{
+	piglit_write_png_level(filename, base_format, width, height, data,
+			       flip_y, -1);
+}
+
+/* Read a PNG file as RGBA unsigned bytes.
+ *
+ * Any bit depth and color type is converted to 8-bit RGBA, with an opaque
+ * alpha if the file has none.
+ *
+ * \param filename The filename to read
+ * \param width    Set to the width of the image
+ * \param height   Set to the height of the image
+ * \param flip_y   Whether to flip the image upside down (for FBO data)
+ * \return         The image data, to be freed with free(), or NULL if the
+ *                 file can't be read or Piglit was built without libpng.
+ */
+GLubyte *
+piglit_read_png(const char *filename,
+		int *width,
+		int *height,
+		bool flip_y)
+{
+#ifndef PIGLIT_HAS_PNG
+	return NULL;
+#else
+	FILE *fp;
+	png_structp png;
+	png_infop info;
+	png_uint_32 w, h, y;
+	int passes, pass;
+	GLubyte *volatile data = NULL;
+
+	fp = fopen(filename, "rb");
+	if (!fp)
+		return NULL;
+
+	png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png) {
+		fclose(fp);
+		return NULL;
+	}
+
+	info = png_create_info_struct(png);
+	if (!info || setjmp(png_jmpbuf(png))) {
+		png_destroy_read_struct(&png, info ? &info : NULL, NULL);
+		free(data);
+		fclose(fp);
+		return NULL;
+	}
+
+	png_init_io(png, fp);
+	png_read_info(png, info);
+
+	png_set_expand(png);
+	png_set_strip_16(png);
+	png_set_gray_to_rgb(png);
+	png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+	passes = png_set_interlace_handling(png);
+	png_read_update_info(png, info);
+
+	w = png_get_image_width(png, info);
+	h = png_get_image_height(png, info);
+	if (png_get_rowbytes(png, info) != w * 4)
+		png_error(png, "unexpected row size");
+
+	data = malloc(w * h * 4);
+	if (!data)
+		png_error(png, "out of memory");
+
+	for (pass = 0; pass < passes; pass++) {
+		for (y = 0; y < h; y++) {
+			png_read_row(png,
+				     data + (flip_y ? h - 1 - y : y) * w * 4,
+				     NULL);
+		}
+	}
+
+	png_read_end(png, NULL);
+	png_destroy_read_struct(&png, &info, NULL);
+	fclose(fp);
+
+	*width = w;
+	*height = h;
+	return data;
+#endif
+}
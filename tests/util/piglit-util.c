@@ -219,6 +219,127 @@ bool piglit_is_extension_in_string(const char *haystack, const char *needle)
 	return false;
 }
 
+struct piglit_extension_set {
+	/** Number of slots minus one; the slot count is a power of two. */
+	unsigned mask;
+	const char **slots;
+	uint32_t *hashes;
+	/** Copies of the extension names, pointed to by \c slots. */
+	char *names;
+};
+
+static uint32_t
+extension_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (unsigned char) *name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Build a hash set from the NULL-terminated array \a names.  The names are
+ * copied, so the array may be freed afterwards.
+ */
+struct piglit_extension_set *
+piglit_extension_set_create(const char **names)
+{
+	struct piglit_extension_set *set;
+	size_t length = 0;
+	unsigned count = 0, size = 16, i;
+	char *dst;
+
+	for (i = 0; names && names[i]; i++) {
+		length += strlen(names[i]) + 1;
+		count++;
+	}
+
+	/* Keep the table at most half full so probe runs stay short. */
+	while (size < count * 2)
+		size *= 2;
+
+	set = malloc(sizeof(*set));
+	assert(set != NULL);
+	set->mask = size - 1;
+	set->slots = calloc(size, sizeof(*set->slots));
+	set->hashes = calloc(size, sizeof(*set->hashes));
+	set->names = malloc(length + 1);
+	assert(set->slots != NULL && set->hashes != NULL &&
+	       set->names != NULL);
+
+	dst = set->names;
+	for (i = 0; i < count; i++) {
+		const uint32_t hash = extension_hash(names[i]);
+		unsigned slot = hash & set->mask;
+
+		if (names[i][0] == '\0' ||
+		    piglit_extension_set_contains(set, names[i]))
+			continue;
+
+		while (set->slots[slot] != NULL)
+			slot = (slot + 1) & set->mask;
+
+		strcpy(dst, names[i]);
+		set->slots[slot] = dst;
+		set->hashes[slot] = hash;
+		dst += strlen(dst) + 1;
+	}
+
+	return set;
+}
+
+/**
+ * Build a hash set from a space-separated extension string, as returned by
+ * glGetString(GL_EXTENSIONS) and friends.  A NULL string gives an empty set.
+ */
+struct piglit_extension_set *
+piglit_extension_set_create_from_string(const char *string)
+{
+	struct piglit_extension_set *set;
+	const char **names;
+
+	if (string == NULL)
+		return piglit_extension_set_create(NULL);
+
+	names = piglit_split_string_to_array(string, " ");
+	set = piglit_extension_set_create(names);
+	free(names);
+
+	return set;
+}
+
+bool
+piglit_extension_set_contains(const struct piglit_extension_set *set,
+			      const char *name)
+{
+	const uint32_t hash = extension_hash(name);
+	unsigned slot = hash & set->mask;
+
+	while (set->slots[slot] != NULL) {
+		if (set->hashes[slot] == hash &&
+		    strcmp(set->slots[slot], name) == 0)
+			return true;
+		slot = (slot + 1) & set->mask;
+	}
+
+	return false;
+}
+
+void
+piglit_extension_set_destroy(struct piglit_extension_set *set)
+{
+	if (set == NULL)
+		return;
+
+	free(set->slots);
+	free(set->hashes);
+	free(set->names);
+	free(set);
+}
+
 /** Returns the line in the program string given the character position. */
 int piglit_find_line(const char *program, int position)
 {
@@ -244,10 +365,25 @@ piglit_result_to_string(enum piglit_result result)
         return "Unknown result";
 }
 
+static void (*report_result_hook)(void);
+
+void
+piglit_set_report_result_hook(void (*hook)(void))
+{
+	report_result_hook = hook;
+}
+
 void
 piglit_report_result(enum piglit_result result)
 {
 	const char *result_str = piglit_result_to_string(result);
+	void (*hook)(void) = report_result_hook;
+
+	/* Outside of the lock, so that the hook may fail the test itself */
+	if (hook) {
+		report_result_hook = NULL;
+		hook();
+	}
 
 #ifdef PIGLIT_HAS_POSIX_TIMER_NOTIFY_THREAD
 	/* Ensure we only report one result in case we race with timeout */
@@ -316,6 +452,21 @@ piglit_report_subtest_result(enum piglit_result result, const char *format, ...)
 	va_end(ap);
 }
 
+void
+piglit_print_json_string(const char *s)
+{
+	putchar('"');
+	for (; s != NULL && *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			printf("\\u%04x", (unsigned char)*s);
+		else
+			putchar(*s);
+	}
+	putchar('"');
+}
+
 
 void
 piglit_disable_error_message_boxes(void)
@@ -406,14 +406,42 @@ bool piglit_is_extension_in_string(const char *haystack, const char *needle);
  */
 bool piglit_is_extension_in_array(const char **haystack, const char *needle);
 
+/**
+ * A set of extension names with constant-time lookup, for code that asks
+ * about many extensions of the same context, display or device.
+ *
+ * \sa piglit_is_extension_supported
+ */
+struct piglit_extension_set;
+
+struct piglit_extension_set *
+piglit_extension_set_create(const char **names);
+struct piglit_extension_set *
+piglit_extension_set_create_from_string(const char *string);
+bool piglit_extension_set_contains(const struct piglit_extension_set *set,
+				   const char *name);
+void piglit_extension_set_destroy(struct piglit_extension_set *set);
+
 int piglit_find_line(const char *program, int position);
 void piglit_merge_result(enum piglit_result *all, enum piglit_result subtest);
 const char * piglit_result_to_string(enum piglit_result result);
 NORETURN void piglit_report_result(enum piglit_result result);
+
+/**
+ * Set a function that piglit_report_result() calls before it prints the
+ * result, to finish work the result depends on.  It runs at most once.
+ */
+void piglit_set_report_result_hook(void (*hook)(void));
 void piglit_set_timeout(double seconds, enum piglit_result timeout_result);
 void piglit_report_subtest_result(enum piglit_result result,
 				  const char *format, ...) PRINTFLIKE(2, 3);
 
+/**
+ * Print \p s to stdout as a quoted JSON string, for the values of
+ * PIGLIT: {...} records.  NULL prints an empty string.
+ */
+void piglit_print_json_string(const char *s);
+
 void piglit_disable_error_message_boxes(void);
 
 extern void piglit_set_rlimit(unsigned long lim);
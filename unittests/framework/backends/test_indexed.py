@@ -0,0 +1,212 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the indexed results backend."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import copy
+import os
+import pickle
+
+import pytest
+import six
+
+from framework import backends
+from framework import exceptions
+from framework import grouptools
+from framework import results
+
+from . import shared
+
+# pylint: disable=no-self-use,protected-access
+
+
+def _write(tmpdir):
+    """Write indexed results of two tests into tmpdir."""
+    meta = copy.deepcopy(shared.INITIAL_METADATA)
+    meta['time_elapsed'] = results.TimeAttribute(start=1.0, end=2.0)
+
+    first = results.TestResult('pass')
+    first.out = 'out of first'
+    first.err = 'err of first'
+    first.command = 'first -auto'
+    second = results.TestResult('fail')
+    second.subtests['sub'] = 'pass'
+    second.dmesg = 'dmesg of second'
+
+    backends.indexed.write_results(
+        six.text_type(tmpdir), meta,
+        [(grouptools.join('a', 'first'), first),
+         (grouptools.join('a', 'second'), second.to_json())])
+
+
+class TestIndexedBackend(object):
+    """Tests for the IndexedBackend class."""
+
+    @pytest.fixture(autouse=True)
+    def setup(self, tmpdir):
+        test = backends.indexed.IndexedBackend(six.text_type(tmpdir))
+        test.initialize(shared.INITIAL_METADATA)
+        result = results.TestResult('pass')
+        result.out = 'some output'
+        with test.write_test('test1') as t:
+            t(result)
+        test.finalize(
+            {'time_elapsed':
+                results.TimeAttribute(start=0.0, end=1.0).to_json()})
+
+    def test_temporary_files_removed(self, tmpdir):
+        assert not tmpdir.join('metadata.json').check()
+        assert not tmpdir.join('tests').check()
+
+    def test_files_created(self, tmpdir):
+        assert tmpdir.join(backends.indexed.INDEX).check()
+        assert tmpdir.join(backends.indexed.BLOBS).check()
+
+    def test_load(self, tmpdir):
+        res = backends.load(six.text_type(tmpdir))
+        assert res.tests['test1'].result == 'pass'
+        assert res.tests['test1'].out == 'some output'
+        assert res.time_elapsed.end == 1.0
+
+
+class TestLoadResults(object):
+    """Tests for the load_results function."""
+
+    def test_status(self, tmpdir):
+        """backends.indexed.load_results: loads the status of the tests and
+        the metadata.
+        """
+        _write(tmpdir)
+        res = backends.indexed.load_results(six.text_type(tmpdir), 'none')
+
+        assert res.name == 'name'
+        assert res.time_elapsed.end == 2.0
+        assert res.tests[grouptools.join('a', 'first')].result == 'pass'
+        assert res.tests[grouptools.join('a', 'second')].subtests == \
+            {'sub': 'pass'}
+        assert res.totals['root']['pass'] == 2
+
+    def test_blobs_not_read(self, tmpdir, mocker):
+        """backends.indexed.load_results: doesn't read the blobs of tests
+        whose output isn't used.
+        """
+        _write(tmpdir)
+        read = mocker.spy(backends.indexed._BlobFile, 'read')
+        res = backends.indexed.load_results(six.text_type(tmpdir), 'none')
+
+        assert res.tests[grouptools.join('a', 'second')].result == 'pass'
+        assert read.call_count == 0
+
+        assert res.tests[grouptools.join('a', 'first')].err == 'err of first'
+        assert read.call_count == 1
+
+    def test_blob_fields(self, tmpdir):
+        """backends.indexed.load_results: loads the fields in the blobs."""
+        _write(tmpdir)
+        res = backends.indexed.load_results(six.text_type(tmpdir), 'none')
+        first = res.tests[grouptools.join('a', 'first')]
+        second = res.tests[grouptools.join('a', 'second')]
+
+        assert first.out == 'out of first'
+        assert first.command == 'first -auto'
+        assert second.dmesg == 'dmesg of second'
+        assert second.out == ''
+
+    def test_set_before_load(self, tmpdir):
+        """backends.indexed.load_results: a field set before the blob is read
+        keeps its value.
+        """
+        _write(tmpdir)
+        res = backends.indexed.load_results(six.text_type(tmpdir), 'none')
+        first = res.tests[grouptools.join('a', 'first')]
+        first.out = 'new'
+
+        assert first.out == 'new'
+        assert first.err == 'err of first'
+
+    def test_to_json(self, tmpdir):
+        """backends.indexed.load_results: results convert back to the same
+        json as before they were written.
+        """
+        _write(tmpdir)
+        res = backends.indexed.load_results(six.text_type(tmpdir), 'none')
+        first = res.tests[grouptools.join('a', 'first')].to_json()
+
+        assert first['out'] == 'out of first'
+        assert first['result'] == 'pass'
+
+    def test_pickle(self, tmpdir):
+        """backends.indexed.load_results: results can be pickled, with their
+        blob.
+        """
+        _write(tmpdir)
+        res = backends.indexed.load_results(six.text_type(tmpdir), 'none')
+        first = pickle.loads(pickle.dumps(
+            res.tests[grouptools.join('a', 'first')]))
+
+        assert first.result == 'pass'
+        assert first.out == 'out of first'
+        assert first.command == 'first -auto'
+
+    def test_not_an_index(self, tmpdir):
+        """backends.indexed.load_results: raises an error for a file that is
+        not an index.
+        """
+        tmpdir.join(backends.indexed.INDEX).write('{"foo": "bar"}\n')
+        with pytest.raises(exceptions.PiglitFatalError):
+            backends.indexed.load_results(six.text_type(tmpdir), 'none')
+
+
+class TestLoad(object):
+    """Tests for loading a directory with an index with backends.load."""
+
+    def test_prefers_index(self, tmpdir):
+        """backends.load: uses the index rather than the results it was
+        written from.
+        """
+        tmpdir.join('results.json').write('not json')
+        os.utime(six.text_type(tmpdir.join('results.json')), (1, 1))
+        _write(tmpdir)
+
+        assert isinstance(backends.load(six.text_type(tmpdir)),
+                          results.TestrunResult)
+
+    def test_stale_index(self, tmpdir):
+        """backends.load: doesn't use an index older than the results."""
+        _write(tmpdir)
+        os.utime(six.text_type(tmpdir.join(backends.indexed.INDEX)), (1, 1))
+        tmpdir.join('results.json').write('not json')
+
+        with pytest.raises(exceptions.PiglitFatalError):
+            backends.load(six.text_type(tmpdir))
+
+    def test_results_file(self, tmpdir):
+        """backends.load: loads a results file as given, even with a newer
+        index next to it.
+        """
+        tmpdir.join('results.json').write('not json')
+        os.utime(six.text_type(tmpdir.join('results.json')), (1, 1))
+        _write(tmpdir)
+
+        with pytest.raises(exceptions.PiglitFatalError):
+            backends.load(six.text_type(tmpdir.join('results.json')))
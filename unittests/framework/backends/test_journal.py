@@ -0,0 +1,107 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the journal module."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+
+import six
+
+from framework.backends import journal
+
+# pylint: disable=no-self-use,protected-access
+
+
+class TestJournal(object):
+    """Tests for the Journal class and read_records."""
+
+    def test_roundtrip(self, tmpdir):
+        """Records are read back in the order they were appended."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p)
+        j.append('foo')
+        j.append('bär')
+        j.close()
+
+        assert list(journal.read_records(p)) == ['foo', 'bär']
+
+    def test_torn_record(self, tmpdir):
+        """A record that was cut short is ignored."""
+        p = tmpdir.join('journal')
+        j = journal.Journal(six.text_type(p))
+        j.append('foo')
+        j.append('bar')
+        j.close()
+        p.write_binary(p.read_binary()[:-1])
+
+        assert list(journal.read_records(six.text_type(p))) == ['foo']
+
+    def test_corrupt_record(self, tmpdir):
+        """A record with a bad checksum and the records after it are
+        ignored.
+        """
+        p = tmpdir.join('journal')
+        j = journal.Journal(six.text_type(p))
+        j.append('foo')
+        j.append('bar')
+        j.append('baz')
+        j.close()
+        data = bytearray(p.read_binary())
+        data[2 * journal._HEADER.size + 4] ^= 0xff
+        p.write_binary(bytes(data))
+
+        assert list(journal.read_records(six.text_type(p))) == ['foo']
+
+    def test_reopen_truncates(self, tmpdir):
+        """Reopening a journal drops a torn record before appending."""
+        p = tmpdir.join('journal')
+        j = journal.Journal(six.text_type(p))
+        j.append('foo')
+        j.append('bar')
+        j.close()
+        p.write_binary(p.read_binary()[:-1])
+
+        j = journal.Journal(six.text_type(p))
+        j.append('baz')
+        j.close()
+
+        assert list(journal.read_records(six.text_type(p))) == ['foo', 'baz']
+
+    def test_grouped_sync(self, tmpdir, mocker):
+        """Records are synced in groups, not one at a time."""
+        fsync = mocker.patch('framework.backends.journal.os.fsync')
+        j = journal.Journal(six.text_type(tmpdir.join('journal')), sync=True,
+                            sync_records=10, sync_interval=60)
+        for i in range(20):
+            j.append(six.text_type(i))
+        j.close()
+
+        assert 1 <= fsync.call_count <= 3
+
+    def test_no_sync(self, tmpdir, mocker):
+        """Nothing is synced when syncing is disabled."""
+        fsync = mocker.patch('framework.backends.journal.os.fsync')
+        j = journal.Journal(six.text_type(tmpdir.join('journal')))
+        j.append('foo')
+        j.close()
+
+        assert fsync.call_count == 0
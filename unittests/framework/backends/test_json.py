@@ -81,7 +81,7 @@ class TestJSONBackend(object):
             with test.write_test('bar') as t:
                 t(results.TestResult())
 
-            assert tmpdir.join('tests/0.json').check()
+            assert tmpdir.join('tests', backends.json.JOURNAL).check()
 
         def test_load(self, tmpdir):
             """Test that the written JSON can be loaded.
@@ -97,8 +97,9 @@ class TestJSONBackend(object):
             with test.write_test('bar') as t:
                 t(results.TestResult())
 
-            with tmpdir.join('tests/0.json').open('r') as f:
-                json.load(f)
+            for record in backends.journal.read_records(
+                    six.text_type(tmpdir.join('tests', backends.json.JOURNAL))):
+                json.loads(record)
 
     class TestFinalize(object):
         """Tests for the finalize method."""
@@ -236,6 +237,50 @@ class TestResume(object):
         assert set(test.tests.keys()) == \
             {'group1/test1', 'group1/test2', 'group2/test3', 'group2/test4'}
 
+    def test_load_final_result(self, tmpdir):
+        """backends.json._resume: the final record of a test replaces its
+        incomplete one.
+        """
+        f = six.text_type(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        with backend.write_test("group1/test1") as t:
+            t(results.TestResult('pass'))
+        test = backends.json._resume(f)
+
+        assert test.tests['group1/test1'].result == 'pass'
+
+    def test_load_torn_journal(self, tmpdir):
+        """backends.json._resume: ignores a record that was cut short."""
+        f = six.text_type(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        with backend.write_test("group1/test1") as t:
+            t(results.TestResult('pass'))
+        with backend.write_test("group1/test2") as t:
+            t(results.TestResult('fail'))
+
+        journal = tmpdir.join('tests', backends.json.JOURNAL)
+        journal.write_binary(journal.read_binary()[:-5])
+        test = backends.json._resume(f)
+
+        assert test.tests['group1/test1'].result == 'pass'
+        assert test.tests['group1/test2'].result == 'incomplete'
+
+    def test_legacy_test_files(self, tmpdir):
+        """backends.json._resume: loads the per-test files of older runs."""
+        f = six.text_type(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        with open(os.path.join(f, 'tests', '0.json'), 'w') as w:
+            json.dump({'group1/test1': results.TestResult('pass')}, w,
+                      default=backends.json.piglit_encoder)
+        with backend.write_test("group1/test2") as t:
+            t(results.TestResult('fail'))
+        test = backends.json._resume(f)
+
+        assert set(test.tests.keys()) == {'group1/test1', 'group1/test2'}
+
 
 class TestLoadResults(object):
     """Tests for the load_results function."""
@@ -216,6 +216,27 @@ class TestJUnitWriter(object):
         assert test_value.find('.//testcase').attrib['classname'] == \
             'piglit.a.group'
 
+    def test_rusage_roundtrip(self, tmpdir):
+        """backends.junit.JUnitBackend.write_test: rusage is written to
+        system-err, and loaded back.
+        """
+        result = results.TestResult()
+        result.time.end = 1.2345
+        result.result = 'pass'
+        result.command = 'foo'
+        result.rusage = results.RusageAttribute(utime=0.5, maxrss=2048,
+                                                nvcsw=3)
+
+        test = backends.junit.JUnitBackend(six.text_type(tmpdir))
+        test.initialize(shared.INITIAL_METADATA)
+        with test.write_test(grouptools.join('a', 'group', 'test1')) as t:
+            t(result)
+        test.finalize()
+
+        loaded = backends.junit.load(six.text_type(tmpdir), 'none')
+        rusage = loaded.tests[grouptools.join('a', 'group', 'test1')].rusage
+        assert rusage.to_json() == result.rusage.to_json()
+
     class TestValid(object):
         @pytest.fixture
         def test_file(self, tmpdir):
@@ -59,6 +59,7 @@ class TestGetBackend(object):
     @pytest.mark.parametrize("name,expected", [
         ('json', backends.json.JSONBackend),
         ('junit', backends.junit.JUnitBackend),
+        ('indexed', backends.indexed.IndexedBackend),
     ])
     def test_basic(self, name, expected):
         """Test that ensures the expected input and output."""
@@ -0,0 +1,98 @@
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the framework.programs.merge module."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+
+import pytest
+
+from framework import exceptions
+from framework import results
+from framework.programs import merge
+
+# pylint: disable=no-self-use
+
+
+def _shard(index, tests, count=2, total=4, digest='abc', expected=None):
+    """Create the TestrunResult of a shard."""
+    run = results.TestrunResult()
+    run.name = 'shard{}'.format(index)
+    run.options = {'shard': {'index': index, 'count': count, 'total': total,
+                             'tests': len(tests) if expected is None
+                                      else expected,
+                             'digest': digest}}
+    run.time_elapsed = results.TimeAttribute(index, index + 10)
+    for name in tests:
+        run.tests[name] = results.TestResult('pass')
+    return run
+
+
+class TestMerge(object):
+    """Tests for merge.merge."""
+
+    def test_merge(self):
+        """All of the tests of all of the shards are merged."""
+        merged = merge.merge([_shard(2, ['c', 'd']), _shard(1, ['a', 'b'])])
+
+        assert list(merged.tests) == ['a', 'b', 'c', 'd']
+        assert merged.totals['root']['pass'] == 4
+        assert merged.time_elapsed.start == 1
+        assert merged.time_elapsed.end == 12
+        assert merged.options['shard'] is None
+
+    def test_not_sharded(self):
+        """Results that are not from a sharded run are rejected."""
+        run = _shard(1, ['a', 'b'])
+        run.options['shard'] = None
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge([run, _shard(2, ['c', 'd'])])
+
+    def test_different_runs(self):
+        """Shards of different test lists are rejected."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge([_shard(1, ['a', 'b']),
+                         _shard(2, ['c', 'd'], digest='def')])
+
+    def test_shard_twice(self):
+        """The same shard given twice is rejected."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge([_shard(1, ['a', 'b']), _shard(1, ['a', 'b'])])
+
+    def test_duplicate_test(self):
+        """A test in more than one shard is rejected."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge([_shard(1, ['a', 'b']), _shard(2, ['b', 'c'])])
+
+    def test_missing_shard(self):
+        """A missing shard is an error, unless allow_missing is set."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge([_shard(1, ['a', 'b'])])
+
+        merged = merge.merge([_shard(1, ['a', 'b'])], allow_missing=True)
+        assert list(merged.tests) == ['a', 'b']
+
+    def test_missing_tests(self):
+        """A shard with fewer tests than it was given is an error."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge([_shard(1, ['a'], expected=2),
+                         _shard(2, ['c', 'd'])])
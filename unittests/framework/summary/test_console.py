@@ -141,3 +141,169 @@ class TestPrintResult(object):
         actual, _ = capsys.readouterr()
 
         assert expected == actual
+
+
+class TestPrintResources(object):
+    """Tests for the _print_resources function."""
+
+    @staticmethod
+    def make_run(values):
+        res = results.TestrunResult()
+        for name, utime in six.iteritems(values):
+            res.tests[name] = results.TestResult('pass')
+            if utime is not None:
+                res.tests[name].rusage = results.RusageAttribute(
+                    utime=utime, maxrss=int(utime * 100))
+        return res
+
+    def test_ranks_and_compares(self, capsys):
+        """summary.console_._print_resources: ranks tests by their largest
+        value, and prints the change from the first run to the last.
+        """
+        reses = common.Results([
+            self.make_run({'a': 1.0, grouptools.join('b', 'c'): 2.0}),
+            self.make_run({'a': 3.0, grouptools.join('b', 'c'): 2.0}),
+        ])
+
+        console_._print_resources(reses, 10)
+        actual = capsys.readouterr()[0].splitlines()
+
+        assert actual[:4] == [
+            'user time (s):',
+            '    total: 3.000 5.000 (+67%)',
+            '    a: 1.000 3.000 (+200%)',
+            '    b/c: 2.000 2.000 (+0%)',
+        ]
+        assert '    total: 200 300 (+50%)' in actual
+
+    def test_top(self, capsys):
+        """summary.console_._print_resources: only prints the top tests."""
+        reses = common.Results([self.make_run({'a': 1.0, 'b': 2.0})])
+
+        console_._print_resources(reses, 1)
+        actual = capsys.readouterr()[0].splitlines()
+
+        assert actual[:3] == ['user time (s):', '    total: 3.000', '    b: 2.000']
+
+    def test_missing(self, capsys):
+        """summary.console_._print_resources: prints - for tests without
+        resource usage in a run.
+        """
+        reses = common.Results([
+            self.make_run({'a': None}),
+            self.make_run({'a': 1.0}),
+        ])
+
+        console_._print_resources(reses, 10)
+        actual = capsys.readouterr()[0].splitlines()
+
+        assert actual[:3] == ['user time (s):', '    total: - 1.000',
+                              '    a: - 1.000']
+
+
+class TestPrintPerf(object):
+    """Tests for the _print_perf function."""
+
+    @staticmethod
+    def make_run(records):
+        res = results.TestrunResult()
+        for name, perf in six.iteritems(records):
+            res.tests[name] = results.TestResult('pass')
+            res.tests[name].perf = perf
+        return res
+
+    @staticmethod
+    def record(median, ci95=None):
+        stats = {'median': median, 'min': median}
+        if ci95 is not None:
+            stats['median_ci95'] = ci95
+        return {'name': 'draw', 'ns_per_iteration': stats}
+
+    def test_compares(self, capsys):
+        """summary.console_._print_perf: prints the change of each median
+        and counts the regressions and improvements.
+        """
+        reses = common.Results([
+            self.make_run({'a': [self.record(100.0)],
+                           'b': [self.record(100.0)]}),
+            self.make_run({'a': [self.record(110.0)],
+                           'b': [self.record(80.0)]}),
+        ])
+
+        assert console_._print_perf(reses, 5.0) == 1
+        assert capsys.readouterr()[0].splitlines() == [
+            'a:',
+            '    draw ns_per_iteration.median: 100.000 110.000 (+10.0%) '
+            'regression',
+            'b:',
+            '    draw ns_per_iteration.median: 100.000 80.000 (-20.0%) '
+            'improvement',
+            'perf regressions: 1, improvements: 1 (threshold 5%)',
+        ]
+
+    def test_threshold(self, capsys):
+        """summary.console_._print_perf: changes below the threshold are not
+        regressions.
+        """
+        reses = common.Results([
+            self.make_run({'a': [self.record(100.0)]}),
+            self.make_run({'a': [self.record(110.0)]}),
+        ])
+
+        assert console_._print_perf(reses, 20.0) == 0
+        assert capsys.readouterr()[0].splitlines()[1] == \
+            '    draw ns_per_iteration.median: 100.000 110.000 (+10.0%)'
+
+    def test_overlapping_intervals(self, capsys):
+        """summary.console_._print_perf: changes within the confidence
+        intervals are not regressions.
+        """
+        reses = common.Results([
+            self.make_run({'a': [self.record(100.0, [90.0, 120.0])]}),
+            self.make_run({'a': [self.record(110.0, [100.0, 130.0])]}),
+        ])
+
+        assert console_._print_perf(reses, 5.0) == 0
+        capsys.readouterr()
+
+    def test_mean_interval(self, capsys):
+        """summary.console_._print_perf: the confidence intervals of the
+        mean don't hide a change of the median.
+        """
+        first, last = self.record(100.0), self.record(110.0)
+        first['ns_per_iteration']['ci95'] = [90.0, 120.0]
+        last['ns_per_iteration']['ci95'] = [100.0, 130.0]
+        reses = common.Results([
+            self.make_run({'a': [first]}),
+            self.make_run({'a': [last]}),
+        ])
+
+        assert console_._print_perf(reses, 5.0) == 1
+        capsys.readouterr()
+
+    def test_cl_records(self, capsys):
+        """summary.console_._print_perf: finds the nested medians of
+        cl-program-tester records.
+        """
+        record = {'file': 'f.cl', 'test': 't', 'runs': 3,
+                  'kernel': {'duration_ns': {'min': 5, 'median': 7}}}
+        reses = common.Results([self.make_run({'a': [record]})])
+
+        assert console_._print_perf(reses, 5.0) == 0
+        assert capsys.readouterr()[0].splitlines() == [
+            'a:',
+            '    t kernel.duration_ns.median: 7.000',
+        ]
+
+    def test_missing(self, capsys):
+        """summary.console_._print_perf: prints - for runs without the
+        record.
+        """
+        reses = common.Results([
+            self.make_run({'a': []}),
+            self.make_run({'a': [self.record(100.0)]}),
+        ])
+
+        assert console_._print_perf(reses, 5.0) == 0
+        assert capsys.readouterr()[0].splitlines()[1] == \
+            '    draw ns_per_iteration.median: - 100.000'
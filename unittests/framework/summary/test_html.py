@@ -27,9 +27,11 @@ from __future__ import (
 )
 import os
 
+import pytest
 import six
 
-from framework.summary import html_
+from framework import exceptions, grouptools, results
+from framework.summary import common, html_
 
 
 def test_copy_static(tmpdir):
@@ -38,3 +40,99 @@ def test_copy_static(tmpdir):
     html_._copy_static_files(six.text_type(tmpdir))
     assert os.path.exists('index.css'), 'index.css not created correctly'
     assert os.path.exists('result.css'), 'result.css not created correctly'
+
+
+def _make_results(outputs, name='run'):
+    """Return a Results of one run, with a test per item of outputs."""
+    run = results.TestrunResult()
+    run.name = name
+    for test, out in six.iteritems(outputs):
+        run.tests[test] = results.TestResult('pass')
+        run.tests[test].out = out
+    run.calculate_group_totals()
+    return common.Results([run])
+
+
+class TestMakeTestrunInfo(object):
+    """Tests for the _make_testrun_info function."""
+
+    tests = {grouptools.join('a', 'b'): 'b', grouptools.join('a', 'c'): 'c',
+             'd': 'd'}
+
+    def test_pages(self, tmpdir):
+        """summary.html_._make_testrun_info: writes a page per test and
+        returns their links.
+        """
+        hrefs = html_._make_testrun_info(_make_results(self.tests),
+                                         six.text_type(tmpdir))
+
+        assert tmpdir.join('run', 'a@b.html').check()
+        assert hrefs['run']['d'] == 'run/d.html'
+        assert tmpdir.join('manifest.json').check()
+
+    def test_jobs(self, tmpdir):
+        """summary.html_._make_testrun_info: writes the same pages with a
+        pool of processes.
+        """
+        html_._make_testrun_info(_make_results(self.tests),
+                                 six.text_type(tmpdir.join('serial')))
+        html_._make_testrun_info(_make_results(self.tests),
+                                 six.text_type(tmpdir.join('pool')), jobs=2)
+
+        for test in self.tests:
+            assert (tmpdir.join('serial', 'run', test + '.html').read() ==
+                    tmpdir.join('pool', 'run', test + '.html').read())
+
+    def test_incremental(self, tmpdir):
+        """summary.html_._make_testrun_info: only writes the pages that
+        changed with incremental.
+        """
+        html_._make_testrun_info(_make_results(self.tests),
+                                 six.text_type(tmpdir))
+        tmpdir.join('run', 'a@b.html').write('unchanged')
+        tmpdir.join('run', 'a@c.html').write('changed')
+
+        tests = dict(self.tests)
+        tests[grouptools.join('a', 'c')] = 'new output'
+        html_._make_testrun_info(_make_results(tests), six.text_type(tmpdir),
+                                 incremental=True)
+
+        assert tmpdir.join('run', 'a@b.html').read() == 'unchanged'
+        assert 'new output' in tmpdir.join('run', 'a@c.html').read()
+
+    def test_incremental_removes(self, tmpdir):
+        """summary.html_._make_testrun_info: removes the pages of tests that
+        are gone with incremental.
+        """
+        html_._make_testrun_info(_make_results(self.tests),
+                                 six.text_type(tmpdir))
+
+        tests = dict(self.tests)
+        del tests['d']
+        html_._make_testrun_info(_make_results(tests), six.text_type(tmpdir),
+                                 incremental=True)
+
+        assert not tmpdir.join('run', 'd.html').check()
+
+    def test_group_pages(self, tmpdir):
+        """summary.html_._make_testrun_info: writes the tests of a group
+        into pages of page_size tests.
+        """
+        hrefs = html_._make_testrun_info(_make_results(self.tests),
+                                         six.text_type(tmpdir), page_size=1)
+
+        assert hrefs['run'][grouptools.join('a', 'c')] == 'run/a.2.html#a@c'
+        assert hrefs['run']['d'] == 'run/root.1.html#d'
+        page = tmpdir.join('run', 'a.1.html').read()
+        assert 'id="a@b"' in page
+        assert 'a.2.html' in page
+        assert not tmpdir.join('run', 'a@b.html').check()
+
+    def test_duplicate_names(self, tmpdir):
+        """summary.html_._make_testrun_info: raises an error for results with
+        the same name.
+        """
+        res = _make_results(self.tests)
+        res.results.append(res.results[0])
+        with pytest.raises(exceptions.PiglitFatalError):
+            html_._make_testrun_info(res, six.text_type(tmpdir))
@@ -24,6 +24,7 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import os
+import sys
 import textwrap
 try:
     import subprocess32 as subprocess
@@ -195,6 +196,30 @@ class TestTest(object):
             test.run()
             assert test.result.result is status.TIMEOUT
 
+        @pytest.mark.skipif(not hasattr(os, 'wait4'),
+                            reason='Requires os.wait4')
+        def test_rusage(self):
+            """test.base.Test: collects the resource usage of the process."""
+            test = _Test([sys.executable, '-c',
+                          'sum(range(1000000)); x = [0] * 10000000'])
+            test.run()
+
+            assert test.result.rusage is not None
+            assert test.result.rusage.utime > 0
+            # 10 million pointers take 80MB on 64 bit
+            assert test.result.rusage.maxrss > 40000
+
+        @pytest.mark.skipif(not hasattr(os, 'wait4'),
+                            reason='Requires os.wait4')
+        def test_rusage_sums_processes(self):
+            """test.base.Test: sums the resource usage of all processes."""
+            test = _Test([sys.executable, '-c', 'sum(range(1000000))'])
+            test.run()
+            first = test.result.rusage.minflt
+            test.run()
+
+            assert test.result.rusage.minflt > first
+
     class TestExecuteTraceback(object):
         """Test.execute tests for Traceback handling."""
 
@@ -403,6 +403,17 @@ class TestGLSLParserTestSkipRequirements(object):
         assert glsl.GLSLParserTest(six.text_type(p)).gl_required == \
             {'GL_ARB_foo'}
 
+    def test_config_from_index(self, tmpdir):
+        """A config that is passed in is used without reading the file."""
+        p = tmpdir.join('test.frag')
+        self.write_config(p, extra="require_extensions: GL_ARB_foo")
+        config = dict(glsl.Parser(six.text_type(p)).config)
+        p.remove()
+
+        test = glsl.GLSLParserTest(six.text_type(p), config)
+        assert test.glsl_version == 4.3
+        assert test.gl_required == {'GL_ARB_foo'}
+
 
 def test_skip_desktop_without_binary(tmpdir, mocker):
     """There is no way to run desktop tests with only GLES compiled make sure
@@ -481,3 +492,68 @@ def test_add_compatibility_requirement_binary(version, extension, tmpdir,
     # The compat extension was added to the slow skipping (C level)
     # requirements
     assert extension in test.command
+
+
+class TestMultiGLSLParserTest(object):
+    """Tests for the MultiGLSLParserTest class."""
+
+    @pytest.fixture
+    def inst(self, tmpdir):
+        """A fixture that creates an instance to test."""
+        one = tmpdir.join('foo.vert')
+        one.write(textwrap.dedent("""\
+            /* [config]
+             * expect_result: pass
+             * glsl_version: 1.10
+             * check_link: true
+             * [end config]
+             */"""))
+        two = tmpdir.join('bar.frag')
+        two.write(textwrap.dedent("""\
+            /* [config]
+             * expect_result: fail
+             * glsl_version: 1.30
+             * require_extensions: GL_ARB_foo
+             * [end config]
+             */"""))
+
+        return glsl.MultiGLSLParserTest(
+            [six.text_type(one), six.text_type(two)])
+
+    def test_command(self, inst):
+        assert os.path.basename(inst.command[0]) == 'glslparsertest'
+        assert os.path.basename(inst.command[1]) == 'foo.vert'
+        assert inst.command[2:5] == ['pass', '1.10', '--check-link']
+        assert os.path.basename(inst.command[5]) == 'bar.frag'
+        assert inst.command[6:] == ['fail', '1.30', 'GL_ARB_foo',
+                                    '-report-subtests']
+
+    def test_subtests(self, inst):
+        assert set(inst.result.subtests) == {'foo.vert', 'bar.frag'}
+
+    def test_resume(self, inst):
+        actual = inst._resume(1)  # pylint: disable=protected-access
+        assert os.path.basename(actual[0]) == 'glslparsertest'
+        assert os.path.basename(actual[1]) == 'bar.frag'
+        assert actual[2:] == ['fail', '1.30', 'GL_ARB_foo',
+                              '-report-subtests']
+
+    def test_mixed_binaries(self, tmpdir):
+        """Raises PiglitInternalError for GL and GLES tests in one command."""
+        one = tmpdir.join('foo.vert')
+        one.write(textwrap.dedent("""\
+            /* [config]
+             * expect_result: pass
+             * glsl_version: 1.10
+             * [end config]
+             */"""))
+        two = tmpdir.join('bar.vert')
+        two.write(textwrap.dedent("""\
+            /* [config]
+             * expect_result: pass
+             * glsl_version: 3.00
+             * [end config]
+             */"""))
+
+        with pytest.raises(exceptions.PiglitInternalError):
+            glsl.MultiGLSLParserTest([six.text_type(one), six.text_type(two)])
@@ -35,7 +35,8 @@ import pytest
 from framework import status
 from framework.options import _Options as Options
 from framework.test.base import TestIsSkip as _TestIsSkip
-from framework.test.piglit_test import PiglitBaseTest, PiglitGLTest
+from framework.test.piglit_test import (PiglitBaseTest, PiglitGLTest,
+                                        MultiCLProgramTest)
 
 # pylint: disable=no-self-use
 # pylint: disable=protected-access
@@ -102,6 +103,39 @@ class TestPiglitBaseTest(object):
             assert dict(test.result.subtests) == \
                 {'test1': 'pass', 'test2': 'pass'}
 
+        def test_golden_mismatch(self):
+            """A frame that doesn't match its golden image makes a pass a
+            warn.
+            """
+            test = PiglitBaseTest(['foo'])
+            test.result.out = textwrap.dedent("""\
+                PIGLIT: {"image": {"frame": 0, "status": "mismatch"}}
+                PIGLIT: {"result": "pass"}""")
+            test.result.returncode = 0
+            test.interpret_result()
+            assert test.result.result is status.WARN
+            assert test.result.images == [{'frame': 0, 'status': 'mismatch'}]
+
+        def test_golden_missing(self):
+            """A frame without a golden image doesn't change the result."""
+            test = PiglitBaseTest(['foo'])
+            test.result.out = textwrap.dedent("""\
+                PIGLIT: {"image": {"frame": 0, "status": "missing"}}
+                PIGLIT: {"result": "pass"}""")
+            test.result.returncode = 0
+            test.interpret_result()
+            assert test.result.result is status.PASS
+
+        def test_golden_mismatch_fail(self):
+            """A golden image mismatch doesn't hide a failure."""
+            test = PiglitBaseTest(['foo'])
+            test.result.out = textwrap.dedent("""\
+                PIGLIT: {"image": {"frame": 0, "status": "mismatch"}}
+                PIGLIT: {"result": "fail"}""")
+            test.result.returncode = 1
+            test.interpret_result()
+            assert test.result.result is status.FAIL
+
 
 class TestPiglitGLTest(object):
     """tests for the PiglitGLTest class."""
@@ -170,3 +204,48 @@ class TestPiglitGLTest(object):
             mock_options.env['PIGLIT_PLATFORM'] = 'gbm'
             test = PiglitGLTest(['foo'], exclude_platforms=['glx'])
             test.is_skip()
+
+
+class TestMultiCLProgramTest(object):
+    """Tests for the MultiCLProgramTest class."""
+
+    @pytest.fixture
+    def inst(self):
+        return MultiCLProgramTest(['a/foo.cl', 'b/bar.program_test'])
+
+    def test_command(self, inst):
+        assert inst.command[1:] == ['a/foo.cl', 'b/bar.program_test',
+                                    '-report-subtests']
+
+    def test_subtests(self, inst):
+        assert set(inst.result.subtests) == {'foo', 'bar'}
+
+    def test_resume(self, inst):
+        assert inst._resume(1)[1:] == ['b/bar.program_test',
+                                       '-report-subtests']
+
+    def test_stop_status_result(self, inst):
+        """The result the process exited with is used for the test."""
+        inst.result.out = textwrap.dedent("""\
+            PIGLIT TEST: 0 - foo
+            PIGLIT: {"result": "warn" }
+            """)
+        inst.result.returncode = 0
+        assert not inst._is_cherry()
+        assert inst._stop_status() is status.WARN
+
+    def test_stop_status_crash(self, inst):
+        inst.result.out = 'PIGLIT TEST: 0 - foo\n'
+        inst.result.returncode = -11
+        assert not inst._is_cherry()
+        assert inst._stop_status() is status.CRASH
+
+    def test_is_cherry(self, inst):
+        inst.result.out = textwrap.dedent("""\
+            PIGLIT TEST: 0 - foo
+            PIGLIT: {"subtest": {"foo" : "pass"}}
+            PIGLIT TEST: 1 - bar
+            PIGLIT: {"subtest": {"bar" : "fail"}}
+            """)
+        inst.result.returncode = 0
+        assert inst._is_cherry()
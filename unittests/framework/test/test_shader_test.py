@@ -24,6 +24,7 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import os
+import sys
 import textwrap
 try:
     import mock
@@ -191,6 +192,31 @@ class TestConfigParsing(object):
         assert test.glsl_version == 1.50
         assert test.gl_required == {'GL_ARB_foobar'}
 
+    def test_index_roundtrip(self, tmpdir):
+        """test.shader_test.Parser: from_index restores the values of
+        to_index without reading the file.
+        """
+        p = tmpdir.join('test.shader_test')
+        p.write(textwrap.dedent("""\
+            [require]
+            GL ES < 3.0
+            GLSL ES >= 1.00
+            GL_OES_foobar
+            """))
+        parser = shader_test.Parser(six.text_type(p))
+        parser.parse()
+        values = parser.to_index()
+        p.remove()
+
+        test = shader_test.ShaderTest(
+            six.text_type(p),
+            shader_test.Parser.from_index(six.text_type(p), values))
+
+        assert os.path.basename(test.command[0]) == 'shader_runner_gles2'
+        assert test.gles_version is None
+        assert test.glsl_es_version == 1.0
+        assert test.gl_required == {'GL_OES_foobar'}
+
 
 class TestCommand(object):
     """Tests for the command property."""
@@ -279,3 +305,72 @@ class TestMultiShaderTest(object):
         assert os.path.basename(actual[0]) == 'shader_runner'
         assert os.path.basename(actual[1]) == 'bar.shader_test'
         assert os.path.basename(actual[2]) == '-auto'
+
+
+@pytest.mark.skipif(six.PY2 or os.name != 'posix',
+                    reason='requires select() on pipes')
+class TestShaderRunnerServer(object):
+    """Tests for the ShaderRunnerServer class, using a fake shader_runner."""
+
+    @pytest.fixture
+    def server(self, tmpdir):
+        """A server running a python script that speaks the -server protocol.
+
+        The fake runner crashes on any file whose name contains 'crash'.
+        """
+        prog = tmpdir.join('fake_runner')
+        prog.write(textwrap.dedent("""\
+            #!{}
+            import os, sys
+
+            def run(num, name):
+                if 'crash' in name:
+                    sys.stdout.write('about to crash\\n')
+                    sys.stdout.flush()
+                    os.abort()
+                sys.stdout.write('PIGLIT TEST: {{}} - {{}}\\n'.format(num, name))
+                sys.stdout.write('running {{}}\\n'.format(name))
+                sys.stderr.write('stderr {{}}\\n'.format(name))
+                sys.stderr.flush()
+                sys.stdout.write('PIGLIT: {{"result": "pass" }}\\n')
+                sys.stdout.write('PIGLIT TEST END: {{}}\\n'.format(num))
+                sys.stdout.flush()
+
+            run(1, sys.argv[1])
+            for num, line in enumerate(iter(sys.stdin.readline, ''), 2):
+                run(num, line.strip())
+            """.format(sys.executable)))
+        prog.chmod(0o755)
+
+        inst = shader_test.ShaderRunnerServer(six.text_type(prog),
+                                              dict(os.environ))
+        yield inst
+        inst.stop()
+
+    def test_first_file_on_command_line(self, server):
+        out, err, returncode = server.run('a')
+        assert out == 'running a\nPIGLIT: {"result": "pass" }\n'
+        assert err == 'stderr a\n'
+        assert returncode == 0
+
+    def test_reuses_process(self, server):
+        server.run('a')
+        pid = server.pid
+        out, err, _ = server.run('b')
+        assert server.pid == pid
+        assert out == 'running b\nPIGLIT: {"result": "pass" }\n'
+        assert err == 'stderr b\n'
+
+    def test_crash_attributed(self, server):
+        server.run('a')
+        out, _, returncode = server.run('crash')
+        assert out == 'about to crash\n'
+        assert returncode < 0
+        assert not server.running
+
+    def test_restart_after_crash(self, server):
+        server.run('a')
+        server.run('crash')
+        out, _, returncode = server.run('b')
+        assert out == 'running b\nPIGLIT: {"result": "pass" }\n'
+        assert returncode == 0
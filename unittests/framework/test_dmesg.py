@@ -29,7 +29,9 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import collections
+import os
 import re
+import threading
 try:
     import mock
 except ImportError:
@@ -311,6 +313,135 @@ class TestLinuxDmesg(object):
             assert repr(dmesg.LinuxDmesg()) == 'LinuxDmesg()'
 
 
+class TestKmsgDmesg(object):
+    """Tests for KmsgDmesg, using a plain file or a FIFO as the device."""
+
+    @staticmethod
+    def write(device, *records):
+        with open(device, 'ab') as f:
+            for prio, seq, usecs, message in records:
+                f.write('{},{},{},-;{}\n'.format(
+                    prio, seq, usecs, message).encode('utf-8'))
+
+    @pytest.fixture
+    def device(self, tmpdir):
+        device = six.text_type(tmpdir.join('kmsg'))
+        self.write(device, (3, 1, 1000000, 'before the run'))
+        return device
+
+    def test_skips_old_messages(self, device):
+        """dmesg.KmsgDmesg: messages from before it was created are not
+        reported.
+        """
+        test = dmesg.KmsgDmesg(device)
+        result = results.TestResult(status.PASS)
+        test.update_dmesg()
+        test.update_result(result)
+
+        assert result.result is status.PASS
+        assert result.dmesg == ''
+
+    def test_update_result(self, device):
+        """dmesg.KmsgDmesg.update_result: reports new messages in the dmesg
+        format, and sets the status.
+        """
+        test = dmesg.KmsgDmesg(device)
+        result = results.TestResult(status.PASS)
+        test.update_dmesg()
+        self.write(device, (3, 2, 2500000, 'oops'),
+                   (4, 3, 12345678, 'warning'))
+        test.update_result(result)
+
+        assert result.result is status.DMESG_WARN
+        assert result.dmesg == '[    2.500000] oops\n[   12.345678] warning'
+
+    def test_level(self, device):
+        """dmesg.KmsgDmesg: info and debug messages are ignored, as are
+        continuation lines.
+        """
+        test = dmesg.KmsgDmesg(device)
+        result = results.TestResult(status.PASS)
+        test.update_dmesg()
+        self.write(device, (6, 2, 2000000, 'info'), (7, 3, 3000000, 'debug'),
+                   (5, 4, 4000000, 'notice\n SUBSYSTEM=pci'))
+        test.update_result(result)
+
+        assert result.dmesg == '[    4.000000] notice'
+
+    def test_partial_record(self, device):
+        """dmesg.KmsgDmesg: a record that is only partly written is read
+        once it is complete.
+        """
+        test = dmesg.KmsgDmesg(device)
+        test.update_dmesg()
+        with open(device, 'ab') as f:
+            f.write(b'3,2,2000000,-;par')
+        result = results.TestResult(status.PASS)
+        test.update_result(result)
+        assert result.dmesg == ''
+
+        test.update_dmesg()
+        with open(device, 'ab') as f:
+            f.write(b'tial\n')
+        result = results.TestResult(status.PASS)
+        test.update_result(result)
+        assert result.dmesg == '[    2.000000] partial'
+
+    def test_concurrent(self, device):
+        """dmesg.KmsgDmesg: messages are reported for the tests that were
+        running when they were logged.
+        """
+        test = dmesg.KmsgDmesg(device)
+        first = results.TestResult(status.PASS)
+        second = results.TestResult(status.PASS)
+        started = threading.Event()
+        logged = threading.Event()
+
+        def other():
+            test.update_dmesg()
+            started.set()
+            logged.wait()
+            test.update_result(second)
+
+        thread = threading.Thread(target=other)
+        test.update_dmesg()
+        self.write(device, (3, 2, 2000000, 'first only'))
+        thread.start()
+        started.wait()
+        self.write(device, (3, 3, 3000000, 'both'))
+        test.update_result(first)
+        logged.set()
+        thread.join()
+
+        assert first.dmesg == '[    2.000000] first only\n[    3.000000] both'
+        assert second.dmesg == '[    3.000000] both'
+
+    @skip.posix
+    def test_fifo(self, tmpdir):
+        """dmesg.KmsgDmesg: reads from a FIFO."""
+        device = six.text_type(tmpdir.join('kmsg'))
+        os.mkfifo(device)
+        test = dmesg.KmsgDmesg(device)
+        writer = os.open(device, os.O_WRONLY)
+        try:
+            test.update_dmesg()
+            os.write(writer, b'3,1,1000000,-;from a fifo\n')
+            result = results.TestResult(status.PASS)
+            test.update_result(result)
+        finally:
+            os.close(writer)
+
+        assert result.dmesg == '[    1.000000] from a fifo'
+
+    def test_missing_device(self, tmpdir):
+        """dmesg.KmsgDmesg: raises OSError if the device can't be opened."""
+        with pytest.raises(OSError):
+            dmesg.KmsgDmesg(six.text_type(tmpdir.join('kmsg')))
+
+    def test_repr(self, device):
+        assert repr(dmesg.KmsgDmesg(device)) == 'KmsgDmesg()'
+
+
 class TestDummyDmesg(object):
     """Tests for the DummyDmesg class."""
     _Namespace = collections.namedtuple('_Namespace', ['dmesg', 'result'])
@@ -364,6 +495,7 @@ class TestGetDmesg(object):
         platforms with various configurations.
         """
         mocker.patch('framework.dmesg.sys.platform', platform)
+        mocker.patch('framework.dmesg.KmsgDmesg.DEVICE', '/does/not/exist')
 
         with mock.patch('framework.dmesg.subprocess.check_output',
                         mock.Mock(return_value=b'[1.0]foo')):
@@ -372,3 +504,15 @@ class TestGetDmesg(object):
         # We don't want a subclass, we want the *exact* class. This is a
         # unittest after all
         assert type(actual) == expected  # pylint: disable=unidiomatic-typecheck
+
+    @skip.linux
+    def test_get_dmesg_kmsg(self, mocker, tmpdir):
+        """KmsgDmesg is used on linux if the device can be read."""
+        device = tmpdir.join('kmsg')
+        device.write('')
+        mocker.patch('framework.dmesg.sys.platform', 'linux')
+        mocker.patch('framework.dmesg.KmsgDmesg.DEVICE', six.text_type(device))
+
+        actual = dmesg.get_dmesg(not_dummy=True)
+
+        assert type(actual) == dmesg.KmsgDmesg  # pylint: disable=unidiomatic-typecheck
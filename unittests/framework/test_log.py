@@ -104,6 +104,21 @@ class TestQuietLog(object):
             # test that here, so just strip it.
             assert sys.stdout.read().rstrip() == b'[1/1] pass: 1'
 
+        def test_summary_efficiency(self, log_state):  # pylint: disable=redefined-outer-name
+            """The summary includes the scheduling efficiency when set."""
+            log_state['efficiency'] = 0.5
+            quiet = log.QuietLog(log_state, threading.Lock())
+            quiet.start(None)
+            quiet.log('pass')
+            sys.stdout.seek(0)
+            sys.stdout.truncate()
+
+            quiet.summary()
+            sys.stdout.seek(0)
+
+            assert sys.stdout.read().rstrip().endswith(
+                'scheduling efficiency: 50.0%')
+
         def test_start(self, log_state):  # pylint: disable=redefined-outer-name
             """Test that the start method doesn't have output."""
             quiet = log.QuietLog(log_state, threading.Lock())
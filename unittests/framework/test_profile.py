@@ -24,6 +24,9 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 
+import threading
+import time
+
 import pytest
 import six
 
@@ -305,3 +308,171 @@ class TestRegexFilter(object):
             """Returns False when the test matches any regex."""
             test = profile.RegexFilter([r'fob', r'bar'], inverse=True)
             assert test('foobob', None)
+
+
+class TestScheduler(object):
+    """Tests for profile.Scheduler."""
+
+    class _Test(object):
+        """A stand-in for a Test with a run_concurrent attribute."""
+        def __init__(self, run_concurrent=True):
+            self.run_concurrent = run_concurrent
+
+    def test_runs_every_test(self):
+        """Every test is run exactly once."""
+        ran = []
+        tests = [(str(i), self._Test()) for i in range(20)]
+        profile.Scheduler(4).run(tests, lambda n, _: ran.append(n))
+        assert sorted(ran) == sorted(n for n, _ in tests)
+
+    def test_longest_first(self):
+        """With one worker tests run longest first."""
+        ran = []
+        tests = [(n, self._Test()) for n in ['a', 'b', 'c']]
+        durations = {'a': 1.0, 'b': 3.0, 'c': 2.0}
+        profile.Scheduler(1, durations).run(
+            tests, lambda n, _: ran.append(n))
+        assert ran == ['b', 'c', 'a']
+
+    def test_unknown_keeps_order(self):
+        """Without durations tests run in profile order."""
+        ran = []
+        tests = [(n, self._Test()) for n in ['c', 'a', 'b']]
+        profile.Scheduler(1).run(tests, lambda n, _: ran.append(n))
+        assert ran == ['c', 'a', 'b']
+
+    def test_unknown_keeps_order_concurrent(self):
+        """Without durations several workers start tests in profile order."""
+        started = []
+        scheduler = profile.Scheduler(4)
+        take = scheduler._take
+
+        def record(index):
+            # Called with the scheduler's lock held
+            job = take(index)
+            if job:
+                started.append(job.name)
+            return job
+
+        scheduler._take = record
+        tests = [(str(i), self._Test()) for i in range(20)]
+        scheduler.run(tests, lambda _, __: time.sleep(0.001))
+        assert started == [n for n, _ in tests]
+
+    def test_serial_exclusive(self):
+        """Only one serial test runs at a time."""
+        lock = threading.Lock()
+        state = {'running': 0, 'max': 0}
+
+        def run(_, test):
+            if test.run_concurrent:
+                return
+            with lock:
+                state['running'] += 1
+                state['max'] = max(state['max'], state['running'])
+            time.sleep(0.01)
+            with lock:
+                state['running'] -= 1
+
+        tests = [(str(i), self._Test(False)) for i in range(8)]
+        tests += [(str(i + 8), self._Test()) for i in range(8)]
+        profile.Scheduler(4).run(tests, run, lambda t: not t.run_concurrent)
+        assert state['max'] == 1
+
+    def test_stop(self):
+        """No more tests are started after stop()."""
+        ran = []
+        scheduler = profile.Scheduler(1)
+
+        def run(name, _):
+            ran.append(name)
+            scheduler.stop()
+
+        scheduler.run([(str(i), self._Test()) for i in range(5)], run)
+        assert ran == ['0']
+
+    def test_exception(self):
+        """An exception in a test is raised again by run()."""
+        def run(_, __):
+            raise exceptions.PiglitInternalError('foo')
+
+        with pytest.raises(exceptions.PiglitInternalError):
+            profile.Scheduler(2).run([('a', self._Test())], run)
+
+    def test_efficiency(self):
+        """efficiency is the busy share of the workers' time."""
+        scheduler = profile.Scheduler(1)
+        scheduler.run([('a', self._Test())], lambda _, __: time.sleep(0.05))
+        assert 0.5 < scheduler.efficiency <= 1.0
+
+
+class TestShard(object):
+    """Tests for profile.shard."""
+
+    @staticmethod
+    def make_profiles(count=1, tests=30):
+        profiles = []
+        for p in range(count):
+            prof = profile.TestProfile()
+            for i in range(tests):
+                name = grouptools.join('p{}'.format(p), 'test{}'.format(i))
+                prof.test_list[name] = utils.Test([name])
+            profiles.append(prof)
+        return profiles
+
+    @staticmethod
+    def names(profiles):
+        return [n for p in profiles for n, _ in p.itertests()]
+
+    @pytest.mark.parametrize('durations', [None, {'p0@test1': 5.0}],
+                             ids=['hash', 'durations'])
+    def test_partition(self, durations):
+        """Every test is in exactly one shard."""
+        all_names = self.names(self.make_profiles(2))
+        names = []
+        for i in range(1, 4):
+            profiles = self.make_profiles(2)
+            profile.shard(profiles, i, 3, durations)
+            names.extend(self.names(profiles))
+
+        assert sorted(names) == sorted(all_names)
+
+    def test_after_filters(self):
+        """Only the tests that pass the other filters are split."""
+        profiles = self.make_profiles()
+        profiles[0].filters.append(lambda n, _: n.endswith('1'))
+        info = profile.shard(profiles, 1, 2)
+
+        assert info['total'] == 3
+        assert all(n.endswith('1') for n in self.names(profiles))
+
+    def test_deterministic(self):
+        """The same tests always give the same shards."""
+        first = self.make_profiles()
+        second = self.make_profiles()
+        assert profile.shard(first, 2, 4) == profile.shard(second, 2, 4)
+        assert self.names(first) == self.names(second)
+
+    def test_durations_balance(self):
+        """With durations the shards take about the same time."""
+        durations = {grouptools.join('p0', 'test{}'.format(i)): float(i)
+                     for i in range(30)}
+        loads = []
+        for i in range(1, 4):
+            profiles = self.make_profiles()
+            profile.shard(profiles, i, 3, durations)
+            loads.append(sum(durations[n] for n in self.names(profiles)))
+
+        assert max(loads) - min(loads) <= 1.0
+
+    def test_info(self):
+        """The returned dict describes the shard."""
+        profiles = self.make_profiles()
+        info = profile.shard(profiles, 1, 3)
+
+        assert info['index'] == 1
+        assert info['count'] == 3
+        assert info['total'] == 30
+        assert info['tests'] == len(self.names(profiles))
+        assert info['digest'] == profile.shard(self.make_profiles(), 2, 3)[
+            'digest']
@@ -116,6 +116,9 @@ class TestTestResult(object):
                     'exception': 'an exception',
                     'dmesg': 'this is dmesg',
                     'pid': [1934],
+                    'probes': [{'failed': 3}],
+                    'perf': [{'runs': 5}],
+                    'images': [{'status': 'mismatch'}],
                 }
 
                 cls.test = results.TestResult.from_dict(cls.dict)
@@ -159,6 +162,18 @@ class TestTestResult(object):
                 """sets subtests properly."""
                 assert self.test.subtests == self.dict['subtests']
 
+            def test_probes(self):
+                """sets probes properly."""
+                assert self.test.probes == self.dict['probes']
+
+            def test_images(self):
+                """sets images properly."""
+                assert self.test.images == self.dict['images']
+
+            def test_perf(self):
+                """sets perf properly."""
+                assert self.test.perf == self.dict['perf']
+
             def test_subtests_type(self):
                 """subtests are Status instances."""
                 assert self.test.subtests['a'] is status.PASS
@@ -233,6 +248,9 @@ class TestTestResult(object):
             test.dmesg = 'this is dmesg'
             test.pid = 1934
             test.traceback = 'a traceback'
+            test.probes = [{'failed': 3}]
+            test.perf = [{'runs': 5}]
+            test.images = [{'status': 'mismatch'}]
 
             cls.test = test
             cls.json = test.to_json()
@@ -285,6 +303,18 @@ class TestTestResult(object):
             """results.TestResult.to_json: Adds the traceback attribute"""
             assert self.test.traceback == self.json['traceback']
 
+        def test_probes(self):
+            """results.TestResult.to_json: Adds the probes attribute"""
+            assert self.test.probes == self.json['probes']
+
+        def test_perf(self):
+            """results.TestResult.to_json: Adds the perf attribute"""
+            assert self.test.perf == self.json['perf']
+
+        def test_images(self):
+            """results.TestResult.to_json: Adds the images attribute"""
+            assert self.test.images == self.json['images']
+
     class TestUpdate(object):
         """Tests for TestResult.update."""
 
@@ -300,6 +330,28 @@ class TestTestResult(object):
             test.update({'subtest': {'result': 'incomplete'}})
             assert test.subtests['result'] == 'incomplete'
 
+        def test_probe(self):
+            """results.TestResult.update: probe statistics are appended"""
+            test = results.TestResult('pass')
+            test.update({'probe': {'failed': 1}})
+            test.update({'probe': {'failed': 2}})
+            assert test.probes == [{'failed': 1}, {'failed': 2}]
+            assert test.result == 'pass'
+
+        def test_perf(self):
+            """results.TestResult.update: perf records are appended"""
+            test = results.TestResult('pass')
+            test.update({'perf': {'runs': 3}})
+            assert test.perf == [{'runs': 3}]
+            assert test.result == 'pass'
+
+        def test_image(self):
+            """results.TestResult.update: golden image records are appended"""
+            test = results.TestResult('pass')
+            test.update({'image': {'frame': 0, 'status': 'missing'}})
+            assert test.images == [{'frame': 0, 'status': 'missing'}]
+            assert test.result == 'pass'
+
     class TestTotals(object):
         """Test the totals generated by TestrunResult.calculate_group_totals().
         """
@@ -616,3 +668,39 @@ class TestTimeAttribute(object):
         """results.TimeAttribute.delta: returns the delta of the values"""
         test = results.TimeAttribute(1.0, 5.0)
         assert test.delta == '0:00:04'
+
+
+class TestRusageAttribute(object):
+    """Tests for the RusageAttribute class."""
+
+    def test_roundtrip(self):
+        """from_dict restores the values of to_json."""
+        baseline = {'utime': 0.5, 'stime': 0.25, 'maxrss': 2048,
+                    'minflt': 100, 'majflt': 1, 'nvcsw': 10, 'nivcsw': 2,
+                    '__type__': 'RusageAttribute'}
+        test = results.RusageAttribute.from_dict(baseline).to_json()
+
+        assert baseline == test
+
+    def test_add(self):
+        """sums the counters and keeps the largest maxrss."""
+        test = results.RusageAttribute(utime=1.0, maxrss=100, minflt=5)
+        test.add(results.RusageAttribute(utime=0.5, maxrss=50, minflt=3))
+
+        assert test.utime == 1.5
+        assert test.maxrss == 100
+        assert test.minflt == 8
+
+    def test_testresult_roundtrip(self):
+        """TestResult.from_dict restores rusage."""
+        test = results.TestResult('pass')
+        test.rusage = results.RusageAttribute(utime=1.0, maxrss=100)
+        test = results.TestResult.from_dict(test.to_json())
+
+        assert test.rusage.utime == 1.0
+        assert test.rusage.maxrss == 100
+
+    def test_testresult_default(self):
+        """TestResult.rusage is None if it wasn't collected."""
+        test = results.TestResult.from_dict(results.TestResult().to_json())
+        assert test.rusage is None
@@ -0,0 +1,215 @@
+# encoding=utf-8
+# Copyright © 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for tests.py_modules.index."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import os
+import textwrap
+try:
+    import mock
+except ImportError:
+    from unittest import mock
+
+import pytest
+import six
+
+from framework.test import shader_test
+from tests.py_modules import index
+
+# pylint: disable=no-self-use,redefined-outer-name
+
+_SHADER_TEST = textwrap.dedent("""\
+    [require]
+    GL >= 3.0
+    GLSL >= 1.30
+    GL_ARB_foobar
+    """)
+
+_PARSER_TEST = textwrap.dedent("""\
+    /* [config]
+     * expect_result: pass
+     * glsl_version: 1.10
+     * [end config]
+     */
+    """)
+
+
+@pytest.fixture
+def tree(tmpdir):
+    """Create a tests and a generated_tests directory with a few tests.
+
+    Returns (index file, [tests dir, generated tests dir]).
+    """
+    tests = tmpdir.mkdir('tests')
+    tests.mkdir('spec').join('a.shader_test').write(_SHADER_TEST)
+    tests.join('spec', 'b.frag').write(_PARSER_TEST)
+    tests.join('spec', 'legacy.vert').write('void main() {}\n')
+    tests.join('spec', 'notes.txt').write('')
+    generated = tmpdir.mkdir('generated_tests')
+    generated.mkdir('gen').join('c.shader_test').write(_SHADER_TEST)
+    return (six.text_type(generated.join('all.index')),
+            [six.text_type(tests), six.text_type(generated)])
+
+
+def _files(filename, basedirs):
+    """Return {relative path: parsed} for the files iter_files yields."""
+    return {
+        os.path.relpath(os.path.join(d, f), os.path.dirname(basedirs[0])):
+        parsed
+        for _, d, f, parsed in index.iter_files(basedirs, filename)
+    }
+
+
+def _touch(path):
+    """Move the mtime of path, without depending on the clock resolution."""
+    mtime = os.stat(path).st_mtime
+    os.utime(path, (mtime + 10, mtime + 10))
+
+
+class TestIterFiles(object):
+    """Tests for iter_files."""
+
+    def test_walk_without_index(self, tree):
+        """index.iter_files: without an index every test file is yielded
+        unparsed.
+        """
+        filename, basedirs = tree
+        files = _files(filename, basedirs)
+        assert files == {
+            os.path.join('tests', 'spec', 'a.shader_test'): None,
+            os.path.join('tests', 'spec', 'b.frag'): None,
+            os.path.join('tests', 'spec', 'legacy.vert'): None,
+            os.path.join('generated_tests', 'gen', 'c.shader_test'): None,
+        }
+
+    def test_index(self, tree):
+        """index.iter_files: an up to date index yields the parsed values,
+        and leaves out parser tests without a config.
+        """
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        files = _files(filename, basedirs)
+
+        assert sorted(files) == sorted([
+            os.path.join('tests', 'spec', 'a.shader_test'),
+            os.path.join('tests', 'spec', 'b.frag'),
+            os.path.join('generated_tests', 'gen', 'c.shader_test'),
+        ])
+        parser = files[os.path.join('tests', 'spec', 'a.shader_test')]
+        assert isinstance(parser, shader_test.Parser)
+        assert parser.gl_required == {'GL_ARB_foobar'}
+        assert files[os.path.join('tests', 'spec', 'b.frag')][
+            'expect_result'] == 'pass'
+
+    def test_stale_directory(self, tree):
+        """index.iter_files: a changed directory falls back to the walk."""
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        new = os.path.join(basedirs[0], 'spec', 'new.shader_test')
+        with open(new, 'w') as f:
+            f.write(_SHADER_TEST)
+        _touch(os.path.dirname(new))
+
+        files = _files(filename, basedirs)
+        assert os.path.join('tests', 'spec', 'new.shader_test') in files
+        assert all(v is None for v in six.itervalues(files))
+
+    def test_stale_file(self, tree):
+        """index.iter_files: only a changed file is left to the caller."""
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        _touch(os.path.join(basedirs[0], 'spec', 'a.shader_test'))
+
+        files = _files(filename, basedirs)
+        assert files[os.path.join('tests', 'spec', 'a.shader_test')] is None
+        assert files[os.path.join('tests', 'spec', 'b.frag')] is not None
+
+    @pytest.mark.parametrize('name', ['__pycache__', 'CMakeFiles'])
+    def test_pruned(self, tree, name):
+        """index.iter_files: directories written by python and cmake don't
+        make the index stale.
+        """
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        os.mkdir(os.path.join(basedirs[0], name))
+        _touch(basedirs[0])
+        with open(os.path.join(basedirs[0], name, 'x.pyc'), 'w') as f:
+            f.write('')
+        _touch(os.path.join(basedirs[0], name))
+
+        files = _files(filename, basedirs)
+        assert files[os.path.join('tests', 'spec', 'a.shader_test')] is not None
+
+    def test_other_files(self, tree):
+        """index.iter_files: a directory whose mtime changed without a
+        change to its tests or subdirectories doesn't make the index stale.
+        """
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        with open(os.path.join(basedirs[0], 'spec', 'notes2.txt'), 'w') as f:
+            f.write('')
+        _touch(os.path.join(basedirs[0], 'spec'))
+
+        files = _files(filename, basedirs)
+        assert files[os.path.join('tests', 'spec', 'a.shader_test')] is not None
+
+    def test_new_directory(self, tree):
+        """index.iter_files: a new directory makes the index stale."""
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        os.mkdir(os.path.join(basedirs[0], 'new'))
+        _touch(basedirs[0])
+
+        files = _files(filename, basedirs)
+        assert all(v is None for v in six.itervalues(files))
+
+    def test_relocated(self, tree, tmpdir):
+        """index.iter_files: the index applies after the tree is moved."""
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        moved = tmpdir.mkdir('moved')
+        tmpdir.join('tests').move(moved.join('tests'))
+        tmpdir.join('generated_tests').move(moved.join('generated_tests'))
+
+        basedirs = [six.text_type(moved.join('tests')),
+                    six.text_type(moved.join('generated_tests'))]
+        files = _files(six.text_type(moved.join('generated_tests', 'all.index')),
+                       basedirs)
+        assert files[os.path.join('tests', 'spec', 'a.shader_test')] is not None
+
+
+class TestBuild(object):
+    """Tests for build."""
+
+    def test_reuse(self, tree):
+        """index.build: only files changed since the last index are parsed."""
+        filename, basedirs = tree
+        index.build(filename, basedirs)
+        changed = os.path.join(basedirs[0], 'spec', 'a.shader_test')
+        _touch(changed)
+
+        with mock.patch('tests.py_modules.index._parse',
+                        mock.Mock(return_value=None)) as parse:
+            index.build(filename, basedirs)
+        parse.assert_called_once_with(changed)
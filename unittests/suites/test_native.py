@@ -31,9 +31,17 @@ from __future__ import (
 )
 import importlib
 import os.path
+import sys
+try:
+    import mock
+except ImportError:
+    from unittest import mock
 
 import pytest
 
+from framework import profile
+from framework.test import GLSLParserTest, MultiGLSLParserTest, ShaderTest
+
 MODULES = [
     'all',
     pytest.mark.skipif(not os.path.exists('generated_tests/cl/builtin'),
@@ -54,3 +62,41 @@ def test_import(name):
     """Test that each built-in module can be imported."""
 
     importlib.import_module('tests.{}'.format(name))
+
+
+class TestParserFilters(object):
+    """Tests for the profiles that select or remove the parser tests."""
+
+    @staticmethod
+    def _filter(name):
+        """Import tests.<name> on top of a stub all.py and quick.py.
+
+        Returns the names of the stub tests the profile keeps.
+        """
+        base = profile.TestProfile()
+        base.test_list['parser'] = mock.Mock(spec=GLSLParserTest)
+        base.test_list['multi parser'] = mock.Mock(spec=MultiGLSLParserTest)
+        base.test_list['shader'] = mock.Mock(spec=ShaderTest)
+        stub = mock.Mock(profile=base)
+
+        module = 'tests.{}'.format(name)
+        with mock.patch.dict(sys.modules, {'tests.all': stub,
+                                           'tests.quick': stub}):
+            sys.modules.pop(module, None)
+            try:
+                return set(n for n, _ in
+                           importlib.import_module(module).profile.itertests())
+            finally:
+                sys.modules.pop(module, None)
+
+    def test_glslparser(self):
+        """tests.glslparser: keeps single and grouped parser tests."""
+        assert self._filter('glslparser') == {'parser', 'multi parser'}
+
+    def test_cpu(self):
+        """tests.cpu: keeps single and grouped parser tests."""
+        assert self._filter('cpu') == {'parser', 'multi parser'}
+
+    def test_gpu(self):
+        """tests.gpu: removes single and grouped parser tests."""
+        assert self._filter('gpu') == {'shader'}